@@ -534,19 +534,18 @@ gen10_hevc_enc_insert_slice_header(VADriverContextP ctx,
 		VAEncSequenceParameterBufferHEVC *seq_param = (VAEncSequenceParameterBufferHEVC *)encode_state->seq_param_ext->buffer;
 		VAEncPictureParameterBufferHEVC *pic_param = (VAEncPictureParameterBufferHEVC *)encode_state->pic_param_ext->buffer;
 		VAEncSliceParameterBufferHEVC *slice_param = (VAEncSliceParameterBufferHEVC *)encode_state->slice_params_ext[slice_index]->buffer;
-		unsigned char *slice_header = NULL;
+		unsigned int slice_header[I965_HEADER_BUFFER_SIZE / 4];
 		int slice_header_bits = 0;
 
 		slice_header_bits = build_hevc_slice_header(seq_param,
 													pic_param,
 													slice_param,
-													&slice_header,
+													(unsigned char *)slice_header,
+													sizeof(slice_header),
 													0);
 
-		gen10_hevc_enc_insert_object(ctx, batch, slice_header, slice_header_bits,
+		gen10_hevc_enc_insert_object(ctx, batch, (uint8_t *)slice_header, slice_header_bits,
 									 0, 1, 1, 5);
-
-		free(slice_header);
 	} else {
 		param = (VAEncPackedHeaderParameterBuffer *)
 				(encode_state->packed_header_params_ext[start_index]->buffer);
@@ -35,6 +35,7 @@
 
 #include "i965_encoder.h"
 #include "i965_gpe_utils.h"
+#include "i965_brc_lookahead.h"
 
 struct encode_state;
 
@@ -228,6 +229,8 @@ struct gen6_mfc_context {
 		double qpf_rounding_accumulator[MAX_TEMPORAL_LAYERS];
 		int bits_prev_frame[MAX_TEMPORAL_LAYERS];
 		int prev_slice_type[MAX_TEMPORAL_LAYERS];
+		struct i965_brc_lookahead lookahead;   // single layer only, I965_BRC_LOOKAHEAD=<frames>
+		double lookahead_complexity;            // VME cost of the frame being coded
 	} brc;
 
 	struct {
@@ -253,7 +256,6 @@ struct gen6_mfc_context {
 	} vui_hrd;
 
 	struct {
-		unsigned char *vp8_frame_header;
 		unsigned int frame_header_bit_count;
 		unsigned int frame_header_qindex_update_pos;
 		unsigned int frame_header_lf_update_pos;
@@ -356,6 +358,11 @@ extern int intel_mfc_interlace_check(VADriverContextP ctx,
 extern void intel_mfc_brc_prepare(struct encode_state *encode_state,
 								  struct intel_encoder_context *encoder_context);
 
+extern void intel_mfc_brc_lookahead_prepare(struct encode_state *encode_state,
+											struct intel_encoder_context *encoder_context,
+											int intra_rdo_offset,
+											int inter_rdo_offset);
+
 extern void intel_mfc_avc_pipeline_header_programing(VADriverContextP ctx,
 													 struct encode_state *encode_state,
 													 struct intel_encoder_context *encoder_context,
@@ -106,6 +106,8 @@ static void intel_mfc_brc_init(struct encode_state *encode_state,
 	int intra_period = encoder_context->brc.gop_size;
 	int i;
 	int tmp_min_qp = 0;
+	int lookahead = 0;
+	const char *env_str;
 
 	if (encoder_context->layer.num_layers > 1)
 		qp1_size = 0.15 * frame_per_bits;
@@ -200,6 +202,16 @@ static void intel_mfc_brc_init(struct encode_state *encode_state,
 			BRC_CLIP(mfc_context->brc.qp_prime_y[i][SLICE_TYPE_B], tmp_min_qp, 45);
 		}
 	}
+
+	if (encoder_context->layer.num_layers == 1 && (env_str = getenv("I965_BRC_LOOKAHEAD")))
+		lookahead = atoi(env_str);
+
+	i965_brc_lookahead_init(&mfc_context->brc.lookahead,
+							lookahead,
+							mfc_context->brc.bits_per_frame[0],
+							mfc_context->hrd.buffer_size[0],
+							mfc_context->hrd.target_buffer_fullness[0],
+							min_qp);
 }
 
 int intel_mfc_update_hrd(struct encode_state *encode_state,
@@ -483,14 +495,94 @@ int intel_mfc_brc_postpack(struct encode_state *encode_state,
 						   struct intel_encoder_context *encoder_context,
 						   int frame_bits)
 {
+	struct gen6_mfc_context *mfc_context = encoder_context->mfc_context;
+	VAEncSliceParameterBufferH264 *pSliceParameter = (VAEncSliceParameterBufferH264 *)encode_state->slice_params_ext[0]->buffer;
+	int slice_type = intel_avc_enc_slice_type_fixup(pSliceParameter->slice_type);
+	int qp = mfc_context->brc.qp_prime_y[0][slice_type];
+	int sts;
+
 	switch (encoder_context->rate_control_mode) {
 	case VA_RC_CBR:
-		return intel_mfc_brc_postpack_cbr(encode_state, encoder_context, frame_bits);
+		sts = intel_mfc_brc_postpack_cbr(encode_state, encoder_context, frame_bits);
+		break;
 	case VA_RC_VBR:
-		return intel_mfc_brc_postpack_vbr(encode_state, encoder_context, frame_bits);
+		sts = intel_mfc_brc_postpack_vbr(encode_state, encoder_context, frame_bits);
+		break;
+	default:
+		assert(0 && "Invalid RC mode");
+		return 1;
 	}
-	assert(0 && "Invalid RC mode");
-	return 1;
+
+	/* Only the frame which is kept is accounted, not the re-encoded ones */
+	if (sts != BRC_UNDERFLOW && sts != BRC_OVERFLOW)
+		i965_brc_lookahead_update(&mfc_context->brc.lookahead,
+								  slice_type,
+								  mfc_context->brc.lookahead_complexity,
+								  qp,
+								  frame_bits);
+
+	return sts;
+}
+
+/*
+ * Sums the VME cost of the best mode of each macroblock and lets the
+ * lookahead controller pick the QP of the frame from it. The encoder has to
+ * wait for the VME kernel here instead of when the slice batch is built.
+ */
+void intel_mfc_brc_lookahead_prepare(struct encode_state *encode_state,
+									 struct intel_encoder_context *encoder_context,
+									 int intra_rdo_offset,
+									 int inter_rdo_offset)
+{
+	struct gen6_mfc_context *mfc_context = encoder_context->mfc_context;
+	struct gen6_vme_context *vme_context = encoder_context->vme_context;
+	VAEncSliceParameterBufferH264 *pSliceParameter;
+	unsigned char *msg_ptr;
+	unsigned int *msg;
+	unsigned int intra_rdo, inter_rdo;
+	double complexity = 0.;
+	int slice_type;
+	int i, j;
+
+	mfc_context->brc.lookahead_complexity = 0.;
+
+	if (!mfc_context->brc.lookahead.window ||
+		(encoder_context->rate_control_mode != VA_RC_CBR &&
+		 encoder_context->rate_control_mode != VA_RC_VBR))
+		return;
+
+	pSliceParameter = (VAEncSliceParameterBufferH264 *)encode_state->slice_params_ext[0]->buffer;
+	slice_type = intel_avc_enc_slice_type_fixup(pSliceParameter->slice_type);
+
+	dri_bo_map(vme_context->vme_output.bo, 0);
+	msg_ptr = (unsigned char *)vme_context->vme_output.bo->virtual;
+
+	for (i = 0; i < encode_state->num_slice_params_ext; i++) {
+		pSliceParameter = (VAEncSliceParameterBufferH264 *)encode_state->slice_params_ext[i]->buffer;
+
+		for (j = pSliceParameter->macroblock_address;
+			 j < pSliceParameter->macroblock_address + pSliceParameter->num_macroblocks; j++) {
+			msg = (unsigned int *)(msg_ptr + j * vme_context->vme_output.size_block);
+			intra_rdo = msg[intra_rdo_offset] & 0xffff;
+
+			if (slice_type == SLICE_TYPE_I) {
+				complexity += intra_rdo;
+			} else {
+				inter_rdo = msg[inter_rdo_offset] & 0xffff;
+				complexity += MIN(intra_rdo, inter_rdo);
+			}
+		}
+	}
+
+	dri_bo_unmap(vme_context->vme_output.bo);
+
+	mfc_context->brc.lookahead_complexity = complexity;
+	mfc_context->brc.qp_prime_y[0][slice_type] =
+		i965_brc_lookahead_get_qp(&mfc_context->brc.lookahead,
+								  slice_type,
+								  complexity,
+								  mfc_context->hrd.current_buffer_fullness[0],
+								  mfc_context->brc.qp_prime_y[0][slice_type]);
 }
 
 static void intel_mfc_hrd_context_init(struct encode_state *encode_state,
@@ -1767,7 +1859,7 @@ void intel_avc_slice_insert_packed_data(VADriverContextP ctx,
 	}
 
 	if (slice_header_index == -1) {
-		unsigned char *slice_header = NULL;
+		unsigned int slice_header[I965_HEADER_BUFFER_SIZE / 4];
 		int slice_header_length_in_bits = 0;
 		VAEncSequenceParameterBufferH264 *pSequenceParameter = (VAEncSequenceParameterBufferH264 *)encode_state->seq_param_ext->buffer;
 		VAEncPictureParameterBufferH264 *pPicParameter = (VAEncPictureParameterBufferH264 *)encode_state->pic_param_ext->buffer;
@@ -1778,15 +1870,14 @@ void intel_avc_slice_insert_packed_data(VADriverContextP ctx,
 		slice_header_length_in_bits = build_avc_slice_header(pSequenceParameter,
 															 pPicParameter,
 															 pSliceParameter,
-															 &slice_header);
+															 (unsigned char *)slice_header,
+															 sizeof(slice_header));
 		mfc_context->insert_object(ctx, encoder_context,
-								   (unsigned int *)slice_header,
+								   slice_header,
 								   ALIGN(slice_header_length_in_bits, 32) >> 5,
 								   slice_header_length_in_bits & 0x1f,
 								   5,  /* first 5 bytes are start code + nal unit type */
 								   1, 0, 1, slice_batch);
-
-		free(slice_header);
 	} else {
 		unsigned int skip_emul_byte_cnt;
 
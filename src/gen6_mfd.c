@@ -1301,69 +1301,20 @@ gen6_mfd_vc1_decode_init(VADriverContextP ctx,
 		gen6_mfd_context->bitplane_read_buffer.valid = 1;
 	else
 		gen6_mfd_context->bitplane_read_buffer.valid = !!(pic_param->bitplane_present.value & 0x7f);
-	dri_bo_unreference(gen6_mfd_context->bitplane_read_buffer.bo);
 
 	if (gen6_mfd_context->bitplane_read_buffer.valid) {
 		int width_in_mbs = ALIGN(pic_param->coded_width, 16) / 16;
 		int height_in_mbs = ALIGN(pic_param->coded_height, 16) / 16;
-		int bitplane_width = ALIGN(width_in_mbs, 2) / 2;
-		int src_w, src_h;
-		uint8_t *src = NULL, *dst = NULL;
-
-		bo = dri_bo_alloc(i965->intel.bufmgr,
-						  "VC-1 Bitplane",
-						  bitplane_width * height_in_mbs,
-						  0x1000);
-		assert(bo);
-		gen6_mfd_context->bitplane_read_buffer.bo = bo;
-
-		dri_bo_map(bo, True);
-		assert(bo->virtual);
-		dst = bo->virtual;
-
-		if (picture_type == GEN6_VC1_SKIPPED_PICTURE) {
-			for (src_h = 0; src_h < height_in_mbs; src_h++) {
-				for (src_w = 0; src_w < width_in_mbs; src_w++) {
-					int dst_index;
-					uint8_t src_value = 0x2;
-
-					dst_index = src_w / 2;
-					dst[dst_index] = ((dst[dst_index] >> 4) | (src_value << 4));
-				}
+		uint8_t *src = NULL;
 
-				if (src_w & 1)
-					dst[src_w / 2] >>= 4;
-
-				dst += bitplane_width;
-			}
-		} else {
+		if (picture_type != GEN6_VC1_SKIPPED_PICTURE) {
 			assert(decode_state->bit_plane->buffer);
 			src = decode_state->bit_plane->buffer;
-
-			for (src_h = 0; src_h < height_in_mbs; src_h++) {
-				for (src_w = 0; src_w < width_in_mbs; src_w++) {
-					int src_index, dst_index;
-					int src_shift;
-					uint8_t src_value;
-
-					src_index = (src_h * width_in_mbs + src_w) / 2;
-					src_shift = !((src_h * width_in_mbs + src_w) & 1) * 4;
-					src_value = ((src[src_index] >> src_shift) & 0xf);
-
-					dst_index = src_w / 2;
-					dst[dst_index] = ((dst[dst_index] >> 4) | (src_value << 4));
-				}
-
-				if (src_w & 1)
-					dst[src_w / 2] >>= 4;
-
-				dst += bitplane_width;
-			}
 		}
 
-		dri_bo_unmap(bo);
-	} else
-		gen6_mfd_context->bitplane_read_buffer.bo = NULL;
+		intel_update_vc1_bitplane_buffer(ctx, &gen6_mfd_context->bitplane_read_buffer,
+										 src, width_in_mbs, height_in_mbs);
+	}
 }
 
 static void
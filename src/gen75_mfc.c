@@ -1698,6 +1698,9 @@ gen75_mfc_avc_encode_picture(VADriverContextP ctx,
 	int current_frame_bits_size;
 	int sts;
 
+	intel_mfc_brc_lookahead_prepare(encode_state, encoder_context,
+									AVC_INTRA_RDO_OFFSET, AVC_INTER_RDO_OFFSET);
+
 	for (;;) {
 		gen75_mfc_init(ctx, encode_state, encoder_context);
 		intel_mfc_avc_prepare(ctx, encode_state, encoder_context);
@@ -1755,12 +1755,14 @@ gen75_vebox_process_picture(VADriverContextP ctx,
 		/* directly copy the saved frame in the second call */
 	} else {
 		intel_batchbuffer_start_atomic_veb(proc_ctx->batch, 0x1000);
+		intel_batchbuffer_begin_stage(proc_ctx->batch, INTEL_GPU_STAGE_VPP);
 		intel_batchbuffer_emit_mi_flush(proc_ctx->batch);
 		hsw_veb_state_table_setup(ctx, proc_ctx);
 		hsw_veb_state_command(ctx, proc_ctx);
 		hsw_veb_surface_state(ctx, proc_ctx, INPUT_SURFACE);
 		hsw_veb_surface_state(ctx, proc_ctx, OUTPUT_SURFACE);
 		hsw_veb_dndi_iecp_command(ctx, proc_ctx);
+		intel_batchbuffer_end_stage(proc_ctx->batch, INTEL_GPU_STAGE_VPP);
 		intel_batchbuffer_end_atomic(proc_ctx->batch);
 		intel_batchbuffer_flush(proc_ctx->batch);
 	}
@@ -1985,12 +1987,14 @@ gen8_vebox_process_picture(VADriverContextP ctx,
 		/* directly copy the saved frame in the second call */
 	} else {
 		intel_batchbuffer_start_atomic_veb(proc_ctx->batch, 0x1000);
+		intel_batchbuffer_begin_stage(proc_ctx->batch, INTEL_GPU_STAGE_VPP);
 		intel_batchbuffer_emit_mi_flush(proc_ctx->batch);
 		hsw_veb_state_table_setup(ctx, proc_ctx);
 		bdw_veb_state_command(ctx, proc_ctx);
 		hsw_veb_surface_state(ctx, proc_ctx, INPUT_SURFACE);
 		hsw_veb_surface_state(ctx, proc_ctx, OUTPUT_SURFACE);
 		bdw_veb_dndi_iecp_command(ctx, proc_ctx);
+		intel_batchbuffer_end_stage(proc_ctx->batch, INTEL_GPU_STAGE_VPP);
 		intel_batchbuffer_end_atomic(proc_ctx->batch);
 		intel_batchbuffer_flush(proc_ctx->batch);
 	}
@@ -2459,12 +2463,14 @@ gen9_vebox_process_picture(VADriverContextP ctx,
 		/* directly copy the saved frame in the second call */
 	} else {
 		intel_batchbuffer_start_atomic_veb(proc_ctx->batch, 0x1000);
+		intel_batchbuffer_begin_stage(proc_ctx->batch, INTEL_GPU_STAGE_VPP);
 		intel_batchbuffer_emit_mi_flush(proc_ctx->batch);
 		skl_veb_state_table_setup(ctx, proc_ctx);
 		skl_veb_state_command(ctx, proc_ctx);
 		skl_veb_surface_state(ctx, proc_ctx, INPUT_SURFACE);
 		skl_veb_surface_state(ctx, proc_ctx, OUTPUT_SURFACE);
 		bdw_veb_dndi_iecp_command(ctx, proc_ctx);
+		intel_batchbuffer_end_stage(proc_ctx->batch, INTEL_GPU_STAGE_VPP);
 		intel_batchbuffer_end_atomic(proc_ctx->batch);
 		intel_batchbuffer_flush(proc_ctx->batch);
 	}
@@ -2717,12 +2723,14 @@ gen10_vebox_process_picture(VADriverContextP ctx, struct intel_vebox_context *pr
 		/* directly copy the saved frame in the second call */
 	} else {
 		intel_batchbuffer_start_atomic_veb(proc_ctx->batch, 0x1000);
+		intel_batchbuffer_begin_stage(proc_ctx->batch, INTEL_GPU_STAGE_VPP);
 		intel_batchbuffer_emit_mi_flush(proc_ctx->batch);
 		skl_veb_state_table_setup(ctx, proc_ctx);
 		cnl_veb_state_command(ctx, proc_ctx);
 		cnl_veb_surface_state(ctx, proc_ctx, INPUT_SURFACE);
 		cnl_veb_surface_state(ctx, proc_ctx, OUTPUT_SURFACE);
 		cnl_veb_dndi_iecp_command(ctx, proc_ctx);
+		intel_batchbuffer_end_stage(proc_ctx->batch, INTEL_GPU_STAGE_VPP);
 		intel_batchbuffer_end_atomic(proc_ctx->batch);
 		intel_batchbuffer_flush(proc_ctx->batch);
 	}
@@ -34,6 +34,7 @@
 #include <i915_drm.h>
 #include <intel_bufmgr.h>
 #include "i965_decoder.h"
+#include "intel_bsd_scheduler.h"
 
 #define GEN7_VC1_I_PICTURE			0
 #define GEN7_VC1_P_PICTURE			1
@@ -75,6 +76,23 @@ struct gen7_vc1_surface {
 
 struct hw_context;
 
+/*
+ * The pictures which don't depend on each other (all intra) can be spread
+ * over the BSD rings, each ring keeps the scratch buffers and the decode
+ * batch of the pictures sent to it in a slot. The slot in use has them in
+ * gen7_mfd_context itself, the others are parked here.
+ */
+#define GEN7_MFD_PICTURE_SLOTS		INTEL_BSD_SCHEDULER_MAX_RINGS
+
+struct gen7_mfd_picture_slot {
+	GenBuffer           intra_row_store_scratch_buffer;
+	GenBuffer           deblocking_filter_row_store_scratch_buffer;
+	GenBuffer           bsd_mpc_row_store_scratch_buffer;
+	GenBuffer           mpr_row_store_scratch_buffer;
+	/* deferred decode batch of the ring, NULL when base.batch serves all */
+	struct intel_batchbuffer *batch;
+};
+
 struct gen7_mfd_context {
 	struct hw_context base;
 
@@ -101,6 +119,13 @@ struct gen7_mfd_context {
 	unsigned int decoder_format_mode : 1;
 	int wa_mpeg2_slice_vertical_position;
 
+	/* BSD ring the context is pinned to, -1 when left to the kernel */
+	int bsd_ring;
+
+	/* Ring of the current picture, its buffers are the ones above */
+	int picture_slot;
+	struct gen7_mfd_picture_slot picture_slots[GEN7_MFD_PICTURE_SLOTS];
+
 	void *driver_context;
 };
 
@@ -159,6 +159,83 @@ static const uint32_t fqm_flat[32] = {
 #define     INTER_MV32      (6 << 20)
 
 
+/*
+ * The size of the bitstream written by the PAK is stored by the batch into
+ * codec_private_data of the coded buffer, it covers the delimiter appended
+ * to MPEG-2 pictures which is not part of the coded data.
+ */
+struct gen8_mfc_status {
+	uint32_t bytes_per_frame;
+};
+
+#define GEN8_MFC_MPEG2_TAIL_SIZE        5
+
+static void
+gen8_mfc_status_init(struct i965_coded_buffer_segment *coded_buffer_segment)
+{
+	struct gen8_mfc_status *mfc_status = (struct gen8_mfc_status *)coded_buffer_segment->codec_private_data;
+
+	coded_buffer_segment->status_support = 1;
+	mfc_status->bytes_per_frame = 0;
+}
+
+static void
+gen8_mfc_read_status(VADriverContextP ctx,
+					 struct intel_encoder_context *encoder_context,
+					 struct intel_batchbuffer *batch)
+{
+	struct gen6_mfc_context *mfc_context = encoder_context->mfc_context;
+	struct gpe_mi_store_register_mem_parameter mi_store_register_mem_params;
+	struct gpe_mi_flush_dw_parameter mi_flush_dw_params;
+
+	memset(&mi_flush_dw_params, 0, sizeof(mi_flush_dw_params));
+	gen8_gpe_mi_flush_dw(ctx, batch, &mi_flush_dw_params);
+
+	memset(&mi_store_register_mem_params, 0, sizeof(mi_store_register_mem_params));
+	/* The register of the first VDBOX, gen8_mfc_start_atomic_status() keeps the batch there */
+	mi_store_register_mem_params.mmio_offset = MFC_BITSTREAM_BYTECOUNT_FRAME_REG;
+	mi_store_register_mem_params.bo = mfc_context->mfc_indirect_pak_bse_object.bo;
+	mi_store_register_mem_params.offset = offsetof(struct i965_coded_buffer_segment, codec_private_data) +
+										  offsetof(struct gen8_mfc_status, bytes_per_frame);
+	gen8_gpe_mi_store_register_mem(ctx, batch, &mi_store_register_mem_params);
+}
+
+/* Starts a batch which reads the status, on the VDBOX of its registers */
+static void
+gen8_mfc_start_atomic_status(VADriverContextP ctx,
+							 struct intel_batchbuffer *batch,
+							 unsigned int size)
+{
+	struct i965_driver_data *i965 = i965_driver_data(ctx);
+
+	if (i965->intel.has_bsd2)
+		intel_batchbuffer_start_atomic_bcs_override(batch, size, BSD_RING0);
+	else
+		intel_batchbuffer_start_atomic_bcs(batch, size);
+}
+
+static VAStatus
+gen8_mfc_get_coded_status(VADriverContextP ctx,
+						  struct intel_encoder_context *encoder_context,
+						  struct i965_coded_buffer_segment *coded_buffer_segment)
+{
+	struct gen8_mfc_status *mfc_status = (struct gen8_mfc_status *)coded_buffer_segment->codec_private_data;
+	unsigned int tail_size = 0;
+
+	if (coded_buffer_segment->codec == CODEC_MPEG2)
+		tail_size = GEN8_MFC_MPEG2_TAIL_SIZE;
+
+	/* Not written by the hardware, let the caller look for the delimiter */
+	if (mfc_status->bytes_per_frame <= tail_size) {
+		coded_buffer_segment->status_support = 0;
+		return VA_STATUS_SUCCESS;
+	}
+
+	coded_buffer_segment->base.size = mfc_status->bytes_per_frame - tail_size;
+
+	return VA_STATUS_SUCCESS;
+}
+
 static void
 gen8_mfc_pipe_mode_select(VADriverContextP ctx,
 						  int standard_select,
@@ -1806,6 +1883,7 @@ gen8_mfc_avc_pipeline_programing(VADriverContextP ctx,
 
 	// begin programing
 	intel_batchbuffer_start_atomic_bcs(batch, 0x4000);
+	intel_batchbuffer_begin_stage(batch, INTEL_GPU_STAGE_PAK);
 	intel_batchbuffer_emit_mi_flush(batch);
 
 	// picture level programing
@@ -1820,6 +1898,7 @@ gen8_mfc_avc_pipeline_programing(VADriverContextP ctx,
 	ADVANCE_BCS_BATCH(batch);
 
 	// end programing
+	intel_batchbuffer_end_stage(batch, INTEL_GPU_STAGE_PAK);
 	intel_batchbuffer_end_atomic(batch);
 
 	dri_bo_unreference(slice_batch_bo);
@@ -1836,6 +1915,9 @@ gen8_mfc_avc_encode_picture(VADriverContextP ctx,
 	int current_frame_bits_size;
 	int sts;
 
+	intel_mfc_brc_lookahead_prepare(encode_state, encoder_context,
+									AVC_INTRA_RDO_OFFSET, AVC_INTER_RDO_OFFSET);
+
 	for (;;) {
 		gen8_mfc_init(ctx, encode_state, encoder_context);
 		intel_mfc_avc_prepare(ctx, encode_state, encoder_context);
@@ -2446,6 +2528,9 @@ gen8_mfc_mpeg2_software_slice_batchbuffer(VADriverContextP ctx,
 		gen8_mfc_mpeg2_pipeline_slice_group(ctx, encode_state, encoder_context, i, next_slice_group_param, batch);
 	}
 
+	/* The main batch doesn't resume after the slice batch */
+	gen8_mfc_read_status(ctx, encoder_context, batch);
+
 	intel_batchbuffer_align(batch, 8);
 
 	BEGIN_BCS_BATCH(batch, 2);
@@ -2488,7 +2573,7 @@ gen8_mfc_mpeg2_pipeline_programing(VADriverContextP ctx,
 	slice_batch_bo = gen8_mfc_mpeg2_software_slice_batchbuffer(ctx, encode_state, encoder_context);
 
 	// begin programing
-	intel_batchbuffer_start_atomic_bcs(batch, 0x4000);
+	gen8_mfc_start_atomic_status(ctx, batch, 0x4000);
 	intel_batchbuffer_emit_mi_flush(batch);
 
 	// picture level programing
@@ -2579,6 +2664,7 @@ intel_mfc_mpeg2_prepare(VADriverContextP ctx,
 	coded_buffer_segment = (struct i965_coded_buffer_segment *)bo->virtual;
 	coded_buffer_segment->mapped = 0;
 	coded_buffer_segment->codec = encoder_context->codec;
+	gen8_mfc_status_init(coded_buffer_segment);
 	dri_bo_unmap(bo);
 
 	return vaStatus;
@@ -2630,6 +2716,7 @@ intel_mfc_jpeg_prepare(VADriverContextP ctx,
 	coded_buffer_segment = (struct i965_coded_buffer_segment *)bo->virtual;
 	coded_buffer_segment->mapped = 0;
 	coded_buffer_segment->codec = encoder_context->codec;
+	gen8_mfc_status_init(coded_buffer_segment);
 	dri_bo_unmap(bo);
 
 	return vaStatus;
@@ -3361,12 +3448,14 @@ gen8_mfc_jpeg_pipeline_programing(VADriverContextP ctx,
 	struct intel_batchbuffer *batch = encoder_context->base.batch;
 
 	// begin programing
-	intel_batchbuffer_start_atomic_bcs(batch, 0x4000);
+	gen8_mfc_start_atomic_status(ctx, batch, 0x4000);
 	intel_batchbuffer_emit_mi_flush(batch);
 
 	// picture level programing
 	gen8_mfc_jpeg_pipeline_picture_programing(ctx, encode_state, encoder_context);
 
+	gen8_mfc_read_status(ctx, encoder_context, batch);
+
 	// end programing
 	intel_batchbuffer_end_atomic(batch);
 
@@ -3687,7 +3776,9 @@ extern void binarize_vp8_frame_header(VAEncSequenceParameterBufferVP8 *seq_param
 									  VAEncPictureParameterBufferVP8 *pic_param,
 									  VAQMatrixBufferVP8 *q_matrix,
 									  struct gen6_mfc_context *mfc_context,
-									  struct intel_encoder_context *encoder_context);
+									  struct intel_encoder_context *encoder_context,
+									  unsigned char *header_buffer,
+									  int buffer_size);
 
 static void vp8_enc_frame_header_binarize(struct encode_state *encode_state,
 										  struct intel_encoder_context *encoder_context,
@@ -3698,13 +3789,12 @@ static void vp8_enc_frame_header_binarize(struct encode_state *encode_state,
 	VAQMatrixBufferVP8 *q_matrix = (VAQMatrixBufferVP8 *)encode_state->q_matrix->buffer;
 	unsigned char *frame_header_buffer;
 
-	binarize_vp8_frame_header(seq_param, pic_param, q_matrix, mfc_context, encoder_context);
-
+	/* The header is binarized straight into the buffer object */
 	dri_bo_map(mfc_context->vp8_state.frame_header_bo, 1);
 	frame_header_buffer = (unsigned char *)mfc_context->vp8_state.frame_header_bo->virtual;
 	assert(frame_header_buffer);
-	memcpy(frame_header_buffer, mfc_context->vp8_state.vp8_frame_header, (mfc_context->vp8_state.frame_header_bit_count + 7) / 8);
-	free(mfc_context->vp8_state.vp8_frame_header);
+	binarize_vp8_frame_header(seq_param, pic_param, q_matrix, mfc_context, encoder_context,
+							  frame_header_buffer, mfc_context->vp8_state.frame_header_bo->size);
 	dri_bo_unmap(mfc_context->vp8_state.frame_header_bo);
 }
 
@@ -4763,6 +4853,7 @@ Bool gen8_mfc_context_init(VADriverContextP ctx, struct intel_encoder_context *e
 	encoder_context->mfc_context = mfc_context;
 	encoder_context->mfc_context_destroy = gen8_mfc_context_destroy;
 	encoder_context->mfc_pipeline = gen8_mfc_pipeline;
+	encoder_context->get_status = gen8_mfc_get_coded_status;
 
 	if (encoder_context->codec == CODEC_VP8)
 		encoder_context->mfc_brc_prepare = gen8_mfc_vp8_brc_prepare;
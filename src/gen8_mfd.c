@@ -130,6 +130,36 @@ gen8_mfd_pipe_mode_select(VADriverContextP ctx,
 	ADVANCE_BCS_BATCH(batch);
 }
 
+/*
+ * Starts the picture on the ring of its slot, accounting its size in
+ * macroblocks so that new contexts go to the least busy ring.
+ */
+static void
+gen8_mfd_start_atomic(VADriverContextP ctx,
+					  struct decode_state *decode_state,
+					  struct gen7_mfd_context *gen7_mfd_context)
+{
+	struct i965_driver_data *i965 = i965_driver_data(ctx);
+	struct intel_batchbuffer *batch = gen7_mfd_context->base.batch;
+	struct object_surface *obj_surface = decode_state->render_object;
+	unsigned int cost;
+
+	intel_batchbuffer_begin_frame(batch);
+
+	if (gen7_mfd_context->bsd_ring < 0) {
+		intel_batchbuffer_start_atomic_bcs(batch, 0x1000);
+	} else {
+		cost = ALIGN(obj_surface->orig_width, 16) / 16 * ALIGN(obj_surface->orig_height, 16) / 16;
+		intel_bsd_scheduler_account(&i965->intel.bsd_scheduler, gen7_mfd_context->picture_slot,
+									cost, intel_bsd_scheduler_now());
+
+		intel_batchbuffer_start_atomic_bcs_override(batch, 0x1000,
+													gen7_mfd_context->picture_slot ? BSD_RING1 : BSD_RING0);
+	}
+
+	intel_batchbuffer_begin_stage(batch, INTEL_GPU_STAGE_DECODE);
+}
+
 static void
 gen8_mfd_surface_state(VADriverContextP ctx,
 					   struct decode_state *decode_state,
@@ -830,6 +860,25 @@ gen8_mfd_avc_context_init(
 	}
 }
 
+/*
+ * The row stores of a slot are only used on its ring, where the pictures
+ * run in order, so they're kept as long as they're large enough.
+ */
+static void
+gen8_mfd_avc_row_store(VADriverContextP ctx, GenBuffer *buffer,
+					   const char *name, unsigned int size)
+{
+	struct i965_driver_data *i965 = i965_driver_data(ctx);
+
+	if (!buffer->bo || buffer->bo->size < size) {
+		dri_bo_unreference(buffer->bo);
+		buffer->bo = dri_bo_alloc(i965->intel.bufmgr, name, size, 0x1000);
+		assert(buffer->bo);
+	}
+
+	buffer->valid = 1;
+}
+
 static void
 gen8_mfd_avc_decode_init(VADriverContextP ctx,
 						 struct decode_state *decode_state,
@@ -837,9 +886,7 @@ gen8_mfd_avc_decode_init(VADriverContextP ctx,
 {
 	VAPictureParameterBufferH264 *pic_param;
 	VASliceParameterBufferH264 *slice_param;
-	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_surface *obj_surface;
-	dri_bo *bo;
 	int i, j, enable_avc_ildb = 0;
 	unsigned int width_in_mbs, height_in_mbs;
 
@@ -893,43 +940,98 @@ gen8_mfd_avc_decode_init(VADriverContextP ctx,
 	dri_bo_reference(gen7_mfd_context->pre_deblocking_output.bo);
 	gen7_mfd_context->pre_deblocking_output.valid = !enable_avc_ildb;
 
-	dri_bo_unreference(gen7_mfd_context->intra_row_store_scratch_buffer.bo);
-	bo = dri_bo_alloc(i965->intel.bufmgr,
-					  "intra row store",
-					  width_in_mbs * 64,
-					  0x1000);
-	assert(bo);
-	gen7_mfd_context->intra_row_store_scratch_buffer.bo = bo;
-	gen7_mfd_context->intra_row_store_scratch_buffer.valid = 1;
+	gen8_mfd_avc_row_store(ctx, &gen7_mfd_context->intra_row_store_scratch_buffer,
+						   "intra row store", width_in_mbs * 64);
+	gen8_mfd_avc_row_store(ctx, &gen7_mfd_context->deblocking_filter_row_store_scratch_buffer,
+						   "deblocking filter row store", width_in_mbs * 64 * 4);
+	gen8_mfd_avc_row_store(ctx, &gen7_mfd_context->bsd_mpc_row_store_scratch_buffer,
+						   "bsd mpc row store", width_in_mbs * 64 * 2);
+	gen8_mfd_avc_row_store(ctx, &gen7_mfd_context->mpr_row_store_scratch_buffer,
+						   "mpr row store", width_in_mbs * 64 * 2);
 
-	dri_bo_unreference(gen7_mfd_context->deblocking_filter_row_store_scratch_buffer.bo);
-	bo = dri_bo_alloc(i965->intel.bufmgr,
-					  "deblocking filter row store",
-					  width_in_mbs * 64 * 4,
-					  0x1000);
-	assert(bo);
-	gen7_mfd_context->deblocking_filter_row_store_scratch_buffer.bo = bo;
-	gen7_mfd_context->deblocking_filter_row_store_scratch_buffer.valid = 1;
+	gen7_mfd_context->bitplane_read_buffer.valid = 0;
+}
 
-	dri_bo_unreference(gen7_mfd_context->bsd_mpc_row_store_scratch_buffer.bo);
-	bo = dri_bo_alloc(i965->intel.bufmgr,
-					  "bsd mpc row store",
-					  width_in_mbs * 64 * 2,
-					  0x1000);
-	assert(bo);
-	gen7_mfd_context->bsd_mpc_row_store_scratch_buffer.bo = bo;
-	gen7_mfd_context->bsd_mpc_row_store_scratch_buffer.valid = 1;
+/* Parks the buffer of the context in last and takes the one of next */
+#define GEN8_MFD_SWITCH_BUFFER(gen7_mfd_context, last, next, buffer) do { \
+		(last)->buffer = (gen7_mfd_context)->buffer;                    \
+		(gen7_mfd_context)->buffer = (next)->buffer;                    \
+		memset(&(next)->buffer, 0, sizeof((next)->buffer));             \
+	} while (0)
 
-	dri_bo_unreference(gen7_mfd_context->mpr_row_store_scratch_buffer.bo);
-	bo = dri_bo_alloc(i965->intel.bufmgr,
-					  "mpr row store",
-					  width_in_mbs * 64 * 2,
-					  0x1000);
-	assert(bo);
-	gen7_mfd_context->mpr_row_store_scratch_buffer.bo = bo;
-	gen7_mfd_context->mpr_row_store_scratch_buffer.valid = 1;
+/* Brings the buffers and the batch of slot into the context */
+static void
+gen8_mfd_switch_picture_slot(struct gen7_mfd_context *gen7_mfd_context, int slot)
+{
+	struct gen7_mfd_picture_slot *last, *next;
 
-	gen7_mfd_context->bitplane_read_buffer.valid = 0;
+	if (slot == gen7_mfd_context->picture_slot)
+		return;
+
+	/*
+	 * The next pictures may read those queued for the ring left, they must
+	 * be submitted first for the implicit sync to order the rings.
+	 */
+	intel_batchbuffer_flush_frames(gen7_mfd_context->base.batch);
+
+	last = &gen7_mfd_context->picture_slots[gen7_mfd_context->picture_slot];
+	next = &gen7_mfd_context->picture_slots[slot];
+
+	GEN8_MFD_SWITCH_BUFFER(gen7_mfd_context, last, next, intra_row_store_scratch_buffer);
+	GEN8_MFD_SWITCH_BUFFER(gen7_mfd_context, last, next, deblocking_filter_row_store_scratch_buffer);
+	GEN8_MFD_SWITCH_BUFFER(gen7_mfd_context, last, next, bsd_mpc_row_store_scratch_buffer);
+	GEN8_MFD_SWITCH_BUFFER(gen7_mfd_context, last, next, mpr_row_store_scratch_buffer);
+
+	if (next->batch) {
+		last->batch = gen7_mfd_context->base.batch;
+		gen7_mfd_context->base.batch = next->batch;
+		next->batch = NULL;
+	}
+
+	gen7_mfd_context->picture_slot = slot;
+}
+
+/*
+ * An intra picture reads no other picture, so it goes to the least busy
+ * ring whatever the ring of its context, the others stay on the latter.
+ */
+static void
+gen8_mfd_avc_picture_slot(VADriverContextP ctx,
+						  struct decode_state *decode_state,
+						  struct gen7_mfd_context *gen7_mfd_context)
+{
+	struct i965_driver_data *i965 = i965_driver_data(ctx);
+	VASliceParameterBufferH264 *slice_param;
+	int i, j, ring = gen7_mfd_context->bsd_ring;
+
+	if (ring < 0)
+		return;
+
+	/* the short format doesn't tell the slice types */
+	if (i965->intel.decode_spread_intra &&
+		gen7_mfd_context->decoder_format_mode == MFX_LONG_MODE) {
+		for (j = 0; j < decode_state->num_slice_params; j++) {
+			slice_param = (VASliceParameterBufferH264 *)decode_state->slice_params[j]->buffer;
+
+			for (i = 0; i < decode_state->slice_params[j]->num_elements; i++) {
+				if (slice_param[i].slice_type != SLICE_TYPE_I &&
+					slice_param[i].slice_type != SLICE_TYPE_SI)
+					break;
+			}
+
+			if (i < decode_state->slice_params[j]->num_elements)
+				break;
+		}
+
+		if (j == decode_state->num_slice_params) {
+			ring = intel_bsd_scheduler_pick(&i965->intel.bsd_scheduler,
+											intel_bsd_scheduler_now());
+			if (ring < 0 || ring >= GEN7_MFD_PICTURE_SLOTS)
+				ring = gen7_mfd_context->bsd_ring;
+		}
+	}
+
+	gen8_mfd_switch_picture_slot(gen7_mfd_context, ring);
 }
 
 static void
@@ -937,17 +1039,20 @@ gen8_mfd_avc_decode_picture(VADriverContextP ctx,
 							struct decode_state *decode_state,
 							struct gen7_mfd_context *gen7_mfd_context)
 {
-	struct intel_batchbuffer *batch = gen7_mfd_context->base.batch;
+	struct intel_batchbuffer *batch;
 	VAPictureParameterBufferH264 *pic_param;
 	VASliceParameterBufferH264 *slice_param, *next_slice_param, *next_slice_group_param;
 	dri_bo *slice_data_bo;
 	int i, j;
 
+	gen8_mfd_avc_picture_slot(ctx, decode_state, gen7_mfd_context);
+	batch = gen7_mfd_context->base.batch;
+
 	assert(decode_state->pic_param && decode_state->pic_param->buffer);
 	pic_param = (VAPictureParameterBufferH264 *)decode_state->pic_param->buffer;
 	gen8_mfd_avc_decode_init(ctx, decode_state, gen7_mfd_context);
 
-	intel_batchbuffer_start_atomic_bcs(batch, 0x1000);
+	gen8_mfd_start_atomic(ctx, decode_state, gen7_mfd_context);
 	intel_batchbuffer_emit_mi_flush(batch);
 	gen8_mfd_pipe_mode_select(ctx, decode_state, MFX_FORMAT_AVC, gen7_mfd_context);
 	gen8_mfd_surface_state(ctx, decode_state, MFX_FORMAT_AVC, gen7_mfd_context);
@@ -993,8 +1098,9 @@ gen8_mfd_avc_decode_picture(VADriverContextP ctx,
 		}
 	}
 
+	intel_batchbuffer_end_stage(batch, INTEL_GPU_STAGE_DECODE);
 	intel_batchbuffer_end_atomic(batch);
-	intel_batchbuffer_flush(batch);
+	intel_batchbuffer_end_frame(batch);
 }
 
 static void
@@ -1215,7 +1321,7 @@ gen8_mfd_mpeg2_decode_picture(VADriverContextP ctx,
 	pic_param = (VAPictureParameterBufferMPEG2 *)decode_state->pic_param->buffer;
 
 	gen8_mfd_mpeg2_decode_init(ctx, decode_state, gen7_mfd_context);
-	intel_batchbuffer_start_atomic_bcs(batch, 0x1000);
+	gen8_mfd_start_atomic(ctx, decode_state, gen7_mfd_context);
 	intel_batchbuffer_emit_mi_flush(batch);
 	gen8_mfd_pipe_mode_select(ctx, decode_state, MFX_FORMAT_MPEG2, gen7_mfd_context);
 	gen8_mfd_surface_state(ctx, decode_state, MFX_FORMAT_MPEG2, gen7_mfd_context);
@@ -1252,8 +1358,9 @@ gen8_mfd_mpeg2_decode_picture(VADriverContextP ctx,
 		}
 	}
 
+	intel_batchbuffer_end_stage(batch, INTEL_GPU_STAGE_DECODE);
 	intel_batchbuffer_end_atomic(batch);
-	intel_batchbuffer_flush(batch);
+	intel_batchbuffer_end_frame(batch);
 }
 
 static const int va_to_gen7_vc1_mv[4] = {
@@ -1595,14 +1702,11 @@ gen8_mfd_vc1_decode_init(VADriverContextP ctx,
 		gen7_mfd_context->bitplane_read_buffer.valid = 1;
 	else
 		gen7_mfd_context->bitplane_read_buffer.valid = !!(pic_param->bitplane_present.value & 0x7f);
-	dri_bo_unreference(gen7_mfd_context->bitplane_read_buffer.bo);
 
 	if (gen7_mfd_context->bitplane_read_buffer.valid) {
 		int width_in_mbs = ALIGN(pic_param->coded_width, 16) / 16;
 		int height_in_mbs;
-		int bitplane_width = ALIGN(width_in_mbs, 2) / 2;
-		int src_w, src_h;
-		uint8_t *src = NULL, *dst = NULL;
+		uint8_t *src = NULL;
 
 		if (!pic_param->sequence_fields.bits.interlace ||
 			(pic_param->picture_fields.bits.frame_coding_mode < 2)) /* Progressive or Frame-Interlace */
@@ -1610,60 +1714,14 @@ gen8_mfd_vc1_decode_init(VADriverContextP ctx,
 		else /* Field-Interlace */
 			height_in_mbs = ALIGN(pic_param->coded_height, 32) / 32;
 
-		bo = dri_bo_alloc(i965->intel.bufmgr,
-						  "VC-1 Bitplane",
-						  bitplane_width * height_in_mbs,
-						  0x1000);
-		assert(bo);
-		gen7_mfd_context->bitplane_read_buffer.bo = bo;
-
-		dri_bo_map(bo, True);
-		assert(bo->virtual);
-		dst = bo->virtual;
-
-		if (picture_type == GEN7_VC1_SKIPPED_PICTURE) {
-			for (src_h = 0; src_h < height_in_mbs; src_h++) {
-				for (src_w = 0; src_w < width_in_mbs; src_w++) {
-					int dst_index;
-					uint8_t src_value = 0x2;
-
-					dst_index = src_w / 2;
-					dst[dst_index] = ((dst[dst_index] >> 4) | (src_value << 4));
-				}
-
-				if (src_w & 1)
-					dst[src_w / 2] >>= 4;
-
-				dst += bitplane_width;
-			}
-		} else {
+		if (picture_type != GEN7_VC1_SKIPPED_PICTURE) {
 			assert(decode_state->bit_plane->buffer);
 			src = decode_state->bit_plane->buffer;
-
-			for (src_h = 0; src_h < height_in_mbs; src_h++) {
-				for (src_w = 0; src_w < width_in_mbs; src_w++) {
-					int src_index, dst_index;
-					int src_shift;
-					uint8_t src_value;
-
-					src_index = (src_h * width_in_mbs + src_w) / 2;
-					src_shift = !((src_h * width_in_mbs + src_w) & 1) * 4;
-					src_value = ((src[src_index] >> src_shift) & 0xf);
-
-					dst_index = src_w / 2;
-					dst[dst_index] = ((dst[dst_index] >> 4) | (src_value << 4));
-				}
-
-				if (src_w & 1)
-					dst[src_w / 2] >>= 4;
-
-				dst += bitplane_width;
-			}
 		}
 
-		dri_bo_unmap(bo);
-	} else
-		gen7_mfd_context->bitplane_read_buffer.bo = NULL;
+		intel_update_vc1_bitplane_buffer(ctx, &gen7_mfd_context->bitplane_read_buffer,
+										 src, width_in_mbs, height_in_mbs);
+	}
 }
 
 static void
@@ -2325,7 +2383,7 @@ gen8_mfd_vc1_decode_picture(VADriverContextP ctx,
 	pic_param = (VAPictureParameterBufferVC1 *)decode_state->pic_param->buffer;
 
 	gen8_mfd_vc1_decode_init(ctx, decode_state, gen7_mfd_context);
-	intel_batchbuffer_start_atomic_bcs(batch, 0x1000);
+	gen8_mfd_start_atomic(ctx, decode_state, gen7_mfd_context);
 	intel_batchbuffer_emit_mi_flush(batch);
 	gen8_mfd_pipe_mode_select(ctx, decode_state, MFX_FORMAT_VC1, gen7_mfd_context);
 	gen8_mfd_surface_state(ctx, decode_state, MFX_FORMAT_VC1, gen7_mfd_context);
@@ -2359,8 +2417,9 @@ gen8_mfd_vc1_decode_picture(VADriverContextP ctx,
 		}
 	}
 
+	intel_batchbuffer_end_stage(batch, INTEL_GPU_STAGE_DECODE);
 	intel_batchbuffer_end_atomic(batch);
-	intel_batchbuffer_flush(batch);
+	intel_batchbuffer_end_frame(batch);
 }
 
 static void
@@ -3110,7 +3169,7 @@ gen8_mfd_jpeg_decode_picture(VADriverContextP ctx,
 
 	/* Currently only support Baseline DCT */
 	gen8_mfd_jpeg_decode_init(ctx, decode_state, gen7_mfd_context);
-	intel_batchbuffer_start_atomic_bcs(batch, 0x1000);
+	gen8_mfd_start_atomic(ctx, decode_state, gen7_mfd_context);
 #ifdef JPEG_WA
 	gen8_mfd_jpeg_wa(ctx, gen7_mfd_context);
 #endif
@@ -3181,8 +3240,9 @@ gen8_mfd_jpeg_decode_picture(VADriverContextP ctx,
 		}
 	}
 
+	intel_batchbuffer_end_stage(batch, INTEL_GPU_STAGE_DECODE);
 	intel_batchbuffer_end_atomic(batch);
-	intel_batchbuffer_flush(batch);
+	intel_batchbuffer_end_frame(batch);
 }
 
 static const int vp8_dc_qlookup[128] = {
@@ -3530,7 +3590,7 @@ gen8_mfd_vp8_decode_picture(VADriverContextP ctx,
 	slice_data_bo = decode_state->slice_datas[0]->bo;
 
 	gen8_mfd_vp8_decode_init(ctx, decode_state, gen7_mfd_context);
-	intel_batchbuffer_start_atomic_bcs(batch, 0x1000);
+	gen8_mfd_start_atomic(ctx, decode_state, gen7_mfd_context);
 	intel_batchbuffer_emit_mi_flush(batch);
 	gen8_mfd_pipe_mode_select(ctx, decode_state, MFX_FORMAT_VP8, gen7_mfd_context);
 	gen8_mfd_surface_state(ctx, decode_state, MFX_FORMAT_VP8, gen7_mfd_context);
@@ -3539,8 +3599,9 @@ gen8_mfd_vp8_decode_picture(VADriverContextP ctx,
 	gen8_mfd_ind_obj_base_addr_state(ctx, slice_data_bo, MFX_FORMAT_VP8, gen7_mfd_context);
 	gen8_mfd_vp8_pic_state(ctx, decode_state, gen7_mfd_context);
 	gen8_mfd_vp8_bsd_object(ctx, pic_param, slice_param, slice_data_bo, gen7_mfd_context);
+	intel_batchbuffer_end_stage(batch, INTEL_GPU_STAGE_DECODE);
 	intel_batchbuffer_end_atomic(batch);
-	intel_batchbuffer_flush(batch);
+	intel_batchbuffer_end_frame(batch);
 }
 
 static VAStatus
@@ -3607,6 +3668,7 @@ gen8_mfd_context_destroy(void *hw_context)
 {
 	VADriverContextP ctx;
 	struct gen7_mfd_context *gen7_mfd_context = (struct gen7_mfd_context *)hw_context;
+	int i;
 
 	ctx = (VADriverContextP)(gen7_mfd_context->driver_context);
 
@@ -3643,6 +3705,21 @@ gen8_mfd_context_destroy(void *hw_context)
 		gen7_mfd_context->jpeg_wa_surface_object = NULL;
 	}
 
+	for (i = 0; i < GEN7_MFD_PICTURE_SLOTS; i++) {
+		struct gen7_mfd_picture_slot *slot = &gen7_mfd_context->picture_slots[i];
+
+		dri_bo_unreference(slot->intra_row_store_scratch_buffer.bo);
+		dri_bo_unreference(slot->deblocking_filter_row_store_scratch_buffer.bo);
+		dri_bo_unreference(slot->bsd_mpc_row_store_scratch_buffer.bo);
+		dri_bo_unreference(slot->mpr_row_store_scratch_buffer.bo);
+
+		if (slot->batch)
+			intel_batchbuffer_free(slot->batch);
+	}
+
+	intel_bsd_scheduler_unpin(&i965_driver_data(ctx)->intel.bsd_scheduler,
+							  gen7_mfd_context->bsd_ring);
+
 	intel_batchbuffer_free(gen7_mfd_context->base.batch);
 	free(gen7_mfd_context);
 }
@@ -3656,6 +3733,45 @@ static void gen8_mfd_mpeg2_context_init(VADriverContextP ctx,
 	gen7_mfd_context->iq_matrix.mpeg2.load_chroma_non_intra_quantiser_matrix = -1;
 }
 
+/*
+ * The frames of a deferred batch are only submitted later, so the codecs
+ * writing context buffers on the CPU between frames (VC-1 bitplanes) keep
+ * a batch of their own.
+ */
+static bool
+gen8_mfd_can_defer(VAProfile profile)
+{
+	switch (profile) {
+	case VAProfileMPEG2Simple:
+	case VAProfileMPEG2Main:
+	case VAProfileH264ConstrainedBaseline:
+	case VAProfileH264Main:
+	case VAProfileH264High:
+	case VAProfileJPEGBaseline:
+	case VAProfileVP8Version0_3:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+static bool
+gen8_mfd_is_avc(VAProfile profile)
+{
+	switch (profile) {
+	case VAProfileH264ConstrainedBaseline:
+	case VAProfileH264Main:
+	case VAProfileH264High:
+	case VAProfileH264StereoHigh:
+	case VAProfileH264MultiviewHigh:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
 struct hw_context *
 gen8_dec_hw_context_init(VADriverContextP ctx, struct object_config *obj_config)
 {
@@ -3668,7 +3784,6 @@ gen8_dec_hw_context_init(VADriverContextP ctx, struct object_config *obj_config)
 
 	gen7_mfd_context->base.destroy = gen8_mfd_context_destroy;
 	gen7_mfd_context->base.run = gen8_mfd_decode_picture;
-	gen7_mfd_context->base.batch = intel_batchbuffer_new(intel, I915_EXEC_RENDER, 0);
 
 	for (i = 0; i < ARRAY_ELEMS(gen7_mfd_context->reference_surface); i++) {
 		gen7_mfd_context->reference_surface[i].surface_id = VA_INVALID_ID;
@@ -3698,6 +3813,30 @@ gen8_dec_hw_context_init(VADriverContextP ctx, struct object_config *obj_config)
 		break;
 	}
 
+	gen7_mfd_context->bsd_ring = intel_bsd_scheduler_pin(&intel->bsd_scheduler,
+														 intel_bsd_scheduler_now());
+	if (gen7_mfd_context->bsd_ring >= 0)
+		i965_log_debug(ctx, "decode context pinned to BSD ring %d (%u contexts there)\n",
+					   gen7_mfd_context->bsd_ring,
+					   intel->bsd_scheduler.rings[gen7_mfd_context->bsd_ring].num_contexts);
+
+	gen7_mfd_context->picture_slot = MAX(gen7_mfd_context->bsd_ring, 0);
+
+	if (gen8_mfd_can_defer(obj_config->profile))
+		gen7_mfd_context->base.batch = intel_batchbuffer_get_decode_batch(intel,
+																		  gen7_mfd_context->bsd_ring);
+	if (!gen7_mfd_context->base.batch)
+		gen7_mfd_context->base.batch = intel_batchbuffer_new(intel, I915_EXEC_RENDER, 0);
+
+	/* The intra pictures sent to the other rings go into their batches */
+	if (gen7_mfd_context->base.batch->deferred && intel->decode_spread_intra &&
+		gen7_mfd_context->bsd_ring >= 0 && gen8_mfd_is_avc(obj_config->profile)) {
+		for (i = 0; i < intel->bsd_scheduler.num_rings && i < GEN7_MFD_PICTURE_SLOTS; i++) {
+			if (i != gen7_mfd_context->picture_slot)
+				gen7_mfd_context->picture_slots[i].batch = intel_batchbuffer_get_decode_batch(intel, i);
+		}
+	}
+
 	gen7_mfd_context->driver_context = ctx;
 	return (struct hw_context *)gen7_mfd_context;
 }
@@ -1486,6 +1486,7 @@ gen8_pp_object_walker(VADriverContextP ctx,
 	/* Have to execute the batch buffer here becuase MI_BATCH_BUFFER_END
 	 * will cause control to pass back to ring buffer
 	 */
+	intel_batchbuffer_end_stage(batch, INTEL_GPU_STAGE_VPP);
 	intel_batchbuffer_end_atomic(batch);
 	intel_batchbuffer_flush(batch);
 	intel_batchbuffer_start_atomic(batch, 0x1000);
@@ -1498,6 +1499,7 @@ gen8_pp_pipeline_setup(VADriverContextP ctx,
 	struct intel_batchbuffer *batch = pp_context->batch;
 
 	intel_batchbuffer_start_atomic(batch, 0x1000);
+	intel_batchbuffer_begin_stage(batch, INTEL_GPU_STAGE_VPP);
 	intel_batchbuffer_emit_mi_flush(batch);
 	gen6_pp_pipeline_select(ctx, pp_context);
 	gen8_pp_state_base_address(ctx, pp_context);
@@ -1590,9 +1592,9 @@ gen8_post_processing_context_common_init(VADriverContextP ctx,
 										 struct intel_batchbuffer *batch)
 {
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
+	struct i965_kernel_cache_blob blobs[NUM_PP_MODULES];
 	int i, kernel_size;
 	unsigned int kernel_offset, end_offset;
-	unsigned char *kernel_ptr;
 	struct pp_module *pp_module;
 	struct i965_post_processing_context *pp_context = data;
 
@@ -1622,41 +1624,38 @@ gen8_post_processing_context_common_init(VADriverContextP ctx,
 		}
 	}
 
-	pp_context->instruction_state.bo = dri_bo_alloc(i965->intel.bufmgr,
-													"kernel shader",
-													kernel_size,
-													0x1000);
-	if (pp_context->instruction_state.bo == NULL) {
-		WARN_ONCE("failure to allocate the buffer space for kernel shader in VPP\n");
-		return;
-	}
-
-	assert(pp_context->instruction_state.bo);
-
-
 	pp_context->instruction_state.bo_size = kernel_size;
 	pp_context->instruction_state.end_offset = 0;
 	end_offset = 0;
 
-	dri_bo_map(pp_context->instruction_state.bo, 1);
-	kernel_ptr = (unsigned char *)(pp_context->instruction_state.bo->virtual);
-
 	for (i = 0; i < NUM_PP_MODULES; i++) {
 		pp_module = &pp_context->pp_modules[i];
 
 		kernel_offset = ALIGN(end_offset, 64);
 		pp_module->kernel.kernel_offset = kernel_offset;
 
-		if (pp_module->kernel.bin && pp_module->kernel.size) {
+		blobs[i].bin = NULL;
+		blobs[i].size = 0;
+		blobs[i].offset = kernel_offset;
 
-			memcpy(kernel_ptr + kernel_offset, pp_module->kernel.bin, pp_module->kernel.size);
+		if (pp_module->kernel.bin && pp_module->kernel.size) {
+			blobs[i].bin = pp_module->kernel.bin;
+			blobs[i].size = pp_module->kernel.size;
 			end_offset = kernel_offset + pp_module->kernel.size;
 		}
 	}
 
-	pp_context->instruction_state.end_offset = ALIGN(end_offset, 64);
+	/* Every VPP context of the driver instance runs the same kernels */
+	pp_context->instruction_state.bo = i965_kernel_cache_get(&i965->kernel_cache,
+															 "kernel shader",
+															 blobs, NUM_PP_MODULES,
+															 kernel_size);
+	if (pp_context->instruction_state.bo == NULL) {
+		WARN_ONCE("failure to allocate the buffer space for kernel shader in VPP\n");
+		return;
+	}
 
-	dri_bo_unmap(pp_context->instruction_state.bo);
+	pp_context->instruction_state.end_offset = ALIGN(end_offset, 64);
 
 	/* static & inline parameters */
 	pp_context->pp_static_parameter = calloc(sizeof(struct gen7_pp_static_parameter), 1);
@@ -1734,6 +1733,7 @@ gen8_run_kernel_media_object_walker(VADriverContextP ctx,
 		return;
 
 	intel_batchbuffer_start_atomic(batch, 0x1000);
+	intel_batchbuffer_begin_stage(batch, INTEL_GPU_STAGE_VPP);
 
 	intel_batchbuffer_emit_mi_flush(batch);
 
@@ -1741,7 +1741,7 @@ gen8_run_kernel_media_object_walker(VADriverContextP ctx,
 	gen8_gpe_media_object_walker(ctx, gpe_context, batch, param);
 	gen8_gpe_media_state_flush(ctx, gpe_context, batch);
 
-
+	intel_batchbuffer_end_stage(batch, INTEL_GPU_STAGE_VPP);
 	intel_batchbuffer_end_atomic(batch);
 
 	intel_batchbuffer_flush(batch);
@@ -1589,6 +1589,49 @@ gen9_hevc_init_object_walker_26(struct gen9_hevc_encoder_state *priv_state,
 	gen9_hevc_vme_set_scoreboard_26(gpe_context, 0xff, use_hw_scoreboard, scoreboard_type);
 }
 
+static enum intel_gpu_stage
+gen9_hevc_gpu_stage(int media_state)
+{
+	switch (media_state) {
+	case HEVC_ENC_MEDIA_STATE_32X_SCALING:
+	case HEVC_ENC_MEDIA_STATE_16X_SCALING:
+	case HEVC_ENC_MEDIA_STATE_4X_SCALING:
+	case HEVC_ENC_MEDIA_STATE_2X_SCALING:
+	case HEVC_ENC_MEDIA_STATE_2X_4X_SCALING:
+	case HEVC_ENC_MEDIA_STATE_DS_COMBINED:
+		return INTEL_GPU_STAGE_SCALING;
+
+	case HEVC_ENC_MEDIA_STATE_32X_ME:
+	case HEVC_ENC_MEDIA_STATE_16X_ME:
+	case HEVC_ENC_MEDIA_STATE_4X_ME:
+		return INTEL_GPU_STAGE_ME;
+
+	case HEVC_ENC_MEDIA_STATE_BRC_INIT_RESET:
+		return INTEL_GPU_STAGE_BRC_INIT;
+
+	case HEVC_ENC_MEDIA_STATE_BRC_UPDATE:
+	case HEVC_ENC_MEDIA_STATE_HEVC_BRC_LCU_UPDATE:
+		return INTEL_GPU_STAGE_BRC_UPDATE;
+
+	case HEVC_ENC_MEDIA_STATE_ENC_I_FRAME_DIST:
+	case HEVC_ENC_MEDIA_STATE_32x32_PU_MODE_DECISION:
+	case HEVC_ENC_MEDIA_STATE_16x16_PU_SAD:
+	case HEVC_ENC_MEDIA_STATE_16x16_PU_MODE_DECISION:
+	case HEVC_ENC_MEDIA_STATE_8x8_PU:
+	case HEVC_ENC_MEDIA_STATE_8x8_PU_FMODE:
+	case HEVC_ENC_MEDIA_STATE_32x32_B_INTRA_CHECK:
+	case HEVC_ENC_MEDIA_STATE_HEVC_B_MBENC:
+	case HEVC_ENC_MEDIA_STATE_HEVC_I_MBENC:
+		return INTEL_GPU_STAGE_MBENC;
+
+	case HEVC_ENC_MEDIA_STATE_HEVC_B_PAK:
+		return INTEL_GPU_STAGE_PAK;
+
+	default:
+		return INTEL_GPU_STAGE_ENC_KERNEL;
+	}
+}
+
 static void
 gen9_hevc_run_object_walker(VADriverContextP ctx,
 							struct intel_encoder_context *encoder_context,
@@ -1599,6 +1642,7 @@ gen9_hevc_run_object_walker(VADriverContextP ctx,
 	struct intel_batchbuffer *batch = encoder_context->base.batch;
 
 	intel_batchbuffer_start_atomic(batch, 0x1000);
+	intel_batchbuffer_begin_stage(batch, gen9_hevc_gpu_stage(media_state));
 
 	intel_batchbuffer_emit_mi_flush(batch);
 
@@ -1607,6 +1651,7 @@ gen9_hevc_run_object_walker(VADriverContextP ctx,
 	gen8_gpe_media_state_flush(ctx, gpe_context, batch);
 	gen9_gpe_pipeline_end(ctx, gpe_context, batch);
 
+	intel_batchbuffer_end_stage(batch, gen9_hevc_gpu_stage(media_state));
 	intel_batchbuffer_end_atomic(batch);
 
 	intel_batchbuffer_flush(batch);
@@ -1622,6 +1667,7 @@ gen9_hevc_run_object(VADriverContextP ctx,
 	struct intel_batchbuffer *batch = encoder_context->base.batch;
 
 	intel_batchbuffer_start_atomic(batch, 0x1000);
+	intel_batchbuffer_begin_stage(batch, gen9_hevc_gpu_stage(media_state));
 
 	intel_batchbuffer_emit_mi_flush(batch);
 
@@ -1631,6 +1677,7 @@ gen9_hevc_run_object(VADriverContextP ctx,
 
 	gen9_gpe_pipeline_end(ctx, gpe_context, batch);
 
+	intel_batchbuffer_end_stage(batch, gen9_hevc_gpu_stage(media_state));
 	intel_batchbuffer_end_atomic(batch);
 
 	intel_batchbuffer_flush(batch);
@@ -6890,20 +6937,19 @@ gen9_hevc_pak_insert_slice_header(VADriverContextP ctx,
 		VAEncSequenceParameterBufferHEVC *seq_param = (VAEncSequenceParameterBufferHEVC *)encode_state->seq_param_ext->buffer;
 		VAEncPictureParameterBufferHEVC *pic_param = (VAEncPictureParameterBufferHEVC *)encode_state->pic_param_ext->buffer;
 		VAEncSliceParameterBufferHEVC *slice_param = (VAEncSliceParameterBufferHEVC *)encode_state->slice_params_ext[slice_idx]->buffer;
-		unsigned char *slice_header = NULL;
+		unsigned int slice_header[I965_HEADER_BUFFER_SIZE / 4];
 		int slice_header_bits = 0;
 
 		slice_header_bits = build_hevc_slice_header(seq_param,
 													pic_param,
 													slice_param,
-													&slice_header,
+													(unsigned char *)slice_header,
+													sizeof(slice_header),
 													0);
 
-		gen9_hevc_pak_insert_object((unsigned int *)slice_header, slice_header_bits,
+		gen9_hevc_pak_insert_object(slice_header, slice_header_bits,
 									1, 1, 0, 5,
 									batch);
-
-		free(slice_header);
 	} else {
 		param = (VAEncPackedHeaderParameterBuffer *)
 				(encode_state->packed_header_params_ext[start_index]->buffer);
@@ -7242,6 +7288,7 @@ gen9_hevc_pak_pipeline(VADriverContextP ctx,
 	else
 		intel_batchbuffer_start_atomic_bcs(batch, 0x1000);
 
+	intel_batchbuffer_begin_stage(batch, INTEL_GPU_STAGE_PAK);
 	intel_batchbuffer_emit_mi_flush(batch);
 
 	generic_state = (struct generic_enc_codec_state *)pak_context->generic_enc_state;
@@ -7264,6 +7311,7 @@ gen9_hevc_pak_pipeline(VADriverContextP ctx,
 		priv_ctx->res_pak_slice_batch_buffer = NULL;
 	}
 
+	intel_batchbuffer_end_stage(batch, INTEL_GPU_STAGE_PAK);
 	intel_batchbuffer_end_atomic(batch);
 
 	intel_batchbuffer_flush(batch);
@@ -1595,7 +1595,7 @@ intel_hevc_slice_insert_packed_data(VADriverContextP ctx,
 	}
 
 	if (slice_header_index == -1) {
-		unsigned char *slice_header = NULL;
+		unsigned int slice_header[I965_HEADER_BUFFER_SIZE / 4];
 		int slice_header_length_in_bits = 0;
 		VAEncSequenceParameterBufferHEVC *pSequenceParameter = (VAEncSequenceParameterBufferHEVC *)encode_state->seq_param_ext->buffer;
 		VAEncPictureParameterBufferHEVC *pPicParameter = (VAEncPictureParameterBufferHEVC *)encode_state->pic_param_ext->buffer;
@@ -1605,15 +1605,15 @@ intel_hevc_slice_insert_packed_data(VADriverContextP ctx,
 		slice_header_length_in_bits = build_hevc_slice_header(pSequenceParameter,
 															  pPicParameter,
 															  pSliceParameter,
-															  &slice_header,
+															  (unsigned char *)slice_header,
+															  sizeof(slice_header),
 															  0);
 		mfc_context->insert_object(ctx, encoder_context,
-								   (unsigned int *)slice_header,
+								   slice_header,
 								   ALIGN(slice_header_length_in_bits, 32) >> 5,
 								   slice_header_length_in_bits & 0x1f,
 								   5,  /* first 6 bytes are start code + nal unit type */
 								   1, 0, 1, slice_batch);
-		free(slice_header);
 	} else {
 		unsigned int skip_emul_byte_cnt;
 
@@ -101,6 +101,36 @@ gen9_hcpd_init_hevc_surface(VADriverContextP ctx,
 	}
 }
 
+/*
+ * HCP decoding stays on the first ring, the work is accounted there so
+ * that the MFX decode contexts get placed on the other one.
+ */
+static void
+gen9_hcpd_start_atomic(VADriverContextP ctx,
+					   struct decode_state *decode_state,
+					   struct intel_batchbuffer *batch,
+					   unsigned int size)
+{
+	struct i965_driver_data *i965 = i965_driver_data(ctx);
+	struct object_surface *obj_surface = decode_state->render_object;
+
+	intel_batchbuffer_begin_frame(batch);
+
+	/* A picture with many slices may not fit, it must never get split */
+	intel_batchbuffer_grow(batch, size);
+
+	if (!i965->intel.has_bsd2) {
+		intel_batchbuffer_start_atomic_bcs(batch, size);
+	} else {
+		intel_bsd_scheduler_account(&i965->intel.bsd_scheduler, 0,
+									ALIGN(obj_surface->orig_width, 16) / 16 * ALIGN(obj_surface->orig_height, 16) / 16,
+									intel_bsd_scheduler_now());
+		intel_batchbuffer_start_atomic_bcs_override(batch, size, BSD_RING0);
+	}
+
+	intel_batchbuffer_begin_stage(batch, INTEL_GPU_STAGE_DECODE);
+}
+
 static VAStatus
 gen9_hcpd_hevc_decode_init(VADriverContextP ctx,
 						   struct decode_state *decode_state,
@@ -650,42 +680,77 @@ gen9_hcpd_get_reference_picture_frame_id(VAPictureHEVC *ref_pic,
 	return 0;
 }
 
+/* The slots of the slice level state packets in hevc_state_dedup */
+enum {
+	GEN9_HCPD_STATE_REF_IDX = 0,                /* one per list */
+	GEN9_HCPD_STATE_WEIGHTOFFSET = 2,           /* one per list */
+};
+
+/*
+ * Per slice dwords of the ref idx packet and the worst case of all the
+ * packets of a slice and of a slice group, used to size the batch.
+ */
+#define GEN9_HCPD_REF_IDX_STATE_SIZE        18
+#define GEN9_HCPD_WEIGHTOFFSET_STATE_SIZE   34
+#define GEN9_HCPD_SLICE_MAX_DWORDS          (9 + 2 * GEN9_HCPD_REF_IDX_STATE_SIZE + \
+											 2 * GEN9_HCPD_WEIGHTOFFSET_STATE_SIZE + 3)
+#define GEN9_HCPD_SLICE_GROUP_MAX_DWORDS    32
+
+/*
+ * The ref idx entries only depend on the picture, they are worked out once
+ * for all the ReferenceFrames instead of for every slice.
+ */
+static void
+gen9_hcpd_hevc_ref_idx_entries(VAPictureParameterBufferHEVC *pic_param,
+							   struct gen9_hcpd_context *gen9_hcpd_context)
+{
+	VAPictureHEVC *curr_pic = &pic_param->CurrPic;
+	int i;
+
+	for (i = 0; i < ARRAY_ELEMS(gen9_hcpd_context->hevc_ref_idx_entries); i++) {
+		VAPictureHEVC *ref_pic = &pic_param->ReferenceFrames[i];
+		int frame_id = gen9_hcpd_get_reference_picture_frame_id(ref_pic,
+																 gen9_hcpd_context->reference_surfaces);
+
+		gen9_hcpd_context->hevc_ref_idx_entries[i] =
+			!(ref_pic->flags & VA_PICTURE_HEVC_BOTTOM_FIELD) << 15 |
+			!!(ref_pic->flags & VA_PICTURE_HEVC_FIELD_PIC) << 14 |
+			!!(ref_pic->flags & VA_PICTURE_HEVC_LONG_TERM_REFERENCE) << 13 |
+			0 << 12 |
+			0 << 11 |
+			frame_id << 8 |
+			(CLAMP(-128, 127, curr_pic->pic_order_cnt - ref_pic->pic_order_cnt) & 0xff);
+	}
+}
+
 static void
 gen9_hcpd_ref_idx_state_1(struct intel_batchbuffer *batch,
 						  int list,
-						  VAPictureParameterBufferHEVC *pic_param,
 						  VASliceParameterBufferHEVC *slice_param,
-						  GenFrameStore frame_store[MAX_GEN_HCP_REFERENCE_FRAMES])
+						  struct gen9_hcpd_context *gen9_hcpd_context)
 {
+	uint32_t packet[GEN9_HCPD_REF_IDX_STATE_SIZE];
 	int i;
 	uint8_t num_ref_minus1 = (list ? slice_param->num_ref_idx_l1_active_minus1 : slice_param->num_ref_idx_l0_active_minus1);
 	uint8_t *ref_list = slice_param->RefPicList[list];
 
-	BEGIN_BCS_BATCH(batch, 18);
-
-	OUT_BCS_BATCH(batch, HCP_REF_IDX_STATE | (18 - 2));
-	OUT_BCS_BATCH(batch,
-				  num_ref_minus1 << 1 |
-				  list);
+	packet[0] = HCP_REF_IDX_STATE | (GEN9_HCPD_REF_IDX_STATE_SIZE - 2);
+	packet[1] = num_ref_minus1 << 1 | list;
 
 	for (i = 0; i < 16; i++) {
-		if (i < MIN((num_ref_minus1 + 1), 15)) {
-			VAPictureHEVC *ref_pic = &pic_param->ReferenceFrames[ref_list[i]];
-			VAPictureHEVC *curr_pic = &pic_param->CurrPic;
-
-			OUT_BCS_BATCH(batch,
-						  !(ref_pic->flags & VA_PICTURE_HEVC_BOTTOM_FIELD) << 15 |
-						  !!(ref_pic->flags & VA_PICTURE_HEVC_FIELD_PIC) << 14 |
-						  !!(ref_pic->flags & VA_PICTURE_HEVC_LONG_TERM_REFERENCE) << 13 |
-						  0 << 12 |
-						  0 << 11 |
-						  gen9_hcpd_get_reference_picture_frame_id(ref_pic, frame_store) << 8 |
-						  (CLAMP(-128, 127, curr_pic->pic_order_cnt - ref_pic->pic_order_cnt) & 0xff));
-		} else {
-			OUT_BCS_BATCH(batch, 0);
-		}
+		if (i < MIN((num_ref_minus1 + 1), 15) && ref_list[i] < 15)
+			packet[2 + i] = gen9_hcpd_context->hevc_ref_idx_entries[ref_list[i]];
+		else
+			packet[2 + i] = 0;
 	}
 
+	if (i965_state_dedup_check(&gen9_hcpd_context->hevc_state_dedup,
+							   GEN9_HCPD_STATE_REF_IDX + list,
+							   packet, GEN9_HCPD_REF_IDX_STATE_SIZE))
+		return;
+
+	BEGIN_BCS_BATCH(batch, GEN9_HCPD_REF_IDX_STATE_SIZE);
+	intel_batchbuffer_data(batch, packet, sizeof(packet));
 	ADVANCE_BCS_BATCH(batch);
 }
 
@@ -700,19 +765,21 @@ gen9_hcpd_ref_idx_state(VADriverContextP ctx,
 	if (slice_param->LongSliceFlags.fields.slice_type == HEVC_SLICE_I)
 		return;
 
-	gen9_hcpd_ref_idx_state_1(batch, 0, pic_param, slice_param, gen9_hcpd_context->reference_surfaces);
+	gen9_hcpd_ref_idx_state_1(batch, 0, slice_param, gen9_hcpd_context);
 
 	if (slice_param->LongSliceFlags.fields.slice_type == HEVC_SLICE_P)
 		return;
 
-	gen9_hcpd_ref_idx_state_1(batch, 1, pic_param, slice_param, gen9_hcpd_context->reference_surfaces);
+	gen9_hcpd_ref_idx_state_1(batch, 1, slice_param, gen9_hcpd_context);
 }
 
 static void
 gen9_hcpd_weightoffset_state_1(struct intel_batchbuffer *batch,
 							   int list,
-							   VASliceParameterBufferHEVC *slice_param)
+							   VASliceParameterBufferHEVC *slice_param,
+							   struct gen9_hcpd_context *gen9_hcpd_context)
 {
+	uint32_t packet[GEN9_HCPD_WEIGHTOFFSET_STATE_SIZE];
 	int i;
 	uint8_t num_ref_minus1 = (list == 1) ? slice_param->num_ref_idx_l1_active_minus1 : slice_param->num_ref_idx_l0_active_minus1;
 	int8_t *luma_offset = (list == 1) ? slice_param->luma_offset_l1 : slice_param->luma_offset_l0;
@@ -720,32 +787,30 @@ gen9_hcpd_weightoffset_state_1(struct intel_batchbuffer *batch,
 	int8_t (* chroma_offset)[2] = (list == 1) ? slice_param->ChromaOffsetL1 : slice_param->ChromaOffsetL0;
 	int8_t (* delta_chroma_weight)[2] = (list == 1) ? slice_param->delta_chroma_weight_l1 : slice_param->delta_chroma_weight_l0;
 
-	BEGIN_BCS_BATCH(batch, 34);
-
-	OUT_BCS_BATCH(batch, HCP_WEIGHTOFFSET | (34 - 2));
-	OUT_BCS_BATCH(batch, list);
+	packet[0] = HCP_WEIGHTOFFSET | (GEN9_HCPD_WEIGHTOFFSET_STATE_SIZE - 2);
+	packet[1] = list;
 
 	for (i = 0; i < 16; i++) {
 		if (i < MIN((num_ref_minus1 + 1), 15)) {
-			OUT_BCS_BATCH(batch,
-						  (luma_offset[i] & 0xff) << 8 |
-						  (delta_luma_weight[i] & 0xff));
+			packet[2 + i] = (luma_offset[i] & 0xff) << 8 |
+							(delta_luma_weight[i] & 0xff);
+			packet[18 + i] = (chroma_offset[i][1] & 0xff) << 24 |
+							 (delta_chroma_weight[i][1] & 0xff) << 16 |
+							 (chroma_offset[i][0] & 0xff) << 8 |
+							 (delta_chroma_weight[i][0] & 0xff);
 		} else {
-			OUT_BCS_BATCH(batch, 0);
-		}
-	}
-	for (i = 0; i < 16; i++) {
-		if (i < MIN((num_ref_minus1 + 1), 15)) {
-			OUT_BCS_BATCH(batch,
-						  (chroma_offset[i][1] & 0xff) << 24 |
-						  (delta_chroma_weight[i][1] & 0xff) << 16 |
-						  (chroma_offset[i][0] & 0xff) << 8 |
-						  (delta_chroma_weight[i][0] & 0xff));
-		} else {
-			OUT_BCS_BATCH(batch, 0);
+			packet[2 + i] = 0;
+			packet[18 + i] = 0;
 		}
 	}
 
+	if (i965_state_dedup_check(&gen9_hcpd_context->hevc_state_dedup,
+							   GEN9_HCPD_STATE_WEIGHTOFFSET + list,
+							   packet, GEN9_HCPD_WEIGHTOFFSET_STATE_SIZE))
+		return;
+
+	BEGIN_BCS_BATCH(batch, GEN9_HCPD_WEIGHTOFFSET_STATE_SIZE);
+	intel_batchbuffer_data(batch, packet, sizeof(packet));
 	ADVANCE_BCS_BATCH(batch);
 }
 
@@ -766,12 +831,12 @@ gen9_hcpd_weightoffset_state(VADriverContextP ctx,
 		 !pic_param->pic_fields.bits.weighted_bipred_flag))
 		return;
 
-	gen9_hcpd_weightoffset_state_1(batch, 0, slice_param);
+	gen9_hcpd_weightoffset_state_1(batch, 0, slice_param, gen9_hcpd_context);
 
 	if (slice_param->LongSliceFlags.fields.slice_type == HEVC_SLICE_P)
 		return;
 
-	gen9_hcpd_weightoffset_state_1(batch, 1, slice_param);
+	gen9_hcpd_weightoffset_state_1(batch, 1, slice_param, gen9_hcpd_context);
 }
 
 static int
@@ -977,6 +1042,7 @@ gen9_hcpd_hevc_decode_picture(VADriverContextP ctx,
 	VAPictureParameterBufferHEVC *pic_param;
 	VASliceParameterBufferHEVC *slice_param, *next_slice_param, *next_slice_group_param;
 	dri_bo *slice_data_bo;
+	unsigned int batch_size;
 	int i, j;
 
 	vaStatus = gen9_hcpd_hevc_decode_init(ctx, decode_state, gen9_hcpd_context);
@@ -987,10 +1053,17 @@ gen9_hcpd_hevc_decode_picture(VADriverContextP ctx,
 	assert(decode_state->pic_param && decode_state->pic_param->buffer);
 	pic_param = (VAPictureParameterBufferHEVC *)decode_state->pic_param->buffer;
 
-	if (i965->intel.has_bsd2)
-		intel_batchbuffer_start_atomic_bcs_override(batch, 0x1000, BSD_RING0);
-	else
-		intel_batchbuffer_start_atomic_bcs(batch, 0x1000);
+	/* Room for the worst case of every slice, a picture never gets split */
+	batch_size = 0x1000;
+	for (j = 0; j < decode_state->num_slice_params; j++) {
+		batch_size += GEN9_HCPD_SLICE_GROUP_MAX_DWORDS * 4;
+		batch_size += decode_state->slice_params[j]->num_elements * GEN9_HCPD_SLICE_MAX_DWORDS * 4;
+	}
+
+	gen9_hcpd_hevc_ref_idx_entries(pic_param, gen9_hcpd_context);
+	i965_state_dedup_reset(&gen9_hcpd_context->hevc_state_dedup);
+
+	gen9_hcpd_start_atomic(ctx, decode_state, batch, batch_size);
 	intel_batchbuffer_emit_mi_flush(batch);
 
 	gen9_hcpd_pipe_mode_select(ctx, decode_state, HCP_CODEC_HEVC, gen9_hcpd_context);
@@ -1032,8 +1105,9 @@ gen9_hcpd_hevc_decode_picture(VADriverContextP ctx,
 		}
 	}
 
+	intel_batchbuffer_end_stage(batch, INTEL_GPU_STAGE_DECODE);
 	intel_batchbuffer_end_atomic(batch);
-	intel_batchbuffer_flush(batch);
+	intel_batchbuffer_end_frame(batch);
 
 out:
 	return vaStatus;
@@ -1077,6 +1151,47 @@ out:
 		gen_buffer->frame_height = height;                      \
 	} while (0)
 
+/*
+ * The row store, segment ID and MV buffers are kept across frames, sized
+ * for the largest frame seen so far or announced at vaCreateContext(), so
+ * the frequent resolution switches of SVC and WebRTC streams don't
+ * reallocate them.
+ */
+#define VP9_ENSURE_GEN_BUFFER(gen_buffer, string, size) do {   \
+		if (!(gen_buffer)->bo || (gen_buffer)->bo->size < (size)) \
+			ALLOC_GEN_BUFFER(gen_buffer, string, size);        \
+	} while (0)
+
+/*
+ * Zeroes the part of the segment ID buffer used by the current frame with
+ * the blitter. The decode batch that follows waits for it through the
+ * implicit sync on the BO, so the CPU never touches the pages.
+ */
+static void
+vp9_clear_segment_id_buffer(VADriverContextP ctx,
+							struct gen9_hcpd_context *gen9_hcpd_context)
+{
+	struct intel_batchbuffer *batch = gen9_hcpd_context->base.batch;
+	/* 64 bytes per CTB, one row of CTBs per blitter row */
+	unsigned int pitch = gen9_hcpd_context->picture_width_in_ctbs << 6;
+	unsigned int height = gen9_hcpd_context->picture_height_in_ctbs;
+
+	intel_batchbuffer_start_atomic_blt(batch, 28);
+	BEGIN_BLT_BATCH(batch, 7);
+
+	OUT_BATCH(batch, GEN8_XY_COLOR_BLT_CMD);
+	OUT_BATCH(batch, (0xf0 << 16) | BR13_8 | pitch);
+	OUT_BATCH(batch, 0 << 16 | 0);
+	OUT_BATCH(batch, height << 16 | pitch);
+	OUT_RELOC64(batch, gen9_hcpd_context->vp9_segment_id_buffer.bo,
+				I915_GEM_DOMAIN_RENDER, I915_GEM_DOMAIN_RENDER,
+				0);
+	OUT_BATCH(batch, 0);
+
+	ADVANCE_BATCH(batch);
+	intel_batchbuffer_end_atomic(batch);
+}
+
 static void
 vp9_update_segmentId_buffer(VADriverContextP ctx,
 							struct decode_state *decode_state,
@@ -1090,11 +1205,9 @@ vp9_update_segmentId_buffer(VADriverContextP ctx,
 	assert(decode_state->pic_param && decode_state->pic_param->buffer);
 	pic_param = (VADecPictureParameterBufferVP9 *)decode_state->pic_param->buffer;
 
-	size = gen9_hcpd_context->picture_width_in_ctbs * gen9_hcpd_context->picture_height_in_ctbs * 1 ;
+	size = gen9_hcpd_context->vp9_buffer_width_in_ctbs * gen9_hcpd_context->vp9_buffer_height_in_ctbs * 1 ;
 	size <<= 6;
-	if (gen9_hcpd_context->vp9_segment_id_buffer.bo == NULL || pic_param->frame_width > gen9_hcpd_context->last_frame.frame_width || pic_param->frame_height > gen9_hcpd_context->last_frame.frame_height) {
-		ALLOC_GEN_BUFFER((&gen9_hcpd_context->vp9_segment_id_buffer), "vp9 segment id buffer", size);
-	}
+	VP9_ENSURE_GEN_BUFFER((&gen9_hcpd_context->vp9_segment_id_buffer), "vp9 segment id buffer", size);
 
 	is_scaling = (pic_param->frame_width != gen9_hcpd_context->last_frame.frame_width) || (pic_param->frame_height != gen9_hcpd_context->last_frame.frame_height);
 
@@ -1103,9 +1216,15 @@ vp9_update_segmentId_buffer(VADriverContextP ctx,
 		pic_param->pic_fields.bits.intra_only || is_scaling) {
 
 		//VP9 Segment ID buffer needs to be zero
-		dri_bo_map(gen9_hcpd_context->vp9_segment_id_buffer.bo, 1);
-		memset((unsigned char *)gen9_hcpd_context->vp9_segment_id_buffer.bo->virtual, 0, size);
-		dri_bo_unmap(gen9_hcpd_context->vp9_segment_id_buffer.bo);
+		if (i965->intel.has_blt) {
+			vp9_clear_segment_id_buffer(ctx, gen9_hcpd_context);
+		} else {
+			size = gen9_hcpd_context->picture_width_in_ctbs * gen9_hcpd_context->picture_height_in_ctbs;
+			size <<= 6;
+			dri_bo_map(gen9_hcpd_context->vp9_segment_id_buffer.bo, 1);
+			memset((unsigned char *)gen9_hcpd_context->vp9_segment_id_buffer.bo->virtual, 0, size);
+			dri_bo_unmap(gen9_hcpd_context->vp9_segment_id_buffer.bo);
+		}
 	}
 }
 
@@ -1121,9 +1240,9 @@ vp9_update_mv_temporal_buffer(VADriverContextP ctx,
 	assert(decode_state->pic_param && decode_state->pic_param->buffer);
 	pic_param = (VADecPictureParameterBufferVP9 *)decode_state->pic_param->buffer;
 
-	size = gen9_hcpd_context->picture_width_in_ctbs * gen9_hcpd_context->picture_height_in_ctbs * 9 ;
+	size = gen9_hcpd_context->vp9_buffer_width_in_ctbs * gen9_hcpd_context->vp9_buffer_height_in_ctbs * 9 ;
 	size <<= 6; //CL aligned
-	if (gen9_hcpd_context->vp9_mv_temporal_buffer_curr.bo == NULL || pic_param->frame_width > gen9_hcpd_context->vp9_mv_temporal_buffer_curr.frame_width || pic_param->frame_height > gen9_hcpd_context->vp9_mv_temporal_buffer_curr.frame_height) {
+	if (gen9_hcpd_context->vp9_mv_temporal_buffer_curr.bo == NULL || gen9_hcpd_context->vp9_mv_temporal_buffer_curr.bo->size < size) {
 		ALLOC_MV_BUFFER((&gen9_hcpd_context->vp9_mv_temporal_buffer_curr), "vp9 curr mv temporal buffer", size, pic_param->frame_width, pic_param->frame_height);
 	}
 	if (gen9_hcpd_context->vp9_mv_temporal_buffer_last.bo == NULL) {
@@ -1136,57 +1255,60 @@ static void
 vp9_gen_default_probabilities(VADriverContextP ctx, struct gen9_hcpd_context *gen9_hcpd_context)
 {
 	int i = 0;
-	uint32_t size = 0;
-
-	size = sizeof(FRAME_CONTEXT);
-	memset(&gen9_hcpd_context->vp9_fc_key_default, 0, size);
-	memset(&gen9_hcpd_context->vp9_fc_inter_default, 0, size);
-	memset(&gen9_hcpd_context->vp9_frame_ctx, 0, size * FRAME_CONTEXTS);
-	//more code to come here below
-
-	//1. key default
-	gen9_hcpd_context->vp9_fc_key_default.tx_probs = default_tx_probs;
-	//dummy 52
-	vp9_copy(gen9_hcpd_context->vp9_fc_key_default.coeff_probs4x4, default_coef_probs_4x4);
-	vp9_copy(gen9_hcpd_context->vp9_fc_key_default.coeff_probs8x8, default_coef_probs_8x8);
-	vp9_copy(gen9_hcpd_context->vp9_fc_key_default.coeff_probs16x16, default_coef_probs_16x16);
-	vp9_copy(gen9_hcpd_context->vp9_fc_key_default.coeff_probs32x32, default_coef_probs_32x32);
-	//dummy 16
-	vp9_copy(gen9_hcpd_context->vp9_fc_key_default.skip_probs, default_skip_probs);
-	vp9_copy(gen9_hcpd_context->vp9_fc_key_default.partition_prob, vp9_kf_partition_probs);
-	//dummy 47
-	vp9_copy(gen9_hcpd_context->vp9_fc_key_default.uv_mode_prob, vp9_kf_uv_mode_prob);
-	vp9_copy(gen9_hcpd_context->vp9_fc_key_default.seg_tree_probs, default_seg_tree_probs);
-	vp9_copy(gen9_hcpd_context->vp9_fc_key_default.seg_pred_probs, default_seg_pred_probs);
-
-	//2. inter default
-	gen9_hcpd_context->vp9_fc_inter_default.tx_probs = default_tx_probs;
-	//dummy 52
-	vp9_copy(gen9_hcpd_context->vp9_fc_inter_default.coeff_probs4x4, default_coef_probs_4x4);
-	vp9_copy(gen9_hcpd_context->vp9_fc_inter_default.coeff_probs8x8, default_coef_probs_8x8);
-	vp9_copy(gen9_hcpd_context->vp9_fc_inter_default.coeff_probs16x16, default_coef_probs_16x16);
-	vp9_copy(gen9_hcpd_context->vp9_fc_inter_default.coeff_probs32x32, default_coef_probs_32x32);
-	//dummy 16
-	vp9_copy(gen9_hcpd_context->vp9_fc_inter_default.skip_probs, default_skip_probs);
-	vp9_copy(gen9_hcpd_context->vp9_fc_inter_default.inter_mode_probs, default_inter_mode_probs);
-	vp9_copy(gen9_hcpd_context->vp9_fc_inter_default.switchable_interp_prob, default_switchable_interp_prob);
-	vp9_copy(gen9_hcpd_context->vp9_fc_inter_default.intra_inter_prob, default_intra_inter_p);
-	vp9_copy(gen9_hcpd_context->vp9_fc_inter_default.comp_inter_prob, default_comp_inter_p);
-	vp9_copy(gen9_hcpd_context->vp9_fc_inter_default.single_ref_prob, default_single_ref_p);
-	vp9_copy(gen9_hcpd_context->vp9_fc_inter_default.comp_ref_prob, default_comp_ref_p);
-	vp9_copy(gen9_hcpd_context->vp9_fc_inter_default.y_mode_prob, default_if_y_probs);
-	vp9_copy(gen9_hcpd_context->vp9_fc_inter_default.partition_prob, default_partition_probs);
-	gen9_hcpd_context->vp9_fc_inter_default.nmvc = default_nmv_context;
-	//dummy 47
-	vp9_copy(gen9_hcpd_context->vp9_fc_inter_default.uv_mode_prob, default_if_uv_probs);
-	vp9_copy(gen9_hcpd_context->vp9_fc_inter_default.seg_tree_probs, default_seg_tree_probs);
-	vp9_copy(gen9_hcpd_context->vp9_fc_inter_default.seg_pred_probs, default_seg_pred_probs);
+
+	gen9_hcpd_context->vp9_fc_key_default = intel_vp9_default_frame_context(true);
+	gen9_hcpd_context->vp9_fc_inter_default = intel_vp9_default_frame_context(false);
 
 	for (i = 0; i < FRAME_CONTEXTS; i++) {
-		gen9_hcpd_context->vp9_frame_ctx[i] = gen9_hcpd_context->vp9_fc_inter_default;
+		gen9_hcpd_context->vp9_frame_ctx[i] = *gen9_hcpd_context->vp9_fc_inter_default;
 	}
 }
 
+/*
+ * The probability buffer of a frame is read back when the next one starts,
+ * so each frame takes the next BO of a small ring instead of a new one,
+ * skipping those still in flight so that filling it never waits.
+ */
+static void
+vp9_next_probability_buffer(VADriverContextP ctx,
+							struct gen9_hcpd_context *gen9_hcpd_context)
+{
+	struct i965_driver_data *i965 = i965_driver_data(ctx);
+	dri_bo **ring = gen9_hcpd_context->vp9_probability_ring;
+	int i, index = 0;
+
+	for (i = 0; i < GEN9_VP9_PROB_RING_SIZE; i++) {
+		index = (gen9_hcpd_context->vp9_probability_ring_next + i) % GEN9_VP9_PROB_RING_SIZE;
+
+		if (!ring[index] ||
+			(ring[index] != gen9_hcpd_context->last_frame.prob_buffer_bo &&
+			 !drm_intel_bo_busy(ring[index])))
+			break;
+	}
+
+	/* All in use, the oldest one is replaced and freed once the GPU is done */
+	if (i == GEN9_VP9_PROB_RING_SIZE) {
+		index = gen9_hcpd_context->vp9_probability_ring_next;
+		dri_bo_unreference(ring[index]);
+		ring[index] = NULL;
+	}
+
+	if (!ring[index]) {
+		ring[index] = dri_bo_alloc(i965->intel.bufmgr,
+								   "vp9 probability buffer",
+								   32 << 6,
+								   0x1000);
+		assert(ring[index]);
+	}
+
+	gen9_hcpd_context->vp9_probability_ring_next = (index + 1) % GEN9_VP9_PROB_RING_SIZE;
+
+	dri_bo_unreference(gen9_hcpd_context->vp9_probability_buffer.bo);
+	gen9_hcpd_context->vp9_probability_buffer.bo = ring[index];
+	dri_bo_reference(ring[index]);
+	gen9_hcpd_context->vp9_probability_buffer.valid = 1;
+}
+
 static void
 vp9_update_probabilities(VADriverContextP ctx,
 						 struct decode_state *decode_state,
@@ -1222,13 +1344,13 @@ vp9_update_probabilities(VADriverContextP ctx,
 			pic_param->pic_fields.bits.error_resilient_mode) {
 			//perform full buffer update
 			for (i = 0; i < FRAME_CONTEXTS; i++) {
-				memcpy(&gen9_hcpd_context->vp9_frame_ctx[i], &gen9_hcpd_context->vp9_fc_inter_default, VP9_PROB_BUFFER_FIRST_PART_SIZE);
+				memcpy(&gen9_hcpd_context->vp9_frame_ctx[i], gen9_hcpd_context->vp9_fc_inter_default, VP9_PROB_BUFFER_FIRST_PART_SIZE);
 
 				vp9_copy(gen9_hcpd_context->vp9_frame_ctx[i].seg_tree_probs, default_seg_tree_probs);
 				vp9_copy(gen9_hcpd_context->vp9_frame_ctx[i].seg_pred_probs, default_seg_pred_probs);
 			}
 		} else if (pic_param->pic_fields.bits.reset_frame_context == 2 && pic_param->pic_fields.bits.intra_only) {
-			memcpy(&gen9_hcpd_context->vp9_frame_ctx[pic_param->pic_fields.bits.frame_context_idx], &gen9_hcpd_context->vp9_fc_inter_default, VP9_PROB_BUFFER_FIRST_PART_SIZE);
+			memcpy(&gen9_hcpd_context->vp9_frame_ctx[pic_param->pic_fields.bits.frame_context_idx], gen9_hcpd_context->vp9_fc_inter_default, VP9_PROB_BUFFER_FIRST_PART_SIZE);
 		}
 		pic_param->pic_fields.bits.frame_context_idx = 0;
 	}
@@ -1258,7 +1380,7 @@ vp9_update_probabilities(VADriverContextP ctx,
 		if (pic_param->pic_fields.bits.frame_type == HCP_VP9_KEY_FRAME ||
 			pic_param->pic_fields.bits.intra_only) {
 			memcpy(pprob + VP9_PROB_BUFFER_FIRST_PART_SIZE - VP9_PROB_BUFFER_KEY_INTER_SIZE
-				   , gen9_hcpd_context->vp9_fc_key_default.inter_mode_probs
+				   , gen9_hcpd_context->vp9_fc_key_default->inter_mode_probs
 				   , VP9_PROB_BUFFER_KEY_INTER_SIZE);
 		}
 
@@ -1292,6 +1414,23 @@ gen9_hcpd_init_vp9_surface(VADriverContextP ctx,
 
 }
 
+static void
+vp9_update_buffer_size(struct decode_state *decode_state,
+					   struct gen9_hcpd_context *gen9_hcpd_context)
+{
+	const int ctb_size = gen9_hcpd_context->ctb_size;
+	int width_in_ctbs = ALIGN(decode_state->picture_width, ctb_size) / ctb_size;
+	int height_in_ctbs = ALIGN(decode_state->picture_height, ctb_size) / ctb_size;
+
+	width_in_ctbs = MAX(width_in_ctbs, gen9_hcpd_context->picture_width_in_ctbs);
+	height_in_ctbs = MAX(height_in_ctbs, gen9_hcpd_context->picture_height_in_ctbs);
+
+	gen9_hcpd_context->vp9_buffer_width_in_ctbs = MAX(gen9_hcpd_context->vp9_buffer_width_in_ctbs,
+													  width_in_ctbs);
+	gen9_hcpd_context->vp9_buffer_height_in_ctbs = MAX(gen9_hcpd_context->vp9_buffer_height_in_ctbs,
+													   height_in_ctbs);
+}
+
 static VAStatus
 gen9_hcpd_vp9_decode_init(VADriverContextP ctx,
 						  struct decode_state *decode_state,
@@ -1357,38 +1496,38 @@ gen9_hcpd_vp9_decode_init(VADriverContextP ctx,
 
 	gen9_hcpd_init_vp9_surface(ctx, pic_param, obj_surface, gen9_hcpd_context);
 
+	vp9_update_buffer_size(decode_state, gen9_hcpd_context);
+
 	if (pic_param->profile >= 2)
-		size = gen9_hcpd_context->picture_width_in_ctbs * 36; //num_width_in_SB * 36
+		size = gen9_hcpd_context->vp9_buffer_width_in_ctbs * 36; //num_width_in_SB * 36
 	else
-		size = gen9_hcpd_context->picture_width_in_ctbs * 18; //num_width_in_SB * 18
+		size = gen9_hcpd_context->vp9_buffer_width_in_ctbs * 18; //num_width_in_SB * 18
 	size <<= 6;
-	ALLOC_GEN_BUFFER((&gen9_hcpd_context->deblocking_filter_line_buffer), "line buffer", size);
-	ALLOC_GEN_BUFFER((&gen9_hcpd_context->deblocking_filter_tile_line_buffer), "tile line buffer", size);
+	VP9_ENSURE_GEN_BUFFER((&gen9_hcpd_context->deblocking_filter_line_buffer), "line buffer", size);
+	VP9_ENSURE_GEN_BUFFER((&gen9_hcpd_context->deblocking_filter_tile_line_buffer), "tile line buffer", size);
 
 	if (pic_param->profile >= 2)
-		size = gen9_hcpd_context->picture_height_in_ctbs * 34; //num_height_in_SB * 17
+		size = gen9_hcpd_context->vp9_buffer_height_in_ctbs * 34; //num_height_in_SB * 17
 	else
-		size = gen9_hcpd_context->picture_height_in_ctbs * 17; //num_height_in_SB * 17
+		size = gen9_hcpd_context->vp9_buffer_height_in_ctbs * 17; //num_height_in_SB * 17
 	size <<= 6;
-	ALLOC_GEN_BUFFER((&gen9_hcpd_context->deblocking_filter_tile_column_buffer), "tile column buffer", size);
+	VP9_ENSURE_GEN_BUFFER((&gen9_hcpd_context->deblocking_filter_tile_column_buffer), "tile column buffer", size);
 
-	size = gen9_hcpd_context->picture_width_in_ctbs * 5; //num_width_in_SB * 5
+	size = gen9_hcpd_context->vp9_buffer_width_in_ctbs * 5; //num_width_in_SB * 5
 	size <<= 6;
-	ALLOC_GEN_BUFFER((&gen9_hcpd_context->metadata_line_buffer), "metadata line buffer", size);
-	ALLOC_GEN_BUFFER((&gen9_hcpd_context->metadata_tile_line_buffer), "metadata tile line buffer", size);
+	VP9_ENSURE_GEN_BUFFER((&gen9_hcpd_context->metadata_line_buffer), "metadata line buffer", size);
+	VP9_ENSURE_GEN_BUFFER((&gen9_hcpd_context->metadata_tile_line_buffer), "metadata tile line buffer", size);
 
-	size = gen9_hcpd_context->picture_height_in_ctbs * 5; //num_height_in_SB * 5
+	size = gen9_hcpd_context->vp9_buffer_height_in_ctbs * 5; //num_height_in_SB * 5
 	size <<= 6;
-	ALLOC_GEN_BUFFER((&gen9_hcpd_context->metadata_tile_column_buffer), "metadata tile column buffer", size);
+	VP9_ENSURE_GEN_BUFFER((&gen9_hcpd_context->metadata_tile_column_buffer), "metadata tile column buffer", size);
 
-	size = gen9_hcpd_context->picture_width_in_ctbs * 1; //num_width_in_SB * 1
+	size = gen9_hcpd_context->vp9_buffer_width_in_ctbs * 1; //num_width_in_SB * 1
 	size <<= 6;
-	ALLOC_GEN_BUFFER((&gen9_hcpd_context->hvd_line_rowstore_buffer), "hvd line rowstore buffer", size);
-	ALLOC_GEN_BUFFER((&gen9_hcpd_context->hvd_tile_rowstore_buffer), "hvd tile rowstore buffer", size);
+	VP9_ENSURE_GEN_BUFFER((&gen9_hcpd_context->hvd_line_rowstore_buffer), "hvd line rowstore buffer", size);
+	VP9_ENSURE_GEN_BUFFER((&gen9_hcpd_context->hvd_tile_rowstore_buffer), "hvd tile rowstore buffer", size);
 
-	size = 32;
-	size <<= 6;
-	ALLOC_GEN_BUFFER((&gen9_hcpd_context->vp9_probability_buffer), "vp9 probability buffer", size);
+	vp9_next_probability_buffer(ctx, gen9_hcpd_context);
 
 	gen9_hcpd_context->first_inter_slice_collocated_ref_idx = 0;
 	gen9_hcpd_context->first_inter_slice_collocated_from_l0_flag = 0;
@@ -1807,10 +1946,7 @@ gen9_hcpd_vp9_decode_picture(VADriverContextP ctx,
 	//Update probability buffer if needed
 	vp9_update_probabilities(ctx, decode_state, gen9_hcpd_context);
 
-	if (i965->intel.has_bsd2)
-		intel_batchbuffer_start_atomic_bcs_override(batch, 0x1000, BSD_RING0);
-	else
-		intel_batchbuffer_start_atomic_bcs(batch, 0x1000);
+	gen9_hcpd_start_atomic(ctx, decode_state, batch, 0x1000);
 	intel_batchbuffer_emit_mi_flush(batch);
 
 	gen9_hcpd_pipe_mode_select(ctx, decode_state, HCP_CODEC_VP9, gen9_hcpd_context);
@@ -1842,8 +1978,9 @@ gen9_hcpd_vp9_decode_picture(VADriverContextP ctx,
 	gen9_hcpd_vp9_pic_state(ctx, decode_state, gen9_hcpd_context);
 	gen9_hcpd_vp9_bsd_object(ctx, pic_param, slice_param, gen9_hcpd_context);
 
+	intel_batchbuffer_end_stage(batch, INTEL_GPU_STAGE_DECODE);
 	intel_batchbuffer_end_atomic(batch);
-	intel_batchbuffer_flush(batch);
+	intel_batchbuffer_end_frame(batch);
 
 	// keep track of the last frame status
 	gen9_hcpd_context->last_frame.frame_width = pic_param->frame_width;
@@ -1919,6 +2056,7 @@ static void
 gen9_hcpd_context_destroy(void *hw_context)
 {
 	struct gen9_hcpd_context *gen9_hcpd_context = (struct gen9_hcpd_context *)hw_context;
+	int i;
 
 	FREE_GEN_BUFFER((&gen9_hcpd_context->deblocking_filter_line_buffer));
 	FREE_GEN_BUFFER((&gen9_hcpd_context->deblocking_filter_tile_line_buffer));
@@ -1932,6 +2070,8 @@ gen9_hcpd_context_destroy(void *hw_context)
 	FREE_GEN_BUFFER((&gen9_hcpd_context->hvd_line_rowstore_buffer));
 	FREE_GEN_BUFFER((&gen9_hcpd_context->hvd_tile_rowstore_buffer));
 	FREE_GEN_BUFFER((&gen9_hcpd_context->vp9_probability_buffer));
+	for (i = 0; i < GEN9_VP9_PROB_RING_SIZE; i++)
+		dri_bo_unreference(gen9_hcpd_context->vp9_probability_ring[i]);
 	FREE_GEN_BUFFER((&gen9_hcpd_context->vp9_segment_id_buffer));
 	dri_bo_unreference(gen9_hcpd_context->vp9_mv_temporal_buffer_curr.bo);
 	dri_bo_unreference(gen9_hcpd_context->vp9_mv_temporal_buffer_last.bo);
@@ -1982,7 +2122,14 @@ gen9_hcpd_context_init(VADriverContextP ctx, struct object_config *object_config
 
 	gen9_hcpd_context->base.destroy = gen9_hcpd_context_destroy;
 	gen9_hcpd_context->base.run = gen9_hcpd_decode_picture;
-	gen9_hcpd_context->base.batch = intel_batchbuffer_new(intel, I915_EXEC_VEBOX, 0);
+
+	/* the VP9 probabilities are written on the CPU between frames, HEVC can defer */
+	if (object_config->profile == VAProfileHEVCMain ||
+		object_config->profile == VAProfileHEVCMain10)
+		gen9_hcpd_context->base.batch = intel_batchbuffer_get_decode_batch(intel,
+																		   intel->has_bsd2 ? 0 : -1);
+	if (!gen9_hcpd_context->base.batch)
+		gen9_hcpd_context->base.batch = intel_batchbuffer_new(intel, I915_EXEC_VEBOX, 0);
 
 	for (i = 0; i < ARRAY_ELEMS(gen9_hcpd_context->reference_surfaces); i++) {
 		gen9_hcpd_context->reference_surfaces[i].surface_id = VA_INVALID_ID;
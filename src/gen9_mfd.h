@@ -34,6 +34,7 @@
 #include <i915_drm.h>
 #include <intel_bufmgr.h>
 #include "i965_decoder.h"
+#include "i965_state_dedup.h"
 #include "vp9_probs.h"
 
 struct hw_context;
@@ -51,6 +52,9 @@ typedef struct vp9_frame_status {
 	dri_bo *prob_buffer_bo;
 } vp9_last_frame_status;
 
+/* Enough for the frame in flight, the one read back and one to fill */
+#define GEN9_VP9_PROB_RING_SIZE 4
+
 typedef struct vp9_mv_temporal_buffer {
 	dri_bo *bo;
 	uint16_t frame_width;
@@ -72,6 +76,9 @@ struct gen9_hcpd_context {
 	uint16_t picture_height_in_ctbs;
 	uint16_t picture_width_in_min_cb_minus1;
 	uint16_t picture_height_in_min_cb_minus1;
+	/* The VP9 buffers are sized for this many CTBs and only ever grow */
+	uint16_t vp9_buffer_width_in_ctbs;
+	uint16_t vp9_buffer_height_in_ctbs;
 	uint8_t ctb_size;
 	uint8_t min_cb_size;
 
@@ -95,10 +102,16 @@ struct gen9_hcpd_context {
 	unsigned short first_inter_slice_collocated_from_l0_flag;
 	int first_inter_slice_valid;
 
+	/* HCP_REF_IDX_STATE entries of the ReferenceFrames of the picture */
+	uint32_t hevc_ref_idx_entries[15];
+	struct i965_state_dedup hevc_state_dedup;
+
 	vp9_last_frame_status last_frame;
 	FRAME_CONTEXT vp9_frame_ctx[FRAME_CONTEXTS];
-	FRAME_CONTEXT vp9_fc_inter_default;
-	FRAME_CONTEXT vp9_fc_key_default;
+	const FRAME_CONTEXT *vp9_fc_inter_default;
+	const FRAME_CONTEXT *vp9_fc_key_default;
+	dri_bo *vp9_probability_ring[GEN9_VP9_PROB_RING_SIZE];
+	int vp9_probability_ring_next;
 };
 
 #endif /* GEN9_MFD_H */
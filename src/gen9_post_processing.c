@@ -454,6 +454,7 @@ gen9_pp_pipeline_setup(VADriverContextP ctx,
 	struct intel_batchbuffer *batch = pp_context->batch;
 
 	intel_batchbuffer_start_atomic(batch, 0x1000);
+	intel_batchbuffer_begin_stage(batch, INTEL_GPU_STAGE_VPP);
 	intel_batchbuffer_emit_mi_flush(batch);
 	gen9_pp_pipeline_select(ctx, pp_context);
 	gen9_pp_state_base_address(ctx, pp_context);
@@ -620,6 +621,7 @@ gen9_run_kernel_media_object_walker(VADriverContextP ctx,
 		return;
 
 	intel_batchbuffer_start_atomic(batch, 0x1000);
+	intel_batchbuffer_begin_stage(batch, INTEL_GPU_STAGE_VPP);
 
 	intel_batchbuffer_emit_mi_flush(batch);
 
@@ -629,6 +631,7 @@ gen9_run_kernel_media_object_walker(VADriverContextP ctx,
 
 	gen9_gpe_pipeline_end(ctx, gpe_context, batch);
 
+	intel_batchbuffer_end_stage(batch, INTEL_GPU_STAGE_VPP);
 	intel_batchbuffer_end_atomic(batch);
 
 	intel_batchbuffer_flush(batch);
@@ -3087,7 +3087,8 @@ gen9_vdenc_mfx_avc_insert_slice_packed_data(VADriverContextP ctx,
 		VAEncSequenceParameterBufferH264 *seq_param = (VAEncSequenceParameterBufferH264 *)encode_state->seq_param_ext->buffer;
 		VAEncPictureParameterBufferH264 *pic_param = (VAEncPictureParameterBufferH264 *)encode_state->pic_param_ext->buffer;
 		VAEncSliceParameterBufferH264 *slice_params = (VAEncSliceParameterBufferH264 *)encode_state->slice_params_ext[slice_index]->buffer;
-		unsigned char *slice_header = NULL, *slice_header1 = NULL;
+		unsigned int slice_header[I965_HEADER_BUFFER_SIZE / 4];
+		unsigned char *slice_header1 = NULL;
 		int slice_header_length_in_bits = 0;
 		uint32_t saved_macroblock_address = 0;
 
@@ -3105,9 +3106,10 @@ gen9_vdenc_mfx_avc_insert_slice_packed_data(VADriverContextP ctx,
 		slice_header_length_in_bits = build_avc_slice_header(seq_param,
 															 pic_param,
 															 slice_params,
-															 &slice_header);
+															 (unsigned char *)slice_header,
+															 sizeof(slice_header));
 
-		slice_header1 = slice_header;
+		slice_header1 = (unsigned char *)slice_header;
 
 		if (slice_index &&
 			(IS_KBL(i965->intel.device_info) ||
@@ -3129,8 +3131,6 @@ gen9_vdenc_mfx_avc_insert_slice_packed_data(VADriverContextP ctx,
 										 5,  /* first 5 bytes are start code + nal unit type */
 										 1, 0, 1,
 										 1);
-
-		free(slice_header);
 	} else {
 		unsigned int skip_emul_byte_cnt;
 		unsigned char *slice_header1 = NULL;
@@ -3708,8 +3708,13 @@ gen9_vdenc_mfx_vdenc_pipeline(VADriverContextP ctx,
 		gen8_gpe_mi_batch_buffer_start(ctx, batch, &mi_batch_buffer_start_params);
 	}
 
-	gen9_vdenc_mfx_avc_qm_state(ctx, encoder_context);
-	gen9_vdenc_mfx_avc_fqm_state(ctx, encoder_context);
+	if (!intel_batchbuffer_replay_record(batch, &vdenc_context->qm_fqm_record, NULL, 0)) {
+		intel_batchbuffer_begin_record(batch, &vdenc_context->qm_fqm_record, NULL, 0,
+									   (4 * 18 + 4 * 34) * 4);
+		gen9_vdenc_mfx_avc_qm_state(ctx, encoder_context);
+		gen9_vdenc_mfx_avc_fqm_state(ctx, encoder_context);
+		intel_batchbuffer_end_record(batch);
+	}
 
 	gen9_vdenc_mfx_vdenc_avc_slices(ctx, encode_state, encoder_context);
 }
@@ -3818,14 +3823,20 @@ gen9_vdenc_avc_encode_picture(VADriverContextP ctx,
 		intel_batchbuffer_emit_mi_flush(batch);
 
 		if (vdenc_context->brc_enabled) {
+			intel_batchbuffer_begin_stage(batch, INTEL_GPU_STAGE_BRC_UPDATE);
+
 			if (!vdenc_context->brc_initted || vdenc_context->brc_need_reset)
 				gen9_vdenc_huc_brc_init_reset(ctx, encode_state, encoder_context);
 
 			gen9_vdenc_huc_brc_update(ctx, encode_state, encoder_context);
 			intel_batchbuffer_emit_mi_flush(batch);
+
+			intel_batchbuffer_end_stage(batch, INTEL_GPU_STAGE_BRC_UPDATE);
 		}
 
+		intel_batchbuffer_begin_stage(batch, INTEL_GPU_STAGE_PAK);
 		gen9_vdenc_mfx_vdenc_pipeline(ctx, encode_state, encoder_context);
+		intel_batchbuffer_end_stage(batch, INTEL_GPU_STAGE_PAK);
 		gen9_vdenc_read_status(ctx, encoder_context);
 
 		intel_batchbuffer_end_atomic(batch);
@@ -3913,6 +3924,7 @@ gen9_vdenc_context_destroy(void *context)
 	struct gen9_vdenc_context *vdenc_context = context;
 
 	gen9_vdenc_free_resources(vdenc_context);
+	intel_batch_record_fini(&vdenc_context->qm_fqm_record);
 
 	free(vdenc_context);
 }
@@ -819,6 +819,9 @@ struct gen9_vdenc_context {
 		uint32_t size;
 		uint32_t bytes_per_frame_offset;
 	} status_bffuer;
+
+	/* The flat QM/FQM state, identical for every frame */
+	struct intel_batch_record qm_fqm_record;
 };
 
 struct huc_pipe_mode_select_parameter {
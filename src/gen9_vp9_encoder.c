@@ -907,6 +907,32 @@ gen9_init_media_object_walker_parameter(struct intel_encoder_context *encoder_co
 	}
 }
 
+static enum intel_gpu_stage
+gen9_vp9_gpu_stage(int media_function)
+{
+	switch (media_function) {
+	case VP9_MEDIA_STATE_32X_SCALING:
+	case VP9_MEDIA_STATE_16X_SCALING:
+	case VP9_MEDIA_STATE_4X_SCALING:
+	case VP9_MEDIA_STATE_DYS:
+		return INTEL_GPU_STAGE_SCALING;
+
+	case VP9_MEDIA_STATE_32X_ME:
+	case VP9_MEDIA_STATE_16X_ME:
+	case VP9_MEDIA_STATE_4X_ME:
+		return INTEL_GPU_STAGE_ME;
+
+	case VP9_MEDIA_STATE_BRC_INIT_RESET:
+		return INTEL_GPU_STAGE_BRC_INIT;
+
+	case VP9_MEDIA_STATE_BRC_UPDATE:
+		return INTEL_GPU_STAGE_BRC_UPDATE;
+
+	default:
+		return INTEL_GPU_STAGE_MBENC;
+	}
+}
+
 static void
 gen9_run_kernel_media_object(VADriverContextP ctx,
 							 struct intel_encoder_context *encoder_context,
@@ -924,6 +950,7 @@ gen9_run_kernel_media_object(VADriverContextP ctx,
 		return;
 
 	intel_batchbuffer_start_atomic(batch, 0x1000);
+	intel_batchbuffer_begin_stage(batch, gen9_vp9_gpu_stage(media_function));
 
 	status_buffer = &(vp9_state->status_buffer);
 	memset(&mi_store_data_imm, 0, sizeof(mi_store_data_imm));
@@ -939,6 +966,7 @@ gen9_run_kernel_media_object(VADriverContextP ctx,
 
 	gen9_gpe_pipeline_end(ctx, gpe_context, batch);
 
+	intel_batchbuffer_end_stage(batch, gen9_vp9_gpu_stage(media_function));
 	intel_batchbuffer_end_atomic(batch);
 
 	intel_batchbuffer_flush(batch);
@@ -961,6 +989,7 @@ gen9_run_kernel_media_object_walker(VADriverContextP ctx,
 		return;
 
 	intel_batchbuffer_start_atomic(batch, 0x1000);
+	intel_batchbuffer_begin_stage(batch, gen9_vp9_gpu_stage(media_function));
 
 	intel_batchbuffer_emit_mi_flush(batch);
 
@@ -977,6 +1006,7 @@ gen9_run_kernel_media_object_walker(VADriverContextP ctx,
 
 	gen9_gpe_pipeline_end(ctx, gpe_context, batch);
 
+	intel_batchbuffer_end_stage(batch, gen9_vp9_gpu_stage(media_function));
 	intel_batchbuffer_end_atomic(batch);
 
 	intel_batchbuffer_flush(batch);
@@ -5530,6 +5560,7 @@ gen9_vp9_pak_pipeline(VADriverContextP ctx,
 	else
 		intel_batchbuffer_start_atomic_bcs(batch, 0x1000);
 
+	intel_batchbuffer_begin_stage(batch, INTEL_GPU_STAGE_PAK);
 	intel_batchbuffer_emit_mi_flush(batch);
 
 	BEGIN_BCS_BATCH(batch, 64);
@@ -5557,6 +5588,7 @@ gen9_vp9_pak_pipeline(VADriverContextP ctx,
 		gen9_vp9_read_mfc_status(ctx, encoder_context);
 	}
 
+	intel_batchbuffer_end_stage(batch, INTEL_GPU_STAGE_PAK);
 	intel_batchbuffer_end_atomic(batch);
 	intel_batchbuffer_flush(batch);
 
@@ -525,6 +525,7 @@ g4x_avc_bsd_object(VADriverContextP ctx,
 
         slice_data_bit_offset = avc_get_first_mb_bit_offset_with_epb(
                                     decode_state->slice_datas[slice_index]->bo,
+                                    decode_state->slice_datas[slice_index]->bo->virtual,
                                     slice_param,
                                     pic_param->pic_fields.bits.entropy_coding_mode_flag
                                 );
@@ -651,6 +652,7 @@ ironlake_avc_bsd_object(VADriverContextP ctx,
 
         slice_data_bit_offset = avc_get_first_mb_bit_offset_with_epb(
                                     decode_state->slice_datas[slice_index]->bo,
+                                    decode_state->slice_datas[slice_index]->bo->virtual,
                                     slice_param,
                                     pic_param->pic_fields.bits.entropy_coding_mode_flag
                                 );
@@ -793,6 +795,8 @@ i965_avc_bsd_pipeline(VADriverContextP ctx, struct decode_state *decode_state, v
     struct intel_batchbuffer *batch = i965_h264_context->batch;
     VAPictureParameterBufferH264 *pic_param;
     VASliceParameterBufferH264 *slice_param;
+    dri_bo *slice_data_bo;
+    int slice_data_mapped;
     int i, j;
 
     assert(decode_state->pic_param && decode_state->pic_param->buffer);
@@ -835,6 +839,10 @@ i965_avc_bsd_pipeline(VADriverContextP ctx, struct decode_state *decode_state, v
 
         i965_bsd_ind_obj_base_address(ctx, decode_state, j, i965_h264_context);
 
+        /* Map once, every slice header is scanned for emulation prevention bytes */
+        slice_data_bo = decode_state->slice_datas[j]->bo;
+        slice_data_mapped = dri_bo_map(slice_data_bo, 0) == 0;
+
         for (i = 0; i < decode_state->slice_params[j]->num_elements; i++) {
             assert(slice_param->slice_data_flag == VA_SLICE_DATA_FLAG_ALL);
             assert((slice_param->slice_type == SLICE_TYPE_I) ||
@@ -853,6 +861,9 @@ i965_avc_bsd_pipeline(VADriverContextP ctx, struct decode_state *decode_state, v
             i965_avc_bsd_object(ctx, decode_state, pic_param, slice_param, j, i965_h264_context);
             slice_param++;
         }
+
+        if (slice_data_mapped)
+            dri_bo_unmap(slice_data_bo);
     }
 
     i965_avc_bsd_phantom_slice(ctx, decode_state, pic_param, i965_h264_context);
@@ -1477,6 +1477,38 @@ gen9_avc_free_resources(struct encoder_vme_mfc_context * vme_context)
 	avc_ctx->preenc_future_ref_scaled_4x_surface_obj = NULL;
 }
 
+static enum intel_gpu_stage
+gen9_avc_gpu_stage(int media_function)
+{
+	switch (media_function) {
+	case INTEL_MEDIA_STATE_32X_SCALING:
+	case INTEL_MEDIA_STATE_16X_SCALING:
+	case INTEL_MEDIA_STATE_4X_SCALING:
+		return INTEL_GPU_STAGE_SCALING;
+
+	case INTEL_MEDIA_STATE_32X_ME:
+	case INTEL_MEDIA_STATE_16X_ME:
+	case INTEL_MEDIA_STATE_4X_ME:
+		return INTEL_GPU_STAGE_ME;
+
+	case INTEL_MEDIA_STATE_BRC_INIT_RESET:
+		return INTEL_GPU_STAGE_BRC_INIT;
+
+	case INTEL_MEDIA_STATE_BRC_UPDATE:
+	case INTEL_MEDIA_STATE_MB_BRC_UPDATE:
+		return INTEL_GPU_STAGE_BRC_UPDATE;
+
+	case INTEL_MEDIA_STATE_ENC_I_FRAME_DIST:
+	case INTEL_MEDIA_STATE_ENC_NORMAL:
+	case INTEL_MEDIA_STATE_ENC_PERFORMANCE:
+	case INTEL_MEDIA_STATE_ENC_QUALITY:
+		return INTEL_GPU_STAGE_MBENC;
+
+	default:
+		return INTEL_GPU_STAGE_ENC_KERNEL;
+	}
+}
+
 static void
 gen9_avc_run_kernel_media_object(VADriverContextP ctx,
 								 struct intel_encoder_context *encoder_context,
@@ -1497,6 +1529,7 @@ gen9_avc_run_kernel_media_object(VADriverContextP ctx,
 		return;
 
 	intel_batchbuffer_start_atomic(batch, 0x1000);
+	intel_batchbuffer_begin_stage(batch, gen9_avc_gpu_stage(media_function));
 	intel_batchbuffer_emit_mi_flush(batch);
 
 	status_buffer = &(avc_ctx->status_buffer);
@@ -1512,6 +1545,7 @@ gen9_avc_run_kernel_media_object(VADriverContextP ctx,
 
 	gpe->pipeline_end(ctx, gpe_context, batch);
 
+	intel_batchbuffer_end_stage(batch, gen9_avc_gpu_stage(media_function));
 	intel_batchbuffer_end_atomic(batch);
 
 	intel_batchbuffer_flush(batch);
@@ -1537,6 +1571,7 @@ gen9_avc_run_kernel_media_object_walker(VADriverContextP ctx,
 		return;
 
 	intel_batchbuffer_start_atomic(batch, 0x1000);
+	intel_batchbuffer_begin_stage(batch, gen9_avc_gpu_stage(media_function));
 
 	intel_batchbuffer_emit_mi_flush(batch);
 
@@ -1553,6 +1588,7 @@ gen9_avc_run_kernel_media_object_walker(VADriverContextP ctx,
 
 	gpe->pipeline_end(ctx, gpe_context, batch);
 
+	intel_batchbuffer_end_stage(batch, gen9_avc_gpu_stage(media_function));
 	intel_batchbuffer_end_atomic(batch);
 
 	intel_batchbuffer_flush(batch);
@@ -1565,6 +1601,9 @@ gen9_init_gpe_context_avc(VADriverContextP ctx,
 {
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 
+	/* Every kernel run initializes the context again */
+	i965_gpe_context_use_state_heap(ctx, gpe_context);
+
 	gpe_context->curbe.length = kernel_param->curbe_size; // in bytes
 
 	gpe_context->sampler.entry_size = 0;
@@ -9859,7 +9898,7 @@ gen9_mfc_avc_insert_slice_packed_data(VADriverContextP ctx,
 		VAEncSequenceParameterBufferH264 *seq_param = (VAEncSequenceParameterBufferH264 *)encode_state->seq_param_ext->buffer;
 		VAEncPictureParameterBufferH264 *pic_param = (VAEncPictureParameterBufferH264 *)encode_state->pic_param_ext->buffer;
 		VAEncSliceParameterBufferH264 *slice_params = (VAEncSliceParameterBufferH264 *)encode_state->slice_params_ext[slice_index]->buffer;
-		unsigned char *slice_header = NULL;
+		unsigned int slice_header[I965_HEADER_BUFFER_SIZE / 4];
 		int slice_header_length_in_bits = 0;
 
 		/* No slice header data is passed. And the driver needs to generate it */
@@ -9867,18 +9906,17 @@ gen9_mfc_avc_insert_slice_packed_data(VADriverContextP ctx,
 		slice_header_length_in_bits = build_avc_slice_header(seq_param,
 															 pic_param,
 															 slice_params,
-															 &slice_header);
+															 (unsigned char *)slice_header,
+															 sizeof(slice_header));
 		gen9_mfc_avc_insert_object(ctx,
 								   encoder_context,
-								   (unsigned int *)slice_header,
+								   slice_header,
 								   ALIGN(slice_header_length_in_bits, 32) >> 5,
 								   slice_header_length_in_bits & 0x1f,
 								   5,  /* first 5 bytes are start code + nal unit type */
 								   1, 0, 1,
 								   1,
 								   batch);
-
-		free(slice_header);
 	} else {
 		unsigned int skip_emul_byte_cnt;
 
@@ -10996,6 +11034,7 @@ gen9_avc_encode_picture(VADriverContextP ctx,
 		intel_batchbuffer_start_atomic_bcs_override(batch, 0x1000, BSD_RING0);
 	else
 		intel_batchbuffer_start_atomic_bcs(batch, 0x1000);
+	intel_batchbuffer_begin_stage(batch, INTEL_GPU_STAGE_PAK);
 	intel_batchbuffer_emit_mi_flush(batch);
 	for (generic_state->curr_pak_pass = 0;
 		 generic_state->curr_pak_pass < generic_state->num_pak_passes;
@@ -11022,6 +11061,7 @@ gen9_avc_encode_picture(VADriverContextP ctx,
 		avc_ctx->pres_slice_batch_buffer_2nd_level = NULL;
 	}
 
+	intel_batchbuffer_end_stage(batch, INTEL_GPU_STAGE_PAK);
 	intel_batchbuffer_end_atomic(batch);
 	intel_batchbuffer_flush(batch);
 
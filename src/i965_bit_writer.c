@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "i965_bit_writer.h"
+
+void
+i965_bit_writer_init(struct i965_bit_writer *bw, void *buffer, size_t size)
+{
+	bw->buffer = buffer;
+	bw->size = size;
+	bw->byte_offset = 0;
+	bw->cache = 0;
+	bw->cache_bits = 0;
+	bw->overflow = 0;
+}
+
+static void
+i965_bit_writer_store(struct i965_bit_writer *bw, uint64_t val, size_t size)
+{
+	val = __builtin_bswap64(val);
+
+	if (bw->byte_offset + size > bw->size) {
+		bw->overflow = 1;
+		return;
+	}
+
+	memcpy(bw->buffer + bw->byte_offset, &val, size);
+}
+
+void
+i965_bit_writer_put_ui(struct i965_bit_writer *bw, uint32_t val, int size_in_bits)
+{
+	int bit_left = 64 - bw->cache_bits;
+
+	assert(size_in_bits >= 0 && size_in_bits <= 32);
+
+	if (!size_in_bits)
+		return;
+
+	if (size_in_bits < 32)
+		val &= (1U << size_in_bits) - 1;
+
+	if (size_in_bits < bit_left) {
+		bw->cache = (bw->cache << size_in_bits) | val;
+		bw->cache_bits += size_in_bits;
+		return;
+	}
+
+	/* bit_left is at most 32 here, the cache is full after this */
+	size_in_bits -= bit_left;
+	i965_bit_writer_store(bw, (bw->cache << bit_left) | (val >> size_in_bits), 8);
+	bw->byte_offset += 8;
+
+	bw->cache = size_in_bits ? val & ((1U << size_in_bits) - 1) : 0;
+	bw->cache_bits = size_in_bits;
+}
+
+void
+i965_bit_writer_put_ue(struct i965_bit_writer *bw, uint32_t val)
+{
+	uint64_t code = (uint64_t)val + 1;
+	int size_in_bits = 64 - __builtin_clzll(code);
+
+	if (size_in_bits <= 16) {
+		/* leading zeros and the code fit in one write */
+		i965_bit_writer_put_ui(bw, (uint32_t)code, 2 * size_in_bits - 1);
+	} else {
+		i965_bit_writer_put_ui(bw, 0, size_in_bits - 1);
+		if (size_in_bits > 32) {
+			i965_bit_writer_put_ui(bw, 1, 1);
+			size_in_bits = 32;
+		}
+		i965_bit_writer_put_ui(bw, (uint32_t)code, size_in_bits);
+	}
+}
+
+void
+i965_bit_writer_put_se(struct i965_bit_writer *bw, int32_t val)
+{
+	if (val <= 0)
+		i965_bit_writer_put_ue(bw, -2 * (int64_t)val);
+	else
+		i965_bit_writer_put_ue(bw, 2 * (int64_t)val - 1);
+}
+
+void
+i965_bit_writer_byte_aligning(struct i965_bit_writer *bw, int bit)
+{
+	int bit_left = 8 - (bw->cache_bits & 0x7);
+
+	assert(bit == 0 || bit == 1);
+
+	if (bit_left == 8)
+		return;
+
+	i965_bit_writer_put_ui(bw, bit ? (1U << bit_left) - 1 : 0, bit_left);
+}
+
+void
+i965_bit_writer_rbsp_trailing_bits(struct i965_bit_writer *bw)
+{
+	i965_bit_writer_put_ui(bw, 1, 1);
+	i965_bit_writer_byte_aligning(bw, 0);
+}
+
+unsigned int
+i965_bit_writer_flush(struct i965_bit_writer *bw)
+{
+	unsigned int bits = i965_bit_writer_bit_offset(bw);
+
+	if (bw->cache_bits) {
+		i965_bit_writer_store(bw, bw->cache << (64 - bw->cache_bits),
+							  ((bw->cache_bits + 31) & ~31) / 8);
+		bw->byte_offset += 8;
+		bw->cache = 0;
+		bw->cache_bits = 0;
+	}
+
+	return bits;
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _I965_BIT_WRITER_H_
+#define _I965_BIT_WRITER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * MSB first bit writer for the headers the encoders generate themselves.
+ * Bits are gathered in a 64-bit accumulator and stored big endian into
+ * storage provided by the caller, nothing is allocated. Writes past the end
+ * of the storage are dropped and flagged in overflow.
+ */
+struct i965_bit_writer {
+	uint8_t *buffer;
+	size_t size;
+	size_t byte_offset;         /* bytes stored so far, a multiple of 8 */
+	uint64_t cache;
+	int cache_bits;
+	int overflow;
+};
+
+void
+i965_bit_writer_init(struct i965_bit_writer *bw, void *buffer, size_t size);
+
+/* Writes the size_in_bits (<= 32) low bits of val */
+void
+i965_bit_writer_put_ui(struct i965_bit_writer *bw, uint32_t val, int size_in_bits);
+
+/* Exp-Golomb codes */
+void
+i965_bit_writer_put_ue(struct i965_bit_writer *bw, uint32_t val);
+
+void
+i965_bit_writer_put_se(struct i965_bit_writer *bw, int32_t val);
+
+/* Pads with bit up to the next byte boundary */
+void
+i965_bit_writer_byte_aligning(struct i965_bit_writer *bw, int bit);
+
+/* rbsp_stop_one_bit followed by zero bits up to the next byte boundary */
+void
+i965_bit_writer_rbsp_trailing_bits(struct i965_bit_writer *bw);
+
+static inline unsigned int
+i965_bit_writer_bit_offset(const struct i965_bit_writer *bw)
+{
+	return bw->byte_offset * 8 + bw->cache_bits;
+}
+
+/*
+ * Stores the pending bits, zero padded up to a dword boundary as the
+ * hardware header insertion commands read dwords, and returns the number
+ * of bits written.
+ */
+unsigned int
+i965_bit_writer_flush(struct i965_bit_writer *bw);
+
+#endif /* _I965_BIT_WRITER_H_ */
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "i965_brc_lookahead.h"
+
+/* Weight of the complexity in the bit allocation, 1 would be constant QP */
+#define LOOKAHEAD_QCOMP             0.6
+#define LOOKAHEAD_QP_MAX_CHANGE     4
+#define LOOKAHEAD_COEFF_ALPHA       0.5
+
+static double
+lookahead_qp_qstep(int qp)
+{
+	return 0.625 * exp2(qp / 6.0);
+}
+
+static int
+lookahead_qstep_qp(double qstep)
+{
+	return (int)floor(6.0 * log2(qstep / 0.625) + 0.5);
+}
+
+static double
+lookahead_weight(double complexity)
+{
+	return pow(complexity, LOOKAHEAD_QCOMP);
+}
+
+void
+i965_brc_lookahead_init(struct i965_brc_lookahead *la, int window,
+						double bits_per_frame, double buffer_size,
+						double target_fullness, int min_qp)
+{
+	int i;
+
+	memset(la, 0, sizeof(*la));
+
+	if (window < 0)
+		window = 0;
+	else if (window > I965_BRC_LOOKAHEAD_MAX_WINDOW)
+		window = I965_BRC_LOOKAHEAD_MAX_WINDOW;
+
+	la->window = window;
+	la->bits_per_frame = bits_per_frame;
+	la->buffer_size = buffer_size;
+	la->target_fullness = target_fullness;
+	la->min_qp = min_qp < 1 ? 1 : min_qp;
+	la->max_qp = 51;
+
+	for (i = 0; i < I965_BRC_LOOKAHEAD_NUM_TYPES; i++)
+		la->last_qp[i] = -1;
+}
+
+int
+i965_brc_lookahead_get_qp(struct i965_brc_lookahead *la, int slice_type,
+						  double complexity, double fullness, int fallback_qp)
+{
+	double weight, sum_weight, budget, target, max_bits;
+	double coeff;
+	int i, n, qp;
+
+	if (!la->window ||
+		slice_type < 0 || slice_type >= I965_BRC_LOOKAHEAD_NUM_TYPES)
+		return fallback_qp;
+
+	coeff = la->coeff[slice_type];
+	if (coeff <= 0. || complexity <= 0.) {
+		la->num_fallbacks++;
+		return fallback_qp;
+	}
+
+	/* Share of the bits of the window, the current frame included */
+	weight = lookahead_weight(complexity);
+	sum_weight = weight;
+	for (i = 0; i < la->count; i++)
+		sum_weight += lookahead_weight(la->complexity[(la->head + i) % la->window]);
+	n = la->count + 1;
+
+	budget = la->bits_per_frame;
+	if (la->buffer_size > 0.)
+		budget += (fullness - la->target_fullness) / la->window;
+
+	target = budget * weight * n / sum_weight;
+	if (target < 0.1 * la->bits_per_frame)
+		target = 0.1 * la->bits_per_frame;
+
+	qp = lookahead_qstep_qp(coeff * complexity / target);
+
+	if (la->last_qp[slice_type] >= 0) {
+		if (qp > la->last_qp[slice_type] + LOOKAHEAD_QP_MAX_CHANGE)
+			qp = la->last_qp[slice_type] + LOOKAHEAD_QP_MAX_CHANGE;
+		else if (qp < la->last_qp[slice_type] - LOOKAHEAD_QP_MAX_CHANGE)
+			qp = la->last_qp[slice_type] - LOOKAHEAD_QP_MAX_CHANGE;
+	}
+
+	if (qp < la->min_qp)
+		qp = la->min_qp;
+	else if (qp > la->max_qp)
+		qp = la->max_qp;
+
+	/* Whatever the smoothing says, keep a margin against HRD underflow */
+	if (la->buffer_size > 0.) {
+		max_bits = fullness - 0.1 * la->buffer_size;
+		while (qp < la->max_qp &&
+			   coeff * complexity / lookahead_qp_qstep(qp) > max_bits)
+			qp++;
+	}
+
+	return qp;
+}
+
+void
+i965_brc_lookahead_update(struct i965_brc_lookahead *la, int slice_type,
+						  double complexity, int qp, int bits)
+{
+	double coeff;
+
+	if (!la->window ||
+		slice_type < 0 || slice_type >= I965_BRC_LOOKAHEAD_NUM_TYPES ||
+		complexity <= 0. || bits <= 0)
+		return;
+
+	coeff = bits * lookahead_qp_qstep(qp) / complexity;
+	if (la->coeff[slice_type] > 0.)
+		coeff = (1. - LOOKAHEAD_COEFF_ALPHA) * la->coeff[slice_type] + LOOKAHEAD_COEFF_ALPHA * coeff;
+	la->coeff[slice_type] = coeff;
+	la->last_qp[slice_type] = qp;
+
+	if (la->count < la->window) {
+		la->complexity[(la->head + la->count) % la->window] = complexity;
+		la->count++;
+	} else {
+		la->complexity[la->head] = complexity;
+		la->head = (la->head + 1) % la->window;
+	}
+
+	la->num_frames++;
+}
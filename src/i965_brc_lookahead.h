@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _I965_BRC_LOOKAHEAD_H_
+#define _I965_BRC_LOOKAHEAD_H_
+
+/*
+ * Complexity driven QP selection for the MFC/VME AVC rate control.
+ *
+ * The reactive controllers in gen6_mfc_common.c pick the QP of a frame from
+ * the size of the previous one, so a scene cut is only noticed after it has
+ * been coded. This one is given the complexity of the frame about to be
+ * coded (the VME distortion of the frame) and spreads the bits over a window
+ * of recent frames in proportion to their complexity, using a per slice type
+ * bits ~ coeff * complexity / qstep(qp) model fitted on the coded frames.
+ */
+
+#define I965_BRC_LOOKAHEAD_MAX_WINDOW   64
+#define I965_BRC_LOOKAHEAD_NUM_TYPES    3
+
+struct i965_brc_lookahead {
+	int window;                 /* 0 when disabled */
+	double bits_per_frame;
+	double buffer_size;         /* HRD buffer size, 0 for no HRD */
+	double target_fullness;
+	int min_qp;
+	int max_qp;
+
+	/* Complexity of the last coded frames */
+	double complexity[I965_BRC_LOOKAHEAD_MAX_WINDOW];
+	int head;
+	int count;
+
+	/* Model coefficient and last QP for each slice type, 0 / -1 if unknown */
+	double coeff[I965_BRC_LOOKAHEAD_NUM_TYPES];
+	int last_qp[I965_BRC_LOOKAHEAD_NUM_TYPES];
+
+	unsigned int num_frames;
+	unsigned int num_fallbacks;
+};
+
+void
+i965_brc_lookahead_init(struct i965_brc_lookahead *la, int window,
+						double bits_per_frame, double buffer_size,
+						double target_fullness, int min_qp);
+
+/*
+ * Returns the QP for a frame of the given slice type and complexity, with
+ * fullness bits in the HRD buffer before it is removed. fallback_qp is
+ * returned as long as there is no model for the slice type.
+ */
+int
+i965_brc_lookahead_get_qp(struct i965_brc_lookahead *la, int slice_type,
+						  double complexity, double fullness, int fallback_qp);
+
+/* Feeds back the size of a coded frame */
+void
+i965_brc_lookahead_update(struct i965_brc_lookahead *la, int slice_type,
+						  double complexity, int qp, int bits);
+
+#endif /* _I965_BRC_LOOKAHEAD_H_ */
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "sysdeps.h"
+
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+
+#include "i965_bufmgr_ops.h"
+
+static pthread_once_t i965_bufmgr_anon_once = PTHREAD_ONCE_INIT;
+static dev_t i965_bufmgr_anon_dev;
+static ino_t i965_bufmgr_anon_ino;
+
+/*
+ * Kernels before 5.3 back every dma-buf with the shared anonymous inode, so
+ * the inode only identifies a buffer if it differs from the one an eventfd
+ * gets.
+ */
+static void
+i965_bufmgr_init_anon_inode(void)
+{
+	struct stat st;
+	int fd = eventfd(0, EFD_CLOEXEC);
+
+	if (fd < 0)
+		return;
+
+	if (fstat(fd, &st) == 0) {
+		i965_bufmgr_anon_dev = st.st_dev;
+		i965_bufmgr_anon_ino = st.st_ino;
+	}
+
+	close(fd);
+}
+
+static int
+i965_bufmgr_drm_prime_inode(int fd, uint64_t *dev, uint64_t *ino)
+{
+	struct stat st;
+
+	pthread_once(&i965_bufmgr_anon_once, i965_bufmgr_init_anon_inode);
+
+	if (fstat(fd, &st) != 0 || !st.st_ino)
+		return -1;
+
+	if (!i965_bufmgr_anon_ino ||
+		(i965_bufmgr_anon_dev == st.st_dev &&
+		 i965_bufmgr_anon_ino == st.st_ino))
+		return -1;
+
+	*dev = st.st_dev;
+	*ino = st.st_ino;
+
+	return 0;
+}
+
+const struct i965_bufmgr_ops i965_bufmgr_drm_ops = {
+	.alloc = drm_intel_bo_alloc,
+	.reference = drm_intel_bo_reference,
+	.unreference = drm_intel_bo_unreference,
+	.madvise = drm_intel_bo_madvise,
+	.subdata = drm_intel_bo_subdata,
+	.map = drm_intel_bo_map,
+	.unmap = drm_intel_bo_unmap,
+	.busy = drm_intel_bo_busy,
+	.import = drm_intel_bo_gem_create_from_prime,
+	.prime_inode = i965_bufmgr_drm_prime_inode,
+	.emit_reloc = drm_intel_bo_emit_reloc,
+};
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _I965_BUFMGR_OPS_H_
+#define _I965_BUFMGR_OPS_H_
+
+#include <stdint.h>
+
+#include <intel_bufmgr.h>
+
+/*
+ * The buffer manager calls of the pools and caches the driver keeps on top
+ * of libdrm. They go through this table so that the unit tests can run the
+ * pools against a mock buffer manager, the init functions take NULL for
+ * i965_bufmgr_drm_ops.
+ */
+struct i965_bufmgr_ops {
+	dri_bo *(*alloc)(dri_bufmgr *bufmgr, const char *name,
+					 unsigned long size, unsigned int alignment);
+
+	void (*reference)(dri_bo *bo);
+
+	/* Drops a reference, the last one frees the buffer object */
+	void (*unreference)(dri_bo *bo);
+
+	/*
+	 * I915_MADV_DONTNEED lets the kernel reclaim the pages under memory
+	 * pressure, I915_MADV_WILLNEED takes them back. Returns whether the
+	 * pages are still there.
+	 */
+	int (*madvise)(dri_bo *bo, int madv);
+
+	/* Writes data at offset without mapping the buffer object */
+	int (*subdata)(dri_bo *bo, unsigned long offset,
+				   unsigned long size, const void *data);
+
+	/* Maps the whole buffer object at bo->virtual, waiting for the GPU */
+	int (*map)(dri_bo *bo, int write_enable);
+	int (*unmap)(dri_bo *bo);
+
+	/* Whether a batch still in flight refers to the buffer object */
+	int (*busy)(dri_bo *bo);
+
+	/*
+	 * Wraps the dma-buf behind fd in a new buffer object, or in the one
+	 * already backed by it, with an extra reference
+	 */
+	dri_bo *(*import)(dri_bufmgr *bufmgr, int fd, int size);
+
+	/*
+	 * The device and inode of the dma-buf behind fd, which tell the buffers
+	 * apart unless the kernel backs all of them with the same inode.
+	 * Returns -1 when they do not.
+	 */
+	int (*prime_inode)(int fd, uint64_t *dev, uint64_t *ino);
+
+	/*
+	 * Records that the dword at offset in bo holds the address of
+	 * target_offset in target_bo
+	 */
+	int (*emit_reloc)(dri_bo *bo, uint32_t offset,
+					  dri_bo *target_bo, uint32_t target_offset,
+					  uint32_t read_domains, uint32_t write_domain);
+};
+
+extern const struct i965_bufmgr_ops i965_bufmgr_drm_ops;
+
+#endif /* _I965_BUFMGR_OPS_H_ */
@@ -0,0 +1,303 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "sysdeps.h"
+
+#include <pthread.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#define I965_BYTE_SCAN_X86      1
+#endif
+
+#include "i965_byte_scan.h"
+
+typedef const uint8_t *(*i965_byte_scan_find_func)(const uint8_t *buf, size_t size,
+												   const uint8_t *pattern, size_t pattern_size);
+typedef unsigned int (*i965_byte_scan_count_epb_func)(const uint8_t *buf, size_t size, size_t header_size,
+													  size_t i, unsigned int n);
+
+static pthread_once_t i965_byte_scan_once = PTHREAD_ONCE_INIT;
+static int i965_byte_scan_best_path;
+static int i965_byte_scan_path;
+
+static const uint8_t *
+i965_byte_scan_find_c(const uint8_t *buf, size_t size,
+					  const uint8_t *pattern, size_t pattern_size)
+{
+	size_t i;
+
+	for (i = 0; i + pattern_size <= size; i++) {
+		if (buf[i] == pattern[0] &&
+			memcmp(buf + i + 1, pattern + 1, pattern_size - 1) == 0)
+			return buf + i;
+	}
+
+	return NULL;
+}
+
+#ifdef I965_BYTE_SCAN_X86
+/*
+ * Candidates are the positions where both the first and the last byte of
+ * the pattern match, which filters out nearly everything in a bitstream
+ * even for the all zero delimiters, the few left are checked with memcmp().
+ */
+__attribute__((target("sse2"))) static const uint8_t *
+i965_byte_scan_find_sse2(const uint8_t *buf, size_t size,
+						 const uint8_t *pattern, size_t pattern_size)
+{
+	const __m128i first = _mm_set1_epi8(pattern[0]);
+	const __m128i last = _mm_set1_epi8(pattern[pattern_size - 1]);
+	const size_t last_offset = pattern_size - 1;
+	size_t i = 0;
+
+	while (i + 16 + last_offset <= size) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(buf + i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(buf + i + last_offset));
+		unsigned int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first),
+															_mm_cmpeq_epi8(b, last)));
+
+		while (mask) {
+			size_t pos = i + __builtin_ctz(mask);
+
+			if (memcmp(buf + pos, pattern, pattern_size) == 0)
+				return buf + pos;
+
+			mask &= mask - 1;
+		}
+
+		i += 16;
+	}
+
+	return i965_byte_scan_find_c(buf + i, size - i, pattern, pattern_size);
+}
+
+__attribute__((target("avx2"))) static const uint8_t *
+i965_byte_scan_find_avx2(const uint8_t *buf, size_t size,
+						 const uint8_t *pattern, size_t pattern_size)
+{
+	const __m256i first = _mm256_set1_epi8(pattern[0]);
+	const __m256i last = _mm256_set1_epi8(pattern[pattern_size - 1]);
+	const size_t last_offset = pattern_size - 1;
+	size_t i = 0;
+
+	while (i + 32 + last_offset <= size) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)(buf + i));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(buf + i + last_offset));
+		unsigned int mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first),
+																  _mm256_cmpeq_epi8(b, last)));
+
+		while (mask) {
+			size_t pos = i + __builtin_ctz(mask);
+
+			if (memcmp(buf + pos, pattern, pattern_size) == 0)
+				return buf + pos;
+
+			mask &= mask - 1;
+		}
+
+		i += 32;
+	}
+
+	return i965_byte_scan_find_sse2(buf + i, size - i, pattern, pattern_size);
+}
+#endif
+
+/*
+ * Byte i is the last one of a candidate 00 00 03 and the walk stops once
+ * header_size unescaped bytes are consumed, so every emulation prevention
+ * byte moves the limit one byte further. Bytes following a match can't
+ * start the next one.
+ */
+static unsigned int
+i965_byte_scan_count_epb_c(const uint8_t *buf, size_t size, size_t header_size,
+						   size_t i, unsigned int n)
+{
+	for (; i < size && i < header_size + n; i++) {
+		if (buf[i] == 0x03 && buf[i - 1] == 0x00 && buf[i - 2] == 0x00)
+			i += 2, n++;
+	}
+
+	return n;
+}
+
+#ifdef I965_BYTE_SCAN_X86
+__attribute__((target("sse2"))) static unsigned int
+i965_byte_scan_count_epb_sse2(const uint8_t *buf, size_t size, size_t header_size,
+							  size_t i, unsigned int n)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i three = _mm_set1_epi8(0x03);
+
+	while (i + 16 <= size && i < header_size + n) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(buf + i - 2));
+		__m128i b = _mm_loadu_si128((const __m128i *)(buf + i - 1));
+		__m128i c = _mm_loadu_si128((const __m128i *)(buf + i));
+		unsigned int mask = _mm_movemask_epi8(_mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(a, zero),
+																		  _mm_cmpeq_epi8(b, zero)),
+															_mm_cmpeq_epi8(c, three)));
+		size_t pos;
+
+		if (!mask) {
+			i += 16;
+			continue;
+		}
+
+		pos = i + __builtin_ctz(mask);
+		if (pos >= header_size + n)
+			return n;
+
+		i = pos + 3;
+		n++;
+	}
+
+	return i965_byte_scan_count_epb_c(buf, size, header_size, i, n);
+}
+
+__attribute__((target("avx2"))) static unsigned int
+i965_byte_scan_count_epb_avx2(const uint8_t *buf, size_t size, size_t header_size,
+							  size_t i, unsigned int n)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i three = _mm256_set1_epi8(0x03);
+
+	while (i + 32 <= size && i < header_size + n) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)(buf + i - 2));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(buf + i - 1));
+		__m256i c = _mm256_loadu_si256((const __m256i *)(buf + i));
+		unsigned int mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(a, zero),
+																					_mm256_cmpeq_epi8(b, zero)),
+																  _mm256_cmpeq_epi8(c, three)));
+		size_t pos;
+
+		if (!mask) {
+			i += 32;
+			continue;
+		}
+
+		pos = i + __builtin_ctz(mask);
+		if (pos >= header_size + n)
+			return n;
+
+		i = pos + 3;
+		n++;
+	}
+
+	/* Headers are short, an SSE2 tail would cost an AVX to SSE transition per slice */
+	return i965_byte_scan_count_epb_c(buf, size, header_size, i, n);
+}
+#endif
+
+static const i965_byte_scan_find_func i965_byte_scan_find_funcs[] = {
+	[I965_BYTE_SCAN_PATH_C] = i965_byte_scan_find_c,
+#ifdef I965_BYTE_SCAN_X86
+	[I965_BYTE_SCAN_PATH_SSE2] = i965_byte_scan_find_sse2,
+	[I965_BYTE_SCAN_PATH_AVX2] = i965_byte_scan_find_avx2,
+#endif
+};
+
+static const i965_byte_scan_count_epb_func i965_byte_scan_count_epb_funcs[] = {
+	[I965_BYTE_SCAN_PATH_C] = i965_byte_scan_count_epb_c,
+#ifdef I965_BYTE_SCAN_X86
+	[I965_BYTE_SCAN_PATH_SSE2] = i965_byte_scan_count_epb_sse2,
+	[I965_BYTE_SCAN_PATH_AVX2] = i965_byte_scan_count_epb_avx2,
+#endif
+};
+
+static void
+i965_byte_scan_init(void)
+{
+	i965_byte_scan_best_path = I965_BYTE_SCAN_PATH_C;
+
+#ifdef I965_BYTE_SCAN_X86
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2"))
+		i965_byte_scan_best_path = I965_BYTE_SCAN_PATH_AVX2;
+	else if (__builtin_cpu_supports("sse2"))
+		i965_byte_scan_best_path = I965_BYTE_SCAN_PATH_SSE2;
+#endif
+
+	i965_byte_scan_path = i965_byte_scan_best_path;
+}
+
+int
+i965_byte_scan_set_path(int path)
+{
+	pthread_once(&i965_byte_scan_once, i965_byte_scan_init);
+
+	if (path < I965_BYTE_SCAN_PATH_C)
+		path = I965_BYTE_SCAN_PATH_C;
+
+	i965_byte_scan_path = path < i965_byte_scan_best_path ? path : i965_byte_scan_best_path;
+
+	return i965_byte_scan_path;
+}
+
+int
+i965_byte_scan_get_path(void)
+{
+	pthread_once(&i965_byte_scan_once, i965_byte_scan_init);
+
+	return i965_byte_scan_path;
+}
+
+const uint8_t *
+i965_byte_scan_find(const uint8_t *buf, size_t size,
+					const uint8_t *pattern, size_t pattern_size)
+{
+	pthread_once(&i965_byte_scan_once, i965_byte_scan_init);
+
+	if (pattern_size == 0)
+		return buf;
+
+	if (pattern_size > size)
+		return NULL;
+
+	return i965_byte_scan_find_funcs[i965_byte_scan_path](buf, size, pattern, pattern_size);
+}
+
+const uint8_t *
+i965_byte_scan_find_start_code(const uint8_t *buf, size_t size)
+{
+	static const uint8_t start_code[] = { 0x00, 0x00, 0x01 };
+
+	return i965_byte_scan_find(buf, size, start_code, sizeof(start_code));
+}
+
+const uint8_t *
+i965_byte_scan_find_epb(const uint8_t *buf, size_t size)
+{
+	static const uint8_t epb[] = { 0x00, 0x00, 0x03 };
+
+	return i965_byte_scan_find(buf, size, epb, sizeof(epb));
+}
+
+unsigned int
+i965_byte_scan_count_epb(const uint8_t *buf, size_t size, size_t header_size)
+{
+	pthread_once(&i965_byte_scan_once, i965_byte_scan_init);
+
+	return i965_byte_scan_count_epb_funcs[i965_byte_scan_path](buf, size, header_size, 2, 0);
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _I965_BYTE_SCAN_H_
+#define _I965_BYTE_SCAN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * memmem() style searches over bitstream buffers, used where the end of
+ * the data has to be found by looking for a marker, e.g. the delimiter the
+ * encoders append to a coded buffer when the hardware doesn't report the
+ * bitstream size.
+ */
+
+enum i965_byte_scan_path {
+	I965_BYTE_SCAN_PATH_C = 0,
+	I965_BYTE_SCAN_PATH_SSE2,
+	I965_BYTE_SCAN_PATH_AVX2,
+};
+
+/*
+ * Scans use AVX2 or SSE2 when the CPU has them. The unit test selects
+ * each path in turn with set_path() and compares it with the C one, the
+ * returned value tells which path it actually got on this CPU.
+ */
+int i965_byte_scan_set_path(int path);
+int i965_byte_scan_get_path(void);
+
+/* Returns the first occurrence of pattern in buf, or NULL */
+const uint8_t *
+i965_byte_scan_find(const uint8_t *buf, size_t size,
+					const uint8_t *pattern, size_t pattern_size);
+
+/* Returns the first 00 00 01 start code prefix in buf, or NULL */
+const uint8_t *
+i965_byte_scan_find_start_code(const uint8_t *buf, size_t size);
+
+/* Returns the first 00 00 03 emulation prevention sequence in buf, or NULL */
+const uint8_t *
+i965_byte_scan_find_epb(const uint8_t *buf, size_t size);
+
+/*
+ * Counts the emulation prevention bytes met while walking header_size
+ * bytes of unescaped slice header, reading at most size bytes of buf.
+ */
+unsigned int
+i965_byte_scan_count_epb(const uint8_t *buf, size_t size, size_t header_size);
+
+#endif /* _I965_BYTE_SCAN_H_ */
@@ -0,0 +1,993 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "sysdeps.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#define I965_COLOR_CONVERT_X86  1
+#endif
+
+#include "i965_yuv_coefs.h"
+#include "i965_color_convert.h"
+
+#define CONVERT_MIN(a, b)       ((a) < (b) ? (a) : (b))
+
+#define MATRIX_SHIFT            13
+#define MATRIX_ROUND            (1 << (MATRIX_SHIFT - 1))
+
+struct i965_color_matrix {
+	int32_t to_rgb[9];      /* rows R, G, B of columns Y, U, V */
+	int32_t to_yuv[9];      /* rows Y, U, V of columns R, G, B */
+	int32_t offsets[3];     /* of Y, U and V */
+};
+
+/*
+ * Row kernels, n is in pixels for the packed and RGB formats and in samples
+ * otherwise. Kernels taking two source rows produce two luma rows and the
+ * chroma row they share, both rows are the same one for the last row of an
+ * odd height.
+ */
+struct i965_color_convert_funcs {
+	void (*split_uv)(uint8_t *u, uint8_t *v, const uint8_t *uv, unsigned int n);
+	void (*merge_uv)(uint8_t *uv, const uint8_t *u, const uint8_t *v, unsigned int n);
+	void (*pack_422)(uint8_t *dst, const uint8_t *y, const uint8_t *uv,
+					 unsigned int n, int uyvy);
+	void (*unpack_422)(uint8_t *y0, uint8_t *y1, uint8_t *uv,
+					   const uint8_t *src0, const uint8_t *src1,
+					   unsigned int n, int uyvy);
+	void (*yuv_to_rgb)(uint8_t *dst, const uint8_t *y, const uint8_t *uv,
+					   unsigned int n, const struct i965_color_matrix *m, int bgr);
+	void (*rgb_to_yuv)(uint8_t *y0, uint8_t *y1, uint8_t *uv,
+					   const uint8_t *src0, const uint8_t *src1,
+					   unsigned int n, const struct i965_color_matrix *m, int bgr);
+	void (*to_p010)(uint16_t *dst, const uint8_t *src, unsigned int n);
+	void (*from_p010)(uint8_t *dst, const uint16_t *src, unsigned int n);
+};
+
+struct i965_color_convert_job {
+	const struct i965_color_convert_funcs *funcs;
+	const struct i965_color_matrix *matrix;
+	struct i965_color_frame dst;
+	struct i965_color_frame src;
+	unsigned int width;
+	unsigned int y;
+	unsigned int height;
+	unsigned int frame_height;
+};
+
+static pthread_once_t i965_color_convert_once = PTHREAD_ONCE_INIT;
+static int i965_color_convert_best_path;
+static int i965_color_convert_path;
+static int i965_color_convert_threads;
+
+static inline uint8_t
+clamp_u8(int v)
+{
+	return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+static inline int
+matrix_row(const int32_t *row, int a, int b, int c)
+{
+	return (row[0] * a + row[1] * b + row[2] * c + MATRIX_ROUND) >> MATRIX_SHIFT;
+}
+
+static void
+i965_color_matrix_init(struct i965_color_matrix *m, VAProcColorStandardType standard)
+{
+	const float *coefs;
+	double a[9], inv[9], det;
+	size_t length;
+	int i;
+
+	/* rows of Y, U, V scales and the offset of one of them */
+	coefs = i915_color_standard_to_coefs(standard, &length);
+
+	for (i = 0; i < 3; i++) {
+		a[i * 3 + 0] = coefs[i * 4 + 0];
+		a[i * 3 + 1] = coefs[i * 4 + 1];
+		a[i * 3 + 2] = coefs[i * 4 + 2];
+		m->offsets[i] = lrint(-coefs[i * 4 + 3] * 255.0);
+	}
+
+	det = a[0] * (a[4] * a[8] - a[5] * a[7]) -
+		  a[1] * (a[3] * a[8] - a[5] * a[6]) +
+		  a[2] * (a[3] * a[7] - a[4] * a[6]);
+
+	inv[0] = (a[4] * a[8] - a[5] * a[7]) / det;
+	inv[1] = (a[2] * a[7] - a[1] * a[8]) / det;
+	inv[2] = (a[1] * a[5] - a[2] * a[4]) / det;
+	inv[3] = (a[5] * a[6] - a[3] * a[8]) / det;
+	inv[4] = (a[0] * a[8] - a[2] * a[6]) / det;
+	inv[5] = (a[2] * a[3] - a[0] * a[5]) / det;
+	inv[6] = (a[3] * a[7] - a[4] * a[6]) / det;
+	inv[7] = (a[1] * a[6] - a[0] * a[7]) / det;
+	inv[8] = (a[0] * a[4] - a[1] * a[3]) / det;
+
+	for (i = 0; i < 9; i++) {
+		m->to_rgb[i] = lrint(a[i] * (1 << MATRIX_SHIFT));
+		m->to_yuv[i] = lrint(inv[i] * (1 << MATRIX_SHIFT));
+	}
+}
+
+static void
+i965_split_uv_c(uint8_t *u, uint8_t *v, const uint8_t *uv, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		u[i] = uv[2 * i];
+		v[i] = uv[2 * i + 1];
+	}
+}
+
+static void
+i965_merge_uv_c(uint8_t *uv, const uint8_t *u, const uint8_t *v, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		uv[2 * i] = u[i];
+		uv[2 * i + 1] = v[i];
+	}
+}
+
+/* The second luma sample of an odd width is left untouched */
+static void
+i965_pack_422_c(uint8_t *dst, const uint8_t *y, const uint8_t *uv,
+				unsigned int n, int uyvy)
+{
+	const int l = uyvy ? 1 : 0, c = uyvy ? 0 : 1;
+	unsigned int i;
+
+	for (i = 0; i < n; i += 2) {
+		dst[2 * i + l] = y[i];
+		dst[2 * i + c] = uv[i];
+		dst[2 * i + c + 2] = uv[i + 1];
+
+		if (i + 1 < n)
+			dst[2 * i + l + 2] = y[i + 1];
+	}
+}
+
+static void
+i965_unpack_422_c(uint8_t *y0, uint8_t *y1, uint8_t *uv,
+				  const uint8_t *src0, const uint8_t *src1,
+				  unsigned int n, int uyvy)
+{
+	const int l = uyvy ? 1 : 0, c = uyvy ? 0 : 1;
+	unsigned int i;
+
+	for (i = 0; i < n; i += 2) {
+		y0[i] = src0[2 * i + l];
+		y1[i] = src1[2 * i + l];
+		uv[i] = (src0[2 * i + c] + src1[2 * i + c] + 1) >> 1;
+		uv[i + 1] = (src0[2 * i + c + 2] + src1[2 * i + c + 2] + 1) >> 1;
+
+		if (i + 1 < n) {
+			y0[i + 1] = src0[2 * i + l + 2];
+			y1[i + 1] = src1[2 * i + l + 2];
+		}
+	}
+}
+
+static void
+i965_yuv_to_rgb_c(uint8_t *dst, const uint8_t *y, const uint8_t *uv,
+				  unsigned int n, const struct i965_color_matrix *m, int bgr)
+{
+	const int r = bgr ? 2 : 0, b = bgr ? 0 : 2;
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		int yy = y[i] - m->offsets[0];
+		int uu = uv[i & ~1] - m->offsets[1];
+		int vv = uv[(i & ~1) + 1] - m->offsets[2];
+
+		dst[4 * i + r] = clamp_u8(matrix_row(&m->to_rgb[0], yy, uu, vv));
+		dst[4 * i + 1] = clamp_u8(matrix_row(&m->to_rgb[3], yy, uu, vv));
+		dst[4 * i + b] = clamp_u8(matrix_row(&m->to_rgb[6], yy, uu, vv));
+		dst[4 * i + 3] = 0xff;
+	}
+}
+
+/* The chroma of a 2x2 block is the one of its average colour */
+static void
+i965_rgb_to_yuv_c(uint8_t *y0, uint8_t *y1, uint8_t *uv,
+				  const uint8_t *src0, const uint8_t *src1,
+				  unsigned int n, const struct i965_color_matrix *m, int bgr)
+{
+	const int r = bgr ? 2 : 0, b = bgr ? 0 : 2;
+	unsigned int i;
+
+	for (i = 0; i < n; i += 2) {
+		const uint8_t *p0 = src0 + 4 * i, *p1 = src1 + 4 * i;
+		/* the last column of an odd width stands for both */
+		const int next = i + 1 < n ? 4 : 0;
+		int rs, gs, bs;
+
+		y0[i] = clamp_u8(matrix_row(&m->to_yuv[0], p0[r], p0[1], p0[b]) + m->offsets[0]);
+		y1[i] = clamp_u8(matrix_row(&m->to_yuv[0], p1[r], p1[1], p1[b]) + m->offsets[0]);
+
+		if (next) {
+			y0[i + 1] = clamp_u8(matrix_row(&m->to_yuv[0], p0[r + 4], p0[5], p0[b + 4]) + m->offsets[0]);
+			y1[i + 1] = clamp_u8(matrix_row(&m->to_yuv[0], p1[r + 4], p1[5], p1[b + 4]) + m->offsets[0]);
+		}
+
+		rs = (p0[r] + p1[r] + p0[r + next] + p1[r + next] + 2) >> 2;
+		gs = (p0[1] + p1[1] + p0[1 + next] + p1[1 + next] + 2) >> 2;
+		bs = (p0[b] + p1[b] + p0[b + next] + p1[b + next] + 2) >> 2;
+
+		uv[i] = clamp_u8(matrix_row(&m->to_yuv[3], rs, gs, bs) + m->offsets[1]);
+		uv[i + 1] = clamp_u8(matrix_row(&m->to_yuv[6], rs, gs, bs) + m->offsets[2]);
+	}
+}
+
+/* P010 keeps the 10 bits in the high bits of each 16 bits sample */
+static void
+i965_to_p010_c(uint16_t *dst, const uint8_t *src, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = src[i] << 8;
+}
+
+static void
+i965_from_p010_c(uint8_t *dst, const uint16_t *src, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = CONVERT_MIN(((src[i] >> 6) + 2) >> 2, 255);
+}
+
+#ifdef I965_COLOR_CONVERT_X86
+static inline int
+load_u32(const uint8_t *p)
+{
+	int v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline void
+store_u32(uint8_t *p, int v)
+{
+	memcpy(p, &v, sizeof(v));
+}
+
+__attribute__((target("sse4.1"))) static void
+i965_split_uv_sse41(uint8_t *u, uint8_t *v, const uint8_t *uv, unsigned int n)
+{
+	const __m128i shuffle = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14,
+										  1, 3, 5, 7, 9, 11, 13, 15);
+	unsigned int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i x = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(uv + 2 * i)), shuffle);
+
+		_mm_storel_epi64((__m128i *)(u + i), x);
+		_mm_storel_epi64((__m128i *)(v + i), _mm_srli_si128(x, 8));
+	}
+
+	i965_split_uv_c(u + i, v + i, uv + 2 * i, n - i);
+}
+
+__attribute__((target("sse4.1"))) static void
+i965_merge_uv_sse41(uint8_t *uv, const uint8_t *u, const uint8_t *v, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(u + i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(v + i));
+
+		_mm_storeu_si128((__m128i *)(uv + 2 * i), _mm_unpacklo_epi8(a, b));
+		_mm_storeu_si128((__m128i *)(uv + 2 * i + 16), _mm_unpackhi_epi8(a, b));
+	}
+
+	i965_merge_uv_c(uv + 2 * i, u + i, v + i, n - i);
+}
+
+/* Interleaving the luma with the UV bytes gives YUYV, the other way UYVY */
+__attribute__((target("sse4.1"))) static void
+i965_pack_422_sse41(uint8_t *dst, const uint8_t *y, const uint8_t *uv,
+					unsigned int n, int uyvy)
+{
+	unsigned int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m128i l = _mm_loadu_si128((const __m128i *)(y + i));
+		__m128i c = _mm_loadu_si128((const __m128i *)(uv + i));
+
+		if (uyvy) {
+			_mm_storeu_si128((__m128i *)(dst + 2 * i), _mm_unpacklo_epi8(c, l));
+			_mm_storeu_si128((__m128i *)(dst + 2 * i + 16), _mm_unpackhi_epi8(c, l));
+		} else {
+			_mm_storeu_si128((__m128i *)(dst + 2 * i), _mm_unpacklo_epi8(l, c));
+			_mm_storeu_si128((__m128i *)(dst + 2 * i + 16), _mm_unpackhi_epi8(l, c));
+		}
+	}
+
+	i965_pack_422_c(dst + 2 * i, y + i, uv + i, n - i, uyvy);
+}
+
+__attribute__((target("sse4.1"))) static void
+i965_unpack_422_sse41(uint8_t *y0, uint8_t *y1, uint8_t *uv,
+					  const uint8_t *src0, const uint8_t *src1,
+					  unsigned int n, int uyvy)
+{
+	const __m128i mask = _mm_set1_epi16(0x00ff);
+	const int l = uyvy ? 8 : 0, c = uyvy ? 0 : 8;
+	unsigned int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m128i a0 = _mm_loadu_si128((const __m128i *)(src0 + 2 * i));
+		__m128i b0 = _mm_loadu_si128((const __m128i *)(src0 + 2 * i + 16));
+		__m128i a1 = _mm_loadu_si128((const __m128i *)(src1 + 2 * i));
+		__m128i b1 = _mm_loadu_si128((const __m128i *)(src1 + 2 * i + 16));
+		/* (a + b + 1) >> 1, the same rounding as the C path */
+		__m128i ac = _mm_avg_epu8(a0, a1);
+		__m128i bc = _mm_avg_epu8(b0, b1);
+
+		_mm_storeu_si128((__m128i *)(y0 + i),
+						 _mm_packus_epi16(_mm_and_si128(_mm_srli_epi16(a0, l), mask),
+										  _mm_and_si128(_mm_srli_epi16(b0, l), mask)));
+		_mm_storeu_si128((__m128i *)(y1 + i),
+						 _mm_packus_epi16(_mm_and_si128(_mm_srli_epi16(a1, l), mask),
+										  _mm_and_si128(_mm_srli_epi16(b1, l), mask)));
+		_mm_storeu_si128((__m128i *)(uv + i),
+						 _mm_packus_epi16(_mm_and_si128(_mm_srli_epi16(ac, c), mask),
+										  _mm_and_si128(_mm_srli_epi16(bc, c), mask)));
+	}
+
+	i965_unpack_422_c(y0 + i, y1 + i, uv + i, src0 + 2 * i, src1 + 2 * i, n - i, uyvy);
+}
+
+/* One row of the matrix on 32 bits lanes, rounded and shifted like matrix_row() */
+#define MATRIX_ROW_SSE41(row, a, b, c)                                          \
+	_mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(                                 \
+									 _mm_mullo_epi32(a, _mm_set1_epi32((row)[0])),  \
+									 _mm_mullo_epi32(b, _mm_set1_epi32((row)[1]))), \
+								 _mm_add_epi32(                                 \
+									 _mm_mullo_epi32(c, _mm_set1_epi32((row)[2])),  \
+									 _mm_set1_epi32(MATRIX_ROUND))),                \
+				   MATRIX_SHIFT)
+
+__attribute__((target("sse4.1"))) static void
+i965_yuv_to_rgb_sse41(uint8_t *dst, const uint8_t *y, const uint8_t *uv,
+					  unsigned int n, const struct i965_color_matrix *m, int bgr)
+{
+	const __m128i dup_u = _mm_setr_epi8(0, 0, 2, 2, -1, -1, -1, -1,
+										-1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i dup_v = _mm_setr_epi8(1, 1, 3, 3, -1, -1, -1, -1,
+										-1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i max = _mm_set1_epi32(255);
+	const __m128i alpha = _mm_set1_epi32(0xff000000);
+	const int s0 = bgr ? 16 : 0, s2 = bgr ? 0 : 16;
+	unsigned int i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		__m128i c = _mm_cvtsi32_si128(load_u32(uv + i));
+		__m128i yy = _mm_sub_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(load_u32(y + i))),
+								   _mm_set1_epi32(m->offsets[0]));
+		__m128i uu = _mm_sub_epi32(_mm_cvtepu8_epi32(_mm_shuffle_epi8(c, dup_u)),
+								   _mm_set1_epi32(m->offsets[1]));
+		__m128i vv = _mm_sub_epi32(_mm_cvtepu8_epi32(_mm_shuffle_epi8(c, dup_v)),
+								   _mm_set1_epi32(m->offsets[2]));
+		__m128i r, g, b;
+
+		r = _mm_min_epi32(_mm_max_epi32(MATRIX_ROW_SSE41(&m->to_rgb[0], yy, uu, vv), zero), max);
+		g = _mm_min_epi32(_mm_max_epi32(MATRIX_ROW_SSE41(&m->to_rgb[3], yy, uu, vv), zero), max);
+		b = _mm_min_epi32(_mm_max_epi32(MATRIX_ROW_SSE41(&m->to_rgb[6], yy, uu, vv), zero), max);
+
+		_mm_storeu_si128((__m128i *)(dst + 4 * i),
+						 _mm_or_si128(_mm_or_si128(_mm_slli_epi32(r, s0),
+												   _mm_slli_epi32(g, 8)),
+									  _mm_or_si128(_mm_slli_epi32(b, s2), alpha)));
+	}
+
+	i965_yuv_to_rgb_c(dst + 4 * i, y + i, uv + i, n - i, m, bgr);
+}
+
+__attribute__((target("sse4.1"))) static void
+i965_rgb_to_yuv_sse41(uint8_t *y0, uint8_t *y1, uint8_t *uv,
+					  const uint8_t *src0, const uint8_t *src1,
+					  unsigned int n, const struct i965_color_matrix *m, int bgr)
+{
+	const __m128i mask = _mm_set1_epi32(0xff);
+	const __m128i two = _mm_set1_epi32(2);
+	const int s0 = bgr ? 16 : 0, s2 = bgr ? 0 : 16;
+	unsigned int i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(src0 + 4 * i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(src1 + 4 * i));
+		__m128i ra = _mm_and_si128(_mm_srli_epi32(a, s0), mask);
+		__m128i ga = _mm_and_si128(_mm_srli_epi32(a, 8), mask);
+		__m128i ba = _mm_and_si128(_mm_srli_epi32(a, s2), mask);
+		__m128i rb = _mm_and_si128(_mm_srli_epi32(b, s0), mask);
+		__m128i gb = _mm_and_si128(_mm_srli_epi32(b, 8), mask);
+		__m128i bb = _mm_and_si128(_mm_srli_epi32(b, s2), mask);
+		__m128i ya, yb, rs, gs, bs, u, v;
+
+		ya = _mm_add_epi32(MATRIX_ROW_SSE41(&m->to_yuv[0], ra, ga, ba),
+						   _mm_set1_epi32(m->offsets[0]));
+		yb = _mm_add_epi32(MATRIX_ROW_SSE41(&m->to_yuv[0], rb, gb, bb),
+						   _mm_set1_epi32(m->offsets[0]));
+		/* the saturating packs clamp to 0..255 */
+		ya = _mm_packus_epi16(_mm_packus_epi32(ya, yb), ya);
+		store_u32(y0 + i, _mm_cvtsi128_si32(ya));
+		store_u32(y1 + i, _mm_cvtsi128_si32(_mm_srli_si128(ya, 4)));
+
+		/* the sums of the two 2x2 blocks in the low lanes */
+		rs = _mm_srai_epi32(_mm_add_epi32(_mm_hadd_epi32(_mm_add_epi32(ra, rb), ra), two), 2);
+		gs = _mm_srai_epi32(_mm_add_epi32(_mm_hadd_epi32(_mm_add_epi32(ga, gb), ga), two), 2);
+		bs = _mm_srai_epi32(_mm_add_epi32(_mm_hadd_epi32(_mm_add_epi32(ba, bb), ba), two), 2);
+
+		u = _mm_add_epi32(MATRIX_ROW_SSE41(&m->to_yuv[3], rs, gs, bs),
+						  _mm_set1_epi32(m->offsets[1]));
+		v = _mm_add_epi32(MATRIX_ROW_SSE41(&m->to_yuv[6], rs, gs, bs),
+						  _mm_set1_epi32(m->offsets[2]));
+		u = _mm_unpacklo_epi32(u, v);
+		u = _mm_packus_epi16(_mm_packus_epi32(u, u), u);
+		store_u32(uv + i, _mm_cvtsi128_si32(u));
+	}
+
+	i965_rgb_to_yuv_c(y0 + i, y1 + i, uv + i, src0 + 4 * i, src1 + 4 * i, n - i, m, bgr);
+}
+
+__attribute__((target("sse4.1"))) static void
+i965_to_p010_sse41(uint16_t *dst, const uint8_t *src, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i x = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(src + i)));
+
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_slli_epi16(x, 8));
+	}
+
+	i965_to_p010_c(dst + i, src + i, n - i);
+}
+
+__attribute__((target("sse4.1"))) static void
+i965_from_p010_sse41(uint8_t *dst, const uint16_t *src, unsigned int n)
+{
+	const __m128i two = _mm_set1_epi16(2);
+	unsigned int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(src + i + 8));
+
+		a = _mm_srli_epi16(_mm_add_epi16(_mm_srli_epi16(a, 6), two), 2);
+		b = _mm_srli_epi16(_mm_add_epi16(_mm_srli_epi16(b, 6), two), 2);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(a, b));
+	}
+
+	i965_from_p010_c(dst + i, src + i, n - i);
+}
+
+/*
+ * The AVX2 byte shuffles and packs work within each 128 bits lane, the
+ * results are put back in order with a cross lane permute.
+ */
+__attribute__((target("avx2"))) static void
+i965_split_uv_avx2(uint8_t *u, uint8_t *v, const uint8_t *uv, unsigned int n)
+{
+	const __m256i shuffle = _mm256_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14,
+											 1, 3, 5, 7, 9, 11, 13, 15,
+											 0, 2, 4, 6, 8, 10, 12, 14,
+											 1, 3, 5, 7, 9, 11, 13, 15);
+	unsigned int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m256i x = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(uv + 2 * i)), shuffle);
+
+		x = _mm256_permute4x64_epi64(x, 0xd8);
+		_mm_storeu_si128((__m128i *)(u + i), _mm256_castsi256_si128(x));
+		_mm_storeu_si128((__m128i *)(v + i), _mm256_extracti128_si256(x, 1));
+	}
+
+	i965_split_uv_sse41(u + i, v + i, uv + 2 * i, n - i);
+}
+
+__attribute__((target("avx2"))) static void
+i965_merge_uv_avx2(uint8_t *uv, const uint8_t *u, const uint8_t *v, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i + 32 <= n; i += 32) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)(u + i));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(v + i));
+		__m256i lo = _mm256_unpacklo_epi8(a, b);
+		__m256i hi = _mm256_unpackhi_epi8(a, b);
+
+		_mm256_storeu_si256((__m256i *)(uv + 2 * i), _mm256_permute2x128_si256(lo, hi, 0x20));
+		_mm256_storeu_si256((__m256i *)(uv + 2 * i + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+	}
+
+	i965_merge_uv_sse41(uv + 2 * i, u + i, v + i, n - i);
+}
+
+__attribute__((target("avx2"))) static void
+i965_pack_422_avx2(uint8_t *dst, const uint8_t *y, const uint8_t *uv,
+				   unsigned int n, int uyvy)
+{
+	unsigned int i;
+
+	for (i = 0; i + 32 <= n; i += 32) {
+		__m256i l = _mm256_loadu_si256((const __m256i *)(y + i));
+		__m256i c = _mm256_loadu_si256((const __m256i *)(uv + i));
+		__m256i lo = uyvy ? _mm256_unpacklo_epi8(c, l) : _mm256_unpacklo_epi8(l, c);
+		__m256i hi = uyvy ? _mm256_unpackhi_epi8(c, l) : _mm256_unpackhi_epi8(l, c);
+
+		_mm256_storeu_si256((__m256i *)(dst + 2 * i), _mm256_permute2x128_si256(lo, hi, 0x20));
+		_mm256_storeu_si256((__m256i *)(dst + 2 * i + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+	}
+
+	i965_pack_422_sse41(dst + 2 * i, y + i, uv + i, n - i, uyvy);
+}
+
+__attribute__((target("avx2"))) static void
+i965_unpack_422_avx2(uint8_t *y0, uint8_t *y1, uint8_t *uv,
+					 const uint8_t *src0, const uint8_t *src1,
+					 unsigned int n, int uyvy)
+{
+	const __m256i mask = _mm256_set1_epi16(0x00ff);
+	const int l = uyvy ? 8 : 0, c = uyvy ? 0 : 8;
+	unsigned int i;
+
+	for (i = 0; i + 32 <= n; i += 32) {
+		__m256i a0 = _mm256_loadu_si256((const __m256i *)(src0 + 2 * i));
+		__m256i b0 = _mm256_loadu_si256((const __m256i *)(src0 + 2 * i + 32));
+		__m256i a1 = _mm256_loadu_si256((const __m256i *)(src1 + 2 * i));
+		__m256i b1 = _mm256_loadu_si256((const __m256i *)(src1 + 2 * i + 32));
+		__m256i ac = _mm256_avg_epu8(a0, a1);
+		__m256i bc = _mm256_avg_epu8(b0, b1);
+		__m256i x;
+
+		x = _mm256_packus_epi16(_mm256_and_si256(_mm256_srli_epi16(a0, l), mask),
+								_mm256_and_si256(_mm256_srli_epi16(b0, l), mask));
+		_mm256_storeu_si256((__m256i *)(y0 + i), _mm256_permute4x64_epi64(x, 0xd8));
+		x = _mm256_packus_epi16(_mm256_and_si256(_mm256_srli_epi16(a1, l), mask),
+								_mm256_and_si256(_mm256_srli_epi16(b1, l), mask));
+		_mm256_storeu_si256((__m256i *)(y1 + i), _mm256_permute4x64_epi64(x, 0xd8));
+		x = _mm256_packus_epi16(_mm256_and_si256(_mm256_srli_epi16(ac, c), mask),
+								_mm256_and_si256(_mm256_srli_epi16(bc, c), mask));
+		_mm256_storeu_si256((__m256i *)(uv + i), _mm256_permute4x64_epi64(x, 0xd8));
+	}
+
+	i965_unpack_422_sse41(y0 + i, y1 + i, uv + i, src0 + 2 * i, src1 + 2 * i, n - i, uyvy);
+}
+
+#define MATRIX_ROW_AVX2(row, a, b, c)                                                   \
+	_mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(                                \
+										   _mm256_mullo_epi32(a, _mm256_set1_epi32((row)[0])),  \
+										   _mm256_mullo_epi32(b, _mm256_set1_epi32((row)[1]))), \
+									   _mm256_add_epi32(                                \
+										   _mm256_mullo_epi32(c, _mm256_set1_epi32((row)[2])),  \
+										   _mm256_set1_epi32(MATRIX_ROUND))),               \
+					  MATRIX_SHIFT)
+
+__attribute__((target("avx2"))) static void
+i965_yuv_to_rgb_avx2(uint8_t *dst, const uint8_t *y, const uint8_t *uv,
+					 unsigned int n, const struct i965_color_matrix *m, int bgr)
+{
+	const __m128i dup_u = _mm_setr_epi8(0, 0, 2, 2, 4, 4, 6, 6,
+										-1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i dup_v = _mm_setr_epi8(1, 1, 3, 3, 5, 5, 7, 7,
+										-1, -1, -1, -1, -1, -1, -1, -1);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i max = _mm256_set1_epi32(255);
+	const __m256i alpha = _mm256_set1_epi32(0xff000000);
+	const int s0 = bgr ? 16 : 0, s2 = bgr ? 0 : 16;
+	unsigned int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i c = _mm_loadl_epi64((const __m128i *)(uv + i));
+		__m256i yy = _mm256_sub_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(y + i))),
+									  _mm256_set1_epi32(m->offsets[0]));
+		__m256i uu = _mm256_sub_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(c, dup_u)),
+									  _mm256_set1_epi32(m->offsets[1]));
+		__m256i vv = _mm256_sub_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(c, dup_v)),
+									  _mm256_set1_epi32(m->offsets[2]));
+		__m256i r, g, b;
+
+		r = _mm256_min_epi32(_mm256_max_epi32(MATRIX_ROW_AVX2(&m->to_rgb[0], yy, uu, vv), zero), max);
+		g = _mm256_min_epi32(_mm256_max_epi32(MATRIX_ROW_AVX2(&m->to_rgb[3], yy, uu, vv), zero), max);
+		b = _mm256_min_epi32(_mm256_max_epi32(MATRIX_ROW_AVX2(&m->to_rgb[6], yy, uu, vv), zero), max);
+
+		_mm256_storeu_si256((__m256i *)(dst + 4 * i),
+							_mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(r, s0),
+															_mm256_slli_epi32(g, 8)),
+											_mm256_or_si256(_mm256_slli_epi32(b, s2), alpha)));
+	}
+
+	i965_yuv_to_rgb_sse41(dst + 4 * i, y + i, uv + i, n - i, m, bgr);
+}
+
+__attribute__((target("avx2"))) static void
+i965_rgb_to_yuv_avx2(uint8_t *y0, uint8_t *y1, uint8_t *uv,
+					 const uint8_t *src0, const uint8_t *src1,
+					 unsigned int n, const struct i965_color_matrix *m, int bgr)
+{
+	const __m256i mask = _mm256_set1_epi32(0xff);
+	const __m256i two = _mm256_set1_epi32(2);
+	const int s0 = bgr ? 16 : 0, s2 = bgr ? 0 : 16;
+	unsigned int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)(src0 + 4 * i));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(src1 + 4 * i));
+		__m256i ra = _mm256_and_si256(_mm256_srli_epi32(a, s0), mask);
+		__m256i ga = _mm256_and_si256(_mm256_srli_epi32(a, 8), mask);
+		__m256i ba = _mm256_and_si256(_mm256_srli_epi32(a, s2), mask);
+		__m256i rb = _mm256_and_si256(_mm256_srli_epi32(b, s0), mask);
+		__m256i gb = _mm256_and_si256(_mm256_srli_epi32(b, 8), mask);
+		__m256i bb = _mm256_and_si256(_mm256_srli_epi32(b, s2), mask);
+		__m256i ya, yb, rs, gs, bs, u, v;
+
+		ya = _mm256_add_epi32(MATRIX_ROW_AVX2(&m->to_yuv[0], ra, ga, ba),
+							  _mm256_set1_epi32(m->offsets[0]));
+		yb = _mm256_add_epi32(MATRIX_ROW_AVX2(&m->to_yuv[0], rb, gb, bb),
+							  _mm256_set1_epi32(m->offsets[0]));
+		/* per lane: 4 samples of row 0, 4 of row 1 */
+		ya = _mm256_packus_epi16(_mm256_packus_epi32(ya, yb), ya);
+		store_u32(y0 + i, _mm_cvtsi128_si32(_mm256_castsi256_si128(ya)));
+		store_u32(y0 + i + 4, _mm_cvtsi128_si32(_mm256_extracti128_si256(ya, 1)));
+		store_u32(y1 + i, _mm_extract_epi32(_mm256_castsi256_si128(ya), 1));
+		store_u32(y1 + i + 4, _mm_extract_epi32(_mm256_extracti128_si256(ya, 1), 1));
+
+		rs = _mm256_srai_epi32(_mm256_add_epi32(_mm256_hadd_epi32(_mm256_add_epi32(ra, rb), ra), two), 2);
+		gs = _mm256_srai_epi32(_mm256_add_epi32(_mm256_hadd_epi32(_mm256_add_epi32(ga, gb), ga), two), 2);
+		bs = _mm256_srai_epi32(_mm256_add_epi32(_mm256_hadd_epi32(_mm256_add_epi32(ba, bb), ba), two), 2);
+
+		u = _mm256_add_epi32(MATRIX_ROW_AVX2(&m->to_yuv[3], rs, gs, bs),
+							 _mm256_set1_epi32(m->offsets[1]));
+		v = _mm256_add_epi32(MATRIX_ROW_AVX2(&m->to_yuv[6], rs, gs, bs),
+							 _mm256_set1_epi32(m->offsets[2]));
+		u = _mm256_unpacklo_epi32(u, v);
+		u = _mm256_packus_epi16(_mm256_packus_epi32(u, u), u);
+		store_u32(uv + i, _mm_cvtsi128_si32(_mm256_castsi256_si128(u)));
+		store_u32(uv + i + 4, _mm_cvtsi128_si32(_mm256_extracti128_si256(u, 1)));
+	}
+
+	i965_rgb_to_yuv_sse41(y0 + i, y1 + i, uv + i, src0 + 4 * i, src1 + 4 * i, n - i, m, bgr);
+}
+
+__attribute__((target("avx2"))) static void
+i965_to_p010_avx2(uint16_t *dst, const uint8_t *src, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m256i x = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(src + i)));
+
+		_mm256_storeu_si256((__m256i *)(dst + i), _mm256_slli_epi16(x, 8));
+	}
+
+	i965_to_p010_sse41(dst + i, src + i, n - i);
+}
+
+__attribute__((target("avx2"))) static void
+i965_from_p010_avx2(uint8_t *dst, const uint16_t *src, unsigned int n)
+{
+	const __m256i two = _mm256_set1_epi16(2);
+	unsigned int i;
+
+	for (i = 0; i + 32 <= n; i += 32) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)(src + i));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(src + i + 16));
+
+		a = _mm256_srli_epi16(_mm256_add_epi16(_mm256_srli_epi16(a, 6), two), 2);
+		b = _mm256_srli_epi16(_mm256_add_epi16(_mm256_srli_epi16(b, 6), two), 2);
+		_mm256_storeu_si256((__m256i *)(dst + i),
+							_mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8));
+	}
+
+	i965_from_p010_sse41(dst + i, src + i, n - i);
+}
+#endif
+
+static const struct i965_color_convert_funcs i965_color_convert_funcs[] = {
+	[I965_COLOR_CONVERT_PATH_C] = {
+		i965_split_uv_c,
+		i965_merge_uv_c,
+		i965_pack_422_c,
+		i965_unpack_422_c,
+		i965_yuv_to_rgb_c,
+		i965_rgb_to_yuv_c,
+		i965_to_p010_c,
+		i965_from_p010_c,
+	},
+#ifdef I965_COLOR_CONVERT_X86
+	[I965_COLOR_CONVERT_PATH_SSE41] = {
+		i965_split_uv_sse41,
+		i965_merge_uv_sse41,
+		i965_pack_422_sse41,
+		i965_unpack_422_sse41,
+		i965_yuv_to_rgb_sse41,
+		i965_rgb_to_yuv_sse41,
+		i965_to_p010_sse41,
+		i965_from_p010_sse41,
+	},
+	[I965_COLOR_CONVERT_PATH_AVX2] = {
+		i965_split_uv_avx2,
+		i965_merge_uv_avx2,
+		i965_pack_422_avx2,
+		i965_unpack_422_avx2,
+		i965_yuv_to_rgb_avx2,
+		i965_rgb_to_yuv_avx2,
+		i965_to_p010_avx2,
+		i965_from_p010_avx2,
+	},
+#endif
+};
+
+static void
+i965_color_convert_init(void)
+{
+	long num_cpus;
+
+	i965_color_convert_best_path = I965_COLOR_CONVERT_PATH_C;
+
+#ifdef I965_COLOR_CONVERT_X86
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2"))
+		i965_color_convert_best_path = I965_COLOR_CONVERT_PATH_AVX2;
+	else if (__builtin_cpu_supports("sse4.1"))
+		i965_color_convert_best_path = I965_COLOR_CONVERT_PATH_SSE41;
+#endif
+
+	i965_color_convert_path = i965_color_convert_best_path;
+
+	num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	i965_color_convert_threads = num_cpus < 1 ? 1 : CONVERT_MIN(num_cpus, I965_COLOR_CONVERT_MAX_THREADS);
+}
+
+int
+i965_color_convert_set_path(int path)
+{
+	pthread_once(&i965_color_convert_once, i965_color_convert_init);
+
+	if (path < I965_COLOR_CONVERT_PATH_C)
+		path = I965_COLOR_CONVERT_PATH_C;
+
+	i965_color_convert_path = CONVERT_MIN(path, i965_color_convert_best_path);
+
+	return i965_color_convert_path;
+}
+
+int
+i965_color_convert_get_path(void)
+{
+	pthread_once(&i965_color_convert_once, i965_color_convert_init);
+
+	return i965_color_convert_path;
+}
+
+int
+i965_color_convert_set_threads(int num_threads)
+{
+	pthread_once(&i965_color_convert_once, i965_color_convert_init);
+
+	if (num_threads < 1)
+		num_threads = 1;
+
+	i965_color_convert_threads = CONVERT_MIN(num_threads, I965_COLOR_CONVERT_MAX_THREADS);
+
+	return i965_color_convert_threads;
+}
+
+static int
+is_rgb(unsigned int fourcc)
+{
+	return fourcc == VA_FOURCC_RGBX || fourcc == VA_FOURCC_BGRX;
+}
+
+static int
+is_packed_422(unsigned int fourcc)
+{
+	return fourcc == VA_FOURCC_YUY2 || fourcc == VA_FOURCC_UYVY;
+}
+
+static int
+is_planar_420(unsigned int fourcc)
+{
+	return fourcc == VA_FOURCC_I420 || fourcc == VA_FOURCC_YV12;
+}
+
+int
+i965_color_convert_supported(unsigned int dst_fourcc, unsigned int src_fourcc)
+{
+	unsigned int other;
+
+	if (dst_fourcc == src_fourcc)
+		return 0;
+
+	if (dst_fourcc == VA_FOURCC_NV12)
+		other = src_fourcc;
+	else if (src_fourcc == VA_FOURCC_NV12)
+		other = dst_fourcc;
+	else
+		return 0;
+
+	return is_rgb(other) || is_packed_422(other) || is_planar_420(other) ||
+		   other == VA_FOURCC_P010;
+}
+
+#define ROW(frame, plane, row) \
+	((frame)->planes[plane] + (size_t)(row) * (frame)->pitches[plane])
+
+/* Rows [y, y + height) of the frame, y is even */
+static void
+i965_color_convert_rows(const struct i965_color_convert_job *job)
+{
+	const struct i965_color_convert_funcs *funcs = job->funcs;
+	const struct i965_color_frame *dst = &job->dst;
+	const struct i965_color_frame *src = &job->src;
+	const unsigned int width = job->width;
+	const unsigned int chroma_width = (width + 1) / 2;
+	unsigned int r, last = job->frame_height - 1;
+
+	if (src->fourcc == VA_FOURCC_NV12) {
+		const unsigned int u = dst->fourcc == VA_FOURCC_YV12 ? 2 : 1;
+
+		for (r = job->y; r < job->y + job->height; r++) {
+			const uint8_t *y = ROW(src, 0, r), *uv = ROW(src, 1, r / 2);
+
+			if (is_planar_420(dst->fourcc)) {
+				memcpy(ROW(dst, 0, r), y, width);
+
+				if (!(r & 1))
+					funcs->split_uv(ROW(dst, u, r / 2), ROW(dst, 3 - u, r / 2), uv, chroma_width);
+			} else if (is_packed_422(dst->fourcc)) {
+				funcs->pack_422(ROW(dst, 0, r), y, uv, width, dst->fourcc == VA_FOURCC_UYVY);
+			} else if (is_rgb(dst->fourcc)) {
+				funcs->yuv_to_rgb(ROW(dst, 0, r), y, uv, width, job->matrix,
+								  dst->fourcc == VA_FOURCC_BGRX);
+			} else {
+				funcs->to_p010((uint16_t *)ROW(dst, 0, r), y, width);
+
+				if (!(r & 1))
+					funcs->to_p010((uint16_t *)ROW(dst, 1, r / 2), uv, 2 * chroma_width);
+			}
+		}
+	} else {
+		const unsigned int u = src->fourcc == VA_FOURCC_YV12 ? 2 : 1;
+
+		/* by pairs of rows, the second one is the first one again at an odd end */
+		for (r = job->y; r < job->y + job->height; r += 2) {
+			const unsigned int r1 = r < last ? r + 1 : r;
+			uint8_t *uv = ROW(dst, 1, r / 2);
+
+			if (is_planar_420(src->fourcc)) {
+				memcpy(ROW(dst, 0, r), ROW(src, 0, r), width);
+				memcpy(ROW(dst, 0, r1), ROW(src, 0, r1), width);
+				funcs->merge_uv(uv, ROW(src, u, r / 2), ROW(src, 3 - u, r / 2), chroma_width);
+			} else if (is_packed_422(src->fourcc)) {
+				funcs->unpack_422(ROW(dst, 0, r), ROW(dst, 0, r1), uv,
+								  ROW(src, 0, r), ROW(src, 0, r1), width,
+								  src->fourcc == VA_FOURCC_UYVY);
+			} else if (is_rgb(src->fourcc)) {
+				funcs->rgb_to_yuv(ROW(dst, 0, r), ROW(dst, 0, r1), uv,
+								  ROW(src, 0, r), ROW(src, 0, r1), width, job->matrix,
+								  src->fourcc == VA_FOURCC_BGRX);
+			} else {
+				funcs->from_p010(ROW(dst, 0, r), (const uint16_t *)ROW(src, 0, r), width);
+				funcs->from_p010(ROW(dst, 0, r1), (const uint16_t *)ROW(src, 0, r1), width);
+				funcs->from_p010(uv, (const uint16_t *)ROW(src, 1, r / 2), 2 * chroma_width);
+			}
+		}
+	}
+}
+
+static void *
+i965_color_convert_job_run(void *arg)
+{
+	i965_color_convert_rows(arg);
+
+	return NULL;
+}
+
+int
+i965_color_convert(struct i965_color_frame *dst,
+				   const struct i965_color_frame *src,
+				   unsigned int width, unsigned int height,
+				   VAProcColorStandardType standard)
+{
+	struct i965_color_convert_job stripes[I965_COLOR_CONVERT_MAX_THREADS];
+	pthread_t threads[I965_COLOR_CONVERT_MAX_THREADS];
+	bool started[I965_COLOR_CONVERT_MAX_THREADS];
+	struct i965_color_matrix matrix;
+	struct i965_color_convert_job job;
+	unsigned int num_stripes, start, i;
+
+	if (!i965_color_convert_supported(dst->fourcc, src->fourcc))
+		return -1;
+
+	if (!width || !height)
+		return 0;
+
+	pthread_once(&i965_color_convert_once, i965_color_convert_init);
+
+	i965_color_matrix_init(&matrix, standard);
+
+	job.funcs = &i965_color_convert_funcs[i965_color_convert_path];
+	job.matrix = &matrix;
+	job.dst = *dst;
+	job.src = *src;
+	job.width = width;
+	job.y = 0;
+	job.height = height;
+	job.frame_height = height;
+
+	num_stripes = i965_color_convert_threads;
+
+	if (num_stripes <= 1 ||
+		height < 2 * num_stripes ||
+		(uint64_t)width * height < I965_COLOR_CONVERT_MT_THRESHOLD) {
+		i965_color_convert_rows(&job);
+		return 0;
+	}
+
+	/* Stripes start on even rows, so that no chroma row is shared */
+	for (i = 0, start = 0; i < num_stripes; i++) {
+		unsigned int end = height;
+
+		if (i + 1 < num_stripes)
+			end = ((uint64_t)height * (i + 1) / num_stripes) & ~1;
+
+		stripes[i] = job;
+		stripes[i].y = start;
+		stripes[i].height = end - start;
+		start = end;
+	}
+
+	for (i = 1; i < num_stripes; i++) {
+		started[i] = !pthread_create(&threads[i], NULL, i965_color_convert_job_run, &stripes[i]);
+
+		if (!started[i])
+			i965_color_convert_rows(&stripes[i]);
+	}
+
+	i965_color_convert_rows(&stripes[0]);
+
+	for (i = 1; i < num_stripes; i++) {
+		if (started[i])
+			pthread_join(threads[i], NULL);
+	}
+
+	return 0;
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _I965_COLOR_CONVERT_H_
+#define _I965_COLOR_CONVERT_H_
+
+#include <stdint.h>
+
+#include <va/va.h>
+#include <va/va_vpp.h>
+
+/*
+ * CPU conversions between NV12 and I420, YV12, YUY2, UYVY, RGBX, BGRX and
+ * P010, used by the software vaGetImage()/vaPutImage() paths when the
+ * surface and the image formats differ.
+ *
+ * Both frames are linear, the planes are in the memory order of the fourcc
+ * (V before U for YV12) and start at the top left pixel of the region. The
+ * 4:2:0 chroma covers a 2x2 block: it is the average of the block when
+ * downsampling and is replicated when upsampling. The RGB matrices are the
+ * ones of i965_yuv_coefs.c in 13 bits fixed point, so that the SIMD paths
+ * produce exactly the output of the C one.
+ */
+
+enum i965_color_convert_path {
+	I965_COLOR_CONVERT_PATH_C = 0,
+	I965_COLOR_CONVERT_PATH_SSE41,
+	I965_COLOR_CONVERT_PATH_AVX2,
+};
+
+/* Frames larger than this many pixels are split in stripes over several threads */
+#define I965_COLOR_CONVERT_MT_THRESHOLD     (512 * 1024)
+#define I965_COLOR_CONVERT_MAX_THREADS      4
+
+struct i965_color_frame {
+	unsigned int fourcc;
+	uint8_t *planes[3];
+	unsigned int pitches[3];
+};
+
+/*
+ * Path and thread count default to the best the machine offers. The
+ * overrides exist so the SIMD output can be checked bit exact against the
+ * C path; they clamp the request and return what the conversions will run
+ * with.
+ */
+int i965_color_convert_set_path(int path);
+int i965_color_convert_get_path(void);
+int i965_color_convert_set_threads(int num_threads);
+
+int
+i965_color_convert_supported(unsigned int dst_fourcc, unsigned int src_fourcc);
+
+/* Returns 0 on success, -1 if the pair of formats isn't supported */
+int
+i965_color_convert(struct i965_color_frame *dst,
+				   const struct i965_color_frame *src,
+				   unsigned int width, unsigned int height,
+				   VAProcColorStandardType standard);
+
+#endif /* _I965_COLOR_CONVERT_H_ */
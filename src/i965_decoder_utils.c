@@ -29,6 +29,8 @@
 #include "i965_drv_video.h"
 #include "i965_decoder_utils.h"
 #include "i965_defines.h"
+#include "i965_byte_scan.h"
+#include "i965_vc1_bitplane.h"
 
 static const int fptype_to_picture_type[8][2] = {
 	{VC1_I_PICTURE, VC1_I_PICTURE},
@@ -294,7 +296,7 @@ avc_get_picture_id(struct object_surface *obj_surface)
 	   that holes in there are filled in for subsequent allocations.
 	   So, this ultimately means that we could just use the Heap ID of
 	   the VA surface as the resulting picture ID (16 bits) */
-	pic_id = 1 + (obj_surface->base.id & OBJECT_HEAP_ID_MASK);
+	pic_id = 1 + (obj_surface->base.id & OBJECT_HEAP_INDEX_MASK);
 	return (pic_id <= 0xffff) ? pic_id : -1;
 }
 
@@ -336,13 +338,14 @@ avc_get_first_mb_bit_offset(
 unsigned int
 avc_get_first_mb_bit_offset_with_epb(
 	dri_bo                     *slice_data_bo,
+	const uint8_t              *slice_data,
 	VASliceParameterBufferH264 *slice_param,
 	unsigned int                mode_flag
 )
 {
 	unsigned int in_slice_data_bit_offset = slice_param->slice_data_bit_offset;
 	unsigned int out_slice_data_bit_offset;
-	unsigned int i, j, n = 0, buf_size, data_size, header_size;
+	unsigned int n = 0, buf_size, data_size, header_size;
 	uint8_t *buf;
 	int ret;
 
@@ -353,6 +356,13 @@ avc_get_first_mb_bit_offset_with_epb(
 	if (buf_size > data_size)
 		buf_size = data_size;
 
+	/* Scan the mapping in place when the caller has one */
+	if (slice_data) {
+		n = i965_byte_scan_count_epb(slice_data + slice_param->slice_data_offset,
+									 buf_size, header_size);
+		goto out;
+	}
+
 	buf = malloc(buf_size);
 
 	if (!buf)
@@ -364,10 +374,7 @@ avc_get_first_mb_bit_offset_with_epb(
 		  );
 	assert(ret == 0);
 
-	for (i = 2, j = 2, n = 0; i < buf_size && j < header_size; i++, j++) {
-		if (buf[i] == 0x03 && buf[i - 1] == 0x00 && buf[i - 2] == 0x00)
-			i += 2, j++, n++;
-	}
+	n = i965_byte_scan_count_epb(buf, buf_size, header_size);
 
 	free(buf);
 
@@ -1540,6 +1547,46 @@ intel_ensure_vp8_segmentation_buffer(VADriverContextP ctx, GenBuffer *buf,
 	return buf->valid;
 }
 
+bool
+intel_update_vc1_bitplane_buffer(VADriverContextP ctx, GenBuffer *buf,
+								 const uint8_t *bitplane,
+								 unsigned int mb_width, unsigned int mb_height)
+{
+	struct i965_driver_data * const i965 = i965_driver_data(ctx);
+	/* Two MBs per byte, each MB row starts on a new byte */
+	const unsigned int pitch = ALIGN(mb_width, 2) / 2;
+	const unsigned int buf_size = pitch * mb_height;
+
+	/* The BO is kept across pictures, unless it is too small or mapping
+	   it would wait for the previous picture to be decoded */
+	if (buf->bo && (buf->bo->size < buf_size || drm_intel_bo_busy(buf->bo))) {
+		drm_intel_bo_unreference(buf->bo);
+		buf->bo = NULL;
+	}
+
+	if (!buf->bo) {
+		buf->bo = drm_intel_bo_alloc(i965->intel.bufmgr, "VC-1 Bitplane",
+									 buf_size, 0x1000);
+		if (!buf->bo) {
+			buf->valid = false;
+			return false;
+		}
+	}
+
+	dri_bo_map(buf->bo, True);
+	assert(buf->bo->virtual);
+
+	if (bitplane)
+		i965_vc1_bitplane_repack(buf->bo->virtual, pitch, bitplane, mb_width, mb_height);
+	else
+		i965_vc1_bitplane_fill_skipped(buf->bo->virtual, pitch, mb_width, mb_height);
+
+	dri_bo_unmap(buf->bo);
+
+	buf->valid = true;
+	return true;
+}
+
 void
 hevc_gen_default_iq_matrix(VAIQMatrixBufferHEVC *iq_matrix)
 {
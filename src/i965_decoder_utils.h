@@ -70,6 +70,7 @@ avc_get_first_mb_bit_offset(
 unsigned int
 avc_get_first_mb_bit_offset_with_epb(
 	dri_bo                     *slice_data_bo,
+	const uint8_t              *slice_data,
 	VASliceParameterBufferH264 *slice_param,
 	unsigned int                mode_flag
 );
@@ -175,6 +176,12 @@ bool
 intel_ensure_vp8_segmentation_buffer(VADriverContextP ctx, GenBuffer *buf,
 									 unsigned int mb_width, unsigned int mb_height);
 
+/* Uploads the VC-1 bitplane, or the one of a skipped picture if bitplane is NULL */
+bool
+intel_update_vc1_bitplane_buffer(VADriverContextP ctx, GenBuffer *buf,
+								 const uint8_t *bitplane,
+								 unsigned int mb_width, unsigned int mb_height);
+
 void
 hevc_gen_default_iq_matrix(VAIQMatrixBufferHEVC *iq_matrix);
 
@@ -29,6 +29,8 @@
 
 #include "sysdeps.h"
 #include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
 #include <dlfcn.h>
 #include <drm_fourcc.h>
 
@@ -51,6 +53,9 @@
 
 #include "i965_post_processing.h"
 #include "i965_format_utils.h"
+#include "i965_image_copy.h"
+#include "i965_color_convert.h"
+#include "i965_byte_scan.h"
 
 #include "gen9_vp9_encapi.h"
 
@@ -388,6 +393,15 @@ is_surface_busy(struct i965_driver_data *i965,
 	return false;
 }
 
+/* Decoded frames in a deferred batch are only seen once it is submitted */
+static inline void
+i965_flush_deferred_surface(struct i965_driver_data *i965,
+							struct object_surface *obj_surface)
+{
+	if (obj_surface->bo)
+		intel_batchbuffer_flush_deferred_bo(&i965->intel, obj_surface->bo);
+}
+
 /* Checks whether the image is in busy state */
 static bool
 is_image_busy(struct i965_driver_data *i965, struct object_image *obj_image, VASurfaceID surface)
@@ -488,10 +502,14 @@ i965_surface_wrapper(VADriverContextP ctx, VASurfaceID surface)
 		VASurfaceAttribExternalBuffers buffer_descriptor;
 		VAGenericID wrapper_surface;
 
-		if (drm_intel_bo_gem_export_to_prime(obj_surface->bo, &fd_handle) != 0)
-			return VA_STATUS_ERROR_OPERATION_FAILED;
+		if (obj_surface->exported_primefd < 0) {
+			if (drm_intel_bo_gem_export_to_prime(obj_surface->bo, &fd_handle) != 0)
+				return VA_STATUS_ERROR_OPERATION_FAILED;
+
+			obj_surface->exported_primefd = fd_handle;
+		}
 
-		obj_surface->exported_primefd = fd_handle;
+		fd_handle = obj_surface->exported_primefd;
 
 		memset(&attrib_list, 0, sizeof(attrib_list));
 		memset(&buffer_descriptor, 0, sizeof(buffer_descriptor));
@@ -542,6 +560,7 @@ i965_QueryConfigProfiles(VADriverContextP ctx,
 						 VAProfile *profile_list,       /* out */
 						 int *num_profiles)             /* out */
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data * const i965 = i965_driver_data(ctx);
 	int i = 0;
 
@@ -639,6 +658,7 @@ i965_QueryConfigEntrypoints(VADriverContextP ctx,
 							VAEntrypoint *entrypoint_list,      /* out */
 							int *num_entrypoints)               /* out */
 {
+	I965_TRACE_FUNCTION();
 	if (!ctx)
 		return VA_STATUS_ERROR_INVALID_CONTEXT;
 
@@ -1168,6 +1188,7 @@ i965_GetConfigAttributes(VADriverContextP ctx,
 						 VAConfigAttrib *attrib_list,  /* in/out */
 						 int num_attribs)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *const i965 = i965_driver_data(ctx);
 	VAStatus va_status;
 	int i;
@@ -1517,6 +1538,7 @@ i965_CreateConfig(VADriverContextP ctx,
 				  int num_attribs,
 				  VAConfigID *config_id)        /* out */
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data * const i965 = i965_driver_data(ctx);
 	struct object_config *obj_config;
 	int configID;
@@ -1686,6 +1708,7 @@ i965_CreateConfig(VADriverContextP ctx,
 VAStatus
 i965_DestroyConfig(VADriverContextP ctx, VAConfigID config_id)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_config *obj_config = CONFIG(config_id);
 	VAStatus vaStatus;
@@ -1714,6 +1737,7 @@ VAStatus i965_QueryConfigAttributes(VADriverContextP ctx,
 									VAConfigAttrib *attrib_list,        /* out */
 									int *num_attribs)                   /* out */
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_config *obj_config = CONFIG(config_id);
 	VAStatus vaStatus = VA_STATUS_SUCCESS;
@@ -1737,8 +1761,35 @@ i965_destroy_surface_storage(struct object_surface *obj_surface)
 	if (!obj_surface)
 		return;
 
-	dri_bo_unreference(obj_surface->bo);
+	/* The exported fd and layout describe this storage only */
+	if (obj_surface->exported_primefd >= 0) {
+		close(obj_surface->exported_primefd);
+		obj_surface->exported_primefd = -1;
+	}
+
+	free(obj_surface->exported_desc);
+	obj_surface->exported_desc = NULL;
+
+	intel_fence_set_reset(&obj_surface->fences);
+	obj_surface->fences_valid = 0;
+
+	/* Recycle the storage unless it may still be seen outside the driver */
+	if (obj_surface->prime_cache)
+		i965_prime_cache_release(obj_surface->prime_cache,
+								 &obj_surface->prime_key,
+								 obj_surface->bo);
+	else if (obj_surface->pool &&
+		obj_surface->derived_image_id == VA_INVALID_ID &&
+		drm_intel_bo_is_reusable(obj_surface->bo))
+		i965_surface_pool_release(obj_surface->pool,
+								  &obj_surface->pool_key,
+								  obj_surface->bo);
+	else
+		dri_bo_unreference(obj_surface->bo);
+
 	obj_surface->bo = NULL;
+	obj_surface->pool = NULL;
+	obj_surface->prime_cache = NULL;
 
 	if (obj_surface->free_private_data != NULL) {
 		obj_surface->free_private_data(&obj_surface->private_data);
@@ -1810,10 +1861,21 @@ i965_surface_external_memory(VADriverContextP ctx,
 		obj_surface->bo = drm_intel_bo_gem_create_from_name(i965->intel.bufmgr,
 															"gem flinked vaapi surface",
 															memory_attribute->buffers[index]);
-	else if (external_memory_type == I965_SURFACE_MEM_DRM_PRIME)
-		obj_surface->bo = drm_intel_bo_gem_create_from_prime(i965->intel.bufmgr,
-															 memory_attribute->buffers[index],
-															 obj_surface->size);
+	else if (external_memory_type == I965_SURFACE_MEM_DRM_PRIME) {
+		obj_surface->bo = i965_prime_cache_import(&i965->prime_cache,
+												  memory_attribute->buffers[index],
+												  obj_surface->size,
+												  &obj_surface->prime_key);
+
+		if (obj_surface->bo)
+			obj_surface->prime_cache = &i965->prime_cache;
+
+		/*
+		 * A cached import may still be written by a deferred decode batch
+		 * of the surface that released it
+		 */
+		i965_flush_deferred_surface(i965, obj_surface);
+	}
 
 	if (!obj_surface->bo)
 		return VA_STATUS_ERROR_INVALID_PARAMETER;
@@ -2059,6 +2121,7 @@ i965_CreateSurfaces2(
 	unsigned int        num_attribs
 )
 {
+	I965_TRACE_FUNCTION();
 	ASSERT_RET(ctx, VA_STATUS_ERROR_INVALID_CONTEXT);
 	ASSERT_RET(width, VA_STATUS_ERROR_INVALID_PARAMETER);
 	ASSERT_RET(height, VA_STATUS_ERROR_INVALID_PARAMETER);
@@ -2172,7 +2235,8 @@ i965_CreateSurfaces2(
 		obj_surface->user_disable_tiling = false;
 		obj_surface->user_h_stride_set = false;
 		obj_surface->user_v_stride_set = false;
-		obj_surface->border_cleared = false;
+		obj_surface->generation = 1;
+		obj_surface->border_generation = 0;
 
 		obj_surface->subpic_render_idx = 0;
 		for (j = 0; j < I965_MAX_SUBPIC_SUM; j++) {
@@ -2196,6 +2260,11 @@ i965_CreateSurfaces2(
 
 		obj_surface->wrapper_surface = VA_INVALID_ID;
 		obj_surface->exported_primefd = -1;
+		obj_surface->exported_desc = NULL;
+		obj_surface->pool = NULL;
+		obj_surface->prime_cache = NULL;
+		intel_fence_set_init(&obj_surface->fences);
+		obj_surface->fences_valid = 0;
 
 		switch (memory_type) {
 		case I965_SURFACE_MEM_NATIVE:
@@ -2285,6 +2354,7 @@ i965_CreateSurfaces(VADriverContextP ctx,
 					int num_surfaces,
 					VASurfaceID *surfaces)      /* out */
 {
+	I965_TRACE_FUNCTION();
 	return i965_CreateSurfaces2(ctx,
 								format,
 								width,
@@ -2300,6 +2370,7 @@ i965_DestroySurfaces(VADriverContextP ctx,
 					 VASurfaceID *surface_list,
 					 int num_surfaces)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	int i;
 	VAStatus va_status = VA_STATUS_SUCCESS;
@@ -2317,10 +2388,6 @@ i965_DestroySurfaces(VADriverContextP ctx,
 										  1));
 			obj_surface->wrapper_surface = VA_INVALID_ID;
 		}
-		if (obj_surface->exported_primefd >= 0) {
-			close(obj_surface->exported_primefd);
-			obj_surface->exported_primefd = -1;
-		}
 
 		i965_destroy_surface(&i965->surface_heap, (struct object_base *)obj_surface);
 	}
@@ -2333,6 +2400,7 @@ i965_QueryImageFormats(VADriverContextP ctx,
 					   VAImageFormat *format_list,      /* out */
 					   int *num_formats)                /* out */
 {
+	I965_TRACE_FUNCTION();
 	if (!ctx)
 		return VA_STATUS_ERROR_INVALID_CONTEXT;
 
@@ -2416,6 +2484,7 @@ i965_QuerySubpictureFormats(VADriverContextP ctx,
 							unsigned int *flags,                /* out */
 							unsigned int *num_formats)          /* out */
 {
+	I965_TRACE_FUNCTION();
 	int n;
 
 	for (n = 0; i965_subpic_formats_map[n].va_format.fourcc != 0; n++) {
@@ -2445,6 +2514,7 @@ i965_CreateSubpicture(VADriverContextP ctx,
 					  VAImageID image,
 					  VASubpictureID *subpicture)         /* out */
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	VASubpictureID subpicID = NEW_SUBPIC_ID()
 							  struct object_subpic * obj_subpic = SUBPIC(subpicID);
@@ -2477,6 +2547,7 @@ VAStatus
 i965_DestroySubpicture(VADriverContextP ctx,
 					   VASubpictureID subpicture)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_subpic *obj_subpic = SUBPIC(subpicture);
 
@@ -2493,6 +2564,7 @@ i965_SetSubpictureImage(VADriverContextP ctx,
 						VASubpictureID subpicture,
 						VAImageID image)
 {
+	I965_TRACE_FUNCTION();
 	/* TODO */
 	return VA_STATUS_ERROR_UNIMPLEMENTED;
 }
@@ -2504,6 +2576,7 @@ i965_SetSubpictureChromakey(VADriverContextP ctx,
 							unsigned int chromakey_max,
 							unsigned int chromakey_mask)
 {
+	I965_TRACE_FUNCTION();
 	/* TODO */
 	return VA_STATUS_ERROR_UNIMPLEMENTED;
 }
@@ -2513,6 +2586,7 @@ i965_SetSubpictureGlobalAlpha(VADriverContextP ctx,
 							  VASubpictureID subpicture,
 							  float global_alpha)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_subpic *obj_subpic = SUBPIC(subpicture);
 
@@ -2547,6 +2621,7 @@ i965_AssociateSubpicture(VADriverContextP ctx,
 						  */
 						 unsigned int flags)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_subpic *obj_subpic = SUBPIC(subpicture);
 	int i, j;
@@ -2595,6 +2670,7 @@ i965_DeassociateSubpicture(VADriverContextP ctx,
 						   VASurfaceID *target_surfaces,
 						   int num_surfaces)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_subpic *obj_subpic = SUBPIC(subpicture);
 	int i, j;
@@ -2788,6 +2864,7 @@ i965_CreateContext(VADriverContextP ctx,
 				   int num_render_targets,
 				   VAContextID *context)                /* out */
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_config *obj_config = CONFIG(config_id);
 	struct object_context *obj_context = NULL;
@@ -2934,6 +3011,8 @@ i965_CreateContext(VADriverContextP ctx,
 			obj_context->codec_type = CODEC_DEC;
 			memset(&obj_context->codec_state.decode, 0, sizeof(obj_context->codec_state.decode));
 			obj_context->codec_state.decode.current_render_target = -1;
+			obj_context->codec_state.decode.picture_width = picture_width;
+			obj_context->codec_state.decode.picture_height = picture_height;
 			obj_context->codec_state.decode.max_slice_params = NUM_SLICES;
 			obj_context->codec_state.decode.max_slice_datas = NUM_SLICES;
 			obj_context->codec_state.decode.slice_params = calloc(obj_context->codec_state.decode.max_slice_params,
@@ -2989,6 +3068,7 @@ i965_CreateContext(VADriverContextP ctx,
 VAStatus
 i965_DestroyContext(VADriverContextP ctx, VAContextID context)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_context *obj_context = CONTEXT(context);
 	VAStatus va_status = VA_STATUS_SUCCESS;
@@ -3226,6 +3306,7 @@ i965_CreateBuffer(VADriverContextP ctx,
 				  void *data,                   /* in */
 				  VABufferID *buf_id)           /* out */
 {
+	I965_TRACE_FUNCTION();
 	return i965_create_buffer_internal(ctx, context, type, size, num_elements, data, NULL, buf_id);
 }
 
@@ -3235,6 +3316,7 @@ i965_BufferSetNumElements(VADriverContextP ctx,
 						  VABufferID buf_id,           /* in */
 						  unsigned int num_elements)   /* in */
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_buffer *obj_buffer = BUFFER(buf_id);
 	VAStatus vaStatus = VA_STATUS_SUCCESS;
@@ -3271,6 +3353,7 @@ i965_MapBuffer(VADriverContextP ctx,
 			   VABufferID buf_id,		/* in */
 			   void **pbuf)				/* out */
 {
+	I965_TRACE_FUNCTION();
 	return i965_MapBuffer2(ctx, buf_id, pbuf, VA_MAPBUFFER_FLAG_DEFAULT);
 }
 
@@ -3280,6 +3363,7 @@ i965_MapBuffer2(VADriverContextP ctx,
 			   void **pbuf,				/* out */
 			   uint32_t flags)			/* in */
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_buffer *obj_buffer = BUFFER(buf_id);
 	VAStatus vaStatus = VA_STATUS_ERROR_UNKNOWN;
@@ -3287,6 +3371,10 @@ i965_MapBuffer2(VADriverContextP ctx,
 
 	ASSERT_RET(obj_buffer && obj_buffer->buffer_store, VA_STATUS_ERROR_INVALID_BUFFER);
 
+	/* the image of a derived surface */
+	if (obj_buffer->buffer_store->bo)
+		intel_batchbuffer_flush_deferred_bo(&i965->intel, obj_buffer->buffer_store->bo);
+
 	obj_context = CONTEXT(obj_buffer->context_id);
 
 	/* When the wrapper_buffer exists, it will wrapper to the
@@ -3333,79 +3421,81 @@ i965_MapBuffer2(VADriverContextP ctx,
 		vaStatus = VA_STATUS_SUCCESS;
 
 		if (obj_buffer->type == VAEncCodedBufferType) {
-			int i;
 			unsigned char *buffer = NULL;
 			unsigned int  header_offset = I965_CODEDBUFFER_HEADER_SIZE;
 			struct i965_coded_buffer_segment *coded_buffer_segment = (struct i965_coded_buffer_segment *)(obj_buffer->buffer_store->bo->virtual);
 
 			if (!coded_buffer_segment->mapped) {
-				unsigned char delimiter0, delimiter1, delimiter2, delimiter3, delimiter4;
+				unsigned char delimiter[5];
+				const unsigned char *end;
+				int len;
 
 				coded_buffer_segment->base.buf = buffer = (unsigned char *)(obj_buffer->buffer_store->bo->virtual) + I965_CODEDBUFFER_HEADER_SIZE;
+				vaStatus = VA_STATUS_SUCCESS;
 
+				/*
+				 * get_status() clears status_support when the size reported
+				 * by the hardware can't be used, the coded buffer is then
+				 * scanned for the delimiter appended by the encoder.
+				 */
 				if (obj_context &&
 					obj_context->hw_context &&
 					obj_context->hw_context->get_status &&
 					coded_buffer_segment->status_support) {
 					vaStatus = obj_context->hw_context->get_status(ctx, obj_context->hw_context, coded_buffer_segment);
-				} else {
+				}
+
+				if (vaStatus == VA_STATUS_SUCCESS && !coded_buffer_segment->status_support) {
 					if (coded_buffer_segment->codec == CODEC_H264 ||
 						coded_buffer_segment->codec == CODEC_H264_MVC) {
-						delimiter0 = H264_DELIMITER0;
-						delimiter1 = H264_DELIMITER1;
-						delimiter2 = H264_DELIMITER2;
-						delimiter3 = H264_DELIMITER3;
-						delimiter4 = H264_DELIMITER4;
+						delimiter[0] = H264_DELIMITER0;
+						delimiter[1] = H264_DELIMITER1;
+						delimiter[2] = H264_DELIMITER2;
+						delimiter[3] = H264_DELIMITER3;
+						delimiter[4] = H264_DELIMITER4;
 					} else if (coded_buffer_segment->codec == CODEC_MPEG2) {
-						delimiter0 = MPEG2_DELIMITER0;
-						delimiter1 = MPEG2_DELIMITER1;
-						delimiter2 = MPEG2_DELIMITER2;
-						delimiter3 = MPEG2_DELIMITER3;
-						delimiter4 = MPEG2_DELIMITER4;
+						delimiter[0] = MPEG2_DELIMITER0;
+						delimiter[1] = MPEG2_DELIMITER1;
+						delimiter[2] = MPEG2_DELIMITER2;
+						delimiter[3] = MPEG2_DELIMITER3;
+						delimiter[4] = MPEG2_DELIMITER4;
 					} else if (coded_buffer_segment->codec == CODEC_JPEG) {
 						//In JPEG End of Image (EOI = 0xDDF9) marker can be used for delimiter.
-						delimiter0 = 0xFF;
-						delimiter1 = 0xD9;
+						delimiter[0] = 0xFF;
+						delimiter[1] = 0xD9;
 					} else if (coded_buffer_segment->codec == CODEC_HEVC) {
-						delimiter0 = HEVC_DELIMITER0;
-						delimiter1 = HEVC_DELIMITER1;
-						delimiter2 = HEVC_DELIMITER2;
-						delimiter3 = HEVC_DELIMITER3;
-						delimiter4 = HEVC_DELIMITER4;
+						delimiter[0] = HEVC_DELIMITER0;
+						delimiter[1] = HEVC_DELIMITER1;
+						delimiter[2] = HEVC_DELIMITER2;
+						delimiter[3] = HEVC_DELIMITER3;
+						delimiter[4] = HEVC_DELIMITER4;
 					} else if (coded_buffer_segment->codec != CODEC_VP8) {
 						ASSERT_RET(0, VA_STATUS_ERROR_UNSUPPORTED_PROFILE);
 					}
 
 					if (coded_buffer_segment->codec == CODEC_JPEG) {
-						int len = obj_buffer->size_element - header_offset - 1 - 0x1000;
-						unsigned char *end_of_file_marker = memmem(buffer, len, "\xff\xd9", 2);
-						if (end_of_file_marker == NULL)
+						len = obj_buffer->size_element - header_offset - 1 - 0x1000;
+						end = i965_byte_scan_find(buffer, len, delimiter, 2);
+						if (end == NULL)
 							coded_buffer_segment->base.size = len + 2;
 						else
-							coded_buffer_segment->base.size = (end_of_file_marker - buffer) + 2;
+							coded_buffer_segment->base.size = (end - buffer) + 2;
 					} else if (coded_buffer_segment->codec != CODEC_VP8) {
 						/* vp8 coded buffer size can be told by vp8 internal statistics buffer,
 						   so it don't need to traversal the coded buffer */
-						for (i = 0; i < obj_buffer->size_element - header_offset - 3 - 0x1000; i++) {
-							if ((buffer[i] == delimiter0) &&
-								(buffer[i + 1] == delimiter1) &&
-								(buffer[i + 2] == delimiter2) &&
-								(buffer[i + 3] == delimiter3) &&
-								(buffer[i + 4] == delimiter4))
-								break;
-						}
-
-						if (i == obj_buffer->size_element - header_offset - 3 - 0x1000) {
+						len = obj_buffer->size_element - header_offset - 3 - 0x1000;
+						end = i965_byte_scan_find(buffer, len + 4, delimiter, 5);
+						if (end == NULL) {
 							coded_buffer_segment->base.status |= VA_CODED_BUF_STATUS_SLICE_OVERFLOW_MASK;
+							coded_buffer_segment->base.size = len;
+						} else {
+							coded_buffer_segment->base.size = end - buffer;
 						}
-						coded_buffer_segment->base.size = i;
-					}
-
-					if (coded_buffer_segment->base.size >= obj_buffer->size_element - header_offset - 0x1000) {
-						coded_buffer_segment->base.status |= VA_CODED_BUF_STATUS_SLICE_OVERFLOW_MASK;
 					}
+				}
 
-					vaStatus = VA_STATUS_SUCCESS;
+				if (coded_buffer_segment->base.size >= obj_buffer->size_element - header_offset - 0x1000) {
+					coded_buffer_segment->base.status |= VA_CODED_BUF_STATUS_SLICE_OVERFLOW_MASK;
 				}
 
 				coded_buffer_segment->mapped = 1;
@@ -3425,6 +3515,7 @@ i965_MapBuffer2(VADriverContextP ctx,
 VAStatus
 i965_UnmapBuffer(VADriverContextP ctx, VABufferID buf_id)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_buffer *obj_buffer = BUFFER(buf_id);
 	VAStatus vaStatus = VA_STATUS_ERROR_UNKNOWN;
@@ -3470,6 +3561,7 @@ i965_UnmapBuffer(VADriverContextP ctx, VABufferID buf_id)
 VAStatus
 i965_DestroyBuffer(VADriverContextP ctx, VABufferID buffer_id)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_buffer *obj_buffer = BUFFER(buffer_id);
 	VAStatus va_status = VA_STATUS_SUCCESS;
@@ -3494,6 +3586,7 @@ i965_BeginPicture(VADriverContextP ctx,
 				  VAContextID context,
 				  VASurfaceID render_target)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_context *obj_context = CONTEXT(context);
 	struct object_surface *obj_surface = SURFACE(render_target);
@@ -4219,6 +4312,7 @@ i965_RenderPicture(VADriverContextP ctx,
 				   VABufferID *buffers,
 				   int num_buffers)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_context *obj_context;
 	struct object_config *obj_config;
@@ -4249,12 +4343,100 @@ i965_RenderPicture(VADriverContextP ctx,
 	return vaStatus;
 }
 
+static VASurfaceID
+i965_context_render_target(struct object_context *obj_context)
+{
+	switch (obj_context->codec_type) {
+	case CODEC_PROC:
+		return obj_context->codec_state.proc.current_render_target;
+
+	case CODEC_ENC:
+	case CODEC_PREENC:
+		return obj_context->codec_state.encode.current_render_target;
+
+	default:
+		return obj_context->codec_state.decode.current_render_target;
+	}
+}
+
+/* Takes the fences over, they replace those of the previous rendering */
+static void
+i965_surface_set_fences(struct i965_driver_data *i965,
+						struct object_surface *obj_surface,
+						struct intel_fence_set *fences,
+						int fences_valid)
+{
+	if (!obj_surface) {
+		intel_fence_set_reset(fences);
+		return;
+	}
+
+	_i965LockMutex(&i965->fence_mutex);
+
+	intel_fence_set_reset(&obj_surface->fences);
+	obj_surface->fences = *fences;
+	obj_surface->fences_valid = fences_valid;
+
+	if (!fences_valid)
+		intel_fence_set_reset(&obj_surface->fences);
+
+	_i965UnlockMutex(&i965->fence_mutex);
+}
+
+/*
+ * Duplicates the surface fences into fences, so they can be waited on
+ * without the lock. Returns 0 when the surface has no valid fences.
+ */
+static int
+i965_surface_get_fences(struct i965_driver_data *i965,
+						struct object_surface *obj_surface,
+						struct intel_fence_set *fences)
+{
+	int ret = 0;
+
+	intel_fence_set_init(fences);
+
+	_i965LockMutex(&i965->fence_mutex);
+
+	if (obj_surface->fences_valid)
+		ret = intel_fence_set_dup(fences, &obj_surface->fences) == 0;
+
+	_i965UnlockMutex(&i965->fence_mutex);
+
+	return ret;
+}
+
+/* 1 when the fences of the surface were waited for, 0 to wait on the BO, -ETIME */
+static int
+i965_surface_wait_fences(struct i965_driver_data *i965,
+						 struct object_surface *obj_surface,
+						 int64_t timeout_ns)
+{
+	struct intel_fence_set fences;
+	int ret;
+
+	if (!i965_surface_get_fences(i965, obj_surface, &fences))
+		return 0;
+
+	ret = intel_fence_set_wait(&fences, timeout_ns);
+	intel_fence_set_reset(&fences);
+
+	if (ret == -ETIME)
+		return ret;
+
+	return ret == 0;
+}
+
 VAStatus
 i965_EndPicture(VADriverContextP ctx, VAContextID context)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_context *obj_context = CONTEXT(context);
 	struct object_config *obj_config;
+	struct intel_fence_set fences;
+	int fences_valid;
+	VAStatus va_status;
 
 	ASSERT_RET(obj_context, VA_STATUS_ERROR_INVALID_CONTEXT);
 	obj_config = obj_context->obj_config;
@@ -4322,7 +4504,6 @@ i965_EndPicture(VADriverContextP ctx, VAContextID context)
 		if (obj_context->wrapper_context != VA_INVALID_ID) {
 			/* call the vaEndPicture of wrapped driver */
 			VADriverContextP pdrvctx;
-			VAStatus va_status;
 
 			pdrvctx = i965->wrapper_pdrvctx;
 			CALL_VTABLE(pdrvctx, va_status,
@@ -4333,13 +4514,27 @@ i965_EndPicture(VADriverContextP ctx, VAContextID context)
 	}
 
 	ASSERT_RET(obj_context->hw_context->run, VA_STATUS_ERROR_OPERATION_FAILED);
-	return obj_context->hw_context->run(ctx, obj_config->profile, &obj_context->codec_state, obj_context->hw_context);
+
+	/* encode and VPP may read the decoded frames on the CPU */
+	if (!obj_context->hw_context->batch || !obj_context->hw_context->batch->deferred)
+		intel_batchbuffer_flush_deferred(&i965->intel);
+
+	intel_fence_set_init(&fences);
+	intel_batchbuffer_begin_fences(&fences);
+	va_status = obj_context->hw_context->run(ctx, obj_config->profile, &obj_context->codec_state, obj_context->hw_context);
+	fences_valid = intel_batchbuffer_end_fences() && va_status == VA_STATUS_SUCCESS;
+
+	i965_surface_set_fences(i965, SURFACE(i965_context_render_target(obj_context)),
+							&fences, fences_valid);
+
+	return va_status;
 }
 
 VAStatus
 i965_SyncSurface(VADriverContextP ctx,
 				 VASurfaceID render_target)
 {
+	I965_TRACE_FUNCTION();
 	if (!ctx)
 		return VA_STATUS_ERROR_INVALID_CONTEXT;
 
@@ -4348,6 +4543,12 @@ i965_SyncSurface(VADriverContextP ctx,
 
 	ASSERT_RET(obj_surface, VA_STATUS_ERROR_INVALID_SURFACE);
 
+	i965_flush_deferred_surface(i965, obj_surface);
+
+	/* the fences leave out the later submissions only reading the surface */
+	if (i965_surface_wait_fences(i965, obj_surface, -1) > 0)
+		return VA_STATUS_SUCCESS;
+
 	if (obj_surface->bo)
 		drm_intel_bo_wait_rendering(obj_surface->bo);
 
@@ -4359,6 +4560,7 @@ i965_SyncSurface2(VADriverContextP ctx,
 				VASurfaceID render_target,
 				uint64_t timeout_ns)
 {
+	I965_TRACE_FUNCTION();
 	if (!ctx)
 		return VA_STATUS_ERROR_INVALID_CONTEXT;
 
@@ -4367,6 +4569,8 @@ i965_SyncSurface2(VADriverContextP ctx,
 
 	ASSERT_RET(obj_surface, VA_STATUS_ERROR_INVALID_SURFACE);
 
+	i965_flush_deferred_surface(i965, obj_surface);
+
 	/**
 	 * We need to workaround a kernel limitation for DRM_IOCTL_I915_GEM_WAIT.
 	 * Treat really large values as an infinite timeout.
@@ -4377,6 +4581,15 @@ i965_SyncSurface2(VADriverContextP ctx,
 		timeout = I965_INFINITE_KERNEL_TIMEOUT;
 	}
 
+	switch (i965_surface_wait_fences(i965, obj_surface, timeout)) {
+	case 0:
+		break;
+	case -ETIME:
+		return VA_STATUS_ERROR_TIMEDOUT;
+	default:
+		return VA_STATUS_SUCCESS;
+	}
+
 	if (obj_surface->bo)
 	{
 		if (drm_intel_gem_bo_wait(obj_surface->bo, timeout) != 0)
@@ -4391,6 +4604,7 @@ i965_SyncBuffer(VADriverContextP ctx,
 				VABufferID buf_id,
 				uint64_t timeout_ns)
 {
+	I965_TRACE_FUNCTION();
 	if (!ctx)
 		return VA_STATUS_ERROR_INVALID_CONTEXT;
 
@@ -4425,11 +4639,23 @@ i965_QuerySurfaceStatus(VADriverContextP ctx,
 						VASurfaceID render_target,
 						VASurfaceStatus *status)        /* out */
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_surface *obj_surface = SURFACE(render_target);
 
 	ASSERT_RET(obj_surface, VA_STATUS_ERROR_INVALID_SURFACE);
 
+	i965_flush_deferred_surface(i965, obj_surface);
+
+	/* a poll of the pending fences, none once they have signaled */
+	_i965LockMutex(&i965->fence_mutex);
+	if (obj_surface->fences_valid) {
+		*status = intel_fence_set_poll(&obj_surface->fences) ? VASurfaceReady : VASurfaceRendering;
+		_i965UnlockMutex(&i965->fence_mutex);
+		return VA_STATUS_SUCCESS;
+	}
+	_i965UnlockMutex(&i965->fence_mutex);
+
 	if (obj_surface->bo) {
 		if (drm_intel_bo_busy(obj_surface->bo)) {
 			*status = VASurfaceRendering;
@@ -4443,6 +4669,71 @@ i965_QuerySurfaceStatus(VADriverContextP ctx,
 	return VA_STATUS_SUCCESS;
 }
 
+VAStatus
+i965_surface_export_fence(VADriverContextP ctx, VASurfaceID surface, int *fd)
+{
+	struct i965_driver_data *i965 = i965_driver_data(ctx);
+	struct object_surface *obj_surface = SURFACE(surface);
+	struct intel_fence_set fences;
+	int ret;
+
+	ASSERT_RET(obj_surface, VA_STATUS_ERROR_INVALID_SURFACE);
+
+	i965_flush_deferred_surface(i965, obj_surface);
+
+	if (!i965_surface_get_fences(i965, obj_surface, &fences))
+		return VA_STATUS_ERROR_UNIMPLEMENTED;
+
+	intel_fence_set_poll(&fences);
+	ret = intel_fence_set_is_empty(&fences) ? -1 : intel_fence_set_export(&fences);
+	intel_fence_set_reset(&fences);
+
+	if (ret < -1)
+		return VA_STATUS_ERROR_OPERATION_FAILED;
+
+	*fd = ret;
+
+	return VA_STATUS_SUCCESS;
+}
+
+VAStatus
+i965_surface_notify(VADriverContextP ctx, VASurfaceID surface,
+					intel_completion_func func, void *data)
+{
+	struct i965_driver_data *i965 = i965_driver_data(ctx);
+	struct object_surface *obj_surface = SURFACE(surface);
+	struct intel_fence_set fences;
+	int ret;
+
+	ASSERT_RET(obj_surface, VA_STATUS_ERROR_INVALID_SURFACE);
+
+	i965_flush_deferred_surface(i965, obj_surface);
+
+	if (!i965_surface_get_fences(i965, obj_surface, &fences))
+		return VA_STATUS_ERROR_UNIMPLEMENTED;
+
+	ret = intel_completion_queue_add(&i965->completion_queue, &fences, func, data);
+	intel_fence_set_reset(&fences);
+
+	return ret < 0 ? VA_STATUS_ERROR_ALLOCATION_FAILED : VA_STATUS_SUCCESS;
+}
+
+int
+i965_completion_fd(VADriverContextP ctx)
+{
+	struct i965_driver_data *i965 = i965_driver_data(ctx);
+
+	return intel_completion_queue_fd(&i965->completion_queue);
+}
+
+int
+i965_dispatch_completions(VADriverContextP ctx)
+{
+	struct i965_driver_data *i965 = i965_driver_data(ctx);
+
+	return intel_completion_queue_dispatch(&i965->completion_queue);
+}
+
 static VADisplayAttribute *
 get_display_attribute(VADriverContextP ctx, VADisplayAttribType type)
 {
@@ -4521,6 +4812,7 @@ i965_QueryDisplayAttributes(
 	int                *num_attribs_ptr /* out */
 )
 {
+	I965_TRACE_FUNCTION();
 	const int num_attribs = ARRAY_ELEMS(i965_display_attributes);
 
 	if (attribs && num_attribs > 0)
@@ -4545,6 +4837,7 @@ i965_GetDisplayAttributes(
 	int                 num_attribs     /* in */
 )
 {
+	I965_TRACE_FUNCTION();
 	int i;
 
 	for (i = 0; i < num_attribs; i++) {
@@ -4579,6 +4872,7 @@ i965_SetDisplayAttributes(
 	int                 num_attribs     /* in */
 )
 {
+	I965_TRACE_FUNCTION();
 	int i;
 
 	for (i = 0; i < num_attribs; i++) {
@@ -4641,6 +4935,7 @@ i965_CreateImage(VADriverContextP ctx,
 				 int height,
 				 VAImage *out_image)        /* out */
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_image *obj_image;
 	VAStatus va_status = VA_STATUS_ERROR_OPERATION_FAILED;
@@ -4809,6 +5104,39 @@ error:
 	return va_status;
 }
 
+static dri_bo *
+i965_alloc_surface_bo(struct i965_driver_data *i965,
+					  struct object_surface *obj_surface,
+					  int tiled,
+					  int region_width,
+					  int region_height)
+{
+	dri_bo *bo;
+
+	if (tiled) {
+		uint32_t tiling_mode = I915_TILING_Y; /* always uses Y-tiled format */
+		unsigned long pitch;
+
+		bo = drm_intel_bo_alloc_tiled(i965->intel.bufmgr,
+									  "vaapi surface",
+									  region_width,
+									  region_height,
+									  1,
+									  &tiling_mode,
+									  &pitch,
+									  0);
+		assert(!bo || tiling_mode == I915_TILING_Y);
+		assert(!bo || pitch == obj_surface->width);
+	} else {
+		bo = dri_bo_alloc(i965->intel.bufmgr,
+						  "vaapi surface",
+						  obj_surface->size,
+						  0x1000);
+	}
+
+	return bo;
+}
+
 VAStatus
 i965_check_alloc_surface_bo(VADriverContextP ctx,
 							struct object_surface *obj_surface,
@@ -4817,6 +5145,7 @@ i965_check_alloc_surface_bo(VADriverContextP ctx,
 							unsigned int subsampling)
 {
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
+	struct i965_surface_pool_key pool_key;
 	int region_width, region_height;
 
 	if (obj_surface->bo) {
@@ -5072,28 +5401,36 @@ i965_check_alloc_surface_bo(VADriverContextP ctx,
 	}
 
 	obj_surface->size = ALIGN(region_width * region_height, 0x1000);
+	tiled = tiled && !obj_surface->user_disable_tiling;
 
-	if ((tiled && !obj_surface->user_disable_tiling)) {
-		uint32_t tiling_mode = I915_TILING_Y; /* always uses Y-tiled format */
-		unsigned long pitch;
+	pool_key.fourcc = fourcc;
+	pool_key.tiling = tiled ? I915_TILING_Y : I915_TILING_NONE;
+	pool_key.pitch = region_width;
+	pool_key.height = region_height;
 
-		obj_surface->bo = drm_intel_bo_alloc_tiled(i965->intel.bufmgr,
-												   "vaapi surface",
-												   region_width,
-												   region_height,
-												   1,
-												   &tiling_mode,
-												   &pitch,
-												   0);
-		assert(tiling_mode == I915_TILING_Y);
-		assert(pitch == obj_surface->width);
-	} else {
-		obj_surface->bo = dri_bo_alloc(i965->intel.bufmgr,
-									   "vaapi surface",
-									   obj_surface->size,
-									   0x1000);
+	obj_surface->bo = i965_surface_pool_acquire(&i965->surface_pool, &pool_key);
+
+	/*
+	 * A deferred decode batch may still write to pooled storage on behalf
+	 * of the surface it was released by, submit it before the storage
+	 * backs another surface.
+	 */
+	i965_flush_deferred_surface(i965, obj_surface);
+
+	if (!obj_surface->bo)
+		obj_surface->bo = i965_alloc_surface_bo(i965, obj_surface, tiled,
+												region_width, region_height);
+
+	if (!obj_surface->bo) {
+		/* Most likely out of memory, give back what the pool holds */
+		i965_surface_pool_trim(&i965->surface_pool, 0);
+		obj_surface->bo = i965_alloc_surface_bo(i965, obj_surface, tiled,
+												region_width, region_height);
 	}
 
+	obj_surface->pool = &i965->surface_pool;
+	obj_surface->pool_key = pool_key;
+	obj_surface->generation++;
 	obj_surface->fourcc = fourcc;
 	obj_surface->subsampling = subsampling;
 	assert(obj_surface->bo);
@@ -5104,6 +5441,7 @@ VAStatus i965_DeriveImage(VADriverContextP ctx,
 						  VASurfaceID surface,
 						  VAImage *out_image)        /* out */
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_image *obj_image;
 	struct object_surface *obj_surface;
@@ -5117,6 +5455,9 @@ VAStatus i965_DeriveImage(VADriverContextP ctx,
 	if (!obj_surface)
 		return VA_STATUS_ERROR_INVALID_SURFACE;
 
+	i965_flush_deferred_surface(i965, obj_surface);
+	obj_surface->generation++;
+
 	if (!obj_surface->bo) {
 		unsigned int is_tiled = 0;
 		unsigned int fourcc = VA_FOURCC_YV12;
@@ -5314,6 +5655,7 @@ i965_destroy_image(struct object_heap *heap, struct object_base *obj)
 VAStatus
 i965_DestroyImage(VADriverContextP ctx, VAImageID image)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_image *obj_image = IMAGE(image);
 	struct object_surface *obj_surface;
@@ -5339,6 +5681,8 @@ i965_DestroyImage(VADriverContextP ctx, VAImageID image)
 	if (obj_surface) {
 		obj_surface->flags &= ~SURFACE_DERIVED;
 		obj_surface->derived_image_id = VA_INVALID_ID;
+		/* the application may have written anywhere in the mapping */
+		obj_surface->generation++;
 	}
 
 	i965_destroy_image(&i965->image_heap, (struct object_base *)obj_image);
@@ -5356,6 +5700,7 @@ i965_SetImagePalette(VADriverContextP ctx,
 					 VAImageID image,
 					 unsigned char *palette)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	unsigned int i;
 
@@ -5384,18 +5729,26 @@ get_sampling_from_fourcc(unsigned int fourcc)
 		return -1;
 }
 
-static inline void
-memcpy_pic(uint8_t *dst, unsigned int dst_stride,
-		   const uint8_t *src, unsigned int src_stride,
-		   unsigned int len, unsigned int height)
+/*
+ * Maps the surface storage for i965_image_copy_*(). Without bit-6 swizzling
+ * a tiled surface is mapped through the CPU and detiled while copying,
+ * otherwise the fenced GTT view is used and the copy sees a linear layout.
+ */
+static uint8_t *
+map_surface_for_copy(struct object_surface *obj_surface, int write_enable,
+					 unsigned int *tiling)
 {
-	unsigned int i;
+	unsigned int swizzle;
 
-	for (i = 0; i < height; i++) {
-		memcpy(dst, src, len);
-		dst += dst_stride;
-		src += src_stride;
-	}
+	dri_bo_get_tiling(obj_surface->bo, tiling, &swizzle);
+
+	if (*tiling != I915_TILING_NONE && swizzle != I915_BIT_6_SWIZZLE_NONE) {
+		drm_intel_gem_bo_map_gtt(obj_surface->bo);
+		*tiling = I915_TILING_NONE;
+	} else
+		dri_bo_map(obj_surface->bo, write_enable);
+
+	return (uint8_t *)obj_surface->bo->virtual;
 }
 
 static VAStatus
@@ -5407,27 +5760,21 @@ get_image_i420(struct object_image *obj_image, uint8_t *image_data,
 	const int Y = 0;
 	const int U = obj_image->image.format.fourcc == obj_surface->fourcc ? 1 : 2;
 	const int V = obj_image->image.format.fourcc == obj_surface->fourcc ? 2 : 1;
-	unsigned int tiling, swizzle;
+	unsigned int tiling;
 	VAStatus va_status = VA_STATUS_SUCCESS;
 
 	if (!obj_surface->bo)
 		return VA_STATUS_ERROR_INVALID_SURFACE;
 
 	ASSERT_RET(obj_surface->fourcc, VA_STATUS_ERROR_INVALID_SURFACE);
-	dri_bo_get_tiling(obj_surface->bo, &tiling, &swizzle);
-
-	if (tiling != I915_TILING_NONE)
-		drm_intel_gem_bo_map_gtt(obj_surface->bo);
-	else
-		dri_bo_map(obj_surface->bo, 0);
+	src[0] = map_surface_for_copy(obj_surface, 0, &tiling);
 
-	if (!obj_surface->bo->virtual)
+	if (!src[0])
 		return VA_STATUS_ERROR_INVALID_SURFACE;
 
 	/* Dest VA image has either I420 or YV12 format.
 	   Source VA surface alway has I420 format */
 	dst[Y] = image_data + obj_image->image.offsets[Y];
-	src[0] = (uint8_t *)obj_surface->bo->virtual;
 	dst[U] = image_data + obj_image->image.offsets[U];
 	src[1] = src[0] + obj_surface->width * obj_surface->height;
 	dst[V] = image_data + obj_image->image.offsets[V];
@@ -5435,29 +5782,26 @@ get_image_i420(struct object_image *obj_image, uint8_t *image_data,
 
 	/* Y plane */
 	dst[Y] += rect->y * obj_image->image.pitches[Y] + rect->x;
-	src[0] += rect->y * obj_surface->width + rect->x;
-	memcpy_pic(dst[Y], obj_image->image.pitches[Y],
-			   src[0], obj_surface->width,
-			   rect->width, rect->height);
+	i965_image_copy_from_surface(dst[Y], obj_image->image.pitches[Y],
+								 src[0], obj_surface->width, tiling,
+								 rect->x, rect->y,
+								 rect->width, rect->height);
 
 	/* U plane */
 	dst[U] += (rect->y / 2) * obj_image->image.pitches[U] + rect->x / 2;
-	src[1] += (rect->y / 2) * obj_surface->width / 2 + rect->x / 2;
-	memcpy_pic(dst[U], obj_image->image.pitches[U],
-			   src[1], obj_surface->width / 2,
-			   rect->width / 2, rect->height / 2);
+	i965_image_copy_from_surface(dst[U], obj_image->image.pitches[U],
+								 src[1], obj_surface->width / 2, tiling,
+								 rect->x / 2, rect->y / 2,
+								 rect->width / 2, rect->height / 2);
 
 	/* V plane */
 	dst[V] += (rect->y / 2) * obj_image->image.pitches[V] + rect->x / 2;
-	src[2] += (rect->y / 2) * obj_surface->width / 2 + rect->x / 2;
-	memcpy_pic(dst[V], obj_image->image.pitches[V],
-			   src[2], obj_surface->width / 2,
-			   rect->width / 2, rect->height / 2);
+	i965_image_copy_from_surface(dst[V], obj_image->image.pitches[V],
+								 src[2], obj_surface->width / 2, tiling,
+								 rect->x / 2, rect->y / 2,
+								 rect->width / 2, rect->height / 2);
 
-	if (tiling != I915_TILING_NONE)
-		drm_intel_gem_bo_unmap_gtt(obj_surface->bo);
-	else
-		dri_bo_unmap(obj_surface->bo);
+	dri_bo_unmap(obj_surface->bo);
 
 	return va_status;
 }
@@ -5467,48 +5811,39 @@ get_image_nv12(struct object_image *obj_image, uint8_t *image_data,
 			   struct object_surface *obj_surface,
 			   const VARectangle *rect)
 {
-	uint8_t *dst[2], *src[2];
-	unsigned int tiling, swizzle;
+	uint8_t *dst[2], *src;
+	unsigned int tiling;
 	VAStatus va_status = VA_STATUS_SUCCESS;
 
 	if (!obj_surface->bo)
 		return VA_STATUS_ERROR_INVALID_SURFACE;
 
 	assert(obj_surface->fourcc);
-	dri_bo_get_tiling(obj_surface->bo, &tiling, &swizzle);
+	src = map_surface_for_copy(obj_surface, 0, &tiling);
 
-	if (tiling != I915_TILING_NONE)
-		drm_intel_gem_bo_map_gtt(obj_surface->bo);
-	else
-		dri_bo_map(obj_surface->bo, 0);
-
-	if (!obj_surface->bo->virtual)
+	if (!src)
 		return VA_STATUS_ERROR_INVALID_SURFACE;
 
-	/* Both dest VA image and source surface have NV12 format */
+	/* Both dest VA image and source surface have NV12 format,
+	   the UV plane of the surface starts at row height */
 	dst[0] = image_data + obj_image->image.offsets[0];
-	src[0] = (uint8_t *)obj_surface->bo->virtual;
 	dst[1] = image_data + obj_image->image.offsets[1];
-	src[1] = src[0] + obj_surface->width * obj_surface->height;
 
 	/* Y plane */
 	dst[0] += rect->y * obj_image->image.pitches[0] + rect->x;
-	src[0] += rect->y * obj_surface->width + rect->x;
-	memcpy_pic(dst[0], obj_image->image.pitches[0],
-			   src[0], obj_surface->width,
-			   rect->width, rect->height);
+	i965_image_copy_from_surface(dst[0], obj_image->image.pitches[0],
+								 src, obj_surface->width, tiling,
+								 rect->x, rect->y,
+								 rect->width, rect->height);
 
 	/* UV plane */
 	dst[1] += (rect->y / 2) * obj_image->image.pitches[1] + (rect->x & -2);
-	src[1] += (rect->y / 2) * obj_surface->width + (rect->x & -2);
-	memcpy_pic(dst[1], obj_image->image.pitches[1],
-			   src[1], obj_surface->width,
-			   rect->width, rect->height / 2);
+	i965_image_copy_from_surface(dst[1], obj_image->image.pitches[1],
+								 src, obj_surface->width, tiling,
+								 rect->x & -2, obj_surface->height + rect->y / 2,
+								 rect->width, rect->height / 2);
 
-	if (tiling != I915_TILING_NONE)
-		drm_intel_gem_bo_unmap_gtt(obj_surface->bo);
-	else
-		dri_bo_unmap(obj_surface->bo);
+	dri_bo_unmap(obj_surface->bo);
 
 	return va_status;
 }
@@ -5519,42 +5854,261 @@ get_image_yuy2(struct object_image *obj_image, uint8_t *image_data,
 			   const VARectangle *rect)
 {
 	uint8_t *dst, *src;
-	unsigned int tiling, swizzle;
+	unsigned int tiling;
 	VAStatus va_status = VA_STATUS_SUCCESS;
 
 	if (!obj_surface->bo)
 		return VA_STATUS_ERROR_INVALID_SURFACE;
 
 	assert(obj_surface->fourcc);
-	dri_bo_get_tiling(obj_surface->bo, &tiling, &swizzle);
+	src = map_surface_for_copy(obj_surface, 0, &tiling);
 
-	if (tiling != I915_TILING_NONE)
-		drm_intel_gem_bo_map_gtt(obj_surface->bo);
-	else
-		dri_bo_map(obj_surface->bo, 0);
-
-	if (!obj_surface->bo->virtual)
+	if (!src)
 		return VA_STATUS_ERROR_INVALID_SURFACE;
 
-	/* Both dest VA image and source surface have YUYV format */
+	/* Both dest VA image and source surface have YUYV format,
+	   the surface width is already in bytes */
 	dst = image_data + obj_image->image.offsets[0];
-	src = (uint8_t *)obj_surface->bo->virtual;
 
 	/* Y plane */
 	dst += rect->y * obj_image->image.pitches[0] + rect->x * 2;
-	src += rect->y * obj_surface->width + rect->x * 2;
-	memcpy_pic(dst, obj_image->image.pitches[0],
-			   src, obj_surface->width * 2,
-			   rect->width * 2, rect->height);
+	i965_image_copy_from_surface(dst, obj_image->image.pitches[0],
+								 src, obj_surface->width, tiling,
+								 rect->x * 2, rect->y,
+								 rect->width * 2, rect->height);
 
-	if (tiling != I915_TILING_NONE)
-		drm_intel_gem_bo_unmap_gtt(obj_surface->bo);
-	else
-		dri_bo_unmap(obj_surface->bo);
+	dri_bo_unmap(obj_surface->bo);
 
 	return va_status;
 }
 
+/* A plane of the surface region, the offset is the one of the plane in bytes */
+struct surface_plane {
+	unsigned int offset;
+	unsigned int pitch;
+	unsigned int x;
+	unsigned int y;
+	unsigned int len;
+	unsigned int rows;
+};
+
+/*
+ * The planes of the region of a surface in the memory order of its fourcc,
+ * as i965_color_convert() takes them. The region starts on an even pixel.
+ */
+static int
+surface_region_planes(struct object_surface *obj_surface, const VARectangle *rect,
+					  struct surface_plane *planes)
+{
+	const unsigned int chroma_width = (rect->width + 1) / 2;
+	const unsigned int chroma_height = (rect->height + 1) / 2;
+	int i, num_planes, bpp = 1;
+
+	switch (obj_surface->fourcc) {
+	case VA_FOURCC_P010:
+		bpp = 2;
+
+		/* fall through */
+	case VA_FOURCC_NV12:
+		num_planes = 2;
+		planes[0].len = rect->width * bpp;
+		planes[1].offset = obj_surface->width * obj_surface->y_cb_offset;
+		planes[1].pitch = obj_surface->cb_cr_pitch;
+		planes[1].x = rect->x * bpp;
+		planes[1].len = chroma_width * 2 * bpp;
+		break;
+
+	case VA_FOURCC_I420:
+	case VA_FOURCC_YV12:
+		num_planes = 3;
+		planes[0].len = rect->width;
+		planes[1].offset = obj_surface->width *
+						   (obj_surface->fourcc == VA_FOURCC_I420 ? obj_surface->y_cb_offset :
+							obj_surface->y_cr_offset);
+		planes[2].offset = obj_surface->width *
+						   (obj_surface->fourcc == VA_FOURCC_I420 ? obj_surface->y_cr_offset :
+							obj_surface->y_cb_offset);
+		planes[1].pitch = planes[2].pitch = obj_surface->cb_cr_pitch;
+		planes[1].x = planes[2].x = rect->x / 2;
+		planes[1].len = planes[2].len = chroma_width;
+		break;
+
+	case VA_FOURCC_YUY2:
+	case VA_FOURCC_UYVY:
+		num_planes = 1;
+		planes[0].len = chroma_width * 4;
+		bpp = 2;
+		break;
+
+	default:
+		num_planes = 1;
+		planes[0].len = rect->width * 4;
+		bpp = 4;
+		break;
+	}
+
+	planes[0].offset = 0;
+	planes[0].pitch = obj_surface->width;
+	planes[0].x = rect->x * bpp;
+	planes[0].y = rect->y;
+	planes[0].rows = rect->height;
+
+	for (i = 1; i < num_planes; i++) {
+		planes[i].y = rect->y / 2;
+		planes[i].rows = chroma_height;
+	}
+
+	return num_planes;
+}
+
+/* The region of an image, the planes in the memory order of its fourcc */
+static void
+image_region_frame(struct object_image *obj_image, uint8_t *image_data,
+				   const VARectangle *rect, struct i965_color_frame *frame)
+{
+	const VAImage *image = &obj_image->image;
+	unsigned int i, x[3] = { rect->x, rect->x, rect->x };
+	unsigned int y[3] = { rect->y, rect->y / 2, rect->y / 2 };
+
+	switch (image->format.fourcc) {
+	case VA_FOURCC_P010:
+		x[0] = x[1] = rect->x * 2;
+		break;
+
+	case VA_FOURCC_I420:
+	case VA_FOURCC_YV12:
+		x[1] = x[2] = rect->x / 2;
+		break;
+
+	case VA_FOURCC_YUY2:
+	case VA_FOURCC_UYVY:
+		x[0] = rect->x * 2;
+		break;
+
+	case VA_FOURCC_RGBX:
+	case VA_FOURCC_BGRX:
+		x[0] = rect->x * 4;
+		break;
+	}
+
+	frame->fourcc = image->format.fourcc;
+
+	for (i = 0; i < 3; i++) {
+		frame->planes[i] = NULL;
+		frame->pitches[i] = 0;
+
+		if (i < image->num_planes) {
+			frame->planes[i] = image_data + image->offsets[i] + y[i] * image->pitches[i] + x[i];
+			frame->pitches[i] = image->pitches[i];
+		}
+	}
+}
+
+/* A linear copy of the surface region is converted, the copy detiles it */
+static VAStatus
+get_image_convert(struct object_image *obj_image, uint8_t *image_data,
+				  struct object_surface *obj_surface,
+				  const VARectangle *rect)
+{
+	struct surface_plane planes[3];
+	struct i965_color_frame src, dst;
+	uint8_t *region, *map;
+	unsigned int tiling;
+	size_t size = 0;
+	int i, num_planes;
+
+	if (!obj_surface->bo)
+		return VA_STATUS_ERROR_INVALID_SURFACE;
+
+	num_planes = surface_region_planes(obj_surface, rect, planes);
+
+	for (i = 0; i < num_planes; i++)
+		size += (size_t)planes[i].len * planes[i].rows;
+
+	region = malloc(size);
+	if (!region)
+		return VA_STATUS_ERROR_ALLOCATION_FAILED;
+
+	map = map_surface_for_copy(obj_surface, 0, &tiling);
+	if (!map) {
+		free(region);
+		return VA_STATUS_ERROR_INVALID_SURFACE;
+	}
+
+	memset(&src, 0, sizeof(src));
+	src.fourcc = obj_surface->fourcc;
+
+	for (i = 0, size = 0; i < num_planes; i++) {
+		src.planes[i] = region + size;
+		src.pitches[i] = planes[i].len;
+		size += (size_t)planes[i].len * planes[i].rows;
+
+		i965_image_copy_from_surface(src.planes[i], src.pitches[i],
+									 map + planes[i].offset, planes[i].pitch, tiling,
+									 planes[i].x, planes[i].y,
+									 planes[i].len, planes[i].rows);
+	}
+
+	dri_bo_unmap(obj_surface->bo);
+
+	image_region_frame(obj_image, image_data, rect, &dst);
+	i965_color_convert(&dst, &src, rect->width, rect->height, VAProcColorStandardBT601);
+
+	free(region);
+
+	return VA_STATUS_SUCCESS;
+}
+
+/* The conversions work on 2x2 chroma blocks, the regions start on one */
+static bool
+can_convert_image(unsigned int dst_fourcc, unsigned int src_fourcc,
+				  const VARectangle *src_rect, const VARectangle *dst_rect)
+{
+	return i965_color_convert_supported(dst_fourcc, src_fourcc) &&
+		   !((src_rect->x | src_rect->y | dst_rect->x | dst_rect->y) & 1) &&
+		   src_rect->width == dst_rect->width &&
+		   src_rect->height == dst_rect->height;
+}
+
+/*
+ * Whether vaGetImage()/vaPutImage() go through the CPU rather than the
+ * post-processing pipeline, by default only when its batches queue up on
+ * the GPU. The same format copies are left to the GPU otherwise. The
+ * image is written to the surface when put is set.
+ */
+static bool
+use_cpu_image(struct i965_driver_data *i965, struct object_surface *obj_surface,
+			  struct object_image *obj_image, int put,
+			  const VARectangle *src_rect, const VARectangle *dst_rect)
+{
+	const unsigned int surface_fourcc = obj_surface->fourcc;
+	const unsigned int image_fourcc = obj_image->image.format.fourcc;
+	int pending;
+
+	if (i965->cpu_convert == I965_CPU_CONVERT_NEVER || !obj_surface->bo)
+		return false;
+
+	if (surface_fourcc == image_fourcc) {
+		if (surface_fourcc != VA_FOURCC_NV12 &&
+			surface_fourcc != VA_FOURCC_I420 &&
+			surface_fourcc != VA_FOURCC_YV12 &&
+			surface_fourcc != VA_FOURCC_YUY2)
+			return false;
+	} else if (!can_convert_image(put ? surface_fourcc : image_fourcc,
+								  put ? image_fourcc : surface_fourcc,
+								  src_rect, dst_rect))
+		return false;
+
+	if (i965->cpu_convert == I965_CPU_CONVERT_ALWAYS)
+		return true;
+
+	_i965LockMutex(&i965->pp_mutex);
+	pending = intel_batchbuffer_num_pending(i965->pp_batch);
+	_i965UnlockMutex(&i965->pp_mutex);
+
+	return pending >= I965_CPU_CONVERT_PENDING_THRESHOLD;
+}
+
 static VAStatus
 i965_sw_getimage(VADriverContextP ctx,
 				 struct object_surface *obj_surface, struct object_image *obj_image,
@@ -5562,29 +6116,35 @@ i965_sw_getimage(VADriverContextP ctx,
 {
 	void *image_data = NULL;
 	VAStatus va_status;
+	bool convert = obj_surface->fourcc != obj_image->image.format.fourcc;
 
-	if (obj_surface->fourcc != obj_image->image.format.fourcc)
+	if (convert && !can_convert_image(obj_image->image.format.fourcc, obj_surface->fourcc,
+									  rect, rect))
 		return VA_STATUS_ERROR_INVALID_IMAGE_FORMAT;
 
 	va_status = i965_MapBuffer(ctx, obj_image->image.buf, &image_data);
 	if (va_status != VA_STATUS_SUCCESS)
 		return va_status;
 
-	switch (obj_image->image.format.fourcc) {
-	case VA_FOURCC_YV12:
-	case VA_FOURCC_I420:
-		get_image_i420(obj_image, image_data, obj_surface, rect);
-		break;
-	case VA_FOURCC_NV12:
-		get_image_nv12(obj_image, image_data, obj_surface, rect);
-		break;
-	case VA_FOURCC_YUY2:
-		/* YUY2 is the format supported by overlay plane */
-		get_image_yuy2(obj_image, image_data, obj_surface, rect);
-		break;
-	default:
-		va_status = VA_STATUS_ERROR_OPERATION_FAILED;
-		break;
+	if (convert) {
+		va_status = get_image_convert(obj_image, image_data, obj_surface, rect);
+	} else {
+		switch (obj_image->image.format.fourcc) {
+		case VA_FOURCC_YV12:
+		case VA_FOURCC_I420:
+			get_image_i420(obj_image, image_data, obj_surface, rect);
+			break;
+		case VA_FOURCC_NV12:
+			get_image_nv12(obj_image, image_data, obj_surface, rect);
+			break;
+		case VA_FOURCC_YUY2:
+			/* YUY2 is the format supported by overlay plane */
+			get_image_yuy2(obj_image, image_data, obj_surface, rect);
+			break;
+		default:
+			va_status = VA_STATUS_ERROR_OPERATION_FAILED;
+			break;
+		}
 	}
 	if (va_status != VA_STATUS_SUCCESS)
 		return va_status;
@@ -5621,6 +6181,7 @@ i965_GetImage(VADriverContextP ctx,
 			  unsigned int height,
 			  VAImageID image)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data * const i965 = i965_driver_data(ctx);
 	struct object_surface * const obj_surface = SURFACE(surface);
 	struct object_image * const obj_image = IMAGE(image);
@@ -5634,6 +6195,8 @@ i965_GetImage(VADriverContextP ctx,
 	if (is_surface_busy(i965, obj_surface))
 		return VA_STATUS_ERROR_SURFACE_BUSY;
 
+	i965_flush_deferred_surface(i965, obj_surface);
+
 	if (!obj_image || !obj_image->bo)
 		return VA_STATUS_ERROR_INVALID_IMAGE;
 	if (is_image_busy(i965, obj_image, surface))
@@ -5653,7 +6216,8 @@ i965_GetImage(VADriverContextP ctx,
 	rect.width = width;
 	rect.height = height;
 
-	if (HAS_ACCELERATED_GETIMAGE(i965))
+	if (HAS_ACCELERATED_GETIMAGE(i965) &&
+		!use_cpu_image(i965, obj_surface, obj_image, 0, &rect, &rect))
 		va_status = i965_hw_getimage(ctx, obj_surface, obj_image, &rect);
 	else
 		va_status = i965_sw_getimage(ctx, obj_surface, obj_image, &rect);
@@ -5671,7 +6235,7 @@ put_image_i420(struct object_surface *obj_surface,
 	const int Y = 0;
 	const int U = obj_image->image.format.fourcc == obj_surface->fourcc ? 1 : 2;
 	const int V = obj_image->image.format.fourcc == obj_surface->fourcc ? 2 : 1;
-	unsigned int tiling, swizzle;
+	unsigned int tiling;
 	VAStatus va_status = VA_STATUS_SUCCESS;
 
 	ASSERT_RET(obj_surface->bo, VA_STATUS_ERROR_INVALID_SURFACE);
@@ -5679,19 +6243,13 @@ put_image_i420(struct object_surface *obj_surface,
 	ASSERT_RET(obj_surface->fourcc, VA_STATUS_ERROR_INVALID_SURFACE);
 	ASSERT_RET(dst_rect->width == src_rect->width, VA_STATUS_ERROR_UNIMPLEMENTED);
 	ASSERT_RET(dst_rect->height == src_rect->height, VA_STATUS_ERROR_UNIMPLEMENTED);
-	dri_bo_get_tiling(obj_surface->bo, &tiling, &swizzle);
+	dst[0] = map_surface_for_copy(obj_surface, 1, &tiling);
 
-	if (tiling != I915_TILING_NONE)
-		drm_intel_gem_bo_map_gtt(obj_surface->bo);
-	else
-		dri_bo_map(obj_surface->bo, 0);
-
-	if (!obj_surface->bo->virtual)
+	if (!dst[0])
 		return VA_STATUS_ERROR_INVALID_SURFACE;
 
 	/* Dest VA image has either I420 or YV12 format.
 	   Source VA surface alway has I420 format */
-	dst[0] = (uint8_t *)obj_surface->bo->virtual;
 	src[Y] = image_data + obj_image->image.offsets[Y];
 	dst[1] = dst[0] + obj_surface->width * obj_surface->height;
 	src[U] = image_data + obj_image->image.offsets[U];
@@ -5699,30 +6257,27 @@ put_image_i420(struct object_surface *obj_surface,
 	src[V] = image_data + obj_image->image.offsets[V];
 
 	/* Y plane */
-	dst[0] += dst_rect->y * obj_surface->width + dst_rect->x;
 	src[Y] += src_rect->y * obj_image->image.pitches[Y] + src_rect->x;
-	memcpy_pic(dst[0], obj_surface->width,
-			   src[Y], obj_image->image.pitches[Y],
-			   src_rect->width, src_rect->height);
+	i965_image_copy_to_surface(dst[0], obj_surface->width, tiling,
+							   dst_rect->x, dst_rect->y,
+							   src[Y], obj_image->image.pitches[Y],
+							   src_rect->width, src_rect->height);
 
 	/* U plane */
-	dst[1] += (dst_rect->y / 2) * obj_surface->width / 2 + dst_rect->x / 2;
 	src[U] += (src_rect->y / 2) * obj_image->image.pitches[U] + src_rect->x / 2;
-	memcpy_pic(dst[1], obj_surface->width / 2,
-			   src[U], obj_image->image.pitches[U],
-			   src_rect->width / 2, src_rect->height / 2);
+	i965_image_copy_to_surface(dst[1], obj_surface->width / 2, tiling,
+							   dst_rect->x / 2, dst_rect->y / 2,
+							   src[U], obj_image->image.pitches[U],
+							   src_rect->width / 2, src_rect->height / 2);
 
 	/* V plane */
-	dst[2] += (dst_rect->y / 2) * obj_surface->width / 2 + dst_rect->x / 2;
 	src[V] += (src_rect->y / 2) * obj_image->image.pitches[V] + src_rect->x / 2;
-	memcpy_pic(dst[2], obj_surface->width / 2,
-			   src[V], obj_image->image.pitches[V],
-			   src_rect->width / 2, src_rect->height / 2);
+	i965_image_copy_to_surface(dst[2], obj_surface->width / 2, tiling,
+							   dst_rect->x / 2, dst_rect->y / 2,
+							   src[V], obj_image->image.pitches[V],
+							   src_rect->width / 2, src_rect->height / 2);
 
-	if (tiling != I915_TILING_NONE)
-		drm_intel_gem_bo_unmap_gtt(obj_surface->bo);
-	else
-		dri_bo_unmap(obj_surface->bo);
+	dri_bo_unmap(obj_surface->bo);
 
 	return va_status;
 }
@@ -5733,8 +6288,8 @@ put_image_nv12(struct object_surface *obj_surface,
 			   struct object_image *obj_image, uint8_t *image_data,
 			   const VARectangle *src_rect)
 {
-	uint8_t *dst[2], *src[2];
-	unsigned int tiling, swizzle;
+	uint8_t *dst, *src[2];
+	unsigned int tiling;
 	VAStatus va_status = VA_STATUS_SUCCESS;
 
 	if (!obj_surface->bo)
@@ -5743,40 +6298,31 @@ put_image_nv12(struct object_surface *obj_surface,
 	ASSERT_RET(obj_surface->fourcc, VA_STATUS_ERROR_INVALID_SURFACE);
 	ASSERT_RET(dst_rect->width == src_rect->width, VA_STATUS_ERROR_UNIMPLEMENTED);
 	ASSERT_RET(dst_rect->height == src_rect->height, VA_STATUS_ERROR_UNIMPLEMENTED);
-	dri_bo_get_tiling(obj_surface->bo, &tiling, &swizzle);
+	dst = map_surface_for_copy(obj_surface, 1, &tiling);
 
-	if (tiling != I915_TILING_NONE)
-		drm_intel_gem_bo_map_gtt(obj_surface->bo);
-	else
-		dri_bo_map(obj_surface->bo, 0);
-
-	if (!obj_surface->bo->virtual)
+	if (!dst)
 		return VA_STATUS_ERROR_INVALID_SURFACE;
 
-	/* Both dest VA image and source surface have NV12 format */
-	dst[0] = (uint8_t *)obj_surface->bo->virtual;
+	/* Both dest VA image and source surface have NV12 format,
+	   the UV plane of the surface starts at row height */
 	src[0] = image_data + obj_image->image.offsets[0];
-	dst[1] = dst[0] + obj_surface->width * obj_surface->height;
 	src[1] = image_data + obj_image->image.offsets[1];
 
 	/* Y plane */
-	dst[0] += dst_rect->y * obj_surface->width + dst_rect->x;
 	src[0] += src_rect->y * obj_image->image.pitches[0] + src_rect->x;
-	memcpy_pic(dst[0], obj_surface->width,
-			   src[0], obj_image->image.pitches[0],
-			   src_rect->width, src_rect->height);
+	i965_image_copy_to_surface(dst, obj_surface->width, tiling,
+							   dst_rect->x, dst_rect->y,
+							   src[0], obj_image->image.pitches[0],
+							   src_rect->width, src_rect->height);
 
 	/* UV plane */
-	dst[1] += (dst_rect->y / 2) * obj_surface->width + (dst_rect->x & -2);
 	src[1] += (src_rect->y / 2) * obj_image->image.pitches[1] + (src_rect->x & -2);
-	memcpy_pic(dst[1], obj_surface->width,
-			   src[1], obj_image->image.pitches[1],
-			   src_rect->width, src_rect->height / 2);
+	i965_image_copy_to_surface(dst, obj_surface->width, tiling,
+							   dst_rect->x & -2, obj_surface->height + dst_rect->y / 2,
+							   src[1], obj_image->image.pitches[1],
+							   src_rect->width, src_rect->height / 2);
 
-	if (tiling != I915_TILING_NONE)
-		drm_intel_gem_bo_unmap_gtt(obj_surface->bo);
-	else
-		dri_bo_unmap(obj_surface->bo);
+	dri_bo_unmap(obj_surface->bo);
 
 	return va_status;
 }
@@ -5788,42 +6334,90 @@ put_image_yuy2(struct object_surface *obj_surface,
 			   const VARectangle *src_rect)
 {
 	uint8_t *dst, *src;
-	unsigned int tiling, swizzle;
+	unsigned int tiling;
 	VAStatus va_status = VA_STATUS_SUCCESS;
 
 	ASSERT_RET(obj_surface->bo, VA_STATUS_ERROR_INVALID_SURFACE);
 	ASSERT_RET(obj_surface->fourcc, VA_STATUS_ERROR_INVALID_SURFACE);
 	ASSERT_RET(dst_rect->width == src_rect->width, VA_STATUS_ERROR_UNIMPLEMENTED);
 	ASSERT_RET(dst_rect->height == src_rect->height, VA_STATUS_ERROR_UNIMPLEMENTED);
-	dri_bo_get_tiling(obj_surface->bo, &tiling, &swizzle);
+	dst = map_surface_for_copy(obj_surface, 1, &tiling);
 
-	if (tiling != I915_TILING_NONE)
-		drm_intel_gem_bo_map_gtt(obj_surface->bo);
-	else
-		dri_bo_map(obj_surface->bo, 0);
-
-	if (!obj_surface->bo->virtual)
+	if (!dst)
 		return VA_STATUS_ERROR_INVALID_SURFACE;
 
-	/* Both dest VA image and source surface have YUY2 format */
-	dst = (uint8_t *)obj_surface->bo->virtual;
+	/* Both dest VA image and source surface have YUY2 format,
+	   the surface width is already in bytes */
 	src = image_data + obj_image->image.offsets[0];
 
 	/* YUYV packed plane */
-	dst += dst_rect->y * obj_surface->width + dst_rect->x * 2;
 	src += src_rect->y * obj_image->image.pitches[0] + src_rect->x * 2;
-	memcpy_pic(dst, obj_surface->width * 2,
-			   src, obj_image->image.pitches[0],
-			   src_rect->width * 2, src_rect->height);
+	i965_image_copy_to_surface(dst, obj_surface->width, tiling,
+							   dst_rect->x * 2, dst_rect->y,
+							   src, obj_image->image.pitches[0],
+							   src_rect->width * 2, src_rect->height);
 
-	if (tiling != I915_TILING_NONE)
-		drm_intel_gem_bo_unmap_gtt(obj_surface->bo);
-	else
-		dri_bo_unmap(obj_surface->bo);
+	dri_bo_unmap(obj_surface->bo);
 
 	return va_status;
 }
 
+/* The image region is converted to a linear copy, the copy tiles it */
+static VAStatus
+put_image_convert(struct object_surface *obj_surface,
+				  const VARectangle *dst_rect,
+				  struct object_image *obj_image, uint8_t *image_data,
+				  const VARectangle *src_rect)
+{
+	struct surface_plane planes[3];
+	struct i965_color_frame src, dst;
+	uint8_t *region, *map;
+	unsigned int tiling;
+	size_t size = 0;
+	int i, num_planes;
+
+	if (!obj_surface->bo)
+		return VA_STATUS_ERROR_INVALID_SURFACE;
+
+	num_planes = surface_region_planes(obj_surface, dst_rect, planes);
+
+	for (i = 0; i < num_planes; i++)
+		size += (size_t)planes[i].len * planes[i].rows;
+
+	region = malloc(size);
+	if (!region)
+		return VA_STATUS_ERROR_ALLOCATION_FAILED;
+
+	memset(&dst, 0, sizeof(dst));
+	dst.fourcc = obj_surface->fourcc;
+
+	for (i = 0, size = 0; i < num_planes; i++) {
+		dst.planes[i] = region + size;
+		dst.pitches[i] = planes[i].len;
+		size += (size_t)planes[i].len * planes[i].rows;
+	}
+
+	image_region_frame(obj_image, image_data, src_rect, &src);
+	i965_color_convert(&dst, &src, src_rect->width, src_rect->height, VAProcColorStandardBT601);
+
+	map = map_surface_for_copy(obj_surface, 1, &tiling);
+	if (!map) {
+		free(region);
+		return VA_STATUS_ERROR_INVALID_SURFACE;
+	}
+
+	for (i = 0; i < num_planes; i++)
+		i965_image_copy_to_surface(map + planes[i].offset, planes[i].pitch, tiling,
+								   planes[i].x, planes[i].y,
+								   dst.planes[i], dst.pitches[i],
+								   planes[i].len, planes[i].rows);
+
+	dri_bo_unmap(obj_surface->bo);
+	free(region);
+
+	return VA_STATUS_SUCCESS;
+}
+
 static VAStatus
 i965_sw_putimage(VADriverContextP ctx,
 				 struct object_surface *obj_surface, struct object_image *obj_image,
@@ -5839,8 +6433,10 @@ i965_sw_putimage(VADriverContextP ctx,
 
 	if (obj_surface->fourcc)
 	{
-		/* Don't allow format mismatch */
-		if (obj_surface->fourcc != obj_image->image.format.fourcc)
+		/* Don't allow format mismatch, unless the CPU can convert */
+		if (obj_surface->fourcc != obj_image->image.format.fourcc &&
+			!can_convert_image(obj_surface->fourcc, obj_image->image.format.fourcc,
+							   src_rect, dst_rect))
 		{
 			i965_log_error(ctx, "i965_sw_putimage: Format mismatch, rejecting call. (surface: %#010x, image: %#010x)\r\n",
 					obj_surface->fourcc, obj_image->image.format.fourcc);
@@ -5865,20 +6461,24 @@ i965_sw_putimage(VADriverContextP ctx,
 	if (va_status != VA_STATUS_SUCCESS)
 		return va_status;
 
-	switch (obj_image->image.format.fourcc) {
-	case VA_FOURCC_YV12:
-	case VA_FOURCC_I420:
-		va_status = put_image_i420(obj_surface, dst_rect, obj_image, image_data, src_rect);
-		break;
-	case VA_FOURCC_NV12:
-		va_status = put_image_nv12(obj_surface, dst_rect, obj_image, image_data, src_rect);
-		break;
-	case VA_FOURCC_YUY2:
-		va_status = put_image_yuy2(obj_surface, dst_rect, obj_image, image_data, src_rect);
-		break;
-	default:
-		va_status = VA_STATUS_ERROR_OPERATION_FAILED;
-		break;
+	if (obj_surface->fourcc != obj_image->image.format.fourcc) {
+		va_status = put_image_convert(obj_surface, dst_rect, obj_image, image_data, src_rect);
+	} else {
+		switch (obj_image->image.format.fourcc) {
+		case VA_FOURCC_YV12:
+		case VA_FOURCC_I420:
+			va_status = put_image_i420(obj_surface, dst_rect, obj_image, image_data, src_rect);
+			break;
+		case VA_FOURCC_NV12:
+			va_status = put_image_nv12(obj_surface, dst_rect, obj_image, image_data, src_rect);
+			break;
+		case VA_FOURCC_YUY2:
+			va_status = put_image_yuy2(obj_surface, dst_rect, obj_image, image_data, src_rect);
+			break;
+		default:
+			va_status = VA_STATUS_ERROR_OPERATION_FAILED;
+			break;
+		}
 	}
 	if (va_status != VA_STATUS_SUCCESS)
 		return va_status;
@@ -5892,7 +6492,10 @@ i965_hw_putimage(VADriverContextP ctx,
 				 struct object_surface *obj_surface, struct object_image *obj_image,
 				 const VARectangle *src_rect, const VARectangle *dst_rect)
 {
+	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct i965_surface src_surface, dst_surface;
+	struct intel_fence_set fences;
+	int fences_valid;
 	VAStatus va_status = VA_STATUS_SUCCESS;
 
 	if (!obj_surface->bo) {
@@ -5917,11 +6520,21 @@ i965_hw_putimage(VADriverContextP ctx,
 	dst_surface.type = I965_SURFACE_TYPE_SURFACE;
 	dst_surface.flags = I965_SURFACE_FLAG_FRAME;
 
+	/*
+	 * The copy is the last write to the surface, which the kernel orders
+	 * after any rendering still running, so its fences replace those of
+	 * the rendering.
+	 */
+	intel_fence_set_init(&fences);
+	intel_batchbuffer_begin_fences(&fences);
 	va_status = i965_image_processing(ctx,
 									  &src_surface,
 									  src_rect,
 									  &dst_surface,
 									  dst_rect);
+	fences_valid = intel_batchbuffer_end_fences() && va_status == VA_STATUS_SUCCESS;
+
+	i965_surface_set_fences(i965, obj_surface, &fences, fences_valid);
 
 	return  va_status;
 }
@@ -5958,6 +6571,7 @@ i965_PutImage(VADriverContextP ctx,
 			  unsigned int dest_width,
 			  unsigned int dest_height)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data * const i965 = i965_driver_data(ctx);
 	struct object_surface * const obj_surface = SURFACE(surface);
 	struct object_image * const obj_image = IMAGE(image);
@@ -5969,6 +6583,8 @@ i965_PutImage(VADriverContextP ctx,
 	if (is_surface_busy(i965, obj_surface))
 		return VA_STATUS_ERROR_SURFACE_BUSY;
 
+	i965_flush_deferred_surface(i965, obj_surface);
+
 	if (!obj_image || !obj_image->bo)
 		return VA_STATUS_ERROR_INVALID_IMAGE;
 	if (is_image_busy(i965, obj_image, surface))
@@ -5996,7 +6612,8 @@ i965_PutImage(VADriverContextP ctx,
 	dst_rect.width  = dest_width;
 	dst_rect.height = dest_height;
 
-	if (use_hw_put_image(i965, obj_surface, obj_image))
+	if (use_hw_put_image(i965, obj_surface, obj_image) &&
+		!use_cpu_image(i965, obj_surface, obj_image, 1, &src_rect, &dst_rect))
 		va_status = i965_hw_putimage(ctx, obj_surface, obj_image,
 									 &src_rect, &dst_rect);
 	else
@@ -6022,6 +6639,7 @@ i965_PutSurface(VADriverContextP ctx,
 				unsigned int number_cliprects, /* number of clip rects in the clip list */
 				unsigned int flags) /* de-interlacing flags */
 {
+	I965_TRACE_FUNCTION();
 #ifdef HAVE_VA_X11
 	if (IS_VA_X11(ctx)) {
 		VARectangle src_rect, dst_rect;
@@ -6052,6 +6670,7 @@ i965_BufferInfo(
 	unsigned int *num_elements  /* out */
 )
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = NULL;
 	struct object_buffer *obj_buffer = NULL;
 
@@ -6082,6 +6701,7 @@ i965_LockSurface(
 	void **buffer                   /* out */
 )
 {
+	I965_TRACE_FUNCTION();
 	VAStatus vaStatus = VA_STATUS_SUCCESS;
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_surface *obj_surface = NULL;
@@ -6154,6 +6774,7 @@ i965_UnlockSurface(
 	VASurfaceID surface     /* in */
 )
 {
+	I965_TRACE_FUNCTION();
 	VAStatus vaStatus = VA_STATUS_SUCCESS;
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_image *locked_img = NULL;
@@ -6207,6 +6828,7 @@ i965_GetSurfaceAttributes(
 	unsigned int num_attribs
 )
 {
+	I965_TRACE_FUNCTION();
 	VAStatus vaStatus = VA_STATUS_SUCCESS;
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	struct object_config *obj_config;
@@ -6401,6 +7023,7 @@ i965_QuerySurfaceAttributes(VADriverContextP ctx,
 							VASurfaceAttrib *attrib_list,
 							unsigned int *num_attribs)
 {
+	I965_TRACE_FUNCTION();
 	if (!ctx)
 		return VA_STATUS_ERROR_INVALID_CONTEXT;
 
@@ -6583,6 +7206,7 @@ static VAStatus
 i965_AcquireBufferHandle(VADriverContextP ctx, VABufferID buf_id,
 						 VABufferInfo *buf_info)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data * const i965 = i965_driver_data(ctx);
 	struct object_buffer * const obj_buffer = BUFFER(buf_id);
 	uint32_t i, mem_type;
@@ -6633,6 +7257,7 @@ i965_AcquireBufferHandle(VADriverContextP ctx, VABufferID buf_id,
 static VAStatus
 i965_ReleaseBufferHandle(VADriverContextP ctx, VABufferID buf_id)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data * const i965 = i965_driver_data(ctx);
 	struct object_buffer * const obj_buffer = BUFFER(buf_id);
 
@@ -6651,14 +7276,19 @@ i965_ExportSurfaceHandle(VADriverContextP ctx, VASurfaceID surface_id,
 						 uint32_t mem_type, uint32_t flags,
 						 void *descriptor)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *const i965 = i965_driver_data(ctx);
 	struct object_surface *obj_surface = SURFACE(surface_id);
+	VADRMPRIMESurfaceDescriptor *desc = (VADRMPRIMESurfaceDescriptor *)descriptor;
 	const i965_fourcc_info *info;
 	unsigned int tiling, swizzle;
 	uint32_t formats[4], pitch, height, offset, y_offset;
 	int fd, p;
 	int composite_object =
 		flags & VA_EXPORT_SURFACE_COMPOSED_LAYERS;
+	uint32_t layer_flags =
+		flags & (VA_EXPORT_SURFACE_COMPOSED_LAYERS | VA_EXPORT_SURFACE_SEPARATE_LAYERS);
+	int exported;
 
 	if (!obj_surface)
 	{
@@ -6666,6 +7296,11 @@ i965_ExportSurfaceHandle(VADriverContextP ctx, VASurfaceID surface_id,
 		return VA_STATUS_ERROR_INVALID_SURFACE;
 	}
 
+	i965_flush_deferred_surface(i965, obj_surface);
+
+	if (flags & VA_EXPORT_SURFACE_WRITE_ONLY)
+		obj_surface->generation++;
+
 	if (!obj_surface->bo)
 	{
 		i965_log_debug(ctx, "vaExportSurfaceHandle: Surface lacks a backing BO to export\n");
@@ -6679,6 +7314,20 @@ i965_ExportSurfaceHandle(VADriverContextP ctx, VASurfaceID surface_id,
 		return VA_STATUS_ERROR_UNSUPPORTED_MEMORY_TYPE;
 	}
 
+	/* The storage was exported with this layout already, only the fd is new */
+	if (obj_surface->exported_desc &&
+		obj_surface->exported_desc_flags == layer_flags) {
+		fd = fcntl(obj_surface->exported_primefd, F_DUPFD_CLOEXEC, 0);
+		if (fd < 0)
+			return VA_STATUS_ERROR_OPERATION_FAILED;
+
+		*desc = *obj_surface->exported_desc;
+		desc->objects[0].fd = fd;
+		i965_prime_cache_count_export(&i965->prime_cache, 1);
+
+		return VA_STATUS_SUCCESS;
+	}
+
 	info = get_fourcc_info(obj_surface->fourcc);
 	if (!info)
 	{
@@ -6709,17 +7358,21 @@ i965_ExportSurfaceHandle(VADriverContextP ctx, VASurfaceID surface_id,
 		}
 	}
 
-	if (drm_intel_bo_gem_export_to_prime(obj_surface->bo, &fd))
+	exported = obj_surface->exported_primefd >= 0;
+
+	if (!exported &&
+		drm_intel_bo_gem_export_to_prime(obj_surface->bo, &obj_surface->exported_primefd))
 	{
+		obj_surface->exported_primefd = -1;
 		i965_log_debug(ctx, "vaExportSurfaceHandle: drm_intel_bo_gem_export_to_prime() returned an error.\n");
 		return VA_STATUS_ERROR_INVALID_SURFACE;
 	}
 
+	i965_prime_cache_count_export(&i965->prime_cache, exported);
+
 	if (drm_intel_bo_get_tiling(obj_surface->bo, &tiling, &swizzle))
 		tiling = I915_TILING_NONE;
 
-	VADRMPRIMESurfaceDescriptor *desc = (VADRMPRIMESurfaceDescriptor *)descriptor;
-
 	/* Chromium doesn't seem to safely init the struct, this can cause memory corruption. */
 	memset(desc, 0, sizeof(VADRMPRIMESurfaceDescriptor));
 
@@ -6728,7 +7381,7 @@ i965_ExportSurfaceHandle(VADriverContextP ctx, VASurfaceID surface_id,
 	desc->height = obj_surface->orig_height;
 
 	desc->num_objects = 1;
-	desc->objects[0].fd = fd;
+	desc->objects[0].fd = -1;
 	desc->objects[0].size = obj_surface->size;
 
 	switch (tiling)
@@ -6815,6 +7468,21 @@ i965_ExportSurfaceHandle(VADriverContextP ctx, VASurfaceID surface_id,
 		}
 	}
 
+	/* Keep the layout around, the caller owns and closes the returned fd */
+	if (!obj_surface->exported_desc)
+		obj_surface->exported_desc = malloc(sizeof(*desc));
+
+	if (obj_surface->exported_desc) {
+		*obj_surface->exported_desc = *desc;
+		obj_surface->exported_desc_flags = layer_flags;
+	}
+
+	fd = fcntl(obj_surface->exported_primefd, F_DUPFD_CLOEXEC, 0);
+	if (fd < 0)
+		return VA_STATUS_ERROR_OPERATION_FAILED;
+
+	desc->objects[0].fd = fd;
+
 	return VA_STATUS_SUCCESS;
 }
 
@@ -6856,6 +7524,7 @@ VAStatus i965_QueryVideoProcFilters(
 	unsigned int       *num_filters
 )
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *const i965 = i965_driver_data(ctx);
 	unsigned int i = 0, num = 0;
 
@@ -6887,6 +7556,7 @@ VAStatus i965_QueryVideoProcFilterCaps(
 	unsigned int       *num_filter_caps
 )
 {
+	I965_TRACE_FUNCTION();
 	unsigned int i = 0;
 	struct i965_driver_data *const i965 = i965_driver_data(ctx);
 
@@ -7020,6 +7690,7 @@ VAStatus i965_QueryVideoProcPipelineCaps(
 	VAProcPipelineCaps *pipeline_cap     /* out */
 )
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data * const i965 = i965_driver_data(ctx);
 	unsigned int i = 0;
 
@@ -7135,6 +7806,129 @@ void i965_log_debug(VADriverContextP ctx, const char *format, ...)
 
 extern struct hw_codec_info *i965_get_codec_info(int devid);
 
+static void
+i965_driver_data_init_surface_pool(struct i965_driver_data *i965)
+{
+	uint64_t pool_size = I965_SURFACE_POOL_DEFAULT_SIZE;
+	char *env_str = NULL;
+
+	/* I965_SURFACE_POOL_SIZE is in MB, 0 disables surface recycling */
+	if ((env_str = getenv("I965_SURFACE_POOL_SIZE")))
+		pool_size = strtoull(env_str, NULL, 10);
+
+	i965_surface_pool_init(&i965->surface_pool, pool_size << 20, NULL);
+}
+
+static void
+i965_driver_data_init_prime_cache(struct i965_driver_data *i965)
+{
+	unsigned int cache_size = I965_PRIME_CACHE_DEFAULT_SIZE;
+	char *env_str = NULL;
+
+	/* I965_PRIME_CACHE_SIZE is the number of imported buffers kept unused */
+	if ((env_str = getenv("I965_PRIME_CACHE_SIZE")))
+		cache_size = strtoul(env_str, NULL, 10);
+
+	i965_prime_cache_init(&i965->prime_cache, i965->intel.bufmgr, cache_size, NULL);
+}
+
+static void
+i965_driver_data_init_cpu_convert(struct i965_driver_data *i965)
+{
+	char *env_str = NULL;
+
+	i965->cpu_convert = I965_CPU_CONVERT_AUTO;
+
+	if ((env_str = getenv("I965_CPU_CONVERT")))
+		i965->cpu_convert = atoi(env_str) ? I965_CPU_CONVERT_ALWAYS : I965_CPU_CONVERT_NEVER;
+}
+
+static void
+i965_driver_data_terminate_prime_cache(VADriverContextP ctx)
+{
+	struct i965_driver_data *i965 = i965_driver_data(ctx);
+	struct i965_prime_cache_stats stats;
+
+	i965_prime_cache_get_stats(&i965->prime_cache, &stats);
+	i965_log_debug(ctx, "i965: prime import %llu hits, %llu misses, %llu uncached, "
+				   "%llu evictions, export %llu/%llu reused\n",
+				   (unsigned long long)stats.hits,
+				   (unsigned long long)stats.misses,
+				   (unsigned long long)stats.uncached,
+				   (unsigned long long)stats.evictions,
+				   (unsigned long long)stats.export_hits,
+				   (unsigned long long)stats.exports);
+
+	i965_prime_cache_terminate(&i965->prime_cache);
+}
+
+static void
+i965_driver_data_terminate_kernel_cache(VADriverContextP ctx)
+{
+	struct i965_driver_data *i965 = i965_driver_data(ctx);
+	struct i965_kernel_cache_stats stats;
+
+	i965_kernel_cache_get_stats(&i965->kernel_cache, &stats);
+	i965_log_debug(ctx, "i965: kernel cache %llu hits, %llu misses, %u kernel sets, "
+				   "%llu bytes uploaded\n",
+				   (unsigned long long)stats.hits,
+				   (unsigned long long)stats.misses,
+				   stats.num_entries,
+				   (unsigned long long)stats.bytes_uploaded);
+
+	i965_kernel_cache_terminate(&i965->kernel_cache);
+}
+
+static void
+i965_driver_data_init_gpe_state_heap(struct i965_driver_data *i965)
+{
+	char *env_str = NULL;
+
+	i965_gpe_state_heap_init(&i965->gpe_state_heap, i965->intel.bufmgr, NULL);
+
+	/* I965_GPE_STATE_HEAP=0 gives every GPE context its own state buffers */
+	i965->use_gpe_state_heap = i965->intel.has_llc;
+	if ((env_str = getenv("I965_GPE_STATE_HEAP")) && !atoi(env_str))
+		i965->use_gpe_state_heap = 0;
+}
+
+static void
+i965_driver_data_terminate_gpe_state_heap(VADriverContextP ctx)
+{
+	struct i965_driver_data *i965 = i965_driver_data(ctx);
+	struct i965_gpe_state_heap_stats stats;
+
+	i965_gpe_state_heap_get_stats(&i965->gpe_state_heap, &stats);
+	i965_log_debug(ctx, "i965: gpe state heap %llu slices, %llu bytes, %llu failures, "
+				   "%llu/%llu chunks reused, %u chunks max\n",
+				   (unsigned long long)stats.allocations,
+				   (unsigned long long)stats.bytes_allocated,
+				   (unsigned long long)stats.failures,
+				   (unsigned long long)stats.chunk_reuses,
+				   (unsigned long long)(stats.chunk_reuses + stats.chunk_allocations),
+				   stats.max_chunks);
+
+	i965_gpe_state_heap_terminate(&i965->gpe_state_heap);
+}
+
+static void
+i965_driver_data_terminate_surface_pool(VADriverContextP ctx)
+{
+	struct i965_driver_data *i965 = i965_driver_data(ctx);
+	struct i965_surface_pool_stats stats;
+
+	i965_surface_pool_get_stats(&i965->surface_pool, &stats);
+	i965_log_debug(ctx, "i965: surface pool %llu hits, %llu misses, %llu evictions, "
+				   "%llu purged, %llu bytes held\n",
+				   (unsigned long long)stats.hits,
+				   (unsigned long long)stats.misses,
+				   (unsigned long long)stats.evictions,
+				   (unsigned long long)stats.purged,
+				   (unsigned long long)stats.bytes_held);
+
+	i965_surface_pool_terminate(&i965->surface_pool);
+}
+
 static bool
 i965_driver_data_init(VADriverContextP ctx)
 {
@@ -7145,6 +7939,15 @@ i965_driver_data_init(VADriverContextP ctx)
 	if (!i965->codec_info)
 		return false;
 
+	i965_driver_data_init_surface_pool(i965);
+	i965_driver_data_init_prime_cache(i965);
+	i965_driver_data_init_cpu_convert(i965);
+	i965_kernel_cache_init(&i965->kernel_cache, i965->intel.bufmgr, NULL);
+	i965_driver_data_init_gpe_state_heap(i965);
+
+	if (intel_completion_queue_init(&i965->completion_queue))
+		goto err_completion_queue;
+
 	if (object_heap_init(&i965->config_heap,
 						 sizeof(struct object_config),
 						 CONFIG_ID_OFFSET))
@@ -7175,6 +7978,7 @@ i965_driver_data_init(VADriverContextP ctx)
 	i965->pp_batch = intel_batchbuffer_new(&i965->intel, I915_EXEC_RENDER, 0);
 	_i965InitMutex(&i965->render_mutex);
 	_i965InitMutex(&i965->pp_mutex);
+	_i965InitMutex(&i965->fence_mutex);
 
 	return true;
 
@@ -7189,6 +7993,12 @@ err_surface_heap:
 err_context_heap:
 	object_heap_destroy(&i965->config_heap);
 err_config_heap:
+	intel_completion_queue_fini(&i965->completion_queue);
+err_completion_queue:
+	i965_gpe_state_heap_terminate(&i965->gpe_state_heap);
+	i965_kernel_cache_terminate(&i965->kernel_cache);
+	i965_prime_cache_terminate(&i965->prime_cache);
+	i965_surface_pool_terminate(&i965->surface_pool);
 
 	return false;
 }
@@ -7198,6 +8008,7 @@ i965_driver_data_terminate(VADriverContextP ctx)
 {
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 
+	_i965DestroyMutex(&i965->fence_mutex);
 	_i965DestroyMutex(&i965->pp_mutex);
 	_i965DestroyMutex(&i965->render_mutex);
 
@@ -7213,6 +8024,13 @@ i965_driver_data_terminate(VADriverContextP ctx)
 	i965_destroy_heap(&i965->surface_heap, i965_destroy_surface);
 	i965_destroy_heap(&i965->context_heap, i965_destroy_context);
 	i965_destroy_heap(&i965->config_heap, i965_destroy_config);
+
+	intel_completion_queue_fini(&i965->completion_queue);
+
+	i965_driver_data_terminate_gpe_state_heap(ctx);
+	i965_driver_data_terminate_kernel_cache(ctx);
+	i965_driver_data_terminate_prime_cache(ctx);
+	i965_driver_data_terminate_surface_pool(ctx);
 }
 
 struct {
@@ -7491,6 +8309,7 @@ i965_Init(VADriverContextP ctx)
 VAStatus
 i965_Terminate(VADriverContextP ctx)
 {
+	I965_TRACE_FUNCTION();
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	int i;
 
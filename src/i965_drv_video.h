@@ -48,6 +48,11 @@
 #include "object_heap.h"
 #include "intel_driver.h"
 #include "i965_fourcc.h"
+#include "i965_surface_pool.h"
+#include "i965_prime_cache.h"
+#include "i965_kernel_cache.h"
+#include "i965_gpe_state_heap.h"
+#include "intel_fence.h"
 
 #define I965_MAX_PROFILES                       20
 #define I965_MAX_ENTRYPOINTS                    7
@@ -234,6 +239,10 @@ struct decode_state {
 	int num_slice_params;
 	int num_slice_datas;
 
+	/* The size announced at vaCreateContext(), a hint for buffer sizing */
+	int picture_width;
+	int picture_height;
+
 	struct object_surface *render_object;
 	struct object_surface *reference_objects[16]; /* Up to 2 reference surfaces are valid for MPEG-2,*/
 };
@@ -390,13 +399,39 @@ struct object_surface {
 	uint32_t user_disable_tiling : 1;
 	uint32_t user_h_stride_set   : 1;
 	uint32_t user_v_stride_set   : 1;
-	/* we need clear right and bottom border for NV12.
-	 * to avoid encode run to run issue*/
-	uint32_t border_cleared      : 1;
+	/*
+	 * The right and bottom padding is cleared before encoding to avoid run to
+	 * run differences. The generation is bumped by a new BO and by the CPU
+	 * accesses which may leave anything in the padding, the clear is only
+	 * redone once it moved past border_generation. The GPU writes whole
+	 * blocks into the padding too, but with pixels of the picture, which is
+	 * as deterministic as zeroes.
+	 */
+	uint32_t generation;
+	uint32_t border_generation;
 
 	VAGenericID wrapper_surface;
 
+	/* PRIME fd owned by the driver, exports hand out duplicates of it */
 	int exported_primefd;
+	VADRMPRIMESurfaceDescriptor *exported_desc;
+	uint32_t exported_desc_flags;
+
+	/* the import cache the storage goes back to on destroy, NULL if not imported */
+	struct i965_prime_cache *prime_cache;
+	struct i965_prime_cache_key prime_key;
+
+	/* the pool the storage goes back to on destroy, NULL if not poolable */
+	struct i965_surface_pool *pool;
+	struct i965_surface_pool_key pool_key;
+
+	/*
+	 * Fences of the last vaEndPicture() rendering to the surface, under the
+	 * fence_mutex. Only valid when they cover all of its submissions,
+	 * otherwise the BO is waited on. Valid and empty means idle.
+	 */
+	struct intel_fence_set fences;
+	int fences_valid;
 };
 
 struct object_buffer {
@@ -531,6 +566,18 @@ struct hw_codec_info {
 #include "i965_render.h"
 #include "i965_gpe_utils.h"
 
+/*
+ * I965_CPU_CONVERT=0 keeps vaGetImage()/vaPutImage() on the GPU, =1 moves
+ * them to the CPU whenever it can do them. By default (AUTO) they move
+ * once I965_CPU_CONVERT_PENDING_THRESHOLD post-processing batches are
+ * queued on the GPU.
+ */
+#define I965_CPU_CONVERT_NEVER          0
+#define I965_CPU_CONVERT_ALWAYS         1
+#define I965_CPU_CONVERT_AUTO           2
+
+#define I965_CPU_CONVERT_PENDING_THRESHOLD  2
+
 struct i965_driver_data {
 	struct intel_driver_data intel;
 	struct object_heap config_heap;
@@ -545,6 +592,7 @@ struct i965_driver_data {
 	_I965Mutex pp_mutex;
 	struct intel_batchbuffer *batch;
 	struct intel_batchbuffer *pp_batch;
+	int cpu_convert;
 	struct i965_render_state render_state;
 	void *pp_context;
 	char va_vendor[256];
@@ -567,6 +615,17 @@ struct i965_driver_data {
 	VADriverContextP wrapper_pdrvctx;
 
 	struct i965_gpe_table gpe_table;
+
+	struct i965_surface_pool surface_pool;
+	struct i965_prime_cache prime_cache;
+	struct i965_kernel_cache kernel_cache;
+
+	/* See i965_gpe_context_use_state_heap() */
+	struct i965_gpe_state_heap gpe_state_heap;
+	int use_gpe_state_heap;
+
+	_I965Mutex fence_mutex;
+	struct intel_completion_queue completion_queue;
 };
 
 #define NEW_CONFIG_ID() object_heap_allocate(&i965->config_heap);
@@ -605,6 +664,31 @@ i965_check_alloc_surface_bo(VADriverContextP ctx,
 int
 va_enc_packed_type_to_idx(int packed_type);
 
+/*
+ * Completion of the surfaces without a thread per surface, for the users
+ * of the driver that go past the VA API.
+ *
+ * i965_surface_export_fence() returns a sync_file signaled once the last
+ * vaEndPicture() rendering to the surface completes, or -1 in fd if the
+ * surface is already idle.
+ *
+ * i965_surface_notify() calls func from i965_dispatch_completions() once
+ * the surface is idle. The completion fd is readable while there are
+ * completions to dispatch.
+ */
+VAStatus
+i965_surface_export_fence(VADriverContextP ctx, VASurfaceID surface, int *fd);
+
+VAStatus
+i965_surface_notify(VADriverContextP ctx, VASurfaceID surface,
+					intel_completion_func func, void *data);
+
+int
+i965_completion_fd(VADriverContextP ctx);
+
+int
+i965_dispatch_completions(VADriverContextP ctx);
+
 int get_max_width_for_codec(struct i965_driver_data *const i965, VAProfile profile, VAEntrypoint entrypoint);
 int get_max_height_for_codec(struct i965_driver_data *const i965, VAProfile profile, VAEntrypoint entrypoint);
 
@@ -57,55 +57,137 @@ reduce_fraction(struct intel_fraction f)
 	};
 }
 
+struct border_plane {
+	int offset;     /* in byte */
+	int pitch;      /* in byte */
+	int width;      /* of the content in byte */
+	int height;     /* of the content in rows */
+	int vstride;    /* the rows the encoder reads */
+};
+
+/*
+ * The planes of the tiled layouts from i965_check_alloc_surface_bo(),
+ * returns 0 for the fourccs the encoders never read directly.
+ */
+static int
+border_planes(struct object_surface *obj_surface, struct border_plane *planes)
+{
+	int chroma_vstride = ALIGN(obj_surface->cb_cr_height, 32);
+	int num_planes, bpp = 1;
+
+	planes[0].offset = 0;
+	planes[0].pitch = obj_surface->width;
+	planes[0].width = obj_surface->orig_width;
+	planes[0].height = obj_surface->orig_height;
+	planes[0].vstride = obj_surface->height;
+
+	switch (obj_surface->fourcc) {
+	case VA_FOURCC_P010:
+		bpp = 2;
+
+		/* fall through */
+	case VA_FOURCC_NV12:
+		num_planes = 2;
+		planes[0].width *= bpp;
+		planes[1].offset = obj_surface->width * obj_surface->y_cb_offset;
+		planes[1].pitch = obj_surface->cb_cr_pitch;
+		planes[1].width = obj_surface->cb_cr_width * 2 * bpp;
+		planes[1].height = obj_surface->cb_cr_height;
+		planes[1].vstride = chroma_vstride;
+		break;
+
+	case VA_FOURCC_IMC1:
+	case VA_FOURCC_IMC3:
+	case VA_FOURCC_422H:
+	case VA_FOURCC_422V:
+	case VA_FOURCC_411P:
+	case VA_FOURCC_444P:
+		num_planes = 3;
+		planes[1].offset = obj_surface->width * obj_surface->y_cb_offset;
+		planes[2].offset = obj_surface->width * obj_surface->y_cr_offset;
+		planes[1].pitch = planes[2].pitch = obj_surface->cb_cr_pitch;
+		planes[1].width = planes[2].width = obj_surface->cb_cr_width;
+		planes[1].height = planes[2].height = obj_surface->cb_cr_height;
+		planes[1].vstride = planes[2].vstride = chroma_vstride;
+		break;
+
+	case VA_FOURCC_Y800:
+		num_planes = 1;
+		break;
+
+	case VA_FOURCC_YUY2:
+	case VA_FOURCC_UYVY:
+		num_planes = 1;
+		planes[0].width *= 2;
+		break;
+
+	case VA_FOURCC_RGBA:
+	case VA_FOURCC_RGBX:
+	case VA_FOURCC_BGRA:
+	case VA_FOURCC_BGRX:
+	case VA_FOURCC_ARGB:
+		num_planes = 1;
+		planes[0].width *= 4;
+		break;
+
+	default:
+		return 0;
+	}
+
+	return num_planes;
+}
+
 static VAStatus
 clear_border(struct object_surface *obj_surface)
 {
-	int width[3], height[3], hstride[3], vstride[3]; /* in byte */
-	int planes;
-	unsigned char* p;
+	struct border_plane planes[3];
+	unsigned int generation = obj_surface->generation;
+	int num_planes, has_border = 0;
+	unsigned char *base, *p;
 	int i, j;
 
-	if (obj_surface->border_cleared)
+	if (obj_surface->border_generation == generation)
 		return VA_STATUS_SUCCESS;
 
-	if (obj_surface->fourcc == VA_FOURCC_NV12) {
-		planes = 2;
-		width[0] = width[1] = obj_surface->orig_width;
-		height[0] = obj_surface->orig_height;
-		height[1] = obj_surface->orig_height / 2;
-		hstride[0] = hstride[1] = obj_surface->width;
-		vstride[0] = obj_surface->height;
-		vstride[1] = obj_surface->height / 2;
+	num_planes = border_planes(obj_surface, planes);
 
-	} else {
-		/* todo add P010 */
+	for (i = 0; i < num_planes; i++)
+		has_border |= (planes[i].width < planes[i].pitch ||
+					   planes[i].height < planes[i].vstride);
+
+	if (!has_border) {
+		obj_surface->border_generation = generation;
 		return VA_STATUS_SUCCESS;
 	}
+
 	drm_intel_gem_bo_map_gtt(obj_surface->bo);
 
-	p = (unsigned char*)obj_surface->bo->virtual;
-	if (!p)
+	base = (unsigned char*)obj_surface->bo->virtual;
+	if (!base)
 		return VA_STATUS_ERROR_INVALID_SURFACE;
 
-	for (i = 0; i < planes; i++) {
-		int w = width[i];
-		int h = height[i];
-		int hs = hstride[i];
-		int vs = vstride[i];
+	for (i = 0; i < num_planes; i++) {
+		int w = planes[i].width;
+		int h = planes[i].height;
+		int hs = planes[i].pitch;
+		int vs = planes[i].vstride;
+
+		/* imported surfaces may end right after the last plane */
+		if (planes[i].offset + vs * hs > obj_surface->bo->size)
+			vs = MAX(h, (int)((obj_surface->bo->size - planes[i].offset) / hs));
+
+		p = base + planes[i].offset;
 		/* right */
-		for (j = 0; j < h; j++) {
-			memset(p + w, 0, hs - w);
-			p += hs;
+		if (w < hs) {
+			for (j = 0; j < h; j++)
+				memset(p + j * hs + w, 0, hs - w);
 		}
 		/* bottom */
-		for (/* nothing */; j < vs; j++) {
-			memset(p, 0, hs);
-			p += hs;
-		}
-
+		if (h < vs)
+			memset(p + h * hs, 0, (vs - h) * hs);
 	}
 	drm_intel_gem_bo_unmap_gtt(obj_surface->bo);
-	obj_surface->border_cleared = true;
+	obj_surface->border_generation = generation;
 	return VA_STATUS_SUCCESS;
 }
 
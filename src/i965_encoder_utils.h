@@ -1,21 +1,30 @@
 #ifndef __I965_ENCODER_UTILS_H__
 #define __I965_ENCODER_UTILS_H__
 
+/*
+ * The header builders write into storage provided by the caller and return
+ * the header length in bits, the data is zero padded to a dword boundary.
+ * This is enough for any slice or SEI header they generate.
+ */
+#define I965_HEADER_BUFFER_SIZE     256
+
 int
 build_avc_slice_header(VAEncSequenceParameterBufferH264 *sps_param,
 					   VAEncPictureParameterBufferH264 *pic_param,
 					   VAEncSliceParameterBufferH264 *slice_param,
-					   unsigned char **slice_header_buffer);
+					   unsigned char *slice_header_buffer,
+					   int buffer_size);
 int
 build_avc_sei_buffering_period(int cpb_removal_length,
 							   unsigned int init_cpb_removal_delay,
 							   unsigned int init_cpb_removal_delay_offset,
-							   unsigned char **sei_buffer);
+							   unsigned char *sei_buffer,
+							   int buffer_size);
 
 int
 build_avc_sei_pic_timing(unsigned int cpb_removal_length, unsigned int cpb_removal_delay,
 						 unsigned int dpb_output_length, unsigned int dpb_output_delay,
-						 unsigned char **sei_buffer);
+						 unsigned char *sei_buffer, int buffer_size);
 
 int
 build_avc_sei_buffer_timing(unsigned int init_cpb_removal_length,
@@ -25,13 +34,15 @@ build_avc_sei_buffer_timing(unsigned int init_cpb_removal_length,
 							unsigned int cpb_removal_delay,
 							unsigned int dpb_output_length,
 							unsigned int dpb_output_delay,
-							unsigned char **sei_buffer);
+							unsigned char *sei_buffer,
+							int buffer_size);
 
 int
 build_mpeg2_slice_header(VAEncSequenceParameterBufferMPEG2 *sps_param,
 						 VAEncPictureParameterBufferMPEG2 *pic_param,
 						 VAEncSliceParameterBufferMPEG2 *slice_param,
-						 unsigned char **slice_header_buffer);
+						 unsigned char *slice_header_buffer,
+						 int buffer_size);
 
 /* HEVC */
 
@@ -39,18 +50,20 @@ int
 build_hevc_slice_header(VAEncSequenceParameterBufferHEVC *seq_param,
 						VAEncPictureParameterBufferHEVC *pic_param,
 						VAEncSliceParameterBufferHEVC *slice_param,
-						unsigned char **header_buffer,
+						unsigned char *header_buffer,
+						int buffer_size,
 						int slice_index);
 int
 build_hevc_sei_buffering_period(int cpb_removal_length,
 								unsigned int init_cpb_removal_delay,
 								unsigned int init_cpb_removal_delay_offset,
-								unsigned char **sei_buffer);
+								unsigned char *sei_buffer,
+								int buffer_size);
 
 int
 build_hevc_sei_pic_timing(unsigned int cpb_removal_length, unsigned int cpb_removal_delay,
 						  unsigned int dpb_output_length, unsigned int dpb_output_delay,
-						  unsigned char **sei_buffer);
+						  unsigned char *sei_buffer, int buffer_size);
 
 int
 build_hevc_idr_sei_buffer_timing(unsigned int init_cpb_removal_delay_length,
@@ -60,7 +73,8 @@ build_hevc_idr_sei_buffer_timing(unsigned int init_cpb_removal_delay_length,
 								 unsigned int cpb_removal_delay,
 								 unsigned int dpb_output_length,
 								 unsigned int dpb_output_delay,
-								 unsigned char **sei_buffer);
+								 unsigned char *sei_buffer,
+								 int buffer_size);
 
 int
 intel_avc_find_skipemulcnt(unsigned char *buf, int bits_length);
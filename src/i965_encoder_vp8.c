@@ -1529,6 +1529,35 @@ i965_add_dri_buffer_2d_gpe_surface(VADriverContextP ctx,
 	i965_free_gpe_resource(&gpe_resource);
 }
 
+static enum intel_gpu_stage
+i965_encoder_vp8_gpu_stage(int media_function)
+{
+	switch (media_function) {
+	case VP8_MEDIA_STATE_16X_SCALING:
+	case VP8_MEDIA_STATE_4X_SCALING:
+		return INTEL_GPU_STAGE_SCALING;
+
+	case VP8_MEDIA_STATE_16X_ME:
+	case VP8_MEDIA_STATE_4X_ME:
+		return INTEL_GPU_STAGE_ME;
+
+	case VP8_MEDIA_STATE_BRC_INIT_RESET:
+		return INTEL_GPU_STAGE_BRC_INIT;
+
+	case VP8_MEDIA_STATE_BRC_UPDATE:
+		return INTEL_GPU_STAGE_BRC_UPDATE;
+
+	case VP8_MEDIA_STATE_MPU:
+		return INTEL_GPU_STAGE_MPU;
+
+	case VP8_MEDIA_STATE_TPU:
+		return INTEL_GPU_STAGE_TPU;
+
+	default:
+		return INTEL_GPU_STAGE_MBENC;
+	}
+}
+
 static void
 i965_run_kernel_media_object(VADriverContextP ctx,
 							 struct intel_encoder_context *encoder_context,
@@ -1541,6 +1570,7 @@ i965_run_kernel_media_object(VADriverContextP ctx,
 	struct intel_batchbuffer *batch = encoder_context->base.batch;
 
 	intel_batchbuffer_start_atomic(batch, 0x1000);
+	intel_batchbuffer_begin_stage(batch, i965_encoder_vp8_gpu_stage(media_function));
 
 	intel_batchbuffer_emit_mi_flush(batch);
 	gpe->pipeline_setup(ctx, gpe_context, batch);
@@ -1548,6 +1578,7 @@ i965_run_kernel_media_object(VADriverContextP ctx,
 	gpe->media_state_flush(ctx, gpe_context, batch);
 	gpe->pipeline_end(ctx, gpe_context, batch);
 
+	intel_batchbuffer_end_stage(batch, i965_encoder_vp8_gpu_stage(media_function));
 	intel_batchbuffer_end_atomic(batch);
 
 	intel_batchbuffer_flush(batch);
@@ -1662,6 +1693,7 @@ i965_run_kernel_media_object_walker(VADriverContextP ctx,
 	struct intel_batchbuffer *batch = encoder_context->base.batch;
 
 	intel_batchbuffer_start_atomic(batch, 0x1000);
+	intel_batchbuffer_begin_stage(batch, i965_encoder_vp8_gpu_stage(media_function));
 
 	intel_batchbuffer_emit_mi_flush(batch);
 	gpe->pipeline_setup(ctx, gpe_context, batch);
@@ -1669,6 +1701,7 @@ i965_run_kernel_media_object_walker(VADriverContextP ctx,
 	gpe->media_state_flush(ctx, gpe_context, batch);
 	gpe->pipeline_end(ctx, gpe_context, batch);
 
+	intel_batchbuffer_end_stage(batch, i965_encoder_vp8_gpu_stage(media_function));
 	intel_batchbuffer_end_atomic(batch);
 
 	intel_batchbuffer_flush(batch);
@@ -6023,9 +6056,11 @@ i965_encoder_vp8_pak_pipeline(VADriverContextP ctx,
 		if (vp8_context->submit_batchbuffer)
 			intel_batchbuffer_start_atomic_bcs_override(batch, 0x1000, vp8_context->vdbox_idc);
 
+		intel_batchbuffer_begin_stage(batch, INTEL_GPU_STAGE_PAK);
 		intel_batchbuffer_emit_mi_flush(batch);
 		i965_encoder_vp8_pak_picture_level(ctx, encode_state, encoder_context);
 		i965_encoder_vp8_pak_slice_level(ctx, encode_state, encoder_context);
+		intel_batchbuffer_end_stage(batch, INTEL_GPU_STAGE_PAK);
 
 		if (vp8_context->submit_batchbuffer) {
 			intel_batchbuffer_end_atomic(batch);
@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "sysdeps.h"
+
+#include "i965_gpe_state_heap.h"
+
+#define STATE_ALIGN(i, n)   (((i) + (n) - 1) & ~((n) - 1))
+
+struct i965_gpe_state_chunk {
+	struct i965_gpe_state_chunk *next;
+	dri_bo *bo;
+	unsigned int size;
+	unsigned int used;
+	unsigned int live;
+};
+
+static void
+i965_gpe_state_heap_destroy_chunk(struct i965_gpe_state_heap *heap,
+								  struct i965_gpe_state_chunk *chunk)
+{
+	/* Contexts still pointing at the chunk keep their own reference */
+	heap->ops->unmap(chunk->bo);
+	heap->ops->unreference(chunk->bo);
+	free(chunk);
+
+	heap->stats.num_chunks--;
+}
+
+static struct i965_gpe_state_chunk *
+i965_gpe_state_heap_new_chunk(struct i965_gpe_state_heap *heap,
+							  unsigned int size)
+{
+	struct i965_gpe_state_chunk *chunk;
+
+	chunk = calloc(1, sizeof(*chunk));
+	if (!chunk)
+		return NULL;
+
+	chunk->size = STATE_ALIGN(size, 4096);
+
+	if (chunk->size < I965_GPE_STATE_HEAP_CHUNK_SIZE)
+		chunk->size = I965_GPE_STATE_HEAP_CHUNK_SIZE;
+
+	chunk->bo = heap->ops->alloc(heap->bufmgr, "gpe state heap", chunk->size, 4096);
+	if (!chunk->bo) {
+		free(chunk);
+		return NULL;
+	}
+
+	/* Mapped once while idle, the mapping is kept for the chunk lifetime */
+	if (heap->ops->map(chunk->bo, 1) != 0 || !chunk->bo->virtual) {
+		heap->ops->unreference(chunk->bo);
+		free(chunk);
+		return NULL;
+	}
+
+	heap->stats.chunk_allocations++;
+	heap->stats.num_chunks++;
+
+	if (heap->stats.num_chunks > heap->stats.max_chunks)
+		heap->stats.max_chunks = heap->stats.num_chunks;
+
+	return chunk;
+}
+
+/*
+ * Retires the current chunk and picks the oldest retired one that is empty
+ * and idle, the idle ones past I965_GPE_STATE_HEAP_MAX_IDLE are released.
+ */
+static struct i965_gpe_state_chunk *
+i965_gpe_state_heap_next_chunk(struct i965_gpe_state_heap *heap,
+							   unsigned int size)
+{
+	struct i965_gpe_state_chunk **link, *chunk, *found = NULL;
+	unsigned int num_idle = 0;
+
+	if (heap->current) {
+		for (link = &heap->retired; *link; link = &(*link)->next)
+			;
+
+		*link = heap->current;
+		heap->current = NULL;
+	}
+
+	link = &heap->retired;
+
+	while ((chunk = *link)) {
+		if (chunk->live || heap->ops->busy(chunk->bo)) {
+			link = &chunk->next;
+			continue;
+		}
+
+		if (!found && chunk->size >= size) {
+			*link = chunk->next;
+			found = chunk;
+		} else if (++num_idle > I965_GPE_STATE_HEAP_MAX_IDLE) {
+			*link = chunk->next;
+			i965_gpe_state_heap_destroy_chunk(heap, chunk);
+		} else
+			link = &chunk->next;
+	}
+
+	if (found) {
+		found->next = NULL;
+		found->used = 0;
+		heap->stats.chunk_reuses++;
+	} else
+		found = i965_gpe_state_heap_new_chunk(heap, size);
+
+	heap->current = found;
+
+	return found;
+}
+
+void
+i965_gpe_state_heap_init(struct i965_gpe_state_heap *heap,
+						 dri_bufmgr *bufmgr,
+						 const struct i965_bufmgr_ops *ops)
+{
+	memset(heap, 0, sizeof(*heap));
+	heap->ops = ops ? ops : &i965_bufmgr_drm_ops;
+	heap->bufmgr = bufmgr;
+	_i965InitMutex(&heap->mutex);
+}
+
+void
+i965_gpe_state_heap_terminate(struct i965_gpe_state_heap *heap)
+{
+	struct i965_gpe_state_chunk *chunk;
+
+	assert(heap->stats.live_slices == 0);
+
+	if (heap->current)
+		i965_gpe_state_heap_destroy_chunk(heap, heap->current);
+
+	heap->current = NULL;
+
+	while ((chunk = heap->retired)) {
+		heap->retired = chunk->next;
+		i965_gpe_state_heap_destroy_chunk(heap, chunk);
+	}
+
+	_i965DestroyMutex(&heap->mutex);
+}
+
+int
+i965_gpe_state_heap_alloc(struct i965_gpe_state_heap *heap,
+						  unsigned int size,
+						  unsigned int alignment,
+						  struct i965_gpe_state_slice *slice)
+{
+	struct i965_gpe_state_chunk *chunk;
+	unsigned int offset = 0;
+
+	if (alignment < 64)
+		alignment = 64;
+
+	assert(!(alignment & (alignment - 1)));
+
+	_i965LockMutex(&heap->mutex);
+
+	chunk = heap->current;
+
+	if (chunk)
+		offset = STATE_ALIGN(chunk->used, alignment);
+
+	if (!chunk || offset > chunk->size || chunk->size - offset < size) {
+		chunk = i965_gpe_state_heap_next_chunk(heap, size);
+		offset = 0;
+	}
+
+	if (!chunk) {
+		heap->stats.failures++;
+		_i965UnlockMutex(&heap->mutex);
+		memset(slice, 0, sizeof(*slice));
+
+		return -1;
+	}
+
+	chunk->used = offset + size;
+	chunk->live++;
+
+	slice->chunk = chunk;
+	slice->bo = chunk->bo;
+	slice->map = (char *)chunk->bo->virtual + offset;
+	slice->offset = offset;
+	slice->size = size;
+
+	heap->stats.allocations++;
+	heap->stats.bytes_allocated += size;
+	heap->stats.live_slices++;
+
+	_i965UnlockMutex(&heap->mutex);
+
+	return 0;
+}
+
+void
+i965_gpe_state_heap_free(struct i965_gpe_state_heap *heap,
+						 struct i965_gpe_state_slice *slice)
+{
+	struct i965_gpe_state_chunk *chunk = slice->chunk;
+
+	if (!chunk)
+		return;
+
+	_i965LockMutex(&heap->mutex);
+
+	assert(chunk->live > 0);
+	chunk->live--;
+	heap->stats.live_slices--;
+
+	/* Nothing can refer to an empty idle chunk, start it over */
+	if (chunk == heap->current && !chunk->live && !heap->ops->busy(chunk->bo))
+		chunk->used = 0;
+
+	_i965UnlockMutex(&heap->mutex);
+
+	memset(slice, 0, sizeof(*slice));
+}
+
+void
+i965_gpe_state_heap_get_stats(struct i965_gpe_state_heap *heap,
+							  struct i965_gpe_state_heap_stats *stats)
+{
+	_i965LockMutex(&heap->mutex);
+	*stats = heap->stats;
+	_i965UnlockMutex(&heap->mutex);
+}
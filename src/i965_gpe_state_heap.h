@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _I965_GPE_STATE_HEAP_H_
+#define _I965_GPE_STATE_HEAP_H_
+
+#include <stdint.h>
+
+#include <intel_bufmgr.h>
+
+#include "i965_bufmgr_ops.h"
+#include "i965_mutext.h"
+
+#define I965_GPE_STATE_HEAP_CHUNK_SIZE  (1024 * 1024)
+#define I965_GPE_STATE_HEAP_MAX_IDLE    2
+
+struct i965_gpe_state_heap_stats {
+	uint64_t allocations;
+	uint64_t bytes_allocated;
+	uint64_t failures;
+	uint64_t chunk_allocations;
+	uint64_t chunk_reuses;
+	unsigned int num_chunks;
+	unsigned int max_chunks;
+	unsigned int live_slices;
+};
+
+struct i965_gpe_state_chunk;
+
+/*
+ * A range of a heap buffer object, map points at it. The buffer object
+ * stays mapped for as long as the heap holds it.
+ */
+struct i965_gpe_state_slice {
+	struct i965_gpe_state_chunk *chunk;
+	dri_bo *bo;
+	void *map;
+	unsigned int offset;
+	unsigned int size;
+};
+
+/*
+ * Surface and dynamic state of the GPE contexts suballocated from a few
+ * large buffer objects instead of a few small ones per context. Slices are
+ * bump allocated from the current chunk, a full chunk is retired and only
+ * reused once it holds no slice and the GPU is done with it, so a new slice
+ * is never read by a batch still in flight and can be written without
+ * waiting for the GPU.
+ *
+ * This relies on the CPU writes to a mapping staying coherent with the GPU
+ * without a domain change, which only holds on LLC platforms.
+ */
+struct i965_gpe_state_heap {
+	const struct i965_bufmgr_ops *ops;
+	dri_bufmgr *bufmgr;
+	_I965Mutex mutex;
+
+	struct i965_gpe_state_chunk *current;
+	struct i965_gpe_state_chunk *retired;
+
+	struct i965_gpe_state_heap_stats stats;
+};
+
+/*
+ * ops may be NULL to use libdrm
+ */
+void
+i965_gpe_state_heap_init(struct i965_gpe_state_heap *heap,
+						 dri_bufmgr *bufmgr,
+						 const struct i965_bufmgr_ops *ops);
+
+/*
+ * All the slices must have been freed
+ */
+void
+i965_gpe_state_heap_terminate(struct i965_gpe_state_heap *heap);
+
+/*
+ * Returns 0 and fills slice in on success. The slice must not be freed
+ * while a batch that isn't submitted yet refers to it.
+ */
+int
+i965_gpe_state_heap_alloc(struct i965_gpe_state_heap *heap,
+						  unsigned int size,
+						  unsigned int alignment,
+						  struct i965_gpe_state_slice *slice);
+
+/*
+ * Does nothing for a slice that was never allocated
+ */
+void
+i965_gpe_state_heap_free(struct i965_gpe_state_heap *heap,
+						 struct i965_gpe_state_slice *slice);
+
+void
+i965_gpe_state_heap_get_stats(struct i965_gpe_state_heap *heap,
+							  struct i965_gpe_state_heap_stats *stats);
+
+#endif /* _I965_GPE_STATE_HEAP_H_ */
@@ -133,7 +133,6 @@ i965_gpe_load_kernels(VADriverContextP ctx,
 					  struct i965_kernel *kernel_list,
 					  unsigned int num_kernels)
 {
-	struct i965_driver_data *i965 = i965_driver_data(ctx);
 	int i;
 
 	assert(num_kernels <= MAX_GPE_KERNELS);
@@ -143,15 +142,28 @@ i965_gpe_load_kernels(VADriverContextP ctx,
 	for (i = 0; i < num_kernels; i++) {
 		struct i965_kernel *kernel = &gpe_context->kernels[i];
 
-		kernel->bo = dri_bo_alloc(i965->intel.bufmgr,
-								  kernel->name,
-								  kernel->size,
-								  0x1000);
+		i965_gpe_load_kernel(ctx, kernel);
 		assert(kernel->bo);
-		dri_bo_subdata(kernel->bo, 0, kernel->size, kernel->bin);
 	}
 }
 
+void
+i965_gpe_load_kernel(VADriverContextP ctx,
+					 struct i965_kernel *kernel)
+{
+	struct i965_driver_data *i965 = i965_driver_data(ctx);
+	struct i965_kernel_cache_blob blob;
+
+	blob.bin = kernel->bin;
+	blob.size = kernel->size;
+	blob.offset = 0;
+
+	kernel->bo = i965_kernel_cache_get(&i965->kernel_cache,
+									   kernel->name,
+									   &blob, 1,
+									   kernel->size);
+}
+
 void
 i965_gpe_context_destroy(struct i965_gpe_context *gpe_context)
 {
@@ -172,6 +184,8 @@ i965_gpe_context_destroy(struct i965_gpe_context *gpe_context)
 		dri_bo_unreference(kernel->bo);
 		kernel->bo = NULL;
 	}
+
+	intel_batch_record_fini(&gpe_context->pipeline_setup_record);
 }
 
 void
@@ -992,7 +1006,7 @@ gen8_gpe_state_base_address(VADriverContextP ctx,
 	OUT_BATCH(batch, 0);
 
 	/*DW4 Surface state base address */
-	OUT_RELOC64(batch, gpe_context->surface_state_binding_table.bo, I915_GEM_DOMAIN_INSTRUCTION, 0, BASE_ADDRESS_MODIFY); /* Surface state base address */
+	OUT_RELOC64(batch, gpe_context->surface_state_binding_table.bo, I915_GEM_DOMAIN_INSTRUCTION, 0, gpe_context->surface_state_binding_table.base_offset | BASE_ADDRESS_MODIFY); /* Surface state base address */
 
 	/*DW6. Dynamic state base address */
 	if (gpe_context->dynamic_state.bo)
@@ -1106,34 +1120,152 @@ gen8_gpe_idrt(VADriverContextP ctx,
 }
 
 
+/*
+ * Everything the state emitted by gen8/gen9_gpe_pipeline_setup() depends
+ * on, the state is recorded once and replayed as long as it doesn't change.
+ */
+struct gpe_pipeline_setup_key {
+	dri_bo *surface_state_bo;
+	unsigned int surface_state_base;
+	dri_bo *dynamic_state_bo;
+	dri_bo *indirect_state_bo;
+	dri_bo *instruction_state_bo;
+	unsigned int gen;
+	unsigned int mocs_state;
+	unsigned int vfe_dw3;
+	unsigned int vfe_dw5;
+	unsigned int vfe_desc5;
+	unsigned int vfe_desc6;
+	unsigned int vfe_desc7;
+	unsigned int curbe_length;
+	unsigned int curbe_offset;
+	unsigned int idrt_size;
+	unsigned int idrt_offset;
+};
+
+/* 39 dwords on gen9 */
+#define GPE_PIPELINE_SETUP_MAX_SIZE     (64 * 4)
+
+static void
+gpe_pipeline_setup_key_init(VADriverContextP ctx,
+							struct i965_gpe_context *gpe_context,
+							unsigned int gen,
+							struct gpe_pipeline_setup_key *key)
+{
+	struct i965_driver_data *i965 = i965_driver_data(ctx);
+
+	memset(key, 0, sizeof(*key));
+	key->surface_state_bo = gpe_context->surface_state_binding_table.bo;
+	key->surface_state_base = gpe_context->surface_state_binding_table.base_offset;
+	key->dynamic_state_bo = gpe_context->dynamic_state.bo;
+	key->indirect_state_bo = gpe_context->indirect_state.bo;
+	key->instruction_state_bo = gpe_context->instruction_state.bo;
+	key->gen = gen;
+	key->mocs_state = i965->intel.mocs_state;
+	key->vfe_dw3 = (gpe_context->vfe_state.max_num_threads << 16 |
+					gpe_context->vfe_state.num_urb_entries << 8 |
+					gpe_context->vfe_state.gpgpu_mode << 2);
+	key->vfe_dw5 = (gpe_context->vfe_state.urb_entry_size << 16 |
+					gpe_context->vfe_state.curbe_allocation_size);
+	key->vfe_desc5 = gpe_context->vfe_desc5.dword;
+	key->vfe_desc6 = gpe_context->vfe_desc6.dword;
+	key->vfe_desc7 = gpe_context->vfe_desc7.dword;
+	key->curbe_length = gpe_context->curbe.length;
+	key->curbe_offset = gpe_context->curbe.offset;
+	key->idrt_size = gpe_context->idrt.max_entries * gpe_context->idrt.entry_size;
+	key->idrt_offset = gpe_context->idrt.offset;
+}
+
 void
 gen8_gpe_pipeline_setup(VADriverContextP ctx,
 						struct i965_gpe_context *gpe_context,
 						struct intel_batchbuffer *batch)
 {
+	struct gpe_pipeline_setup_key key;
+
 	intel_batchbuffer_emit_mi_flush(batch);
 
+	gpe_pipeline_setup_key_init(ctx, gpe_context, 8, &key);
+
+	if (intel_batchbuffer_replay_record(batch, &gpe_context->pipeline_setup_record,
+										&key, sizeof(key)))
+		return;
+
+	intel_batchbuffer_begin_record(batch, &gpe_context->pipeline_setup_record,
+								   &key, sizeof(key), GPE_PIPELINE_SETUP_MAX_SIZE);
 	i965_gpe_select(ctx, gpe_context, batch);
 	gen8_gpe_state_base_address(ctx, gpe_context, batch);
 	gen8_gpe_vfe_state(ctx, gpe_context, batch);
 	gen8_gpe_curbe_load(ctx, gpe_context, batch);
 	gen8_gpe_idrt(ctx, gpe_context, batch);
+	intel_batchbuffer_end_record(batch);
+}
+
+/*
+ * The state of a heap backed context stays mapped and is written without
+ * waiting for the GPU, see gen8_gpe_context_init().
+ */
+static void *
+gpe_context_map_state(struct i965_gpe_context *gpe_context, dri_bo *bo)
+{
+	if (bo != gpe_context->surface_state_binding_table.slice.bo &&
+		bo != gpe_context->dynamic_state.slice.bo)
+		dri_bo_map(bo, 1);
+
+	return bo->virtual;
+}
+
+static void
+gpe_context_unmap_state(struct i965_gpe_context *gpe_context, dri_bo *bo)
+{
+	if (bo != gpe_context->surface_state_binding_table.slice.bo &&
+		bo != gpe_context->dynamic_state.slice.bo)
+		dri_bo_unmap(bo);
 }
 
+/*
+ * A heap backed context gets new slices each time it is initialized. The
+ * previous ones went out with the batches of its previous use, the heap
+ * doesn't hand them out again before the GPU is done with them.
+ */
 void
 gen8_gpe_context_init(VADriverContextP ctx,
 					  struct i965_gpe_context *gpe_context)
 {
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
+	struct i965_gpe_state_heap *heap = gpe_context->state_heap;
 	dri_bo *bo;
 	int bo_size;
 	unsigned int start_offset, end_offset;
 
+	/* The offsets set by the caller are relative to the base address */
+	gpe_context->surface_state_binding_table.binding_table_offset -= gpe_context->surface_state_binding_table.base_offset;
+	gpe_context->surface_state_binding_table.surface_state_offset -= gpe_context->surface_state_binding_table.base_offset;
+	gpe_context->surface_state_binding_table.base_offset = 0;
+
+	if (heap) {
+		i965_gpe_state_heap_free(heap, &gpe_context->surface_state_binding_table.slice);
+		i965_gpe_state_heap_free(heap, &gpe_context->dynamic_state.slice);
+	}
+
 	dri_bo_unreference(gpe_context->surface_state_binding_table.bo);
-	bo = dri_bo_alloc(i965->intel.bufmgr,
-					  "surface state & binding table",
-					  gpe_context->surface_state_binding_table.length,
-					  4096);
+
+	if (heap &&
+		i965_gpe_state_heap_alloc(heap,
+								  gpe_context->surface_state_binding_table.length,
+								  4096,
+								  &gpe_context->surface_state_binding_table.slice) == 0) {
+		bo = gpe_context->surface_state_binding_table.slice.bo;
+		dri_bo_reference(bo);
+
+		gpe_context->surface_state_binding_table.base_offset = gpe_context->surface_state_binding_table.slice.offset;
+		gpe_context->surface_state_binding_table.binding_table_offset += gpe_context->surface_state_binding_table.base_offset;
+		gpe_context->surface_state_binding_table.surface_state_offset += gpe_context->surface_state_binding_table.base_offset;
+	} else
+		bo = dri_bo_alloc(i965->intel.bufmgr,
+						  "surface state & binding table",
+						  gpe_context->surface_state_binding_table.length,
+						  4096);
 	assert(bo);
 	gpe_context->surface_state_binding_table.bo = bo;
 
@@ -1141,15 +1273,25 @@ gen8_gpe_context_init(VADriverContextP ctx,
 			  ALIGN(gpe_context->curbe.length, 64) +
 			  gpe_context->sampler.max_entries * ALIGN(gpe_context->sampler.entry_size, 64);
 	dri_bo_unreference(gpe_context->dynamic_state.bo);
-	bo = dri_bo_alloc(i965->intel.bufmgr,
-					  "surface state & binding table",
-					  bo_size,
-					  4096);
+
+	/* The dynamic state base address is the one of the heap bo */
+	if (heap &&
+		i965_gpe_state_heap_alloc(heap, bo_size, 64,
+								  &gpe_context->dynamic_state.slice) == 0) {
+		bo = gpe_context->dynamic_state.slice.bo;
+		dri_bo_reference(bo);
+		end_offset = gpe_context->dynamic_state.slice.offset;
+	} else {
+		bo = dri_bo_alloc(i965->intel.bufmgr,
+						  "surface state & binding table",
+						  bo_size,
+						  4096);
+		end_offset = 0;
+	}
 	assert(bo);
 	gpe_context->dynamic_state.bo = bo;
 	gpe_context->dynamic_state.bo_size = bo_size;
 
-	end_offset = 0;
 	gpe_context->dynamic_state.end_offset = 0;
 
 	/* Constant buffer offset */
@@ -1184,6 +1326,11 @@ gen8_gpe_context_init(VADriverContextP ctx,
 void
 gen8_gpe_context_destroy(struct i965_gpe_context *gpe_context)
 {
+	if (gpe_context->state_heap) {
+		i965_gpe_state_heap_free(gpe_context->state_heap, &gpe_context->surface_state_binding_table.slice);
+		i965_gpe_state_heap_free(gpe_context->state_heap, &gpe_context->dynamic_state.slice);
+	}
+
 	dri_bo_unreference(gpe_context->surface_state_binding_table.bo);
 	gpe_context->surface_state_binding_table.bo = NULL;
 
@@ -1204,8 +1351,19 @@ gen8_gpe_context_destroy(struct i965_gpe_context *gpe_context)
 
 	dri_bo_unreference(gpe_context->sampler.bo);
 	gpe_context->sampler.bo = NULL;
+
+	intel_batch_record_fini(&gpe_context->pipeline_setup_record);
 }
 
+void
+i965_gpe_context_use_state_heap(VADriverContextP ctx,
+								struct i965_gpe_context *gpe_context)
+{
+	struct i965_driver_data *i965 = i965_driver_data(ctx);
+
+	if (i965->use_gpe_state_heap)
+		gpe_context->state_heap = &i965->gpe_state_heap;
+}
 
 void
 gen8_gpe_load_kernels(VADriverContextP ctx,
@@ -1214,9 +1372,9 @@ gen8_gpe_load_kernels(VADriverContextP ctx,
 					  unsigned int num_kernels)
 {
 	struct i965_driver_data *i965 = i965_driver_data(ctx);
+	struct i965_kernel_cache_blob blobs[MAX_GPE_KERNELS];
 	int i, kernel_size = 0;
 	unsigned int kernel_offset, end_offset;
-	unsigned char *kernel_ptr;
 	struct i965_kernel *kernel;
 
 	assert(num_kernels <= MAX_GPE_KERNELS);
@@ -1229,38 +1387,34 @@ gen8_gpe_load_kernels(VADriverContextP ctx,
 		kernel_size += ALIGN(kernel->size, 64);
 	}
 
-	gpe_context->instruction_state.bo = dri_bo_alloc(i965->intel.bufmgr,
-													 "kernel shader",
-													 kernel_size,
-													 0x1000);
-	if (gpe_context->instruction_state.bo == NULL) {
-		WARN_ONCE("failure to allocate the buffer space for kernel shader\n");
-		return;
-	}
-
-	assert(gpe_context->instruction_state.bo);
-
 	gpe_context->instruction_state.bo_size = kernel_size;
 	gpe_context->instruction_state.end_offset = 0;
 	end_offset = 0;
 
-	dri_bo_map(gpe_context->instruction_state.bo, 1);
-	kernel_ptr = (unsigned char *)(gpe_context->instruction_state.bo->virtual);
 	for (i = 0; i < num_kernels; i++) {
 		kernel_offset = ALIGN(end_offset, 64);
 		kernel = &gpe_context->kernels[i];
 		kernel->kernel_offset = kernel_offset;
 
-		if (kernel->size) {
-			memcpy(kernel_ptr + kernel_offset, kernel->bin, kernel->size);
+		blobs[i].bin = kernel->bin;
+		blobs[i].size = kernel->size;
+		blobs[i].offset = kernel_offset;
 
+		if (kernel->size)
 			end_offset = kernel_offset + kernel->size;
-		}
 	}
 
-	gpe_context->instruction_state.end_offset = end_offset;
+	/* Contexts loading the same kernels share one read-only copy */
+	gpe_context->instruction_state.bo = i965_kernel_cache_get(&i965->kernel_cache,
+															  "kernel shader",
+															  blobs, num_kernels,
+															  kernel_size);
+	if (gpe_context->instruction_state.bo == NULL) {
+		WARN_ONCE("failure to allocate the buffer space for kernel shader\n");
+		return;
+	}
 
-	dri_bo_unmap(gpe_context->instruction_state.bo);
+	gpe_context->instruction_state.end_offset = end_offset;
 
 	return;
 }
@@ -1280,7 +1434,7 @@ gen9_gpe_state_base_address(VADriverContextP ctx,
 	OUT_BATCH(batch, 0);
 
 	/*DW4 Surface state base address */
-	OUT_RELOC64(batch, gpe_context->surface_state_binding_table.bo, I915_GEM_DOMAIN_INSTRUCTION, 0, BASE_ADDRESS_MODIFY | (i965->intel.mocs_state << 4)); /* Surface state base address */
+	OUT_RELOC64(batch, gpe_context->surface_state_binding_table.bo, I915_GEM_DOMAIN_INSTRUCTION, 0, gpe_context->surface_state_binding_table.base_offset | BASE_ADDRESS_MODIFY | (i965->intel.mocs_state << 4)); /* Surface state base address */
 
 	/*DW6. Dynamic state base address */
 	if (gpe_context->dynamic_state.bo)
@@ -1350,13 +1504,24 @@ gen9_gpe_pipeline_setup(VADriverContextP ctx,
 						struct i965_gpe_context *gpe_context,
 						struct intel_batchbuffer *batch)
 {
+	struct gpe_pipeline_setup_key key;
+
 	intel_batchbuffer_emit_mi_flush(batch);
 
+	gpe_pipeline_setup_key_init(ctx, gpe_context, 9, &key);
+
+	if (intel_batchbuffer_replay_record(batch, &gpe_context->pipeline_setup_record,
+										&key, sizeof(key)))
+		return;
+
+	intel_batchbuffer_begin_record(batch, &gpe_context->pipeline_setup_record,
+								   &key, sizeof(key), GPE_PIPELINE_SETUP_MAX_SIZE);
 	gen9_gpe_select(ctx, gpe_context, batch);
 	gen9_gpe_state_base_address(ctx, gpe_context, batch);
 	gen8_gpe_vfe_state(ctx, gpe_context, batch);
 	gen8_gpe_curbe_load(ctx, gpe_context, batch);
 	gen8_gpe_idrt(ctx, gpe_context, batch);
+	intel_batchbuffer_end_record(batch);
 }
 
 void
@@ -1658,6 +1823,9 @@ gen8_gpe_context_set_dynamic_buffer(VADriverContextP ctx,
 	if (!ds->bo || !gpe_context)
 		return;
 
+	if (gpe_context->state_heap)
+		i965_gpe_state_heap_free(gpe_context->state_heap, &gpe_context->dynamic_state.slice);
+
 	dri_bo_unreference(gpe_context->dynamic_state.bo);
 	gpe_context->dynamic_state.bo = ds->bo;
 	dri_bo_reference(gpe_context->dynamic_state.bo);
@@ -1687,15 +1855,13 @@ gen8_gpe_context_set_dynamic_buffer(VADriverContextP ctx,
 void *
 i965_gpe_context_map_curbe(struct i965_gpe_context *gpe_context)
 {
-	dri_bo_map(gpe_context->curbe.bo, 1);
-
-	return (char *)gpe_context->curbe.bo->virtual + gpe_context->curbe.offset;
+	return (char *)gpe_context_map_state(gpe_context, gpe_context->curbe.bo) + gpe_context->curbe.offset;
 }
 
 void
 i965_gpe_context_unmap_curbe(struct i965_gpe_context *gpe_context)
 {
-	dri_bo_unmap(gpe_context->curbe.bo);
+	gpe_context_unmap_state(gpe_context, gpe_context->curbe.bo);
 }
 
 void
@@ -1706,14 +1872,15 @@ gen9_gpe_reset_binding_table(VADriverContextP ctx,
 	unsigned int binding_table_offset = gpe_context->surface_state_binding_table.binding_table_offset;
 	int i;
 
-	dri_bo_map(gpe_context->surface_state_binding_table.bo, 1);
-	binding_table = (unsigned int*)((char *)gpe_context->surface_state_binding_table.bo->virtual + binding_table_offset);
+	binding_table = (unsigned int*)((char *)gpe_context_map_state(gpe_context, gpe_context->surface_state_binding_table.bo) + binding_table_offset);
 
 	for (i = 0; i < gpe_context->surface_state_binding_table.max_entries; i++) {
-		*(binding_table + i) = gpe_context->surface_state_binding_table.surface_state_offset + i * SURFACE_STATE_PADDED_SIZE_GEN9;
+		*(binding_table + i) = gpe_context->surface_state_binding_table.surface_state_offset -
+							   gpe_context->surface_state_binding_table.base_offset +
+							   i * SURFACE_STATE_PADDED_SIZE_GEN9;
 	}
 
-	dri_bo_unmap(gpe_context->surface_state_binding_table.bo);
+	gpe_context_unmap_state(gpe_context, gpe_context->surface_state_binding_table.bo);
 }
 
 void
@@ -1726,9 +1893,9 @@ gen8_gpe_setup_interface_data(VADriverContextP ctx,
 	unsigned char *desc_ptr;
 
 	bo = gpe_context->idrt.bo;
-	dri_bo_map(bo, 1);
-	assert(bo->virtual);
-	desc_ptr = (unsigned char *)bo->virtual + gpe_context->idrt.offset;
+	desc_ptr = (unsigned char *)gpe_context_map_state(gpe_context, bo);
+	assert(desc_ptr);
+	desc_ptr += gpe_context->idrt.offset;
 	desc = (struct gen8_interface_descriptor_data *)desc_ptr;
 
 	for (i = 0; i < gpe_context->num_kernels; i++) {
@@ -1743,14 +1910,15 @@ gen8_gpe_setup_interface_data(VADriverContextP ctx,
 		desc->desc3.sampler_count = 0;
 		desc->desc3.sampler_state_pointer = (gpe_context->sampler.offset >> 5);
 		desc->desc4.binding_table_entry_count = 0;
-		desc->desc4.binding_table_pointer = (gpe_context->surface_state_binding_table.binding_table_offset >> 5);
+		desc->desc4.binding_table_pointer = ((gpe_context->surface_state_binding_table.binding_table_offset -
+											  gpe_context->surface_state_binding_table.base_offset) >> 5);
 		desc->desc5.constant_urb_entry_read_offset = 0;
 		desc->desc5.constant_urb_entry_read_length = ALIGN(gpe_context->curbe.length, 32) >> 5; // in registers
 
 		desc++;
 	}
 
-	dri_bo_unmap(bo);
+	gpe_context_unmap_state(gpe_context, bo);
 }
 
 static void
@@ -1909,9 +2077,8 @@ gen9_gpe_context_add_surface(struct i965_gpe_context *gpe_context,
 
 	dri_bo_get_tiling(gpe_resource->bo, &tiling, &swizzle);
 
-	dri_bo_map(gpe_context->surface_state_binding_table.bo, 1);
-	buf = (char *)gpe_context->surface_state_binding_table.bo->virtual;
-	*((unsigned int *)(buf + binding_table_offset)) = surface_state_offset;
+	buf = (char *)gpe_context_map_state(gpe_context, gpe_context->surface_state_binding_table.bo);
+	*((unsigned int *)(buf + binding_table_offset)) = surface_state_offset - gpe_context->surface_state_binding_table.base_offset;
 
 	if (gpe_surface->is_2d_surface && gpe_surface->is_override_offset) {
 		struct gen9_surface_state *ss = (struct gen9_surface_state *)(buf + surface_state_offset);
@@ -2055,7 +2222,7 @@ gen9_gpe_context_add_surface(struct i965_gpe_context *gpe_context,
 						  gpe_resource->bo);
 	}
 
-	dri_bo_unmap(gpe_context->surface_state_binding_table.bo);
+	gpe_context_unmap_state(gpe_context, gpe_context->surface_state_binding_table.bo);
 }
 
 bool
@@ -2223,14 +2390,15 @@ gen8_gpe_reset_binding_table(VADriverContextP ctx, struct i965_gpe_context *gpe_
 	unsigned int binding_table_offset = gpe_context->surface_state_binding_table.binding_table_offset;
 	int i;
 
-	dri_bo_map(gpe_context->surface_state_binding_table.bo, 1);
-	binding_table = (unsigned int*)((char *)gpe_context->surface_state_binding_table.bo->virtual + binding_table_offset);
+	binding_table = (unsigned int*)((char *)gpe_context_map_state(gpe_context, gpe_context->surface_state_binding_table.bo) + binding_table_offset);
 
 	for (i = 0; i < gpe_context->surface_state_binding_table.max_entries; i++) {
-		*(binding_table + i) = gpe_context->surface_state_binding_table.surface_state_offset + i * SURFACE_STATE_PADDED_SIZE_GEN8;
+		*(binding_table + i) = gpe_context->surface_state_binding_table.surface_state_offset -
+							   gpe_context->surface_state_binding_table.base_offset +
+							   i * SURFACE_STATE_PADDED_SIZE_GEN8;
 	}
 
-	dri_bo_unmap(gpe_context->surface_state_binding_table.bo);
+	gpe_context_unmap_state(gpe_context, gpe_context->surface_state_binding_table.bo);
 }
 
 static void
@@ -2347,9 +2515,8 @@ gen8_gpe_context_add_surface(struct i965_gpe_context *gpe_context,
 
 	dri_bo_get_tiling(gpe_resource->bo, &tiling, &swizzle);
 
-	dri_bo_map(gpe_context->surface_state_binding_table.bo, 1);
-	buf = (char *)gpe_context->surface_state_binding_table.bo->virtual;
-	*((unsigned int *)(buf + binding_table_offset)) = surface_state_offset;
+	buf = (char *)gpe_context_map_state(gpe_context, gpe_context->surface_state_binding_table.bo);
+	*((unsigned int *)(buf + binding_table_offset)) = surface_state_offset - gpe_context->surface_state_binding_table.base_offset;
 
 	if (gpe_surface->is_2d_surface) {
 		struct gen8_surface_state *ss = (struct gen8_surface_state *)(buf + surface_state_offset);
@@ -2447,7 +2614,7 @@ gen8_gpe_context_add_surface(struct i965_gpe_context *gpe_context,
 						  gpe_resource->bo);
 	}
 
-	dri_bo_unmap(gpe_context->surface_state_binding_table.bo);
+	gpe_context_unmap_state(gpe_context, gpe_context->surface_state_binding_table.bo);
 }
 
 void
@@ -32,6 +32,8 @@
 
 #include "i965_defines.h"
 #include "i965_structs.h"
+#include "intel_batch_record.h"
+#include "i965_gpe_state_heap.h"
 
 #define MAX_GPE_KERNELS    32
 
@@ -83,12 +85,21 @@ struct gpe_pipe_control_parameter {
 };
 
 struct i965_gpe_context {
+	/*
+	 * Set before gen8_gpe_context_init() for the surface and dynamic state
+	 * to come from the heap, only for a context initialized again before
+	 * each use as they are written without waiting for the GPU.
+	 */
+	struct i965_gpe_state_heap *state_heap;
+
 	struct {
 		dri_bo *bo;
 		unsigned int length;            /* in bytes */
 		unsigned int max_entries;
 		unsigned int binding_table_offset;
 		unsigned int surface_state_offset;
+		unsigned int base_offset;       /* of the surface state base address in bo */
+		struct i965_gpe_state_slice slice;
 	} surface_state_binding_table;
 
 	struct {
@@ -178,7 +189,11 @@ struct i965_gpe_context {
 		dri_bo *bo;
 		int bo_size;
 		unsigned int end_offset;
+		struct i965_gpe_state_slice slice;
 	} dynamic_state;
+
+	/* The state emitted by gen8/gen9_gpe_pipeline_setup() after the flush */
+	struct intel_batch_record pipeline_setup_record;
 };
 
 struct gpe_mi_flush_dw_parameter {
@@ -252,6 +267,8 @@ void i965_gpe_load_kernels(VADriverContextP ctx,
 						   struct i965_gpe_context *gpe_context,
 						   struct i965_kernel *kernel_list,
 						   unsigned int num_kernels);
+void i965_gpe_load_kernel(VADriverContextP ctx,
+						  struct i965_kernel *kernel);
 void gen6_gpe_pipeline_setup(VADriverContextP ctx,
 							 struct i965_gpe_context *gpe_context,
 							 struct intel_batchbuffer *batch);
@@ -329,6 +346,8 @@ gen8_gpe_context_set_dynamic_buffer(VADriverContextP ctx,
 void gen8_gpe_context_destroy(struct i965_gpe_context *gpe_context);
 void gen8_gpe_context_init(VADriverContextP ctx,
 						   struct i965_gpe_context *gpe_context);
+void i965_gpe_context_use_state_heap(VADriverContextP ctx,
+									 struct i965_gpe_context *gpe_context);
 
 void gen8_gpe_load_kernels(VADriverContextP ctx,
 						   struct i965_gpe_context *gpe_context,
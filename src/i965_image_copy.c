@@ -0,0 +1,510 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "sysdeps.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#define I965_IMAGE_COPY_X86     1
+#endif
+
+#include <i915_drm.h>
+
+#include "i965_image_copy.h"
+
+/*
+ * A Y tile is 128 bytes x 32 rows, stored as 8 columns of 16 bytes x 32
+ * rows, an X tile is 512 bytes x 8 rows stored row by row.
+ */
+#define TILE_SIZE               4096
+#define TILE_Y_WIDTH            128
+#define TILE_Y_HEIGHT           32
+#define TILE_Y_COLUMN_WIDTH     16
+#define TILE_X_WIDTH            512
+#define TILE_X_HEIGHT           8
+
+#define COPY_MIN(a, b)          ((a) < (b) ? (a) : (b))
+
+struct i965_image_copy_funcs {
+	/* Copies len bytes, src is a surface mapping which may be write-combined */
+	void (*read_row)(uint8_t *dst, const uint8_t *src, unsigned int len);
+	/* Copies a 16 bytes wide Y tile column, src rows are contiguous */
+	void (*read_column)(uint8_t *dst, unsigned int dst_stride,
+						const uint8_t *src, unsigned int rows);
+};
+
+struct i965_image_copy_job {
+	const struct i965_image_copy_funcs *funcs;
+	uint8_t *linear;
+	unsigned int linear_stride;
+	uint8_t *surface;
+	unsigned int surface_pitch;
+	unsigned int tiling;
+	unsigned int x;
+	unsigned int y;
+	unsigned int len;
+	unsigned int height;
+	bool to_surface;
+};
+
+static pthread_once_t i965_image_copy_once = PTHREAD_ONCE_INIT;
+static int i965_image_copy_best_path;
+static int i965_image_copy_path;
+static int i965_image_copy_threads;
+
+static void
+i965_read_row_c(uint8_t *dst, const uint8_t *src, unsigned int len)
+{
+	memcpy(dst, src, len);
+}
+
+static void
+i965_read_column_c(uint8_t *dst, unsigned int dst_stride,
+				   const uint8_t *src, unsigned int rows)
+{
+	unsigned int i;
+
+	for (i = 0; i < rows; i++) {
+		memcpy(dst, src, TILE_Y_COLUMN_WIDTH);
+		dst += dst_stride;
+		src += TILE_Y_COLUMN_WIDTH;
+	}
+}
+
+#ifdef I965_IMAGE_COPY_X86
+/*
+ * MOVNTDQA only pays off on write-combined (GTT) mappings, where it fetches
+ * whole lines instead of uncached dwords, and behaves as a normal load on
+ * cacheable memory. It needs aligned addresses, the unaligned head goes
+ * through memcpy.
+ */
+__attribute__((target("sse4.1"))) static void
+i965_read_row_sse41(uint8_t *dst, const uint8_t *src, unsigned int len)
+{
+	unsigned int head = (16 - ((uintptr_t)src & 15)) & 15;
+
+	head = COPY_MIN(head, len);
+	memcpy(dst, src, head);
+	dst += head;
+	src += head;
+	len -= head;
+
+	while (len >= 64) {
+		__m128i a = _mm_stream_load_si128((__m128i *)src);
+		__m128i b = _mm_stream_load_si128((__m128i *)(src + 16));
+		__m128i c = _mm_stream_load_si128((__m128i *)(src + 32));
+		__m128i d = _mm_stream_load_si128((__m128i *)(src + 48));
+
+		_mm_storeu_si128((__m128i *)dst, a);
+		_mm_storeu_si128((__m128i *)(dst + 16), b);
+		_mm_storeu_si128((__m128i *)(dst + 32), c);
+		_mm_storeu_si128((__m128i *)(dst + 48), d);
+		dst += 64;
+		src += 64;
+		len -= 64;
+	}
+
+	while (len >= 16) {
+		_mm_storeu_si128((__m128i *)dst, _mm_stream_load_si128((__m128i *)src));
+		dst += 16;
+		src += 16;
+		len -= 16;
+	}
+
+	memcpy(dst, src, len);
+}
+
+__attribute__((target("sse4.1"))) static void
+i965_read_column_sse41(uint8_t *dst, unsigned int dst_stride,
+					   const uint8_t *src, unsigned int rows)
+{
+	unsigned int i;
+
+	if ((uintptr_t)src & 15) {
+		i965_read_column_c(dst, dst_stride, src, rows);
+		return;
+	}
+
+	for (i = 0; i < rows; i++) {
+		_mm_storeu_si128((__m128i *)dst, _mm_stream_load_si128((__m128i *)src));
+		dst += dst_stride;
+		src += TILE_Y_COLUMN_WIDTH;
+	}
+}
+
+__attribute__((target("avx2"))) static void
+i965_read_row_avx2(uint8_t *dst, const uint8_t *src, unsigned int len)
+{
+	unsigned int head = (32 - ((uintptr_t)src & 31)) & 31;
+
+	head = COPY_MIN(head, len);
+	memcpy(dst, src, head);
+	dst += head;
+	src += head;
+	len -= head;
+
+	while (len >= 128) {
+		__m256i a = _mm256_stream_load_si256((__m256i *)src);
+		__m256i b = _mm256_stream_load_si256((__m256i *)(src + 32));
+		__m256i c = _mm256_stream_load_si256((__m256i *)(src + 64));
+		__m256i d = _mm256_stream_load_si256((__m256i *)(src + 96));
+
+		_mm256_storeu_si256((__m256i *)dst, a);
+		_mm256_storeu_si256((__m256i *)(dst + 32), b);
+		_mm256_storeu_si256((__m256i *)(dst + 64), c);
+		_mm256_storeu_si256((__m256i *)(dst + 96), d);
+		dst += 128;
+		src += 128;
+		len -= 128;
+	}
+
+	while (len >= 32) {
+		_mm256_storeu_si256((__m256i *)dst, _mm256_stream_load_si256((__m256i *)src));
+		dst += 32;
+		src += 32;
+		len -= 32;
+	}
+
+	memcpy(dst, src, len);
+}
+
+/* Two consecutive rows of a column are one 32 bytes load */
+__attribute__((target("avx2"))) static void
+i965_read_column_avx2(uint8_t *dst, unsigned int dst_stride,
+					  const uint8_t *src, unsigned int rows)
+{
+	if ((uintptr_t)src & 15) {
+		i965_read_column_c(dst, dst_stride, src, rows);
+		return;
+	}
+
+	if (((uintptr_t)src & 31) && rows) {
+		_mm_storeu_si128((__m128i *)dst, _mm_stream_load_si128((__m128i *)src));
+		dst += dst_stride;
+		src += TILE_Y_COLUMN_WIDTH;
+		rows--;
+	}
+
+	while (rows >= 2) {
+		__m256i v = _mm256_stream_load_si256((__m256i *)src);
+
+		_mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(v));
+		_mm_storeu_si128((__m128i *)(dst + dst_stride), _mm256_extracti128_si256(v, 1));
+		dst += 2 * dst_stride;
+		src += 2 * TILE_Y_COLUMN_WIDTH;
+		rows -= 2;
+	}
+
+	if (rows)
+		_mm_storeu_si128((__m128i *)dst, _mm_stream_load_si128((__m128i *)src));
+}
+#endif
+
+static const struct i965_image_copy_funcs i965_image_copy_funcs[] = {
+	[I965_IMAGE_COPY_PATH_C] = {
+		i965_read_row_c,
+		i965_read_column_c,
+	},
+#ifdef I965_IMAGE_COPY_X86
+	[I965_IMAGE_COPY_PATH_SSE41] = {
+		i965_read_row_sse41,
+		i965_read_column_sse41,
+	},
+	[I965_IMAGE_COPY_PATH_AVX2] = {
+		i965_read_row_avx2,
+		i965_read_column_avx2,
+	},
+#endif
+};
+
+static void
+i965_image_copy_init(void)
+{
+	long num_cpus;
+
+	i965_image_copy_best_path = I965_IMAGE_COPY_PATH_C;
+
+#ifdef I965_IMAGE_COPY_X86
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2"))
+		i965_image_copy_best_path = I965_IMAGE_COPY_PATH_AVX2;
+	else if (__builtin_cpu_supports("sse4.1"))
+		i965_image_copy_best_path = I965_IMAGE_COPY_PATH_SSE41;
+#endif
+
+	i965_image_copy_path = i965_image_copy_best_path;
+
+	num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	i965_image_copy_threads = num_cpus < 1 ? 1 : COPY_MIN(num_cpus, I965_IMAGE_COPY_MAX_THREADS);
+}
+
+int
+i965_image_copy_set_path(int path)
+{
+	pthread_once(&i965_image_copy_once, i965_image_copy_init);
+
+	if (path < I965_IMAGE_COPY_PATH_C)
+		path = I965_IMAGE_COPY_PATH_C;
+
+	i965_image_copy_path = COPY_MIN(path, i965_image_copy_best_path);
+
+	return i965_image_copy_path;
+}
+
+int
+i965_image_copy_get_path(void)
+{
+	pthread_once(&i965_image_copy_once, i965_image_copy_init);
+
+	return i965_image_copy_path;
+}
+
+int
+i965_image_copy_set_threads(int num_threads)
+{
+	pthread_once(&i965_image_copy_once, i965_image_copy_init);
+
+	if (num_threads < 1)
+		num_threads = 1;
+
+	i965_image_copy_threads = COPY_MIN(num_threads, I965_IMAGE_COPY_MAX_THREADS);
+
+	return i965_image_copy_threads;
+}
+
+static void
+i965_image_copy_linear(const struct i965_image_copy_job *job)
+{
+	uint8_t *linear = job->linear;
+	uint8_t *surface = job->surface + job->y * job->surface_pitch + job->x;
+	unsigned int i;
+
+	for (i = 0; i < job->height; i++) {
+		if (job->to_surface)
+			memcpy(surface, linear, job->len);
+		else
+			job->funcs->read_row(linear, surface, job->len);
+
+		linear += job->linear_stride;
+		surface += job->surface_pitch;
+	}
+}
+
+static void
+i965_image_copy_tiled_x(const struct i965_image_copy_job *job)
+{
+	unsigned int i, col, n;
+
+	for (i = 0; i < job->height; i++) {
+		unsigned int y = job->y + i;
+		uint8_t *tile_row = job->surface +
+							(y / TILE_X_HEIGHT) * job->surface_pitch * TILE_X_HEIGHT +
+							(y % TILE_X_HEIGHT) * TILE_X_WIDTH;
+		uint8_t *linear = job->linear + i * job->linear_stride;
+
+		for (col = job->x; col < job->x + job->len; col += n) {
+			uint8_t *surface = tile_row + (col / TILE_X_WIDTH) * TILE_SIZE + col % TILE_X_WIDTH;
+
+			n = COPY_MIN(job->x + job->len - col, TILE_X_WIDTH - col % TILE_X_WIDTH);
+
+			if (job->to_surface)
+				memcpy(surface, linear + col - job->x, n);
+			else
+				job->funcs->read_row(linear + col - job->x, surface, n);
+		}
+	}
+}
+
+static void
+i965_image_copy_tiled_y(const struct i965_image_copy_job *job)
+{
+	unsigned int i, r, rows, col, n;
+
+	/* Walk one band of tile rows at a time, column by column */
+	for (i = 0; i < job->height; i += rows) {
+		unsigned int y = job->y + i;
+		uint8_t *tile_row = job->surface +
+							(y / TILE_Y_HEIGHT) * job->surface_pitch * TILE_Y_HEIGHT +
+							(y % TILE_Y_HEIGHT) * TILE_Y_COLUMN_WIDTH;
+		uint8_t *linear = job->linear + i * job->linear_stride;
+
+		rows = COPY_MIN(job->height - i, TILE_Y_HEIGHT - y % TILE_Y_HEIGHT);
+
+		for (col = job->x; col < job->x + job->len; col += n) {
+			unsigned int cx = col % TILE_Y_COLUMN_WIDTH;
+			uint8_t *surface = tile_row +
+							   (col / TILE_Y_WIDTH) * TILE_SIZE +
+							   ((col % TILE_Y_WIDTH) / TILE_Y_COLUMN_WIDTH) * TILE_Y_COLUMN_WIDTH * TILE_Y_HEIGHT +
+							   cx;
+			uint8_t *l = linear + col - job->x;
+
+			n = COPY_MIN(job->x + job->len - col, TILE_Y_COLUMN_WIDTH - cx);
+
+			if (n == TILE_Y_COLUMN_WIDTH && !job->to_surface) {
+				job->funcs->read_column(l, job->linear_stride, surface, rows);
+				continue;
+			}
+
+			for (r = 0; r < rows; r++) {
+				if (job->to_surface)
+					memcpy(surface, l, n);
+				else
+					memcpy(l, surface, n);
+
+				l += job->linear_stride;
+				surface += TILE_Y_COLUMN_WIDTH;
+			}
+		}
+	}
+}
+
+static void *
+i965_image_copy_job_run(void *arg)
+{
+	const struct i965_image_copy_job *job = arg;
+
+	switch (job->tiling) {
+	case I915_TILING_X:
+		i965_image_copy_tiled_x(job);
+		break;
+
+	case I915_TILING_Y:
+		i965_image_copy_tiled_y(job);
+		break;
+
+	default:
+		i965_image_copy_linear(job);
+		break;
+	}
+
+	return NULL;
+}
+
+/*
+ * Large copies are split in horizontal stripes, aligned on tile rows so
+ * that no tile is shared between two threads.
+ */
+static void
+i965_image_copy_run(struct i965_image_copy_job *job)
+{
+	struct i965_image_copy_job stripes[I965_IMAGE_COPY_MAX_THREADS];
+	pthread_t threads[I965_IMAGE_COPY_MAX_THREADS];
+	bool started[I965_IMAGE_COPY_MAX_THREADS];
+	unsigned int num_stripes, start, i;
+
+	pthread_once(&i965_image_copy_once, i965_image_copy_init);
+	job->funcs = &i965_image_copy_funcs[i965_image_copy_path];
+
+	num_stripes = i965_image_copy_threads;
+
+	if (num_stripes <= 1 ||
+		job->height < TILE_Y_HEIGHT * 2 ||
+		(uint64_t)job->len * job->height < I965_IMAGE_COPY_MT_THRESHOLD) {
+		i965_image_copy_job_run(job);
+		return;
+	}
+
+	for (i = 0, start = job->y; i < num_stripes; i++) {
+		unsigned int end = job->y + job->height;
+
+		if (i + 1 < num_stripes) {
+			end = job->y + (uint64_t)job->height * (i + 1) / num_stripes;
+			end &= ~(TILE_Y_HEIGHT - 1);
+			end = end < start ? start : end;
+		}
+
+		stripes[i] = *job;
+		stripes[i].y = start;
+		stripes[i].height = end - start;
+		stripes[i].linear = job->linear + (start - job->y) * job->linear_stride;
+		start = end;
+	}
+
+	for (i = 1; i < num_stripes; i++) {
+		started[i] = false;
+
+		if (stripes[i].height)
+			started[i] = !pthread_create(&threads[i], NULL, i965_image_copy_job_run, &stripes[i]);
+
+		if (!started[i] && stripes[i].height)
+			i965_image_copy_job_run(&stripes[i]);
+	}
+
+	i965_image_copy_job_run(&stripes[0]);
+
+	for (i = 1; i < num_stripes; i++) {
+		if (started[i])
+			pthread_join(threads[i], NULL);
+	}
+}
+
+void
+i965_image_copy_from_surface(uint8_t *dst, unsigned int dst_stride,
+							 const uint8_t *surface, unsigned int surface_pitch,
+							 unsigned int tiling,
+							 unsigned int x, unsigned int y,
+							 unsigned int len, unsigned int height)
+{
+	struct i965_image_copy_job job;
+
+	job.linear = dst;
+	job.linear_stride = dst_stride;
+	job.surface = (uint8_t *)surface;
+	job.surface_pitch = surface_pitch;
+	job.tiling = tiling;
+	job.x = x;
+	job.y = y;
+	job.len = len;
+	job.height = height;
+	job.to_surface = false;
+
+	i965_image_copy_run(&job);
+}
+
+void
+i965_image_copy_to_surface(uint8_t *surface, unsigned int surface_pitch,
+						   unsigned int tiling,
+						   unsigned int x, unsigned int y,
+						   const uint8_t *src, unsigned int src_stride,
+						   unsigned int len, unsigned int height)
+{
+	struct i965_image_copy_job job;
+
+	job.linear = (uint8_t *)src;
+	job.linear_stride = src_stride;
+	job.surface = surface;
+	job.surface_pitch = surface_pitch;
+	job.tiling = tiling;
+	job.x = x;
+	job.y = y;
+	job.len = len;
+	job.height = height;
+	job.to_surface = true;
+
+	i965_image_copy_run(&job);
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _I965_IMAGE_COPY_H_
+#define _I965_IMAGE_COPY_H_
+
+#include <stdint.h>
+
+/*
+ * CPU copies between a surface mapping and a linear image, used by the
+ * software vaGetImage()/vaPutImage() paths.
+ *
+ * The surface side is addressed through its raw layout: for X and Y tiled
+ * surfaces the mapping must be a CPU mapping of the tiled storage without
+ * bit-6 swizzling, the detiling is done here rather than by a GTT fence.
+ * Positions and widths are in bytes, the pitch of a tiled surface must be a
+ * whole number of tiles.
+ */
+
+enum i965_image_copy_path {
+	I965_IMAGE_COPY_PATH_C = 0,
+	I965_IMAGE_COPY_PATH_SSE41,
+	I965_IMAGE_COPY_PATH_AVX2,
+};
+
+/* Copies larger than this are split in stripes over several threads */
+#define I965_IMAGE_COPY_MT_THRESHOLD    (2 * 1024 * 1024)
+#define I965_IMAGE_COPY_MAX_THREADS     4
+
+/*
+ * The copies run on the widest of the paths the CPU has, looked up once.
+ * set_path() lets a test force a narrower one, it is capped at what the
+ * CPU supports, and set_threads() overrides the stripe count; both return
+ * the setting the copies will use.
+ */
+int i965_image_copy_set_path(int path);
+int i965_image_copy_get_path(void);
+int i965_image_copy_set_threads(int num_threads);
+
+void
+i965_image_copy_from_surface(uint8_t *dst, unsigned int dst_stride,
+							 const uint8_t *surface, unsigned int surface_pitch,
+							 unsigned int tiling,
+							 unsigned int x, unsigned int y,
+							 unsigned int len, unsigned int height);
+
+void
+i965_image_copy_to_surface(uint8_t *surface, unsigned int surface_pitch,
+						   unsigned int tiling,
+						   unsigned int x, unsigned int y,
+						   const uint8_t *src, unsigned int src_stride,
+						   unsigned int len, unsigned int height);
+
+#endif /* _I965_IMAGE_COPY_H_ */
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "sysdeps.h"
+
+#include "i965_kernel_cache.h"
+
+struct i965_kernel_cache_entry {
+	struct i965_kernel_cache_entry *next;
+	unsigned int hash;
+	dri_bo *bo;
+	unsigned long bo_size;
+	unsigned int num_blobs;
+	struct i965_kernel_cache_blob blobs[];
+};
+
+static unsigned int
+i965_kernel_cache_hash(const struct i965_kernel_cache_blob *blobs,
+					   unsigned int num_blobs,
+					   unsigned long bo_size)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	unsigned int i;
+
+#define HASH(v) hash = (hash ^ (uint64_t)(v)) * 1099511628211ULL
+	HASH(bo_size);
+	HASH(num_blobs);
+
+	for (i = 0; i < num_blobs; i++) {
+		HASH((uintptr_t)blobs[i].bin);
+		HASH(blobs[i].size);
+		HASH(blobs[i].offset);
+	}
+#undef HASH
+
+	return (unsigned int)(hash ^ (hash >> 32));
+}
+
+static bool
+i965_kernel_cache_entry_match(const struct i965_kernel_cache_entry *entry,
+							  unsigned int hash,
+							  const struct i965_kernel_cache_blob *blobs,
+							  unsigned int num_blobs,
+							  unsigned long bo_size)
+{
+	return (entry->hash == hash &&
+			entry->bo_size == bo_size &&
+			entry->num_blobs == num_blobs &&
+			memcmp(entry->blobs, blobs, sizeof(*blobs) * num_blobs) == 0);
+}
+
+void
+i965_kernel_cache_init(struct i965_kernel_cache *cache,
+					   dri_bufmgr *bufmgr,
+					   const struct i965_bufmgr_ops *ops)
+{
+	memset(cache, 0, sizeof(*cache));
+	cache->ops = ops ? ops : &i965_bufmgr_drm_ops;
+	cache->bufmgr = bufmgr;
+	_i965InitMutex(&cache->mutex);
+}
+
+void
+i965_kernel_cache_terminate(struct i965_kernel_cache *cache)
+{
+	struct i965_kernel_cache_entry *entry;
+	int i;
+
+	/* Contexts still using a kernel keep their own reference */
+	for (i = 0; i < I965_KERNEL_CACHE_NUM_BUCKETS; i++) {
+		while ((entry = cache->buckets[i])) {
+			cache->buckets[i] = entry->next;
+			cache->ops->unreference(entry->bo);
+			free(entry);
+		}
+	}
+
+	cache->stats.num_entries = 0;
+	_i965DestroyMutex(&cache->mutex);
+}
+
+dri_bo *
+i965_kernel_cache_get(struct i965_kernel_cache *cache,
+					  const char *name,
+					  const struct i965_kernel_cache_blob *blobs,
+					  unsigned int num_blobs,
+					  unsigned long bo_size)
+{
+	unsigned int hash = i965_kernel_cache_hash(blobs, num_blobs, bo_size);
+	unsigned int index = hash % I965_KERNEL_CACHE_NUM_BUCKETS;
+	struct i965_kernel_cache_entry *entry;
+	dri_bo *bo = NULL;
+	unsigned int i;
+
+	_i965LockMutex(&cache->mutex);
+
+	for (entry = cache->buckets[index]; entry; entry = entry->next) {
+		if (i965_kernel_cache_entry_match(entry, hash, blobs, num_blobs, bo_size)) {
+			bo = entry->bo;
+			cache->ops->reference(bo);
+			cache->stats.hits++;
+			break;
+		}
+	}
+
+	/*
+	 * Upload under the lock, a context racing for the same kernels has to
+	 * wait for them anyway.
+	 */
+	if (!bo) {
+		cache->stats.misses++;
+
+		bo = cache->ops->alloc(cache->bufmgr, name, bo_size, 0x1000);
+		if (!bo)
+			goto out;
+
+		for (i = 0; i < num_blobs; i++) {
+			assert(blobs[i].offset + blobs[i].size <= bo_size);
+
+			if (blobs[i].bin && blobs[i].size)
+				cache->ops->subdata(bo, blobs[i].offset, blobs[i].size, blobs[i].bin);
+		}
+
+		cache->stats.bytes_uploaded += bo_size;
+
+		entry = malloc(sizeof(*entry) + sizeof(*blobs) * num_blobs);
+		if (entry) {
+			entry->hash = hash;
+			entry->bo = bo;
+			entry->bo_size = bo_size;
+			entry->num_blobs = num_blobs;
+			memcpy(entry->blobs, blobs, sizeof(*blobs) * num_blobs);
+
+			/* One reference for the caller, one for the cache */
+			cache->ops->reference(bo);
+
+			entry->next = cache->buckets[index];
+			cache->buckets[index] = entry;
+			cache->stats.num_entries++;
+		}
+	}
+
+out:
+	_i965UnlockMutex(&cache->mutex);
+
+	return bo;
+}
+
+void
+i965_kernel_cache_get_stats(struct i965_kernel_cache *cache,
+							struct i965_kernel_cache_stats *stats)
+{
+	_i965LockMutex(&cache->mutex);
+	*stats = cache->stats;
+	_i965UnlockMutex(&cache->mutex);
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _I965_KERNEL_CACHE_H_
+#define _I965_KERNEL_CACHE_H_
+
+#include <stdint.h>
+
+#include <intel_bufmgr.h>
+
+#include "i965_bufmgr_ops.h"
+#include "i965_mutext.h"
+
+#define I965_KERNEL_CACHE_NUM_BUCKETS   64
+
+/*
+ * One kernel binary placed at offset in the buffer object. The binaries
+ * are static data of the driver, so the pointer identifies the content.
+ */
+struct i965_kernel_cache_blob {
+	const void *bin;
+	unsigned int size;
+	unsigned int offset;
+};
+
+struct i965_kernel_cache_entry;
+
+struct i965_kernel_cache_stats {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t bytes_uploaded;
+	unsigned int num_entries;
+};
+
+/*
+ * Kernel buffer objects shared by all the contexts of a driver instance.
+ * They are only ever read by the GPU once uploaded, so any context loading
+ * the same set of binaries with the same layout can use the same one.
+ */
+struct i965_kernel_cache {
+	const struct i965_bufmgr_ops *ops;
+	dri_bufmgr *bufmgr;
+	_I965Mutex mutex;
+
+	struct i965_kernel_cache_entry *buckets[I965_KERNEL_CACHE_NUM_BUCKETS];
+
+	struct i965_kernel_cache_stats stats;
+};
+
+/*
+ * ops may be NULL to use libdrm
+ */
+void
+i965_kernel_cache_init(struct i965_kernel_cache *cache,
+					   dri_bufmgr *bufmgr,
+					   const struct i965_bufmgr_ops *ops);
+
+void
+i965_kernel_cache_terminate(struct i965_kernel_cache *cache);
+
+/*
+ * Returns a buffer object of bo_size bytes holding the blobs, uploading
+ * them on first use only. The caller owns the returned reference and must
+ * not write to the buffer object.
+ */
+dri_bo *
+i965_kernel_cache_get(struct i965_kernel_cache *cache,
+					  const char *name,
+					  const struct i965_kernel_cache_blob *blobs,
+					  unsigned int num_blobs,
+					  unsigned long bo_size);
+
+void
+i965_kernel_cache_get_stats(struct i965_kernel_cache *cache,
+							struct i965_kernel_cache_stats *stats);
+
+#endif /* _I965_KERNEL_CACHE_H_ */
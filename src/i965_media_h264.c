@@ -859,11 +859,8 @@ i965_media_h264_dec_context_init(VADriverContextP ctx, struct i965_media_context
 
 	for (i = 0; i < NUM_H264_AVC_KERNELS; i++) {
 		struct i965_kernel *kernel = &i965_h264_context->avc_kernels[i];
-		kernel->bo = dri_bo_alloc(i965->intel.bufmgr,
-								  kernel->name,
-								  kernel->size, 0x1000);
+		i965_gpe_load_kernel(ctx, kernel);
 		assert(kernel->bo);
-		dri_bo_subdata(kernel->bo, 0, kernel->size, kernel->bin);
 	}
 
 	for (i = 0; i < 16; i++) {
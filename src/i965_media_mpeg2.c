@@ -996,11 +996,8 @@ i965_media_mpeg2_dec_context_init(VADriverContextP ctx, struct i965_media_contex
 
 	for (i = 0; i < NUM_MPEG2_VLD_KERNELS; i++) {
 		struct i965_kernel *kernel = &i965_mpeg2_context->vld_kernels[i];
-		kernel->bo = dri_bo_alloc(i965->intel.bufmgr,
-								  kernel->name,
-								  kernel->size, 64);
+		i965_gpe_load_kernel(ctx, kernel);
 		assert(kernel->bo);
-		dri_bo_subdata(kernel->bo, 0, kernel->size, kernel->bin);
 	}
 
 	/* URB */
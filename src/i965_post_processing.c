@@ -5736,12 +5736,8 @@ i965_post_processing_context_init(VADriverContextP ctx,
 		struct pp_module *pp_module = &pp_context->pp_modules[i];
 		dri_bo_unreference(pp_module->kernel.bo);
 		if (pp_module->kernel.bin && pp_module->kernel.size) {
-			pp_module->kernel.bo = dri_bo_alloc(i965->intel.bufmgr,
-												pp_module->kernel.name,
-												pp_module->kernel.size,
-												4096);
+			i965_gpe_load_kernel(ctx, &pp_module->kernel);
 			assert(pp_module->kernel.bo);
-			dri_bo_subdata(pp_module->kernel.bo, 0, pp_module->kernel.size, pp_module->kernel.bin);
 		} else {
 			pp_module->kernel.bo = NULL;
 		}
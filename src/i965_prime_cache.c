@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "sysdeps.h"
+
+#include "i965_prime_cache.h"
+
+struct i965_prime_cache_entry {
+	struct i965_prime_cache_key key;
+	dri_bo *bo;
+	unsigned int users;     /* surfaces currently backed by bo */
+
+	struct i965_prime_cache_entry *bucket_prev;
+	struct i965_prime_cache_entry *bucket_next;
+	struct i965_prime_cache_entry *idle_prev;
+	struct i965_prime_cache_entry *idle_next;
+};
+
+static unsigned int
+i965_prime_cache_hash(const struct i965_prime_cache_key *key)
+{
+	uint64_t hash = key->ino * 31 + key->dev;
+
+	return (unsigned int)(hash % I965_PRIME_CACHE_NUM_BUCKETS);
+}
+
+static bool
+i965_prime_cache_key_valid(const struct i965_prime_cache_key *key)
+{
+	return key->dev || key->ino;
+}
+
+static struct i965_prime_cache_entry *
+i965_prime_cache_lookup(struct i965_prime_cache *cache,
+						const struct i965_prime_cache_key *key)
+{
+	struct i965_prime_cache_entry *entry;
+
+	for (entry = cache->buckets[i965_prime_cache_hash(key)]; entry; entry = entry->bucket_next) {
+		if (entry->key.dev == key->dev && entry->key.ino == key->ino)
+			return entry;
+	}
+
+	return NULL;
+}
+
+static void
+i965_prime_cache_idle_unlink(struct i965_prime_cache *cache,
+							 struct i965_prime_cache_entry *entry)
+{
+	if (entry->idle_prev)
+		entry->idle_prev->idle_next = entry->idle_next;
+	else
+		cache->idle_head = entry->idle_next;
+
+	if (entry->idle_next)
+		entry->idle_next->idle_prev = entry->idle_prev;
+	else
+		cache->idle_tail = entry->idle_prev;
+
+	entry->idle_prev = entry->idle_next = NULL;
+	cache->stats.num_idle--;
+}
+
+static void
+i965_prime_cache_evict(struct i965_prime_cache *cache,
+					   struct i965_prime_cache_entry *entry)
+{
+	if (!entry->users)
+		i965_prime_cache_idle_unlink(cache, entry);
+
+	if (entry->bucket_prev)
+		entry->bucket_prev->bucket_next = entry->bucket_next;
+	else
+		cache->buckets[i965_prime_cache_hash(&entry->key)] = entry->bucket_next;
+
+	if (entry->bucket_next)
+		entry->bucket_next->bucket_prev = entry->bucket_prev;
+
+	cache->ops->unreference(entry->bo);
+	cache->stats.num_entries--;
+	free(entry);
+}
+
+static void
+i965_prime_cache_trim_locked(struct i965_prime_cache *cache, unsigned int max_idle)
+{
+	while (cache->idle_tail && cache->stats.num_idle > max_idle) {
+		i965_prime_cache_evict(cache, cache->idle_tail);
+		cache->stats.evictions++;
+	}
+}
+
+void
+i965_prime_cache_init(struct i965_prime_cache *cache,
+					  dri_bufmgr *bufmgr,
+					  unsigned int max_idle,
+					  const struct i965_bufmgr_ops *ops)
+{
+	memset(cache, 0, sizeof(*cache));
+	cache->ops = ops ? ops : &i965_bufmgr_drm_ops;
+	cache->bufmgr = bufmgr;
+	cache->max_idle = max_idle;
+	_i965InitMutex(&cache->mutex);
+}
+
+void
+i965_prime_cache_terminate(struct i965_prime_cache *cache)
+{
+	struct i965_prime_cache_entry *entry;
+	int i;
+
+	_i965LockMutex(&cache->mutex);
+
+	/* Surfaces are gone by now, drop whatever the cache still holds */
+	for (i = 0; i < I965_PRIME_CACHE_NUM_BUCKETS; i++) {
+		while ((entry = cache->buckets[i]))
+			i965_prime_cache_evict(cache, entry);
+	}
+
+	_i965UnlockMutex(&cache->mutex);
+	_i965DestroyMutex(&cache->mutex);
+}
+
+dri_bo *
+i965_prime_cache_import(struct i965_prime_cache *cache,
+						int fd,
+						int size,
+						struct i965_prime_cache_key *key)
+{
+	struct i965_prime_cache_entry *entry;
+	dri_bo *bo;
+
+	if (cache->ops->prime_inode(fd, &key->dev, &key->ino) != 0 || !i965_prime_cache_key_valid(key)) {
+		memset(key, 0, sizeof(*key));
+
+		_i965LockMutex(&cache->mutex);
+		cache->stats.uncached++;
+		_i965UnlockMutex(&cache->mutex);
+
+		return cache->ops->import(cache->bufmgr, fd, size);
+	}
+
+	_i965LockMutex(&cache->mutex);
+
+	entry = i965_prime_cache_lookup(cache, key);
+
+	/* The caller can't claim more than the exporter handed out */
+	if (entry && size > 0 && (unsigned long)size > entry->bo->size) {
+		if (entry->users) {
+			cache->stats.uncached++;
+			_i965UnlockMutex(&cache->mutex);
+			memset(key, 0, sizeof(*key));
+
+			return cache->ops->import(cache->bufmgr, fd, size);
+		}
+
+		i965_prime_cache_evict(cache, entry);
+		cache->stats.evictions++;
+		entry = NULL;
+	}
+
+	if (entry) {
+		if (!entry->users++)
+			i965_prime_cache_idle_unlink(cache, entry);
+
+		cache->ops->reference(entry->bo);
+		cache->stats.hits++;
+		_i965UnlockMutex(&cache->mutex);
+
+		return entry->bo;
+	}
+
+	cache->stats.misses++;
+	bo = cache->ops->import(cache->bufmgr, fd, size);
+
+	if (bo && (entry = calloc(1, sizeof(*entry)))) {
+		unsigned int index = i965_prime_cache_hash(key);
+
+		entry->key = *key;
+		entry->bo = bo;
+		entry->users = 1;
+
+		/* One reference for the caller, one for the cache */
+		cache->ops->reference(bo);
+
+		entry->bucket_next = cache->buckets[index];
+		if (entry->bucket_next)
+			entry->bucket_next->bucket_prev = entry;
+		cache->buckets[index] = entry;
+		cache->stats.num_entries++;
+	} else
+		memset(key, 0, sizeof(*key));
+
+	_i965UnlockMutex(&cache->mutex);
+
+	return bo;
+}
+
+void
+i965_prime_cache_release(struct i965_prime_cache *cache,
+						 const struct i965_prime_cache_key *key,
+						 dri_bo *bo)
+{
+	struct i965_prime_cache_entry *entry = NULL;
+
+	if (!bo)
+		return;
+
+	_i965LockMutex(&cache->mutex);
+
+	if (i965_prime_cache_key_valid(key))
+		entry = i965_prime_cache_lookup(cache, key);
+
+	cache->ops->unreference(bo);
+
+	if (entry && entry->bo == bo && entry->users && !--entry->users) {
+		entry->idle_next = cache->idle_head;
+		if (entry->idle_next)
+			entry->idle_next->idle_prev = entry;
+		else
+			cache->idle_tail = entry;
+		cache->idle_head = entry;
+		cache->stats.num_idle++;
+
+		i965_prime_cache_trim_locked(cache, cache->max_idle);
+	}
+
+	_i965UnlockMutex(&cache->mutex);
+}
+
+void
+i965_prime_cache_count_export(struct i965_prime_cache *cache, int hit)
+{
+	_i965LockMutex(&cache->mutex);
+
+	cache->stats.exports++;
+
+	if (hit)
+		cache->stats.export_hits++;
+
+	_i965UnlockMutex(&cache->mutex);
+}
+
+void
+i965_prime_cache_get_stats(struct i965_prime_cache *cache,
+						   struct i965_prime_cache_stats *stats)
+{
+	_i965LockMutex(&cache->mutex);
+	*stats = cache->stats;
+	_i965UnlockMutex(&cache->mutex);
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _I965_PRIME_CACHE_H_
+#define _I965_PRIME_CACHE_H_
+
+#include <stdint.h>
+
+#include <intel_bufmgr.h>
+
+#include "i965_bufmgr_ops.h"
+#include "i965_mutext.h"
+
+#define I965_PRIME_CACHE_NUM_BUCKETS    32
+
+/* Default number of imported buffers kept after their last surface is gone */
+#define I965_PRIME_CACHE_DEFAULT_SIZE   8
+
+/*
+ * A dma-buf is identified by the inode behind its file, so every fd
+ * referring to the same buffer maps to the same key. A zero key marks a
+ * buffer that is not tracked by the cache.
+ */
+struct i965_prime_cache_key {
+	uint64_t dev;
+	uint64_t ino;
+};
+
+struct i965_prime_cache_entry;
+
+struct i965_prime_cache_stats {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t uncached;      /* imports that could not be keyed */
+	uint64_t evictions;
+	uint64_t exports;
+	uint64_t export_hits;   /* exports served from the surface's own fd */
+	unsigned int num_entries;
+	unsigned int num_idle;
+};
+
+struct i965_prime_cache {
+	const struct i965_bufmgr_ops *ops;
+	dri_bufmgr *bufmgr;
+	_I965Mutex mutex;
+	unsigned int max_idle;
+
+	struct i965_prime_cache_entry *buckets[I965_PRIME_CACHE_NUM_BUCKETS];
+
+	/* Buffers no surface refers to anymore, most recently released first */
+	struct i965_prime_cache_entry *idle_head;
+	struct i965_prime_cache_entry *idle_tail;
+
+	struct i965_prime_cache_stats stats;
+};
+
+/*
+ * max_idle bounds the buffers kept alive by the cache alone, ops may be
+ * NULL to use libdrm
+ */
+void
+i965_prime_cache_init(struct i965_prime_cache *cache,
+					  dri_bufmgr *bufmgr,
+					  unsigned int max_idle,
+					  const struct i965_bufmgr_ops *ops);
+
+void
+i965_prime_cache_terminate(struct i965_prime_cache *cache);
+
+/*
+ * Returns the buffer object behind the dma-buf fd, importing it only if
+ * the buffer is not known yet. The caller owns the returned reference and
+ * hands it back with i965_prime_cache_release() using the returned key.
+ */
+dri_bo *
+i965_prime_cache_import(struct i965_prime_cache *cache,
+						int fd,
+						int size,
+						struct i965_prime_cache_key *key);
+
+void
+i965_prime_cache_release(struct i965_prime_cache *cache,
+						 const struct i965_prime_cache_key *key,
+						 dri_bo *bo);
+
+/*
+ * Accounts a surface export, hit is set when no new PRIME handle was needed
+ */
+void
+i965_prime_cache_count_export(struct i965_prime_cache *cache, int hit);
+
+void
+i965_prime_cache_get_stats(struct i965_prime_cache *cache,
+						   struct i965_prime_cache_stats *stats);
+
+#endif /* _I965_PRIME_CACHE_H_ */
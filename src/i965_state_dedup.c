@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "sysdeps.h"
+
+#include "i965_state_dedup.h"
+
+void
+i965_state_dedup_reset(struct i965_state_dedup *dedup)
+{
+	unsigned int i;
+
+	for (i = 0; i < I965_STATE_DEDUP_MAX_SLOTS; i++)
+		dedup->slots[i].len = 0;
+}
+
+bool
+i965_state_dedup_check(struct i965_state_dedup *dedup, unsigned int slot,
+					   const uint32_t *packet, unsigned int len)
+{
+	struct i965_state_dedup_slot *last;
+
+	assert(slot < I965_STATE_DEDUP_MAX_SLOTS);
+	assert(len > 0 && len <= I965_STATE_DEDUP_MAX_DWORDS);
+
+	last = &dedup->slots[slot];
+
+	if (last->len == len && memcmp(last->dw, packet, len * 4) == 0) {
+		dedup->skipped++;
+		return true;
+	}
+
+	memcpy(last->dw, packet, len * 4);
+	last->len = len;
+	dedup->emitted++;
+
+	return false;
+}
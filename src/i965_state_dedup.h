@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _I965_STATE_DEDUP_H_
+#define _I965_STATE_DEDUP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define I965_STATE_DEDUP_MAX_SLOTS      8
+#define I965_STATE_DEDUP_MAX_DWORDS     34
+
+struct i965_state_dedup_slot {
+	unsigned int len;
+	uint32_t dw[I965_STATE_DEDUP_MAX_DWORDS];
+};
+
+/*
+ * Remembers the last state packet emitted for each slot of a picture, so
+ * that a slice whose packet is the same as the one programmed before can
+ * skip it. The hardware keeps the state until the next packet of the same
+ * kind, the slots must be reset whenever that may no longer hold, e.g. at
+ * the start of each picture.
+ */
+struct i965_state_dedup {
+	struct i965_state_dedup_slot slots[I965_STATE_DEDUP_MAX_SLOTS];
+	unsigned int emitted;
+	unsigned int skipped;
+};
+
+void
+i965_state_dedup_reset(struct i965_state_dedup *dedup);
+
+/*
+ * Returns true if the len dwords of packet were the last ones emitted for
+ * slot and don't need to be emitted again, otherwise the packet becomes
+ * the last one for slot and false is returned.
+ */
+bool
+i965_state_dedup_check(struct i965_state_dedup *dedup, unsigned int slot,
+					   const uint32_t *packet, unsigned int len);
+
+#endif /* _I965_STATE_DEDUP_H_ */
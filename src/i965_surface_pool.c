@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "sysdeps.h"
+
+#include "i965_surface_pool.h"
+
+struct i965_surface_pool_entry {
+	struct i965_surface_pool_key key;
+	dri_bo *bo;
+
+	struct i965_surface_pool_entry *bucket_prev;
+	struct i965_surface_pool_entry *bucket_next;
+	struct i965_surface_pool_entry *lru_prev;
+	struct i965_surface_pool_entry *lru_next;
+};
+
+static unsigned int
+i965_surface_pool_hash(const struct i965_surface_pool_key *key)
+{
+	unsigned int hash = key->fourcc;
+
+	hash = hash * 31 + key->tiling;
+	hash = hash * 31 + key->pitch;
+	hash = hash * 31 + key->height;
+
+	return hash % I965_SURFACE_POOL_NUM_BUCKETS;
+}
+
+static bool
+i965_surface_pool_key_equal(const struct i965_surface_pool_key *a,
+							const struct i965_surface_pool_key *b)
+{
+	return (a->fourcc == b->fourcc &&
+			a->tiling == b->tiling &&
+			a->pitch == b->pitch &&
+			a->height == b->height);
+}
+
+static void
+i965_surface_pool_unlink(struct i965_surface_pool *pool,
+						 struct i965_surface_pool_entry *entry)
+{
+	if (entry->bucket_prev)
+		entry->bucket_prev->bucket_next = entry->bucket_next;
+	else
+		pool->buckets[i965_surface_pool_hash(&entry->key)] = entry->bucket_next;
+
+	if (entry->bucket_next)
+		entry->bucket_next->bucket_prev = entry->bucket_prev;
+
+	if (entry->lru_prev)
+		entry->lru_prev->lru_next = entry->lru_next;
+	else
+		pool->lru_head = entry->lru_next;
+
+	if (entry->lru_next)
+		entry->lru_next->lru_prev = entry->lru_prev;
+	else
+		pool->lru_tail = entry->lru_prev;
+
+	pool->stats.bytes_held -= entry->bo->size;
+	pool->stats.num_held--;
+}
+
+static void
+i965_surface_pool_evict(struct i965_surface_pool *pool,
+						struct i965_surface_pool_entry *entry)
+{
+	i965_surface_pool_unlink(pool, entry);
+	pool->ops->unreference(entry->bo);
+	free(entry);
+}
+
+static void
+i965_surface_pool_trim_locked(struct i965_surface_pool *pool, uint64_t max_bytes)
+{
+	while (pool->lru_tail && pool->stats.bytes_held > max_bytes) {
+		i965_surface_pool_evict(pool, pool->lru_tail);
+		pool->stats.evictions++;
+	}
+}
+
+void
+i965_surface_pool_init(struct i965_surface_pool *pool,
+					   uint64_t max_bytes,
+					   const struct i965_bufmgr_ops *ops)
+{
+	memset(pool, 0, sizeof(*pool));
+	pool->ops = ops ? ops : &i965_bufmgr_drm_ops;
+	pool->max_bytes = max_bytes;
+	_i965InitMutex(&pool->mutex);
+}
+
+void
+i965_surface_pool_terminate(struct i965_surface_pool *pool)
+{
+	i965_surface_pool_trim(pool, 0);
+	_i965DestroyMutex(&pool->mutex);
+}
+
+dri_bo *
+i965_surface_pool_acquire(struct i965_surface_pool *pool,
+						  const struct i965_surface_pool_key *key)
+{
+	struct i965_surface_pool_entry *entry, *next;
+	dri_bo *bo = NULL;
+
+	if (!pool->max_bytes)
+		return NULL;
+
+	_i965LockMutex(&pool->mutex);
+
+	for (entry = pool->buckets[i965_surface_pool_hash(key)]; entry; entry = next) {
+		next = entry->bucket_next;
+
+		if (!i965_surface_pool_key_equal(&entry->key, key))
+			continue;
+
+		/* The pages may have been reclaimed under memory pressure */
+		if (!pool->ops->madvise(entry->bo, I915_MADV_WILLNEED)) {
+			i965_surface_pool_evict(pool, entry);
+			pool->stats.purged++;
+			continue;
+		}
+
+		bo = entry->bo;
+		i965_surface_pool_unlink(pool, entry);
+		free(entry);
+		break;
+	}
+
+	if (bo)
+		pool->stats.hits++;
+	else
+		pool->stats.misses++;
+
+	_i965UnlockMutex(&pool->mutex);
+
+	return bo;
+}
+
+void
+i965_surface_pool_release(struct i965_surface_pool *pool,
+						  const struct i965_surface_pool_key *key,
+						  dri_bo *bo)
+{
+	struct i965_surface_pool_entry *entry;
+	unsigned int index;
+
+	if (!bo)
+		return;
+
+	if (bo->size > pool->max_bytes ||
+		!(entry = calloc(1, sizeof(*entry)))) {
+		pool->ops->unreference(bo);
+		return;
+	}
+
+	entry->key = *key;
+	entry->bo = bo;
+
+	/* Let the kernel reclaim the pages if it runs short of memory */
+	pool->ops->madvise(bo, I915_MADV_DONTNEED);
+
+	_i965LockMutex(&pool->mutex);
+
+	index = i965_surface_pool_hash(key);
+	entry->bucket_next = pool->buckets[index];
+	if (entry->bucket_next)
+		entry->bucket_next->bucket_prev = entry;
+	pool->buckets[index] = entry;
+
+	entry->lru_next = pool->lru_head;
+	if (entry->lru_next)
+		entry->lru_next->lru_prev = entry;
+	else
+		pool->lru_tail = entry;
+	pool->lru_head = entry;
+
+	pool->stats.bytes_held += bo->size;
+	pool->stats.num_held++;
+
+	i965_surface_pool_trim_locked(pool, pool->max_bytes);
+
+	_i965UnlockMutex(&pool->mutex);
+}
+
+void
+i965_surface_pool_trim(struct i965_surface_pool *pool, uint64_t max_bytes)
+{
+	_i965LockMutex(&pool->mutex);
+	i965_surface_pool_trim_locked(pool, max_bytes);
+	_i965UnlockMutex(&pool->mutex);
+}
+
+void
+i965_surface_pool_get_stats(struct i965_surface_pool *pool,
+							struct i965_surface_pool_stats *stats)
+{
+	_i965LockMutex(&pool->mutex);
+	*stats = pool->stats;
+	_i965UnlockMutex(&pool->mutex);
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _I965_SURFACE_POOL_H_
+#define _I965_SURFACE_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <i915_drm.h>
+#include <intel_bufmgr.h>
+
+#include "i965_bufmgr_ops.h"
+#include "i965_mutext.h"
+
+#define I965_SURFACE_POOL_NUM_BUCKETS   32
+
+/* Default upper bound of the memory held by the pool, in MB */
+#define I965_SURFACE_POOL_DEFAULT_SIZE  64
+
+/*
+ * Two surfaces with the same key have the very same storage layout, so the
+ * storage of a destroyed surface can back a new one as is.
+ */
+struct i965_surface_pool_key {
+	unsigned int fourcc;
+	unsigned int tiling;
+	unsigned int pitch;
+	unsigned int height;
+};
+
+struct i965_surface_pool_entry;
+
+struct i965_surface_pool_stats {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	uint64_t purged;        /* storage reclaimed by the kernel while pooled */
+	uint64_t bytes_held;
+	unsigned int num_held;
+};
+
+struct i965_surface_pool {
+	const struct i965_bufmgr_ops *ops;
+	_I965Mutex mutex;
+	uint64_t max_bytes;
+
+	struct i965_surface_pool_entry *buckets[I965_SURFACE_POOL_NUM_BUCKETS];
+
+	/* Most recently released entry first */
+	struct i965_surface_pool_entry *lru_head;
+	struct i965_surface_pool_entry *lru_tail;
+
+	struct i965_surface_pool_stats stats;
+};
+
+/*
+ * max_bytes of 0 disables the pool, ops may be NULL to use libdrm
+ */
+void
+i965_surface_pool_init(struct i965_surface_pool *pool,
+					   uint64_t max_bytes,
+					   const struct i965_bufmgr_ops *ops);
+
+void
+i965_surface_pool_terminate(struct i965_surface_pool *pool);
+
+/*
+ * Returns a pooled buffer object matching the key, or NULL on a miss.
+ * The caller owns the returned reference.
+ */
+dri_bo *
+i965_surface_pool_acquire(struct i965_surface_pool *pool,
+						  const struct i965_surface_pool_key *key);
+
+/*
+ * Hands the caller's reference to bo over to the pool. The buffer object
+ * must not be shared with anything outside of the driver.
+ */
+void
+i965_surface_pool_release(struct i965_surface_pool *pool,
+						  const struct i965_surface_pool_key *key,
+						  dri_bo *bo);
+
+/*
+ * Evicts the least recently used buffer objects until at most max_bytes
+ * are held, e.g. trim to 0 when an allocation fails.
+ */
+void
+i965_surface_pool_trim(struct i965_surface_pool *pool, uint64_t max_bytes);
+
+void
+i965_surface_pool_get_stats(struct i965_surface_pool *pool,
+							struct i965_surface_pool_stats *stats);
+
+#endif /* _I965_SURFACE_POOL_H_ */
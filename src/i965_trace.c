@@ -0,0 +1,440 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "i965_trace.h"
+
+int i965_trace_enabled;
+
+struct i965_trace_point i965_trace_bo_alloc = {
+	.name = "bo_alloc",
+	.category = "bo",
+};
+
+static pthread_mutex_t trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int trace_refcount;
+static uint32_t trace_session;
+static char *trace_path;
+
+static struct i965_trace_point *trace_points;
+static struct i965_trace_ring *trace_rings;
+static __thread struct i965_trace_ring *thread_ring;
+
+static pthread_once_t trace_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t trace_key;
+static int trace_key_created;
+
+uint64_t
+i965_trace_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void
+i965_trace_register(struct i965_trace_point *point)
+{
+	struct i965_trace_point *head;
+
+	if (likely(__atomic_load_n(&point->registered, __ATOMIC_ACQUIRE)))
+		return;
+
+	if (__atomic_exchange_n(&point->registered, 1, __ATOMIC_ACQ_REL))
+		return;
+
+	head = __atomic_load_n(&trace_points, __ATOMIC_RELAXED);
+	do {
+		point->next = head;
+	} while (!__atomic_compare_exchange_n(&trace_points, &head, point, 1,
+										  __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/* Called with trace_mutex held */
+static void
+i965_trace_free_ring(struct i965_trace_ring *ring)
+{
+	struct i965_trace_ring **link = &trace_rings;
+
+	while (*link != ring)
+		link = &(*link)->next;
+
+	__atomic_store_n(link, ring->next, __ATOMIC_RELEASE);
+	free(ring);
+}
+
+static void
+i965_trace_thread_exit(void *data)
+{
+	struct i965_trace_ring *ring = data;
+
+	thread_ring = NULL;
+
+	pthread_mutex_lock(&trace_mutex);
+
+	/* the events are written by i965_trace_fini() */
+	if (trace_refcount)
+		ring->orphaned = 1;
+	else
+		i965_trace_free_ring(ring);
+
+	pthread_mutex_unlock(&trace_mutex);
+}
+
+static void
+i965_trace_key_init(void)
+{
+	trace_key_created = !pthread_key_create(&trace_key, i965_trace_thread_exit);
+}
+
+/* The threads must not run the destructor of an unloaded driver */
+static void __attribute__((destructor))
+i965_trace_unload(void)
+{
+	if (trace_key_created)
+		pthread_key_delete(trace_key);
+}
+
+static struct i965_trace_ring *
+i965_trace_thread_ring(void)
+{
+	struct i965_trace_ring *ring = thread_ring;
+
+	if (likely(ring))
+		return ring;
+
+	pthread_once(&trace_key_once, i965_trace_key_init);
+	if (!trace_key_created)
+		return NULL;
+
+	/* rings outlive a trace session, the thread reuses its ring in the next */
+	ring = calloc(1, sizeof(*ring));
+	if (!ring)
+		return NULL;
+
+	ring->tid = syscall(SYS_gettid);
+
+	if (pthread_setspecific(trace_key, ring)) {
+		free(ring);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&trace_mutex);
+	ring->next = trace_rings;
+	__atomic_store_n(&trace_rings, ring, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&trace_mutex);
+
+	thread_ring = ring;
+
+	return ring;
+}
+
+static void
+i965_trace_record(struct i965_trace_point *point, uint64_t timestamp,
+				  uint64_t duration, uint64_t arg)
+{
+	struct i965_trace_ring *ring = i965_trace_thread_ring();
+	struct i965_trace_event *event;
+	uint32_t session;
+	uint64_t head;
+
+	if (!ring)
+		return;
+
+	/* only the owner writes the ring, it starts over in a new session */
+	session = __atomic_load_n(&trace_session, __ATOMIC_RELAXED);
+	if (unlikely(ring->session != session)) {
+		__atomic_store_n(&ring->head, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&ring->claimed, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&ring->session, session, __ATOMIC_RELEASE);
+	}
+
+	head = ring->head;
+	event = &ring->events[head & (I965_TRACE_RING_SIZE - 1)];
+
+	/* a reader that sees any part of the event sees the claim */
+	__atomic_store_n(&ring->claimed, head + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&event->point, point, __ATOMIC_RELAXED);
+	__atomic_store_n(&event->timestamp, timestamp, __ATOMIC_RELAXED);
+	__atomic_store_n(&event->duration, duration, __ATOMIC_RELAXED);
+	__atomic_store_n(&event->arg, arg, __ATOMIC_RELAXED);
+
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+void
+i965_trace_complete(struct i965_trace_point *point, uint64_t start, uint64_t end)
+{
+	uint64_t ns = end - start;
+	uint64_t us = ns / 1000;
+	uint64_t max;
+	int bucket = us ? 64 - __builtin_clzll(us) : 0;
+
+	/* the call began before the trace was finished */
+	if (!__atomic_load_n(&i965_trace_enabled, __ATOMIC_RELAXED))
+		return;
+
+	i965_trace_register(point);
+
+	__atomic_fetch_add(&point->count, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&point->total_ns, ns, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&point->histogram[bucket < I965_TRACE_BUCKETS ? bucket : I965_TRACE_BUCKETS - 1],
+					   1, __ATOMIC_RELAXED);
+
+	max = __atomic_load_n(&point->max_ns, __ATOMIC_RELAXED);
+	while (ns > max &&
+		   !__atomic_compare_exchange_n(&point->max_ns, &max, ns, 1,
+										__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+
+	i965_trace_record(point, start, ns, 0);
+}
+
+void
+i965_trace_instant(struct i965_trace_point *point, uint64_t arg)
+{
+	i965_trace_register(point);
+
+	__atomic_fetch_add(&point->num_instants, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&point->total_arg, arg, __ATOMIC_RELAXED);
+
+	i965_trace_record(point, i965_trace_now(), I965_TRACE_INSTANT, arg);
+}
+
+struct i965_trace_point *
+i965_trace_points(void)
+{
+	return __atomic_load_n(&trace_points, __ATOMIC_ACQUIRE);
+}
+
+struct i965_trace_ring *
+i965_trace_rings(void)
+{
+	return __atomic_load_n(&trace_rings, __ATOMIC_ACQUIRE);
+}
+
+uint64_t
+i965_trace_ring_head(const struct i965_trace_ring *ring)
+{
+	if (__atomic_load_n(&ring->session, __ATOMIC_ACQUIRE) !=
+		__atomic_load_n(&trace_session, __ATOMIC_RELAXED))
+		return 0;
+
+	return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+}
+
+/* Called with trace_mutex held, the owners may still be recording */
+static void
+i965_trace_write_json_locked(FILE *fp)
+{
+	const struct i965_trace_ring *ring;
+	const struct i965_trace_event *slot;
+	struct i965_trace_event event;
+	const char *separator = "";
+	uint64_t head, i;
+	int pid = getpid();
+
+	fprintf(fp, "{\"traceEvents\":[");
+
+	for (ring = i965_trace_rings(); ring; ring = ring->next) {
+		head = i965_trace_ring_head(ring);
+
+		/* the oldest events have been overwritten when the ring wrapped */
+		for (i = head > I965_TRACE_RING_SIZE ? head - I965_TRACE_RING_SIZE : 0; i < head; i++) {
+			slot = &ring->events[i & (I965_TRACE_RING_SIZE - 1)];
+
+			event.point = __atomic_load_n(&slot->point, __ATOMIC_RELAXED);
+			event.timestamp = __atomic_load_n(&slot->timestamp, __ATOMIC_RELAXED);
+			event.duration = __atomic_load_n(&slot->duration, __ATOMIC_RELAXED);
+			event.arg = __atomic_load_n(&slot->arg, __ATOMIC_RELAXED);
+
+			/* drop the event if the owner has moved on to overwrite it */
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if (__atomic_load_n(&ring->claimed, __ATOMIC_RELAXED) > i + I965_TRACE_RING_SIZE)
+				continue;
+
+			fprintf(fp, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,",
+					separator, event.point->name, event.point->category,
+					pid, ring->tid, event.timestamp / 1000.0);
+
+			if (event.duration == I965_TRACE_INSTANT)
+				fprintf(fp, "\"ph\":\"i\",\"s\":\"t\",\"args\":{\"value\":%llu}}",
+						(unsigned long long)event.arg);
+			else
+				fprintf(fp, "\"ph\":\"X\",\"dur\":%.3f}", event.duration / 1000.0);
+
+			separator = ",";
+		}
+	}
+
+	fprintf(fp, "\n],\"displayTimeUnit\":\"ns\"}\n");
+}
+
+void
+i965_trace_write_json(FILE *fp)
+{
+	pthread_mutex_lock(&trace_mutex);
+	i965_trace_write_json_locked(fp);
+	pthread_mutex_unlock(&trace_mutex);
+}
+
+/* Upper bound in us of the bucket holding the given fraction of the calls */
+static uint64_t
+i965_trace_percentile(const struct i965_trace_point *point, double fraction)
+{
+	uint64_t target = (uint64_t)(point->count * fraction);
+	uint64_t seen = 0;
+	int i;
+
+	for (i = 0; i < I965_TRACE_BUCKETS - 1; i++) {
+		seen += point->histogram[i];
+
+		if (seen > target)
+			break;
+	}
+
+	return 1ULL << i;
+}
+
+void
+i965_trace_dump_summary(FILE *fp)
+{
+	const struct i965_trace_point *point;
+	int i;
+
+	if (!i965_trace_points())
+		return;
+
+	fprintf(fp, "i965: VA trace summary\n");
+
+	for (point = i965_trace_points(); point; point = point->next) {
+		if (point->num_instants)
+			fprintf(fp, "  %-32s %8llu events, sum %llu\n", point->name,
+					(unsigned long long)point->num_instants,
+					(unsigned long long)point->total_arg);
+
+		if (!point->count)
+			continue;
+
+		fprintf(fp, "  %-32s %8llu calls, avg %9.1f us, max %9.1f us, p50 <%llu us, p99 <%llu us\n",
+				point->name,
+				(unsigned long long)point->count,
+				point->total_ns / 1000.0 / point->count,
+				point->max_ns / 1000.0,
+				(unsigned long long)i965_trace_percentile(point, 0.50),
+				(unsigned long long)i965_trace_percentile(point, 0.99));
+
+		fprintf(fp, "  %-32s", "");
+		for (i = 0; i < I965_TRACE_BUCKETS; i++) {
+			if (!point->histogram[i])
+				continue;
+
+			if (i == 0)
+				fprintf(fp, " <1us:%llu", (unsigned long long)point->histogram[i]);
+			else if (i == I965_TRACE_BUCKETS - 1)
+				fprintf(fp, " >=%lluus:%llu", 1ULL << (i - 1),
+						(unsigned long long)point->histogram[i]);
+			else
+				fprintf(fp, " %lluus:%llu", 1ULL << (i - 1),
+						(unsigned long long)point->histogram[i]);
+		}
+		fprintf(fp, "\n");
+	}
+}
+
+void
+i965_trace_init(const char *path)
+{
+	pthread_mutex_lock(&trace_mutex);
+
+	if (trace_refcount++ == 0) {
+		free(trace_path);
+		trace_path = path ? strdup(path) : NULL;
+		__atomic_store_n(&trace_session, trace_session + 1, __ATOMIC_RELAXED);
+		__atomic_store_n(&i965_trace_enabled, 1, __ATOMIC_RELEASE);
+	}
+
+	pthread_mutex_unlock(&trace_mutex);
+}
+
+void
+i965_trace_fini(void)
+{
+	struct i965_trace_point *point, *next;
+	struct i965_trace_ring *ring, *next_ring;
+	FILE *fp;
+
+	pthread_mutex_lock(&trace_mutex);
+
+	if (trace_refcount == 0 || --trace_refcount > 0) {
+		pthread_mutex_unlock(&trace_mutex);
+		return;
+	}
+
+	__atomic_store_n(&i965_trace_enabled, 0, __ATOMIC_RELEASE);
+
+	if (trace_path) {
+		fp = fopen(trace_path, "w");
+
+		if (fp) {
+			i965_trace_write_json_locked(fp);
+			fclose(fp);
+		} else
+			fprintf(stderr, "i965: failed to write the trace to %s\n", trace_path);
+	}
+
+	i965_trace_dump_summary(stderr);
+
+	/* start the next session from scratch, the points are static */
+	for (point = __atomic_exchange_n(&trace_points, NULL, __ATOMIC_ACQ_REL); point; point = next) {
+		next = point->next;
+		point->next = NULL;
+		point->count = point->total_ns = point->max_ns = 0;
+		point->num_instants = point->total_arg = 0;
+		memset(point->histogram, 0, sizeof(point->histogram));
+		__atomic_store_n(&point->registered, 0, __ATOMIC_RELEASE);
+	}
+
+	/* the rings start over when their thread records in the next session */
+	for (ring = trace_rings; ring; ring = next_ring) {
+		next_ring = ring->next;
+
+		if (ring->orphaned)
+			i965_trace_free_ring(ring);
+	}
+
+	free(trace_path);
+	trace_path = NULL;
+
+	pthread_mutex_unlock(&trace_mutex);
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _I965_TRACE_H_
+#define _I965_TRACE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "intel_compiler.h"
+
+/*
+ * CPU side tracing of the VA entry points, enabled with VA_INTEL_DEBUG=64.
+ *
+ * Every thread appends to its own ring of events, so recording takes no
+ * lock. The rings are written as a Chrome trace (chrome://tracing, Perfetto)
+ * to I965_TRACE_FILE and the per call latency histograms are printed when
+ * the driver terminates. When disabled, a traced function costs a load and
+ * a predictable branch on entry and on exit.
+ */
+
+#define I965_TRACE_RING_SIZE    (1 << 16)   /* events per thread, a power of two */
+#define I965_TRACE_BUCKETS      20          /* [2^(i-1), 2^i) us, the last is open */
+
+/* duration of the events that only mark a point in time */
+#define I965_TRACE_INSTANT      UINT64_MAX
+
+struct i965_trace_point {
+	const char *name;
+	const char *category;
+
+	/* all the points that recorded an event, see i965_trace_points() */
+	struct i965_trace_point *next;
+	int registered;
+
+	/* timed calls */
+	uint64_t count;
+	uint64_t total_ns;
+	uint64_t max_ns;
+	uint64_t histogram[I965_TRACE_BUCKETS];
+
+	/* instant events and the sum of their arguments */
+	uint64_t num_instants;
+	uint64_t total_arg;
+};
+
+struct i965_trace_event {
+	struct i965_trace_point *point;
+	uint64_t timestamp;                 /* ns, CLOCK_MONOTONIC */
+	uint64_t duration;                  /* ns or I965_TRACE_INSTANT */
+	uint64_t arg;
+};
+
+struct i965_trace_ring {
+	struct i965_trace_ring *next;
+	uint32_t tid;
+	int orphaned;                       /* the thread exited during a session */
+	uint32_t session;                   /* trace session of the events */
+	uint64_t head;                      /* events written in the session */
+	uint64_t claimed;                   /* and the one being written */
+	struct i965_trace_event events[I965_TRACE_RING_SIZE];
+};
+
+struct i965_trace_scope {
+	struct i965_trace_point *point;
+	uint64_t start;                     /* 0 when tracing is disabled */
+};
+
+extern int i965_trace_enabled;
+
+extern struct i965_trace_point i965_trace_bo_alloc;
+
+/*
+ * Tracing is reference counted, the trace is written by the last
+ * i965_trace_fini(). A NULL path only collects the latency statistics.
+ */
+void
+i965_trace_init(const char *path);
+
+void
+i965_trace_fini(void);
+
+uint64_t
+i965_trace_now(void);
+
+void
+i965_trace_complete(struct i965_trace_point *point, uint64_t start, uint64_t end);
+
+void
+i965_trace_instant(struct i965_trace_point *point, uint64_t arg);
+
+/* The points that recorded an event since i965_trace_init(), most recent first */
+struct i965_trace_point *
+i965_trace_points(void);
+
+/*
+ * The rings of the threads that recorded an event, most recent first. The
+ * ring of a thread is freed when it exits, or by i965_trace_fini() if it
+ * exits during a trace session.
+ */
+struct i965_trace_ring *
+i965_trace_rings(void);
+
+/* Events the ring recorded in the current trace session */
+uint64_t
+i965_trace_ring_head(const struct i965_trace_ring *ring);
+
+void
+i965_trace_write_json(FILE *fp);
+
+void
+i965_trace_dump_summary(FILE *fp);
+
+static inline void
+i965_trace_scope_end(struct i965_trace_scope *scope)
+{
+	if (unlikely(scope->start))
+		i965_trace_complete(scope->point, scope->start, i965_trace_now());
+}
+
+/* Records the time spent from here to the end of the enclosing scope */
+#define I965_TRACE_SCOPE(trace_name, trace_category)                            \
+	static struct i965_trace_point __trace_point = {                            \
+		.name = trace_name,                                                     \
+		.category = trace_category,                                             \
+	};                                                                          \
+	struct i965_trace_scope __trace_scope                                       \
+		__attribute__((cleanup(i965_trace_scope_end))) = {                      \
+		&__trace_point,                                                         \
+		unlikely(i965_trace_enabled) ? i965_trace_now() : 0,                    \
+	}
+
+#define I965_TRACE_FUNCTION()   I965_TRACE_SCOPE(__func__, "va")
+
+#define I965_TRACE_EVENT(trace_point, trace_arg) do {                          \
+		if (unlikely(i965_trace_enabled))                                       \
+			i965_trace_instant(trace_point, trace_arg);                         \
+	} while (0)
+
+#endif /* _I965_TRACE_H_ */
@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "sysdeps.h"
+
+#include <pthread.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#define I965_VC1_BITPLANE_X86   1
+#endif
+
+#include "i965_vc1_bitplane.h"
+
+/* The MB value the hardware expects for each MB of a skipped picture */
+#define VC1_BITPLANE_SKIPPED    0x2
+
+typedef void (*i965_vc1_bitplane_row_func)(uint8_t *dst, const uint8_t *src,
+										   unsigned int n);
+
+static pthread_once_t i965_vc1_bitplane_once = PTHREAD_ONCE_INIT;
+static int i965_vc1_bitplane_best_path;
+static int i965_vc1_bitplane_path;
+
+/*
+ * Both row functions produce n whole destination bytes, i.e. 2 * n MB
+ * values. When the row starts on a byte the nibbles of each byte just
+ * swap places, otherwise a destination byte takes the low nibble of one
+ * source byte and the high nibble of the next.
+ */
+static void
+i965_vc1_bitplane_swap_c(uint8_t *dst, const uint8_t *src, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = (src[i] >> 4) | (src[i] << 4);
+}
+
+static void
+i965_vc1_bitplane_merge_c(uint8_t *dst, const uint8_t *src, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = (src[i] & 0x0f) | (src[i + 1] & 0xf0);
+}
+
+#ifdef I965_VC1_BITPLANE_X86
+/*
+ * SSE2 has no byte shifts, the 16 bit ones move nibbles across bytes and
+ * the masks drop whatever crossed.
+ */
+__attribute__((target("sse2"))) static void
+i965_vc1_bitplane_swap_sse2(uint8_t *dst, const uint8_t *src, unsigned int n)
+{
+	const __m128i low = _mm_set1_epi8(0x0f);
+	unsigned int i = 0;
+
+	for (; i + 16 <= n; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(src + i));
+
+		a = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(a, 4), low),
+						 _mm_andnot_si128(low, _mm_slli_epi16(a, 4)));
+		_mm_storeu_si128((__m128i *)(dst + i), a);
+	}
+
+	i965_vc1_bitplane_swap_c(dst + i, src + i, n - i);
+}
+
+__attribute__((target("sse2"))) static void
+i965_vc1_bitplane_merge_sse2(uint8_t *dst, const uint8_t *src, unsigned int n)
+{
+	const __m128i low = _mm_set1_epi8(0x0f);
+	unsigned int i = 0;
+
+	for (; i + 16 <= n; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(src + i + 1));
+
+		a = _mm_or_si128(_mm_and_si128(a, low), _mm_andnot_si128(low, b));
+		_mm_storeu_si128((__m128i *)(dst + i), a);
+	}
+
+	i965_vc1_bitplane_merge_c(dst + i, src + i, n - i);
+}
+#endif
+
+static const i965_vc1_bitplane_row_func i965_vc1_bitplane_swap_funcs[] = {
+	[I965_VC1_BITPLANE_PATH_C] = i965_vc1_bitplane_swap_c,
+#ifdef I965_VC1_BITPLANE_X86
+	[I965_VC1_BITPLANE_PATH_SSE2] = i965_vc1_bitplane_swap_sse2,
+#endif
+};
+
+static const i965_vc1_bitplane_row_func i965_vc1_bitplane_merge_funcs[] = {
+	[I965_VC1_BITPLANE_PATH_C] = i965_vc1_bitplane_merge_c,
+#ifdef I965_VC1_BITPLANE_X86
+	[I965_VC1_BITPLANE_PATH_SSE2] = i965_vc1_bitplane_merge_sse2,
+#endif
+};
+
+static void
+i965_vc1_bitplane_init(void)
+{
+	i965_vc1_bitplane_best_path = I965_VC1_BITPLANE_PATH_C;
+
+#ifdef I965_VC1_BITPLANE_X86
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("sse2"))
+		i965_vc1_bitplane_best_path = I965_VC1_BITPLANE_PATH_SSE2;
+#endif
+
+	i965_vc1_bitplane_path = i965_vc1_bitplane_best_path;
+}
+
+int
+i965_vc1_bitplane_set_path(int path)
+{
+	pthread_once(&i965_vc1_bitplane_once, i965_vc1_bitplane_init);
+
+	if (path < I965_VC1_BITPLANE_PATH_C)
+		path = I965_VC1_BITPLANE_PATH_C;
+
+	i965_vc1_bitplane_path = path < i965_vc1_bitplane_best_path ? path : i965_vc1_bitplane_best_path;
+
+	return i965_vc1_bitplane_path;
+}
+
+int
+i965_vc1_bitplane_get_path(void)
+{
+	pthread_once(&i965_vc1_bitplane_once, i965_vc1_bitplane_init);
+
+	return i965_vc1_bitplane_path;
+}
+
+void
+i965_vc1_bitplane_repack_row(uint8_t *dst, const uint8_t *src,
+							 unsigned int src_offset, unsigned int width)
+{
+	pthread_once(&i965_vc1_bitplane_once, i965_vc1_bitplane_init);
+
+	src += src_offset / 2;
+
+	/* An odd width leaves the last MB alone in the low nibble */
+	if (src_offset & 1) {
+		i965_vc1_bitplane_merge_funcs[i965_vc1_bitplane_path](dst, src, width / 2);
+
+		if (width & 1)
+			dst[width / 2] = src[width / 2] & 0x0f;
+	} else {
+		i965_vc1_bitplane_swap_funcs[i965_vc1_bitplane_path](dst, src, width / 2);
+
+		if (width & 1)
+			dst[width / 2] = src[width / 2] >> 4;
+	}
+}
+
+void
+i965_vc1_bitplane_repack(uint8_t *dst, unsigned int dst_pitch,
+						 const uint8_t *src, unsigned int width, unsigned int height)
+{
+	unsigned int y;
+
+	for (y = 0; y < height; y++) {
+		i965_vc1_bitplane_repack_row(dst, src, y * width, width);
+		dst += dst_pitch;
+	}
+}
+
+void
+i965_vc1_bitplane_fill_skipped(uint8_t *dst, unsigned int dst_pitch,
+							   unsigned int width, unsigned int height)
+{
+	unsigned int y;
+
+	for (y = 0; y < height; y++) {
+		memset(dst, VC1_BITPLANE_SKIPPED | (VC1_BITPLANE_SKIPPED << 4), width / 2);
+
+		if (width & 1)
+			dst[width / 2] = VC1_BITPLANE_SKIPPED;
+
+		dst += dst_pitch;
+	}
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _I965_VC1_BITPLANE_H_
+#define _I965_VC1_BITPLANE_H_
+
+#include <stdint.h>
+
+/*
+ * VC-1 bitplanes come from the application as one 4 bit value per MB,
+ * packed high nibble first and continuously across MB rows. The MFX unit
+ * reads them low nibble first with each MB row starting on a new byte.
+ */
+
+enum i965_vc1_bitplane_path {
+	I965_VC1_BITPLANE_PATH_C = 0,
+	I965_VC1_BITPLANE_PATH_SSE2,
+};
+
+/* SSE2 is used when present, set_path() returns the path it could select */
+int i965_vc1_bitplane_set_path(int path);
+int i965_vc1_bitplane_get_path(void);
+
+/* Repacks the width MB values starting at nibble src_offset of src into dst */
+void
+i965_vc1_bitplane_repack_row(uint8_t *dst, const uint8_t *src,
+							 unsigned int src_offset, unsigned int width);
+
+/*
+ * Repacks a whole width x height MBs bitplane, dst rows are dst_pitch
+ * bytes apart and at least (width + 1) / 2 bytes wide.
+ */
+void
+i965_vc1_bitplane_repack(uint8_t *dst, unsigned int dst_pitch,
+						 const uint8_t *src, unsigned int width, unsigned int height);
+
+/* Fills dst with the bitplane of a skipped picture, all MBs are skipped */
+void
+i965_vc1_bitplane_fill_skipped(uint8_t *dst, unsigned int dst_pitch,
+							   unsigned int width, unsigned int height);
+
+#endif /* _I965_VC1_BITPLANE_H_ */
@@ -27,12 +27,58 @@
 
 #include "sysdeps.h"
 #include <math.h>
+#include <pthread.h>
 #include <va/va.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <emmintrin.h>
+#define AVS_X86 1
+#endif
+
 #include "i965_vpp_avs.h"
+#include "i965_mutext.h"
 
 typedef void (*AVSGenCoeffsFunc)(float *coeffs, int num_coeffs, int phase,
 								 int num_phases, float f);
 
+/* Odd Taylor coefficients of sin(x * M_PI), up to x^13 */
+#define AVS_SINPI_C1    3.14159265f
+#define AVS_SINPI_C3    -5.16771278f
+#define AVS_SINPI_C5    2.55016404f
+#define AVS_SINPI_C7    -0.599264529f
+#define AVS_SINPI_C9    0.0821458866f
+#define AVS_SINPI_C11   -0.00737043095f
+#define AVS_SINPI_C13   0.000466302806f
+
+#define AVS_PI2         9.8696044f
+
+/* Tables of coefficients, shared by all contexts */
+struct avs_cache_entry {
+	const AVSConfig *config;
+	uint32_t flags;
+	float scale_x;
+	float scale_y;
+	/* 0 for unused entries */
+	uint64_t last_use;
+	AVSCoeffs coeffs[AVS_MAX_PHASES + 1];
+};
+
+struct avs_cache {
+	_I965Mutex mutex;
+	uint64_t use_count;
+	unsigned int num_hits;
+	unsigned int num_misses;
+	struct avs_cache_entry entries[AVS_COEFFS_CACHE_SIZE];
+};
+
+static struct avs_cache avs_cache = {
+	.mutex = _I965_MUTEX_INITIALIZER,
+};
+
+static pthread_once_t avs_gen_once = PTHREAD_ONCE_INIT;
+static int avs_gen_best_path;
+static int avs_gen_path;
+
 /* Initializes all coefficients to zero */
 static void
 avs_init_coeffs(float *coeffs, int num_coeffs)
@@ -47,15 +93,6 @@ avs_init_coeffs(float *coeffs, int num_coeffs)
 #endif
 }
 
-/* Computes the sinc(x) function */
-static float
-avs_sinc(float x)
-{
-	if (x == 0.0f)
-		return 1.0f;
-	return sin(x * M_PI) / (x * M_PI);
-}
-
 /* Convolution kernel for linear interpolation */
 static float
 avs_kernel_linear(float x)
@@ -65,15 +102,6 @@ avs_kernel_linear(float x)
 	return abs_x < 1.0f ? 1 - abs_x : 0.0f;
 }
 
-/* Convolution kernel for Lanczos-based interpolation */
-static float
-avs_kernel_lanczos(float x, float a)
-{
-	const float abs_x = fabsf(x);
-
-	return abs_x < a ? avs_sinc(x) * avs_sinc(x / a) : 0.0f;
-}
-
 /* Truncates floating-point value towards an epsilon factor */
 static inline float
 avs_trunc_coeff(float x, float epsilon)
@@ -171,6 +199,45 @@ avs_gen_coeffs_linear(float *coeffs, int num_coeffs, int phase, int num_phases,
 	coeffs[c + 1] = avs_kernel_linear(p - 1);
 }
 
+/*
+ * Computes sin(x * M_PI) with a polynomial over [-0.5, 0.5] after range
+ * reduction, the SIMD version performs the very same operations.
+ */
+static inline float
+avs_sinpi(float x)
+{
+	const float n = rintf(x);
+	const float r = x - n;
+	const float r2 = r * r;
+	float s;
+
+	s = AVS_SINPI_C13;
+	s = s * r2 + AVS_SINPI_C11;
+	s = s * r2 + AVS_SINPI_C9;
+	s = s * r2 + AVS_SINPI_C7;
+	s = s * r2 + AVS_SINPI_C5;
+	s = s * r2 + AVS_SINPI_C3;
+	s = s * r2 + AVS_SINPI_C1;
+	s = s * r;
+
+	return ((int)n & 1) ? -s : s;
+}
+
+/* Convolution kernel for Lanczos-based interpolation */
+static inline float
+avs_kernel_lanczos(float x, float a)
+{
+	float xa;
+
+	if (!(fabsf(x) < a))
+		return 0.0f;
+	if (x == 0.0f)
+		return 1.0f;
+
+	xa = x / a;
+	return (avs_sinpi(x) * avs_sinpi(xa)) / (AVS_PI2 * x * xa);
+}
+
 /* Generate coefficients for high quality (lanczos) */
 static void
 avs_gen_coeffs_lanczos(float *coeffs, int num_coeffs, int phase, int num_phases,
@@ -187,6 +254,111 @@ avs_gen_coeffs_lanczos(float *coeffs, int num_coeffs, int phase, int num_phases,
 		coeffs[i] = avs_kernel_lanczos((i - (c + p)) * f, l);
 }
 
+#ifdef AVS_X86
+__attribute__((target("sse2"))) static inline __m128
+avs_sinpi_sse2(__m128 x)
+{
+	const __m128i n = _mm_cvtps_epi32(x);
+	const __m128 r = _mm_sub_ps(x, _mm_cvtepi32_ps(n));
+	const __m128 r2 = _mm_mul_ps(r, r);
+	const __m128 sign = _mm_castsi128_ps(_mm_slli_epi32(n, 31));
+	__m128 s;
+
+	s = _mm_set1_ps(AVS_SINPI_C13);
+	s = _mm_add_ps(_mm_mul_ps(s, r2), _mm_set1_ps(AVS_SINPI_C11));
+	s = _mm_add_ps(_mm_mul_ps(s, r2), _mm_set1_ps(AVS_SINPI_C9));
+	s = _mm_add_ps(_mm_mul_ps(s, r2), _mm_set1_ps(AVS_SINPI_C7));
+	s = _mm_add_ps(_mm_mul_ps(s, r2), _mm_set1_ps(AVS_SINPI_C5));
+	s = _mm_add_ps(_mm_mul_ps(s, r2), _mm_set1_ps(AVS_SINPI_C3));
+	s = _mm_add_ps(_mm_mul_ps(s, r2), _mm_set1_ps(AVS_SINPI_C1));
+	s = _mm_mul_ps(s, r);
+
+	return _mm_xor_ps(s, sign);
+}
+
+/* Same as avs_gen_coeffs_lanczos(), 4 taps at a time */
+__attribute__((target("sse2"))) static void
+avs_gen_coeffs_lanczos_sse2(float *coeffs, int num_coeffs, int phase,
+							int num_phases, float f)
+{
+	const int c = num_coeffs / 2 - 1;
+	const int l = num_coeffs > 4 ? 3 : 2;
+	const float p = (float)phase / (num_phases * 2);
+	const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	const __m128 a = _mm_set1_ps(l);
+	__m128 vf, cp;
+	int i;
+
+	if (f > 1.0f)
+		f = 1.0f;
+
+	vf = _mm_set1_ps(f);
+	cp = _mm_set1_ps(c + p);
+
+	for (i = 0; i + 4 <= num_coeffs; i += 4) {
+		const __m128 x = _mm_mul_ps(_mm_sub_ps(_mm_setr_ps(i, i + 1, i + 2, i + 3), cp), vf);
+		const __m128 xa = _mm_div_ps(x, a);
+		const __m128 num = _mm_mul_ps(avs_sinpi_sse2(x), avs_sinpi_sse2(xa));
+		const __m128 den = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(AVS_PI2), x), xa);
+		const __m128 in_range = _mm_cmplt_ps(_mm_and_ps(x, abs_mask), a);
+		const __m128 is_zero = _mm_cmpeq_ps(x, _mm_setzero_ps());
+		__m128 k;
+
+		k = _mm_div_ps(num, den);
+		k = _mm_or_ps(_mm_and_ps(is_zero, _mm_set1_ps(1.0f)),
+					  _mm_andnot_ps(is_zero, k));
+		k = _mm_and_ps(in_range, k);
+
+		_mm_storeu_ps(coeffs + i, k);
+	}
+
+	for (; i < num_coeffs; i++)
+		coeffs[i] = avs_kernel_lanczos((i - (c + p)) * f, l);
+}
+#endif
+
+static void
+avs_gen_init(void)
+{
+	avs_gen_best_path = AVS_GEN_PATH_C;
+
+#ifdef AVS_X86
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("sse2"))
+		avs_gen_best_path = AVS_GEN_PATH_SSE2;
+#endif
+
+	avs_gen_path = avs_gen_best_path;
+}
+
+/* Selects the Lanczos generator, meant for testing */
+int
+avs_set_gen_path(int path)
+{
+	pthread_once(&avs_gen_once, avs_gen_init);
+
+	if (path < AVS_GEN_PATH_C)
+		path = AVS_GEN_PATH_C;
+
+	avs_gen_path = path < avs_gen_best_path ? path : avs_gen_best_path;
+
+	return avs_gen_path;
+}
+
+static AVSGenCoeffsFunc
+avs_get_gen_coeffs_lanczos(void)
+{
+	pthread_once(&avs_gen_once, avs_gen_init);
+
+#ifdef AVS_X86
+	if (avs_gen_path == AVS_GEN_PATH_SSE2)
+		return avs_gen_coeffs_lanczos_sse2;
+#endif
+
+	return avs_gen_coeffs_lanczos;
+}
+
 /* Generate coefficients with the supplied scaler */
 static bool
 avs_gen_coeffs(AVSState *avs, float sx, float sy, AVSGenCoeffsFunc gen_coeffs)
@@ -240,11 +412,103 @@ avs_params_changed(AVSState *avs, float sx, float sy, uint32_t flags)
 	return false;
 }
 
+/* Copies a cached table to avs on hit, the entry is then most recently used */
+static bool
+avs_cache_lookup(AVSState *avs, float sx, float sy, uint32_t flags)
+{
+	const AVSConfig * const config = avs->config;
+	bool found = false;
+	int i;
+
+	_i965LockMutex(&avs_cache.mutex);
+
+	for (i = 0; i < AVS_COEFFS_CACHE_SIZE; i++) {
+		struct avs_cache_entry * const entry = &avs_cache.entries[i];
+
+		if (entry->last_use &&
+			entry->config == config &&
+			entry->flags == flags &&
+			entry->scale_x == sx &&
+			entry->scale_y == sy) {
+			memcpy(avs->coeffs, entry->coeffs,
+				   (config->num_phases + 1) * sizeof(AVSCoeffs));
+			entry->last_use = ++avs_cache.use_count;
+			found = true;
+			break;
+		}
+	}
+
+	if (found)
+		avs_cache.num_hits++;
+	else
+		avs_cache.num_misses++;
+
+	_i965UnlockMutex(&avs_cache.mutex);
+
+	return found;
+}
+
+/* Stores the table of avs in place of the least recently used entry */
+static void
+avs_cache_insert(const AVSState *avs, float sx, float sy, uint32_t flags)
+{
+	const AVSConfig * const config = avs->config;
+	struct avs_cache_entry *entry = &avs_cache.entries[0];
+	int i;
+
+	_i965LockMutex(&avs_cache.mutex);
+
+	for (i = 1; i < AVS_COEFFS_CACHE_SIZE; i++) {
+		if (avs_cache.entries[i].last_use < entry->last_use)
+			entry = &avs_cache.entries[i];
+	}
+
+	entry->config = config;
+	entry->flags = flags;
+	entry->scale_x = sx;
+	entry->scale_y = sy;
+	entry->last_use = ++avs_cache.use_count;
+	memcpy(entry->coeffs, avs->coeffs,
+		   (config->num_phases + 1) * sizeof(AVSCoeffs));
+
+	_i965UnlockMutex(&avs_cache.mutex);
+}
+
+/* Drops all cached coefficients */
+void
+avs_flush_coefficients_cache(void)
+{
+	int i;
+
+	_i965LockMutex(&avs_cache.mutex);
+
+	for (i = 0; i < AVS_COEFFS_CACHE_SIZE; i++)
+		avs_cache.entries[i].last_use = 0;
+
+	avs_cache.num_hits = 0;
+	avs_cache.num_misses = 0;
+
+	_i965UnlockMutex(&avs_cache.mutex);
+}
+
+/* Returns the number of cache hits and misses since the last flush */
+void
+avs_get_coefficients_cache_stats(unsigned int *num_hits, unsigned int *num_misses)
+{
+	_i965LockMutex(&avs_cache.mutex);
+
+	*num_hits = avs_cache.num_hits;
+	*num_misses = avs_cache.num_misses;
+
+	_i965UnlockMutex(&avs_cache.mutex);
+}
+
 /* Updates AVS coefficients for the supplied factors and quality level */
 bool
 avs_update_coefficients(AVSState *avs, float sx, float sy, uint32_t flags)
 {
 	AVSGenCoeffsFunc gen_coeffs;
+	float key_sx, key_sy;
 
 	flags &= VA_FILTER_SCALING_MASK;
 	if (!avs_params_changed(avs, sx, sy, flags))
@@ -252,15 +516,24 @@ avs_update_coefficients(AVSState *avs, float sx, float sy, uint32_t flags)
 
 	switch (flags) {
 	case VA_FILTER_SCALING_HQ:
-		gen_coeffs = avs_gen_coeffs_lanczos;
+		gen_coeffs = avs_get_gen_coeffs_lanczos();
+		key_sx = sx;
+		key_sy = sy;
 		break;
 	default:
+		/* The bilinear filter doesn't depend on the scaling factors */
 		gen_coeffs = avs_gen_coeffs_linear;
+		key_sx = 0.0f;
+		key_sy = 0.0f;
 		break;
 	}
-	if (!avs_gen_coeffs(avs, sx, sy, gen_coeffs)) {
-		assert(0 && "invalid set of coefficients generated");
-		return false;
+
+	if (!avs_cache_lookup(avs, key_sx, key_sy, flags)) {
+		if (!avs_gen_coeffs(avs, sx, sy, gen_coeffs)) {
+			assert(0 && "invalid set of coefficients generated");
+			return false;
+		}
+		avs_cache_insert(avs, key_sx, key_sy, flags);
 	}
 
 	avs->flags = flags;
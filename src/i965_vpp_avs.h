@@ -40,6 +40,15 @@
 /** Maximum number of coefficients for chroma samples */
 #define AVS_MAX_CHROMA_COEFFS 4
 
+/** Number of coefficient tables kept around by avs_update_coefficients() */
+#define AVS_COEFFS_CACHE_SIZE 8
+
+/** Implementations of the Lanczos coefficients generator */
+enum {
+	AVS_GEN_PATH_C = 0,
+	AVS_GEN_PATH_SSE2,
+};
+
 typedef struct avs_coeffs               AVSCoeffs;
 typedef struct avs_coeffs_range         AVSCoeffsRange;
 typedef struct avs_config               AVSConfig;
@@ -103,6 +112,18 @@ avs_init_state(AVSState *avs, const AVSConfig *config);
 bool
 avs_update_coefficients(AVSState *avs, float sx, float sy, uint32_t flags);
 
+/** Drops all cached coefficient tables and resets the cache statistics */
+void
+avs_flush_coefficients_cache(void);
+
+/** Returns the number of cache hits and misses since the last flush */
+void
+avs_get_coefficients_cache_stats(unsigned int *num_hits, unsigned int *num_misses);
+
+/** Selects the Lanczos generator, returns the one in effect (for testing) */
+int
+avs_set_gen_path(int path);
+
 /** Checks whether AVS is needed, e.g. if high-quality scaling is requested */
 static inline bool
 avs_is_needed(uint32_t flags)
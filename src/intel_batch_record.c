@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "sysdeps.h"
+
+#include "intel_batch_record.h"
+
+void
+intel_batch_record_init(struct intel_batch_record *record,
+						const struct i965_bufmgr_ops *ops)
+{
+	memset(record, 0, sizeof(*record));
+	record->ops = ops;
+}
+
+void
+intel_batch_record_fini(struct intel_batch_record *record)
+{
+	free(record->key);
+	free(record->dwords);
+	free(record->relocs);
+	intel_batch_record_init(record, record->ops);
+}
+
+bool
+intel_batch_record_match(const struct intel_batch_record *record,
+						 const void *key, size_t key_size)
+{
+	return (record->valid &&
+			record->key_size == key_size &&
+			(!key_size || !memcmp(record->key, key, key_size)));
+}
+
+bool
+intel_batch_record_begin(struct intel_batch_record *record,
+						 const void *key, size_t key_size)
+{
+	record->valid = false;
+	record->failed = false;
+	record->num_dwords = 0;
+	record->num_relocs = 0;
+
+	if (key_size > record->key_size) {
+		void *new_key = realloc(record->key, key_size);
+
+		if (!new_key) {
+			record->failed = true;
+			return false;
+		}
+
+		record->key = new_key;
+	}
+
+	if (key_size)
+		memcpy(record->key, key, key_size);
+
+	record->key_size = key_size;
+
+	return true;
+}
+
+void
+intel_batch_record_add_reloc(struct intel_batch_record *record,
+							 uint32_t offset, dri_bo *bo,
+							 uint32_t read_domains, uint32_t write_domain,
+							 uint32_t delta, bool is_64bit)
+{
+	struct intel_batch_record_reloc *reloc;
+
+	if (record->failed)
+		return;
+
+	if (record->num_relocs == record->max_relocs) {
+		unsigned int max_relocs = record->max_relocs ? record->max_relocs * 2 : 8;
+		struct intel_batch_record_reloc *relocs;
+
+		relocs = realloc(record->relocs, max_relocs * sizeof(*relocs));
+
+		if (!relocs) {
+			record->failed = true;
+			return;
+		}
+
+		record->relocs = relocs;
+		record->max_relocs = max_relocs;
+	}
+
+	reloc = &record->relocs[record->num_relocs++];
+	reloc->bo = bo;
+	reloc->offset = offset;
+	reloc->read_domains = read_domains;
+	reloc->write_domain = write_domain;
+	reloc->delta = delta;
+	reloc->is_64bit = is_64bit;
+}
+
+bool
+intel_batch_record_end(struct intel_batch_record *record,
+					   const void *commands, unsigned int size)
+{
+	unsigned int num_dwords = size / 4;
+
+	assert((size & 3) == 0);
+
+	if (record->failed)
+		return false;
+
+	if (num_dwords > record->max_dwords) {
+		uint32_t *dwords = realloc(record->dwords, num_dwords * 4);
+
+		if (!dwords) {
+			record->failed = true;
+			return false;
+		}
+
+		record->dwords = dwords;
+		record->max_dwords = num_dwords;
+	}
+
+	if (size)
+		memcpy(record->dwords, commands, size);
+
+	record->num_dwords = num_dwords;
+	record->valid = true;
+
+	return true;
+}
+
+void
+intel_batch_record_abort(struct intel_batch_record *record)
+{
+	record->valid = false;
+	record->failed = false;
+	record->num_dwords = 0;
+	record->num_relocs = 0;
+}
+
+unsigned int
+intel_batch_record_size(const struct intel_batch_record *record)
+{
+	return record->num_dwords * 4;
+}
+
+void
+intel_batch_record_replay(const struct intel_batch_record *record,
+						  void *dst, dri_bo *dst_bo, uint32_t dst_offset)
+{
+	const struct i965_bufmgr_ops *ops = record->ops ? record->ops : &i965_bufmgr_drm_ops;
+	unsigned int i;
+
+	assert(record->valid);
+	memcpy(dst, record->dwords, record->num_dwords * 4);
+
+	for (i = 0; i < record->num_relocs; i++) {
+		const struct intel_batch_record_reloc *reloc = &record->relocs[i];
+		uint32_t *presumed = (uint32_t *)((char *)dst + reloc->offset);
+		uint64_t address = reloc->bo->offset64 + reloc->delta;
+
+		ops->emit_reloc(dst_bo, dst_offset + reloc->offset,
+						reloc->bo, reloc->delta,
+						reloc->read_domains, reloc->write_domain);
+
+		presumed[0] = address;
+
+		if (reloc->is_64bit)
+			presumed[1] = address >> 32;
+	}
+}
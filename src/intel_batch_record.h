@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _INTEL_BATCH_RECORD_H_
+#define _INTEL_BATCH_RECORD_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <intel_bufmgr.h>
+
+#include "i965_bufmgr_ops.h"
+
+/*
+ * A recorded command sequence and the relocations it carries, keyed by the
+ * state it was built from. Replaying it copies the commands and emits the
+ * relocations again, the presumed addresses are patched with the current
+ * offsets of the target buffers.
+ *
+ * A zeroed record is a valid empty record using the libdrm hooks.
+ */
+struct intel_batch_record_reloc {
+	dri_bo *bo;
+	uint32_t offset;            /* in bytes from the start of the record */
+	uint32_t read_domains;
+	uint32_t write_domain;
+	uint32_t delta;
+	bool is_64bit;
+};
+
+struct intel_batch_record {
+	const struct i965_bufmgr_ops *ops;
+
+	void *key;
+	size_t key_size;
+
+	uint32_t *dwords;
+	unsigned int num_dwords;
+	unsigned int max_dwords;
+
+	struct intel_batch_record_reloc *relocs;
+	unsigned int num_relocs;
+	unsigned int max_relocs;
+
+	bool valid;
+	bool failed;
+};
+
+void intel_batch_record_init(struct intel_batch_record *record,
+							 const struct i965_bufmgr_ops *ops);
+void intel_batch_record_fini(struct intel_batch_record *record);
+
+bool intel_batch_record_match(const struct intel_batch_record *record,
+							  const void *key, size_t key_size);
+
+/* Drops the previous content, the record is valid again once ended */
+bool intel_batch_record_begin(struct intel_batch_record *record,
+							  const void *key, size_t key_size);
+void intel_batch_record_add_reloc(struct intel_batch_record *record,
+								  uint32_t offset, dri_bo *bo,
+								  uint32_t read_domains, uint32_t write_domain,
+								  uint32_t delta, bool is_64bit);
+bool intel_batch_record_end(struct intel_batch_record *record,
+							const void *commands, unsigned int size);
+void intel_batch_record_abort(struct intel_batch_record *record);
+
+/* Size of the recorded commands, in bytes */
+unsigned int intel_batch_record_size(const struct intel_batch_record *record);
+
+/* Copies the commands to dst, which is at dst_offset in dst_bo */
+void intel_batch_record_replay(const struct intel_batch_record *record,
+							   void *dst, dri_bo *dst_bo, uint32_t dst_offset);
+
+#endif /* _INTEL_BATCH_RECORD_H_ */
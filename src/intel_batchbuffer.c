@@ -25,6 +25,9 @@
  *
  **************************************************************************/
 
+#include "sysdeps.h"
+
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
@@ -39,12 +42,99 @@
 #define LOCAL_I915_EXEC_BSD_RING0       (1<<13)
 #define LOCAL_I915_EXEC_BSD_RING1       (2<<13)
 
+/* the second VCS has its own fence slot, see intel_batchbuffer_fence_slot() */
+#define VCS1_FENCE_SLOT                 5
+
+#define RCS_TIMESTAMP                   0x2358
+#define VCS0_TIMESTAMP                  0x12358
+#define VCS1_TIMESTAMP                  0x1c358
+#define VECS_TIMESTAMP                  0x1a358
+#define BCS_TIMESTAMP                   0x22358
+
+/*
+ * Returns a buffer to build the next batch in: the oldest submitted one if
+ * the GPU has retired it, a new one while the pool isn't full, otherwise
+ * the oldest one anyway and mapping it waits for the GPU.
+ */
+static dri_bo *
+intel_batchbuffer_get_bo(struct intel_batchbuffer *batch, int batch_size)
+{
+	struct intel_driver_data *intel = batch->intel;
+	struct intel_batch_pool_stats *stats = &intel->batch_pool_stats;
+	dri_bo *bo;
+	int busy;
+
+	if (batch->pool_count > 0) {
+		bo = batch->pool[batch->pool_head];
+		busy = drm_intel_bo_busy(bo);
+
+		if (!busy || batch->pool_count == batch->pool_depth) {
+			batch->pool_head = (batch->pool_head + 1) % batch->pool_depth;
+			batch->pool_count--;
+
+			if (bo->size >= batch_size) {
+				if (busy)
+					__atomic_fetch_add(&stats->stalls, 1, __ATOMIC_RELAXED);
+
+				__atomic_fetch_add(&stats->reuses, 1, __ATOMIC_RELAXED);
+				return bo;
+			}
+
+			dri_bo_unreference(bo);
+		}
+	}
+
+	__atomic_fetch_add(&stats->allocations, 1, __ATOMIC_RELAXED);
+
+	return dri_bo_alloc(intel->bufmgr,
+						"batch buffer",
+						batch_size,
+						0x1000);
+}
+
+/*
+ * Queues the buffer just submitted, its relocations are dropped right away
+ * so that the pool doesn't keep the target buffers alive.
+ */
+static void
+intel_batchbuffer_retire_bo(struct intel_batchbuffer *batch, dri_bo *bo)
+{
+	if (!bo)
+		return;
+
+	if (batch->pool_count == batch->pool_depth) {
+		dri_bo_unreference(bo);
+		return;
+	}
+
+	drm_intel_gem_bo_clear_relocs(bo, 0);
+	batch->pool[(batch->pool_head + batch->pool_count) % batch->pool_depth] = bo;
+	batch->pool_count++;
+}
+
+/*
+ * The submitted buffers the GPU hasn't retired yet, a ring executes them in
+ * order so the count stops at the newest idle one.
+ */
+int
+intel_batchbuffer_num_pending(struct intel_batchbuffer *batch)
+{
+	int i;
+
+	for (i = batch->pool_count; i > 0; i--) {
+		if (!drm_intel_bo_busy(batch->pool[(batch->pool_head + i - 1) % batch->pool_depth]))
+			break;
+	}
+
+	return batch->pool_count - i;
+}
+
 static void
 intel_batchbuffer_reset(struct intel_batchbuffer *batch, int buffer_size)
 {
-	struct intel_driver_data *intel = batch->intel;
 	int batch_size = buffer_size;
 	int ring_flag;
+	dri_bo *retired;
 
 	ring_flag = batch->flag & I915_EXEC_RING_MASK;
 
@@ -53,11 +143,10 @@ intel_batchbuffer_reset(struct intel_batchbuffer *batch, int buffer_size)
 		   ring_flag == I915_EXEC_BSD ||
 		   ring_flag == I915_EXEC_VEBOX);
 
-	dri_bo_unreference(batch->buffer);
-	batch->buffer = dri_bo_alloc(intel->bufmgr,
-								 "batch buffer",
-								 batch_size,
-								 0x1000);
+	retired = batch->buffer;
+	batch->buffer = intel_batchbuffer_get_bo(batch, batch_size);
+	intel_batchbuffer_retire_bo(batch, retired);
+
 	assert(batch->buffer);
 	dri_bo_map(batch->buffer, 1);
 	assert(batch->buffer->virtual);
@@ -99,6 +188,7 @@ intel_batchbuffer_new(struct intel_driver_data *intel, int flag, int buffer_size
 	batch->intel = intel;
 	batch->flag = flag;
 	batch->run = drm_intel_bo_mrb_exec;
+	batch->refcount = 1;
 
 	if (IS_GEN6(intel->device_info) &&
 		flag == I915_EXEC_RENDER)
@@ -109,32 +199,267 @@ intel_batchbuffer_new(struct intel_driver_data *intel, int flag, int buffer_size
 	else
 		batch->wa_render_bo = NULL;
 
+	batch->pool_depth = intel->batch_pool_depth;
 	intel_batchbuffer_reset(batch, buffer_size);
 
+	/* the timestamps are stored with the Gen8+ MI_STORE_REGISTER_MEM */
+	if ((g_intel_debug_option_flags & INTEL_DEBUG_FLAGS_GPU_PROFILE) &&
+		intel->device_info->gen >= 8)
+		batch->profiler = intel_gpu_profiler_new(intel->bufmgr, intel->timestamp_frequency);
+
+	return batch;
+}
+
+static void
+intel_batchbuffer_dump_profile(struct intel_batchbuffer *batch)
+{
+	static const char *ring_names[] = {
+		[I915_EXEC_RENDER] = "render",
+		[I915_EXEC_BSD] = "bsd",
+		[I915_EXEC_BLT] = "blt",
+		[I915_EXEC_VEBOX] = "vebox",
+	};
+	const char *path = getenv("I965_GPU_PROFILE_FILE");
+	FILE *fp = NULL;
+
+	intel_gpu_profiler_wait(batch->profiler);
+
+	if (path)
+		fp = fopen(path, "a");
+
+	intel_gpu_profiler_dump(batch->profiler, fp ? fp : stderr,
+							ring_names[batch->flag & I915_EXEC_RING_MASK]);
+
+	if (fp)
+		fclose(fp);
+}
+
+struct intel_batchbuffer *
+intel_batchbuffer_reference(struct intel_batchbuffer *batch)
+{
+	__atomic_add_fetch(&batch->refcount, 1, __ATOMIC_RELAXED);
+
 	return batch;
 }
 
 void intel_batchbuffer_free(struct intel_batchbuffer *batch)
 {
+	if (__atomic_sub_fetch(&batch->refcount, 1, __ATOMIC_ACQ_REL) > 0)
+		return;
+
+	if (batch->deferred) {
+		intel_batchbuffer_flush(batch);
+		pthread_mutex_destroy(&batch->frame_mutex);
+	}
+
+	if (batch->profiler) {
+		intel_batchbuffer_dump_profile(batch);
+		intel_gpu_profiler_free(batch->profiler);
+	}
+
 	if (batch->map) {
 		dri_bo_unmap(batch->buffer);
 		batch->map = NULL;
 	}
 
+	while (batch->pool_count > 0) {
+		dri_bo_unreference(batch->pool[batch->pool_head]);
+		batch->pool_head = (batch->pool_head + 1) % batch->pool_depth;
+		batch->pool_count--;
+	}
+
 	dri_bo_unreference(batch->buffer);
 	dri_bo_unreference(batch->wa_render_bo);
 	free(batch);
 }
 
+/* The out fences of the flushes this thread makes go into the set */
+static __thread struct intel_fence_set *collected_fences;
+static __thread int missed_fences;
+
+void
+intel_batchbuffer_begin_fences(struct intel_fence_set *set)
+{
+	collected_fences = set;
+	missed_fences = 0;
+}
+
+int
+intel_batchbuffer_end_fences(void)
+{
+	int complete = collected_fences && !missed_fences &&
+				   !intel_fence_set_is_empty(collected_fences);
+
+	collected_fences = NULL;
+
+	return complete;
+}
+
+/* Submissions to an engine complete in order, so each needs only its last fence */
+static int
+intel_batchbuffer_fence_slot(int flag)
+{
+	int ring = flag & I915_EXEC_RING_MASK;
+
+	if (ring == I915_EXEC_BSD &&
+		(flag & LOCAL_I915_EXEC_BSD_MASK) == LOCAL_I915_EXEC_BSD_RING1)
+		return VCS1_FENCE_SLOT;
+
+	return ring == I915_EXEC_DEFAULT ? I915_EXEC_RENDER : ring;
+}
+
+static void
+intel_batchbuffer_exec(struct intel_batchbuffer *batch, int used)
+{
+#ifdef HAVE_DRM_INTEL_FENCE_EXEC
+	int fence_fd = -1;
+
+	if (collected_fences && batch->intel->has_exec_fence &&
+		batch->run == drm_intel_bo_mrb_exec) {
+		if (drm_intel_gem_bo_fence_exec(batch->buffer, NULL, used, -1, &fence_fd,
+										batch->flag) == 0 && fence_fd >= 0)
+			intel_fence_set_add(collected_fences, intel_batchbuffer_fence_slot(batch->flag),
+								fence_fd);
+		else
+			missed_fences = 1;
+
+		return;
+	}
+#endif
+
+	if (collected_fences)
+		missed_fences = 1;
+
+	batch->run(batch->buffer, used, 0, 0, 0, batch->flag);
+}
+
+struct intel_batchbuffer *
+intel_batchbuffer_get_decode_batch(struct intel_driver_data *intel, int bsd_ring)
+{
+	struct intel_batchbuffer *batch;
+	int index = bsd_ring + 1;
+
+	if (intel->decode_batch_frames <= 1 || index < 0 || index >= INTEL_DECODE_BATCHES)
+		return NULL;
+
+	pthread_mutex_lock(&intel->decode_batches_mutex);
+
+	batch = intel->decode_batches[index];
+	if (!batch) {
+		batch = intel_batchbuffer_new(intel, I915_EXEC_BSD, 0);
+		pthread_mutex_init(&batch->frame_mutex, NULL);
+		batch->deferred = 1;
+
+		__atomic_store_n(&intel->decode_batches[index], batch, __ATOMIC_RELEASE);
+	}
+
+	pthread_mutex_unlock(&intel->decode_batches_mutex);
+
+	return intel_batchbuffer_reference(batch);
+}
+
+void
+intel_batchbuffer_begin_frame(struct intel_batchbuffer *batch)
+{
+	if (!batch->deferred)
+		return;
+
+	pthread_mutex_lock(&batch->frame_mutex);
+
+	/* a frame must never be split, leave it the other half of the batch */
+	if (batch->ptr - batch->map > batch->size / 2)
+		intel_batchbuffer_flush(batch);
+}
+
+void
+intel_batchbuffer_end_frame(struct intel_batchbuffer *batch)
+{
+	struct intel_driver_data *intel = batch->intel;
+	uint64_t now;
+
+	if (!batch->deferred) {
+		intel_batchbuffer_flush(batch);
+		return;
+	}
+
+	now = intel_bsd_scheduler_now();
+
+	if (!batch->num_frames)
+		batch->first_frame_ns = now;
+
+	batch->num_frames++;
+	__atomic_add_fetch(&intel->num_deferred_frames, 1, __ATOMIC_RELAXED);
+
+	if (batch->num_frames >= intel->decode_batch_frames ||
+		now - batch->first_frame_ns >= intel->decode_batch_us * 1000ULL)
+		intel_batchbuffer_flush(batch);
+	else if (collected_fences)
+		/* the fences of begin_frame's flush are of older frames only */
+		missed_fences = 1;
+
+	pthread_mutex_unlock(&batch->frame_mutex);
+}
+
+void
+intel_batchbuffer_flush_frames(struct intel_batchbuffer *batch)
+{
+	if (!batch->deferred)
+		return;
+
+	pthread_mutex_lock(&batch->frame_mutex);
+	if (batch->num_frames)
+		intel_batchbuffer_flush(batch);
+	pthread_mutex_unlock(&batch->frame_mutex);
+}
+
+void
+intel_batchbuffer_flush_deferred_bo(struct intel_driver_data *intel, dri_bo *bo)
+{
+	struct intel_batchbuffer *batch;
+	int i;
+
+	if (!__atomic_load_n(&intel->num_deferred_frames, __ATOMIC_RELAXED))
+		return;
+
+	for (i = 0; i < INTEL_DECODE_BATCHES; i++) {
+		batch = __atomic_load_n(&intel->decode_batches[i], __ATOMIC_ACQUIRE);
+		if (!batch)
+			continue;
+
+		pthread_mutex_lock(&batch->frame_mutex);
+		if (batch->num_frames && (!bo || drm_intel_bo_references(batch->buffer, bo)))
+			intel_batchbuffer_flush(batch);
+		pthread_mutex_unlock(&batch->frame_mutex);
+	}
+}
+
+void
+intel_batchbuffer_flush_deferred(struct intel_driver_data *intel)
+{
+	intel_batchbuffer_flush_deferred_bo(intel, NULL);
+}
+
 void
 intel_batchbuffer_flush(struct intel_batchbuffer *batch)
 {
 	unsigned int used = batch->ptr - batch->map;
 
+	/* keeps the submission order of immediate flushing */
+	if (!batch->deferred)
+		intel_batchbuffer_flush_deferred(batch->intel);
+
 	if (used == 0) {
 		return;
 	}
 
+	if (batch->num_frames) {
+		__atomic_sub_fetch(&batch->intel->num_deferred_frames, batch->num_frames,
+						   __ATOMIC_RELAXED);
+		batch->num_frames = 0;
+	}
+
+	I965_TRACE_SCOPE("batch_flush", "batch");
+
 	if ((used & 4) == 0) {
 		*(unsigned int*)batch->ptr = 0;
 		batch->ptr += 4;
@@ -144,8 +469,30 @@ intel_batchbuffer_flush(struct intel_batchbuffer *batch)
 	batch->ptr += 4;
 	dri_bo_unmap(batch->buffer);
 	used = batch->ptr - batch->map;
-	batch->run(batch->buffer, used, 0, 0, 0, batch->flag);
+	intel_batchbuffer_exec(batch, used);
 	intel_batchbuffer_reset(batch, batch->size);
+
+	if (batch->profiler)
+		intel_gpu_profiler_submit(batch->profiler);
+}
+
+void
+intel_batchbuffer_grow(struct intel_batchbuffer *batch, unsigned int size)
+{
+	unsigned int batch_size;
+
+	if (size + BATCH_RESERVED + 8 <= batch->size)
+		return;
+
+	assert(!batch->atomic);
+	batch_size = ALIGN(size + BATCH_RESERVED + 8, 0x1000);
+	assert(batch_size <= MAX_BATCH_SIZE);
+	batch_size = MIN(batch_size, MAX_BATCH_SIZE);
+
+	/* the queued commands go first, the new buffer starts empty */
+	intel_batchbuffer_flush(batch);
+	dri_bo_unmap(batch->buffer);
+	intel_batchbuffer_reset(batch, batch_size);
 }
 
 void
@@ -164,6 +511,11 @@ intel_batchbuffer_emit_reloc(struct intel_batchbuffer *batch, dri_bo *bo,
 	assert(batch->ptr - batch->map < batch->size);
 	dri_bo_emit_reloc(batch->buffer, read_domains, write_domains,
 					  delta, batch->ptr - batch->map, bo);
+
+	if (batch->record)
+		intel_batch_record_add_reloc(batch->record, batch->ptr - batch->record_start, bo,
+									 read_domains, write_domains, delta, false);
+
 	intel_batchbuffer_emit_dword(batch, bo->offset + delta);
 }
 
@@ -176,6 +528,10 @@ intel_batchbuffer_emit_reloc64(struct intel_batchbuffer *batch, dri_bo *bo,
 	dri_bo_emit_reloc(batch->buffer, read_domains, write_domains,
 					  delta, batch->ptr - batch->map, bo);
 
+	if (batch->record)
+		intel_batch_record_add_reloc(batch->record, batch->ptr - batch->record_start, bo,
+									 read_domains, write_domains, delta, true);
+
 	/* Using the old buffer offset, write in what the right data would be, in
 	 * case the buffer doesn't move and we can short-circuit the relocation
 	 * processing in the kernel.
@@ -446,3 +802,142 @@ intel_batchbuffer_align(struct intel_batchbuffer *batch, unsigned int alignedmen
 	}
 }
 
+
+/*
+ * Records the commands emitted until intel_batchbuffer_end_record(). The
+ * space is reserved up front as a flush in the middle would split the
+ * sequence, max_size must cover it all.
+ */
+void
+intel_batchbuffer_begin_record(struct intel_batchbuffer *batch, struct intel_batch_record *record,
+							   const void *key, size_t key_size, unsigned int max_size)
+{
+	assert(!batch->record);
+	intel_batchbuffer_require_space(batch, max_size);
+
+	if (!intel_batch_record_begin(record, key, key_size))
+		return;
+
+	batch->record = record;
+	batch->record_start = batch->ptr;
+	batch->record_buffer = batch->buffer;
+}
+
+void
+intel_batchbuffer_end_record(struct intel_batchbuffer *batch)
+{
+	struct intel_batch_record *record = batch->record;
+
+	if (!record)
+		return;
+
+	batch->record = NULL;
+
+	if (batch->buffer != batch->record_buffer) {
+		intel_batch_record_abort(record);
+		return;
+	}
+
+	intel_batch_record_end(record, batch->record_start, batch->ptr - batch->record_start);
+}
+
+/*
+ * Emits the record if it was built for key, otherwise the caller has to
+ * emit (and usually record) the commands again.
+ */
+bool
+intel_batchbuffer_replay_record(struct intel_batchbuffer *batch, struct intel_batch_record *record,
+								const void *key, size_t key_size)
+{
+	unsigned int size;
+
+	if (!intel_batch_record_match(record, key, key_size))
+		return false;
+
+	size = intel_batch_record_size(record);
+	intel_batchbuffer_require_space(batch, size);
+	intel_batch_record_replay(record, batch->ptr, batch->buffer, batch->ptr - batch->map);
+	batch->ptr += size;
+
+	return true;
+}
+
+static unsigned int
+intel_batchbuffer_timestamp_reg(struct intel_batchbuffer *batch)
+{
+	switch (batch->flag & I915_EXEC_RING_MASK) {
+	case I915_EXEC_BSD:
+		/*
+		 * All the engines count the same clock, the first VCS is read
+		 * when the kernel picks the ring
+		 */
+		if ((batch->flag & LOCAL_I915_EXEC_BSD_MASK) == LOCAL_I915_EXEC_BSD_RING1)
+			return VCS1_TIMESTAMP;
+
+		return VCS0_TIMESTAMP;
+
+	case I915_EXEC_VEBOX:
+		return VECS_TIMESTAMP;
+
+	case I915_EXEC_BLT:
+		return BCS_TIMESTAMP;
+
+	default:
+		return RCS_TIMESTAMP;
+	}
+}
+
+static void
+intel_batchbuffer_store_timestamp(struct intel_batchbuffer *batch, dri_bo *bo, uint32_t offset)
+{
+	unsigned int reg = intel_batchbuffer_timestamp_reg(batch);
+	int i;
+
+	/* the low and the high dword */
+	for (i = 0; i < 2; i++) {
+		intel_batchbuffer_emit_dword(batch, MI_STORE_REGISTER_MEM | (4 - 2));
+		intel_batchbuffer_emit_dword(batch, reg + 4 * i);
+		intel_batchbuffer_emit_reloc64(batch, bo,
+									   I915_GEM_DOMAIN_RENDER, I915_GEM_DOMAIN_RENDER,
+									   offset + 4 * i);
+	}
+}
+
+/*
+ * Brackets the commands of a pipeline stage with timestamps when profiling
+ * is enabled. Both have to be emitted in the same batch, a stage which gets
+ * split by a flush is dropped. Recorded sequences aren't profiled as the
+ * query locations would be replayed.
+ */
+void
+intel_batchbuffer_begin_stage(struct intel_batchbuffer *batch, enum intel_gpu_stage stage)
+{
+	dri_bo *bo;
+	uint32_t offset;
+
+	if (!batch->profiler || batch->record)
+		return;
+
+	/* reserve first, a flush submits the query buffer */
+	intel_batchbuffer_require_space(batch, 8 * 4);
+
+	if (intel_gpu_profiler_begin(batch->profiler, stage, &bo, &offset))
+		intel_batchbuffer_store_timestamp(batch, bo, offset);
+}
+
+void
+intel_batchbuffer_end_stage(struct intel_batchbuffer *batch, enum intel_gpu_stage stage)
+{
+	dri_bo *bo;
+	uint32_t offset;
+
+	if (!batch->profiler || batch->record)
+		return;
+
+	/* wait for the stage to complete */
+	intel_batchbuffer_emit_mi_flush(batch);
+	intel_batchbuffer_require_space(batch, 8 * 4);
+
+	if (intel_gpu_profiler_end(batch->profiler, stage, &bo, &offset))
+		intel_batchbuffer_store_timestamp(batch, bo, offset);
+}
@@ -7,6 +7,24 @@
 #include <intel_bufmgr.h>
 
 #include "intel_driver.h"
+#include "intel_batch_record.h"
+#include "intel_gpu_profiler.h"
+#include "intel_fence.h"
+
+/*
+ * Submitted batch buffers are kept, still mapped, and handed out again once
+ * the GPU is done with them instead of allocating a new buffer per flush.
+ */
+#define INTEL_BATCH_POOL_DEFAULT_DEPTH  4
+#define INTEL_BATCH_POOL_MAX_DEPTH      16
+
+/*
+ * Decode frames can be gathered into a batch shared by the contexts on a
+ * ring, flushed once it holds enough frames, is half full, or its first
+ * frame is old enough.
+ */
+#define INTEL_DECODE_BATCH_MAX_FRAMES   64
+#define INTEL_DECODE_BATCH_DEFAULT_US   2000
 
 struct intel_batchbuffer {
 	struct intel_driver_data *intel;
@@ -26,15 +44,40 @@ struct intel_batchbuffer {
 
 	/* Used for Sandybdrige workaround */
 	dri_bo *wa_render_bo;
+
+	/* Submitted buffers, oldest first from pool_head */
+	dri_bo *pool[INTEL_BATCH_POOL_MAX_DEPTH];
+	int pool_depth;
+	int pool_head;
+	int pool_count;
+
+	/* Set while a command sequence is being recorded */
+	struct intel_batch_record *record;
+	unsigned char *record_start;
+	dri_bo *record_buffer;
+
+	/* Set with VA_INTEL_DEBUG=32 */
+	struct intel_gpu_profiler *profiler;
+
+	int refcount;
+
+	/* Set on the shared decode batches, the frames are under frame_mutex */
+	int deferred;
+	pthread_mutex_t frame_mutex;
+	int num_frames;
+	uint64_t first_frame_ns;
 };
 
 struct intel_batchbuffer *intel_batchbuffer_new(struct intel_driver_data *intel, int flag, int buffer_size);
 void intel_batchbuffer_free(struct intel_batchbuffer *batch);
+struct intel_batchbuffer *intel_batchbuffer_reference(struct intel_batchbuffer *batch);
 void intel_batchbuffer_start_atomic(struct intel_batchbuffer *batch, unsigned int size);
 void intel_batchbuffer_start_atomic_bcs(struct intel_batchbuffer *batch, unsigned int size);
 void intel_batchbuffer_start_atomic_blt(struct intel_batchbuffer *batch, unsigned int size);
 void intel_batchbuffer_start_atomic_veb(struct intel_batchbuffer *batch, unsigned int size);
 void intel_batchbuffer_end_atomic(struct intel_batchbuffer *batch);
+/* Replaces the buffer by a larger one if an atomic section of size bytes can't fit */
+void intel_batchbuffer_grow(struct intel_batchbuffer *batch, unsigned int size);
 void intel_batchbuffer_emit_dword(struct intel_batchbuffer *batch, unsigned int x);
 void intel_batchbuffer_emit_reloc(struct intel_batchbuffer *batch, dri_bo *bo,
 								  uint32_t read_domains, uint32_t write_domains,
@@ -51,7 +94,41 @@ void intel_batchbuffer_advance_batch(struct intel_batchbuffer *batch);
 void intel_batchbuffer_check_batchbuffer_flag(struct intel_batchbuffer *batch, int flag);
 int intel_batchbuffer_check_free_space(struct intel_batchbuffer *batch, int size);
 int intel_batchbuffer_used_size(struct intel_batchbuffer *batch);
+int intel_batchbuffer_num_pending(struct intel_batchbuffer *batch);
 void intel_batchbuffer_align(struct intel_batchbuffer *batch, unsigned int alignedment);
+void intel_batchbuffer_begin_record(struct intel_batchbuffer *batch, struct intel_batch_record *record,
+									const void *key, size_t key_size, unsigned int max_size);
+void intel_batchbuffer_end_record(struct intel_batchbuffer *batch);
+bool intel_batchbuffer_replay_record(struct intel_batchbuffer *batch, struct intel_batch_record *record,
+									 const void *key, size_t key_size);
+void intel_batchbuffer_begin_stage(struct intel_batchbuffer *batch, enum intel_gpu_stage stage);
+void intel_batchbuffer_end_stage(struct intel_batchbuffer *batch, enum intel_gpu_stage stage);
+
+/*
+ * Collects the sync_file out fences of the flushes this thread makes
+ * between begin and end into set. End returns whether every flush left a
+ * fence in it, false when there were none.
+ */
+void intel_batchbuffer_begin_fences(struct intel_fence_set *set);
+int intel_batchbuffer_end_fences(void);
+
+/*
+ * The shared decode batch of a BSD ring (-1 when the kernel places the
+ * work), referenced, or NULL when the decode flushes aren't deferred.
+ *
+ * A frame is built between begin_frame and end_frame, which flushes it
+ * right away on the batches that aren't shared. The deferred frames are
+ * submitted before any other batch and by intel_batchbuffer_flush_deferred,
+ * which the CPU accesses to the surfaces have to call first.
+ */
+struct intel_batchbuffer *intel_batchbuffer_get_decode_batch(struct intel_driver_data *intel, int bsd_ring);
+void intel_batchbuffer_begin_frame(struct intel_batchbuffer *batch);
+void intel_batchbuffer_end_frame(struct intel_batchbuffer *batch);
+void intel_batchbuffer_flush_deferred(struct intel_driver_data *intel);
+/* Submits the frames queued in batch, if it is a deferred one */
+void intel_batchbuffer_flush_frames(struct intel_batchbuffer *batch);
+/* Only flushes the deferred batches that use bo */
+void intel_batchbuffer_flush_deferred_bo(struct intel_driver_data *intel, dri_bo *bo);
 
 typedef enum {
 	BSD_DEFAULT,
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include "intel_bsd_scheduler.h"
+
+int
+intel_bsd_scheduler_parse_mode(const char *str)
+{
+	if (!str || !strcasecmp(str, "balance"))
+		return INTEL_BSD_SCHEDULER_BALANCE;
+
+	if (!strcasecmp(str, "kernel"))
+		return INTEL_BSD_SCHEDULER_KERNEL;
+
+	if (!strcmp(str, "0"))
+		return INTEL_BSD_SCHEDULER_RING0;
+
+	if (!strcmp(str, "1"))
+		return INTEL_BSD_SCHEDULER_RING1;
+
+	return INTEL_BSD_SCHEDULER_BALANCE;
+}
+
+void
+intel_bsd_scheduler_init(struct intel_bsd_scheduler *sched, int num_rings, int mode)
+{
+	memset(sched, 0, sizeof(*sched));
+	_i965InitMutex(&sched->mutex);
+
+	if (num_rings < 1)
+		num_rings = 1;
+	if (num_rings > INTEL_BSD_SCHEDULER_MAX_RINGS)
+		num_rings = INTEL_BSD_SCHEDULER_MAX_RINGS;
+
+	sched->num_rings = num_rings;
+	sched->mode = mode;
+
+	/* Without a second ring, ring selection flags aren't even supported */
+	if (num_rings == 1)
+		sched->mode = INTEL_BSD_SCHEDULER_KERNEL;
+}
+
+void
+intel_bsd_scheduler_fini(struct intel_bsd_scheduler *sched)
+{
+	_i965DestroyMutex(&sched->mutex);
+}
+
+uint64_t
+intel_bsd_scheduler_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Brings the load of ring up to now, must be called with the mutex held */
+static double
+intel_bsd_scheduler_decay(struct intel_bsd_ring_load *ring, uint64_t now)
+{
+	if (now > ring->timestamp) {
+		ring->load *= exp2(-(double)(now - ring->timestamp) / INTEL_BSD_SCHEDULER_HALF_LIFE);
+		ring->timestamp = now;
+	}
+
+	return ring->load;
+}
+
+/* The ring forced by the mode, -1 if it has to be balanced */
+static int
+intel_bsd_scheduler_fixed_ring(struct intel_bsd_scheduler *sched)
+{
+	switch (sched->mode) {
+	case INTEL_BSD_SCHEDULER_RING0:
+		return 0;
+
+	case INTEL_BSD_SCHEDULER_RING1:
+		return 1;
+
+	default:
+		return -1;
+	}
+}
+
+/* Must be called with the mutex held */
+static int
+intel_bsd_scheduler_least_loaded(struct intel_bsd_scheduler *sched, uint64_t now)
+{
+	int i, ring = -1;
+	double best_load = 0.0;
+
+	/* Ties, e.g. contexts created before any decoding, alternate */
+	for (i = 0; i < sched->num_rings; i++) {
+		double load = intel_bsd_scheduler_decay(&sched->rings[i], now);
+
+		if (ring < 0 ||
+			load < best_load ||
+			(load == best_load &&
+			 sched->rings[i].num_contexts < sched->rings[ring].num_contexts)) {
+			ring = i;
+			best_load = load;
+		}
+	}
+
+	return ring;
+}
+
+int
+intel_bsd_scheduler_pin(struct intel_bsd_scheduler *sched, uint64_t now)
+{
+	int ring;
+
+	if (sched->mode == INTEL_BSD_SCHEDULER_KERNEL)
+		return -1;
+
+	ring = intel_bsd_scheduler_fixed_ring(sched);
+
+	_i965LockMutex(&sched->mutex);
+
+	if (ring < 0)
+		ring = intel_bsd_scheduler_least_loaded(sched, now);
+
+	sched->rings[ring].num_contexts++;
+
+	_i965UnlockMutex(&sched->mutex);
+
+	return ring;
+}
+
+int
+intel_bsd_scheduler_pick(struct intel_bsd_scheduler *sched, uint64_t now)
+{
+	int ring;
+
+	if (sched->mode == INTEL_BSD_SCHEDULER_KERNEL)
+		return -1;
+
+	ring = intel_bsd_scheduler_fixed_ring(sched);
+	if (ring >= 0)
+		return ring;
+
+	_i965LockMutex(&sched->mutex);
+	ring = intel_bsd_scheduler_least_loaded(sched, now);
+	_i965UnlockMutex(&sched->mutex);
+
+	return ring;
+}
+
+void
+intel_bsd_scheduler_unpin(struct intel_bsd_scheduler *sched, int ring)
+{
+	if (ring < 0 || ring >= sched->num_rings)
+		return;
+
+	_i965LockMutex(&sched->mutex);
+	sched->rings[ring].num_contexts--;
+	_i965UnlockMutex(&sched->mutex);
+}
+
+void
+intel_bsd_scheduler_account(struct intel_bsd_scheduler *sched, int ring,
+							unsigned int cost, uint64_t now)
+{
+	if (ring < 0 || ring >= sched->num_rings)
+		return;
+
+	_i965LockMutex(&sched->mutex);
+	intel_bsd_scheduler_decay(&sched->rings[ring], now);
+	sched->rings[ring].load += cost;
+	sched->rings[ring].total_cost += cost;
+	sched->rings[ring].num_submissions++;
+	_i965UnlockMutex(&sched->mutex);
+}
+
+double
+intel_bsd_scheduler_get_load(struct intel_bsd_scheduler *sched, int ring, uint64_t now)
+{
+	double load;
+
+	if (ring < 0 || ring >= sched->num_rings)
+		return 0.0;
+
+	_i965LockMutex(&sched->mutex);
+	load = intel_bsd_scheduler_decay(&sched->rings[ring], now);
+	_i965UnlockMutex(&sched->mutex);
+
+	return load;
+}
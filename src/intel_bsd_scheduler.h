@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _INTEL_BSD_SCHEDULER_H_
+#define _INTEL_BSD_SCHEDULER_H_
+
+#include <stdint.h>
+
+#include "i965_mutext.h"
+
+/*
+ * Placement of decode contexts on the BSD (VCS) rings. Each context is
+ * pinned to one ring for its whole life, so its buffers stay hot there,
+ * new contexts go to the ring which got the least work recently.
+ *
+ * The work is accounted by the submitter in arbitrary cost units, e.g.
+ * macroblocks per frame, and decays with INTEL_BSD_SCHEDULER_HALF_LIFE.
+ */
+
+#define INTEL_BSD_SCHEDULER_MAX_RINGS   2
+
+/* ns after which the work submitted to a ring counts for half */
+#define INTEL_BSD_SCHEDULER_HALF_LIFE   (100 * 1000 * 1000ULL)
+
+enum intel_bsd_scheduler_mode {
+	INTEL_BSD_SCHEDULER_BALANCE = 0,        /* least loaded ring */
+	INTEL_BSD_SCHEDULER_KERNEL,             /* let the kernel pick per batch */
+	INTEL_BSD_SCHEDULER_RING0,              /* everything on the first ring */
+	INTEL_BSD_SCHEDULER_RING1,              /* everything on the second ring */
+};
+
+struct intel_bsd_ring_load {
+	/* decayed cost, as of timestamp */
+	double load;
+	uint64_t timestamp;
+	unsigned int num_contexts;
+	uint64_t total_cost;
+	uint64_t num_submissions;
+};
+
+struct intel_bsd_scheduler {
+	_I965Mutex mutex;
+	int mode;
+	int num_rings;
+	struct intel_bsd_ring_load rings[INTEL_BSD_SCHEDULER_MAX_RINGS];
+};
+
+/* Parses the I965_BSD_RING setting: "balance", "kernel", "0" or "1" */
+int
+intel_bsd_scheduler_parse_mode(const char *str);
+
+void
+intel_bsd_scheduler_init(struct intel_bsd_scheduler *sched, int num_rings, int mode);
+
+void
+intel_bsd_scheduler_fini(struct intel_bsd_scheduler *sched);
+
+/* Monotonic time in ns, the default clock of the callers */
+uint64_t
+intel_bsd_scheduler_now(void);
+
+/* Returns the ring to pin a new context to, or -1 to leave it to the kernel */
+int
+intel_bsd_scheduler_pin(struct intel_bsd_scheduler *sched, uint64_t now);
+
+/*
+ * Returns the ring for a single picture which doesn't depend on the others
+ * of its context, e.g. an intra picture, or -1 to leave it to the kernel.
+ * Unlike pin, nothing stays assigned to the ring.
+ */
+int
+intel_bsd_scheduler_pick(struct intel_bsd_scheduler *sched, uint64_t now);
+
+void
+intel_bsd_scheduler_unpin(struct intel_bsd_scheduler *sched, int ring);
+
+/* Records cost units of work submitted to ring, ignored for ring -1 */
+void
+intel_bsd_scheduler_account(struct intel_bsd_scheduler *sched, int ring,
+							unsigned int cost, uint64_t now);
+
+/* Returns the decayed load of ring as of now */
+double
+intel_bsd_scheduler_get_load(struct intel_bsd_scheduler *sched, int ring, uint64_t now);
+
+#endif /* _INTEL_BSD_SCHEDULER_H_ */
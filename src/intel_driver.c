@@ -50,6 +50,18 @@ uint32_t g_intel_debug_option_flags = 0;
 #define LOCAL_I915_PARAM_HAS_HUC 42
 #endif
 
+#ifdef I915_PARAM_HAS_EXEC_FENCE
+#define LOCAL_I915_PARAM_HAS_EXEC_FENCE I915_PARAM_HAS_EXEC_FENCE
+#else
+#define LOCAL_I915_PARAM_HAS_EXEC_FENCE 44
+#endif
+
+#ifdef I915_PARAM_CS_TIMESTAMP_FREQUENCY
+#define LOCAL_I915_PARAM_CS_TIMESTAMP_FREQUENCY I915_PARAM_CS_TIMESTAMP_FREQUENCY
+#else
+#define LOCAL_I915_PARAM_CS_TIMESTAMP_FREQUENCY 51
+#endif
+
 #ifdef I915_PARAM_EU_TOTAL
 #define LOCAL_I915_PARAM_EU_TOTAL I915_PARAM_EU_TOTAL
 #else
@@ -69,7 +81,9 @@ static const struct debug_flag flags[] = {
 	{INTEL_DEBUG_FLAGS_BENCH, "BENCH", "Disable calling swap_buffer in the X11 backend"},
 	{INTEL_DEBUG_FLAGS_DUMP_AUB, "DUMP_AUB", "Dumps all buffer submissions into an AUB trace (deprecated)"},
 	{INTEL_DEBUG_FLAGS_VERBOSE, "VERBOSE", "Enable verbose logging"},
-	{INTEL_DEBUG_FLAGS_KERNEL_CAPS, "KERNEL_CAPS", "Prints the kernel caps that the driver probes for"}
+	{INTEL_DEBUG_FLAGS_KERNEL_CAPS, "KERNEL_CAPS", "Prints the kernel caps that the driver probes for"},
+	{INTEL_DEBUG_FLAGS_GPU_PROFILE, "GPU_PROFILE", "Measures the GPU time of each pipeline stage, see I965_GPU_PROFILE_FILE"},
+	{INTEL_DEBUG_FLAGS_TRACE, "TRACE", "Traces the VA calls into a Chrome trace, see I965_TRACE_FILE"}
 };
 
 static Bool
@@ -158,6 +172,8 @@ intel_driver_dump_kernel_caps(struct intel_driver_data intel)
 	fprintf(stderr, "HAS_VEBOX_RING : %s\r\n", (intel.has_vebox ? "true" : "false"));
 	fprintf(stderr, "HAS_BSD2_RING  : %s\r\n", (intel.has_bsd2 ? "true" : "false"));
 	fprintf(stderr, "HAS_LOADED_HUC : %s\r\n", (intel.has_huc ? "true" : "false"));
+	fprintf(stderr, "HAS_EXEC_FENCE : %s\r\n", (intel.has_exec_fence ? "true" : "false"));
+	fprintf(stderr, "HAS_LLC        : %s\r\n", (intel.has_llc ? "true" : "false"));
 }
 
 bool
@@ -167,6 +183,7 @@ intel_driver_init(VADriverContextP ctx)
 	struct drm_state * const drm_state = (struct drm_state *)ctx->drm_state;
 	int has_exec2 = 0, has_bsd = 0, has_blt = 0, has_vebox = 0;
 	int ret_value = 0;
+	char *env_str = NULL;
 
 	intel_driver_handle_debug();
 
@@ -215,6 +232,19 @@ intel_driver_init(VADriverContextP ctx)
 	if (intel_driver_get_param(intel, LOCAL_I915_PARAM_HAS_HUC, &ret_value))
 		intel->has_huc = !!ret_value;
 
+	/* sync_file out fences need drm_intel_gem_bo_fence_exec() too */
+	intel->has_exec_fence = 0;
+#ifdef HAVE_DRM_INTEL_FENCE_EXEC
+	ret_value = 0;
+	if (intel_driver_get_param(intel, LOCAL_I915_PARAM_HAS_EXEC_FENCE, &ret_value))
+		intel->has_exec_fence = !!ret_value;
+#endif
+
+	intel->has_llc = 0;
+	ret_value = 0;
+	if (intel_driver_get_param(intel, I915_PARAM_HAS_LLC, &ret_value))
+		intel->has_llc = !!ret_value;
+
 	intel->eu_total = 0;
 	if (intel_driver_get_param(intel, LOCAL_I915_PARAM_EU_TOTAL, &ret_value)) {
 		intel->eu_total = ret_value;
@@ -225,6 +255,30 @@ intel_driver_init(VADriverContextP ctx)
 	intel->rc_hw_mode = should_enable_int("I965_RC_COUNTER");
 	intel->dec_base = should_enable_int("I965_BASE_DECODING");
 
+	/* I965_BATCH_POOL_DEPTH=0 allocates a new buffer on every flush */
+	intel->batch_pool_depth = INTEL_BATCH_POOL_DEFAULT_DEPTH;
+	if ((env_str = getenv("I965_BATCH_POOL_DEPTH")))
+		intel->batch_pool_depth = MIN(MAX(atoi(env_str), 0), INTEL_BATCH_POOL_MAX_DEPTH);
+	memset(&intel->batch_pool_stats, 0, sizeof(intel->batch_pool_stats));
+
+	/* I965_DECODE_BATCH_FRAMES=N defers the decode flushes, 0 or 1 flushes each frame */
+	intel->decode_batch_frames = 0;
+	if ((env_str = getenv("I965_DECODE_BATCH_FRAMES")))
+		intel->decode_batch_frames = MIN(MAX(atoi(env_str), 0), INTEL_DECODE_BATCH_MAX_FRAMES);
+	intel->decode_batch_us = INTEL_DECODE_BATCH_DEFAULT_US;
+	if ((env_str = getenv("I965_DECODE_BATCH_US")))
+		intel->decode_batch_us = MAX(atoi(env_str), 0);
+	memset(intel->decode_batches, 0, sizeof(intel->decode_batches));
+	pthread_mutex_init(&intel->decode_batches_mutex, NULL);
+	intel->num_deferred_frames = 0;
+
+	/* I965_BSD_RING=kernel|0|1 overrides the placement of decode contexts */
+	intel_bsd_scheduler_init(&intel->bsd_scheduler, intel->has_bsd2 ? 2 : 1,
+							 intel_bsd_scheduler_parse_mode(getenv("I965_BSD_RING")));
+
+	/* I965_DECODE_SPREAD_INTRA=1 sends the intra pictures to the least loaded ring */
+	intel->decode_spread_intra = should_enable_int("I965_DECODE_SPREAD_INTRA");
+
 #define GEN9_PTE_CACHE    2
 
 	if (IS_GEN9(intel->device_info) ||
@@ -233,9 +287,29 @@ intel_driver_init(VADriverContextP ctx)
 
 	intel_driver_get_revid(intel, &intel->revision);
 
+	/* Older kernels don't report it, fall back to the documented clocks */
+	intel->timestamp_frequency = 0;
+	ret_value = 0;
+	if (intel_driver_get_param(intel, LOCAL_I915_PARAM_CS_TIMESTAMP_FREQUENCY, &ret_value) &&
+		ret_value > 0)
+		intel->timestamp_frequency = ret_value;
+	else if (IS_GEN9(intel->device_info) && (intel->device_info->is_broxton ||
+											 intel->device_info->is_glklake))
+		intel->timestamp_frequency = 19200000;
+	else if (IS_GEN9(intel->device_info) || IS_GEN10(intel->device_info))
+		intel->timestamp_frequency = 12000000;
+	else
+		intel->timestamp_frequency = 12500000;
+
 	if (g_intel_debug_option_flags & INTEL_DEBUG_FLAGS_KERNEL_CAPS)
 		intel_driver_dump_kernel_caps(*intel);
 
+	/* I965_TRACE_FILE= (empty) only prints the latency summary */
+	if (g_intel_debug_option_flags & INTEL_DEBUG_FLAGS_TRACE) {
+		env_str = getenv("I965_TRACE_FILE");
+		i965_trace_init(env_str ? (*env_str ? env_str : NULL) : "i965_trace.json");
+	}
+
 	return true;
 }
 
@@ -243,7 +317,32 @@ void
 intel_driver_terminate(VADriverContextP ctx)
 {
 	struct intel_driver_data *intel = intel_driver_data(ctx);
+	int i;
+
+	if (g_intel_debug_option_flags & INTEL_DEBUG_FLAGS_VERBOSE)
+		fprintf(stderr, "i965: batch buffer pool: %llu allocations, %llu reuses, %llu stalls\n",
+				(unsigned long long)intel->batch_pool_stats.allocations,
+				(unsigned long long)intel->batch_pool_stats.reuses,
+				(unsigned long long)intel->batch_pool_stats.stalls);
+
+	if (g_intel_debug_option_flags & INTEL_DEBUG_FLAGS_VERBOSE) {
+		for (i = 0; i < intel->bsd_scheduler.num_rings; i++)
+			fprintf(stderr, "i965: BSD ring %d: %llu submissions, %llu cost units\n", i,
+					(unsigned long long)intel->bsd_scheduler.rings[i].num_submissions,
+					(unsigned long long)intel->bsd_scheduler.rings[i].total_cost);
+	}
+
+	/* submits the frames still deferred */
+	for (i = 0; i < INTEL_DECODE_BATCHES; i++) {
+		if (intel->decode_batches[i])
+			intel_batchbuffer_free(intel->decode_batches[i]);
+	}
+	pthread_mutex_destroy(&intel->decode_batches_mutex);
+
+	if (g_intel_debug_option_flags & INTEL_DEBUG_FLAGS_TRACE)
+		i965_trace_fini();
 
+	intel_bsd_scheduler_fini(&intel->bsd_scheduler);
 	intel_memman_terminate(intel);
 	pthread_mutex_destroy(&intel->ctxmutex);
 }
@@ -14,6 +14,16 @@
 #include "va_backend_compat.h"
 
 #include "intel_compiler.h"
+#include "intel_bsd_scheduler.h"
+#include "i965_trace.h"
+
+/* BO allocations are instant events of the VA trace, the argument is the size */
+#undef dri_bo_alloc
+#define dri_bo_alloc(bufmgr, name, size, alignment) ({                         \
+		unsigned long __bo_size = (size);                                       \
+		I965_TRACE_EVENT(&i965_trace_bo_alloc, __bo_size);                      \
+		drm_intel_bo_alloc(bufmgr, name, __bo_size, alignment);                 \
+	})
 
 #define BATCH_SIZE      0x80000
 #define BATCH_RESERVED  0x10
@@ -113,7 +123,9 @@ enum intel_debug_flags
 	INTEL_DEBUG_FLAGS_BENCH = 2,
 	INTEL_DEBUG_FLAGS_DUMP_AUB = 4,
 	INTEL_DEBUG_FLAGS_VERBOSE = 8,
-	INTEL_DEBUG_FLAGS_KERNEL_CAPS = 16
+	INTEL_DEBUG_FLAGS_KERNEL_CAPS = 16,
+	INTEL_DEBUG_FLAGS_GPU_PROFILE = 32,
+	INTEL_DEBUG_FLAGS_TRACE = 64
 };
 
 extern uint32_t g_intel_debug_option_flags;
@@ -210,6 +222,17 @@ struct intel_device_info {
 	unsigned int is_cfllake     : 1; /* gen10 (unreleased) */
 };
 
+struct intel_batch_pool_stats {
+	uint64_t allocations;   /* new batch buffers */
+	uint64_t reuses;        /* idle buffers taken back from the pool */
+	uint64_t stalls;        /* reuses that had to wait for the GPU */
+};
+
+/* decode batches shared per BSD ring: kernel placed, ring 0, ring 1 */
+#define INTEL_DECODE_BATCHES    3
+
+struct intel_batchbuffer;
+
 struct intel_driver_data {
 	int fd;
 	int device_id;
@@ -229,12 +252,34 @@ struct intel_driver_data {
 
 	unsigned int mocs_state;
 
+	int batch_pool_depth;
+	struct intel_batch_pool_stats batch_pool_stats;
+
+	/*
+	 * I965_DECODE_BATCH_FRAMES > 1 gathers that many decoded frames per
+	 * submission, or those of I965_DECODE_BATCH_US at most.
+	 */
+	int decode_batch_frames;
+	int decode_batch_us;
+	struct intel_batchbuffer *decode_batches[INTEL_DECODE_BATCHES];
+	pthread_mutex_t decode_batches_mutex;
+	int num_deferred_frames;
+
+	struct intel_bsd_scheduler bsd_scheduler;
+	/* Intra pictures may go to another ring than the one of their context */
+	int decode_spread_intra;
+
+	/* TIMESTAMP register ticks per second */
+	uint64_t timestamp_frequency;
+
 	unsigned int has_exec2  : 1; /* Flag: has execbuffer2? */
 	unsigned int has_bsd    : 1; /* Flag: has bitstream decoder for H.264? */
 	unsigned int has_blt    : 1; /* Flag: has BLT unit? */
 	unsigned int has_vebox  : 1; /* Flag: has VEBOX unit */
 	unsigned int has_bsd2   : 1; /* Flag: has the second BSD video ring unit */
 	unsigned int has_huc    : 1; /* Flag: has a fully loaded HuC firmware? */
+	unsigned int has_exec_fence : 1; /* Flag: can submissions return a sync_file? */
+	unsigned int has_llc    : 1; /* Flag: are CPU caches coherent with the GPU? */
 	unsigned int hybrid_vp8 : 1; /* Flag: User has enrolled in experimental VP8 encoding support. */
 	unsigned int rc_hw_mode : 1; /* Flag: User has enrolled in RateControlCounter */
 	unsigned int dec_base	: 1; /* Flag: User has enrolled in experimental VA_DEC_SLICE_MODE_BASE support  */
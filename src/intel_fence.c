@@ -0,0 +1,409 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <linux/sync_file.h>
+
+#include "intel_fence.h"
+
+/* ready fences taken from epoll per call */
+#define INTEL_COMPLETION_EVENTS 32
+
+void
+intel_fence_set_init(struct intel_fence_set *set)
+{
+	int i;
+
+	for (i = 0; i < INTEL_FENCE_SET_SIZE; i++)
+		set->fds[i] = -1;
+}
+
+void
+intel_fence_set_reset(struct intel_fence_set *set)
+{
+	int i;
+
+	for (i = 0; i < INTEL_FENCE_SET_SIZE; i++) {
+		if (set->fds[i] >= 0)
+			close(set->fds[i]);
+
+		set->fds[i] = -1;
+	}
+}
+
+void
+intel_fence_set_add(struct intel_fence_set *set, int slot, int fd)
+{
+	if (set->fds[slot] >= 0)
+		close(set->fds[slot]);
+
+	set->fds[slot] = fd;
+}
+
+int
+intel_fence_set_is_empty(const struct intel_fence_set *set)
+{
+	int i;
+
+	for (i = 0; i < INTEL_FENCE_SET_SIZE; i++) {
+		if (set->fds[i] >= 0)
+			return 0;
+	}
+
+	return 1;
+}
+
+int
+intel_fence_set_dup(struct intel_fence_set *dst, const struct intel_fence_set *src)
+{
+	int i, err;
+
+	for (i = 0; i < INTEL_FENCE_SET_SIZE; i++) {
+		if (src->fds[i] < 0)
+			continue;
+
+		dst->fds[i] = fcntl(src->fds[i], F_DUPFD_CLOEXEC, 0);
+		if (dst->fds[i] < 0) {
+			err = -errno;
+			intel_fence_set_reset(dst);
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+static uint64_t
+intel_fence_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Polls the pending fences for up to timeout_ms, dropping those signaled */
+static int
+intel_fence_set_poll_timeout(struct intel_fence_set *set, int timeout_ms)
+{
+	struct pollfd pfds[INTEL_FENCE_SET_SIZE];
+	int slots[INTEL_FENCE_SET_SIZE];
+	int i, n = 0, ret;
+
+	for (i = 0; i < INTEL_FENCE_SET_SIZE; i++) {
+		if (set->fds[i] < 0)
+			continue;
+
+		pfds[n].fd = set->fds[i];
+		pfds[n].events = POLLIN;
+		pfds[n].revents = 0;
+		slots[n++] = i;
+	}
+
+	if (!n)
+		return 0;
+
+	ret = poll(pfds, n, timeout_ms);
+	if (ret < 0)
+		return -errno;
+
+	/* errors signal too, there is nothing left to wait for */
+	for (i = 0; i < n; i++) {
+		if (pfds[i].revents) {
+			close(set->fds[slots[i]]);
+			set->fds[slots[i]] = -1;
+		}
+	}
+
+	return ret;
+}
+
+int
+intel_fence_set_poll(struct intel_fence_set *set)
+{
+	intel_fence_set_poll_timeout(set, 0);
+
+	return intel_fence_set_is_empty(set);
+}
+
+int
+intel_fence_set_wait(struct intel_fence_set *set, int64_t timeout_ns)
+{
+	uint64_t deadline = timeout_ns >= 0 ? intel_fence_now() + timeout_ns : 0;
+	uint64_t now;
+	int timeout_ms = -1;
+	int ret;
+
+	while (!intel_fence_set_is_empty(set)) {
+		if (timeout_ns >= 0) {
+			now = intel_fence_now();
+			timeout_ms = now < deadline ? (deadline - now + 999999) / 1000000 : 0;
+		}
+
+		ret = intel_fence_set_poll_timeout(set, timeout_ms);
+		if (ret == -EINTR)
+			continue;
+
+		if (ret < 0)
+			return ret;
+
+		if (ret == 0 && timeout_ms == 0)
+			return -ETIME;
+	}
+
+	return 0;
+}
+
+int
+intel_fence_set_export(const struct intel_fence_set *set)
+{
+	struct sync_merge_data merge;
+	int i, fd = -1;
+
+	for (i = 0; i < INTEL_FENCE_SET_SIZE; i++) {
+		if (set->fds[i] < 0)
+			continue;
+
+		if (fd < 0) {
+			fd = fcntl(set->fds[i], F_DUPFD_CLOEXEC, 0);
+			if (fd < 0)
+				return -errno;
+
+			continue;
+		}
+
+		memset(&merge, 0, sizeof(merge));
+		strcpy(merge.name, "i965 surface");
+		merge.fd2 = set->fds[i];
+
+		if (ioctl(fd, SYNC_IOC_MERGE, &merge) < 0) {
+			int err = -errno;
+
+			close(fd);
+			return err;
+		}
+
+		close(fd);
+		fd = merge.fence;
+	}
+
+	return fd < 0 ? -ENOENT : fd;
+}
+
+struct intel_completion_wait {
+	struct intel_completion *completion;
+	int fd;
+};
+
+struct intel_completion {
+	struct intel_completion *prev;
+	struct intel_completion *next;
+
+	intel_completion_func func;
+	void *data;
+
+	int num_waits;                      /* fences still pending */
+	struct intel_completion_wait waits[INTEL_FENCE_SET_SIZE];
+};
+
+int
+intel_completion_queue_init(struct intel_completion_queue *queue)
+{
+	queue->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (queue->epoll_fd < 0)
+		return -errno;
+
+	pthread_mutex_init(&queue->mutex, NULL);
+	queue->pending = NULL;
+	queue->num_pending = 0;
+
+	return 0;
+}
+
+static void
+intel_completion_free(struct intel_completion_queue *queue,
+					  struct intel_completion *completion)
+{
+	int i;
+
+	for (i = 0; i < INTEL_FENCE_SET_SIZE; i++) {
+		if (completion->waits[i].fd < 0)
+			continue;
+
+		epoll_ctl(queue->epoll_fd, EPOLL_CTL_DEL, completion->waits[i].fd, NULL);
+		close(completion->waits[i].fd);
+	}
+
+	free(completion);
+}
+
+void
+intel_completion_queue_fini(struct intel_completion_queue *queue)
+{
+	struct intel_completion *completion, *next;
+
+	if (queue->epoll_fd < 0)
+		return;
+
+	for (completion = queue->pending; completion; completion = next) {
+		next = completion->next;
+		intel_completion_free(queue, completion);
+	}
+
+	queue->pending = NULL;
+	queue->num_pending = 0;
+
+	close(queue->epoll_fd);
+	queue->epoll_fd = -1;
+	pthread_mutex_destroy(&queue->mutex);
+}
+
+int
+intel_completion_queue_add(struct intel_completion_queue *queue,
+						   const struct intel_fence_set *set,
+						   intel_completion_func func, void *data)
+{
+	struct intel_completion *completion;
+	struct epoll_event event;
+	int i, err;
+
+	if (intel_fence_set_is_empty(set)) {
+		func(data);
+		return 0;
+	}
+
+	completion = calloc(1, sizeof(*completion));
+	if (!completion)
+		return -ENOMEM;
+
+	completion->func = func;
+	completion->data = data;
+
+	for (i = 0; i < INTEL_FENCE_SET_SIZE; i++)
+		completion->waits[i].fd = -1;
+
+	pthread_mutex_lock(&queue->mutex);
+
+	for (i = 0; i < INTEL_FENCE_SET_SIZE; i++) {
+		if (set->fds[i] < 0)
+			continue;
+
+		completion->waits[i].completion = completion;
+		completion->waits[i].fd = fcntl(set->fds[i], F_DUPFD_CLOEXEC, 0);
+		if (completion->waits[i].fd < 0) {
+			err = -errno;
+			goto error;
+		}
+
+		event.events = EPOLLIN;
+		event.data.ptr = &completion->waits[i];
+		if (epoll_ctl(queue->epoll_fd, EPOLL_CTL_ADD, completion->waits[i].fd, &event) < 0) {
+			err = -errno;
+			close(completion->waits[i].fd);
+			completion->waits[i].fd = -1;
+			goto error;
+		}
+
+		completion->num_waits++;
+	}
+
+	completion->next = queue->pending;
+	if (queue->pending)
+		queue->pending->prev = completion;
+	queue->pending = completion;
+	queue->num_pending++;
+
+	pthread_mutex_unlock(&queue->mutex);
+
+	return 0;
+
+error:
+	intel_completion_free(queue, completion);
+	pthread_mutex_unlock(&queue->mutex);
+
+	return err;
+}
+
+int
+intel_completion_queue_dispatch(struct intel_completion_queue *queue)
+{
+	struct epoll_event events[INTEL_COMPLETION_EVENTS];
+	struct intel_completion_wait *wait;
+	struct intel_completion *completion, *ready = NULL;
+	int i, n, num_dispatched = 0;
+
+	pthread_mutex_lock(&queue->mutex);
+
+	do {
+		n = epoll_wait(queue->epoll_fd, events, INTEL_COMPLETION_EVENTS, 0);
+
+		for (i = 0; i < n; i++) {
+			wait = events[i].data.ptr;
+			completion = wait->completion;
+
+			epoll_ctl(queue->epoll_fd, EPOLL_CTL_DEL, wait->fd, NULL);
+			close(wait->fd);
+			wait->fd = -1;
+
+			if (--completion->num_waits > 0)
+				continue;
+
+			if (completion->prev)
+				completion->prev->next = completion->next;
+			else
+				queue->pending = completion->next;
+
+			if (completion->next)
+				completion->next->prev = completion->prev;
+
+			queue->num_pending--;
+
+			completion->next = ready;
+			ready = completion;
+		}
+	} while (n == INTEL_COMPLETION_EVENTS);
+
+	pthread_mutex_unlock(&queue->mutex);
+
+	/* without the lock, so that the callbacks may queue more */
+	while (ready) {
+		completion = ready;
+		ready = completion->next;
+
+		completion->func(completion->data);
+		free(completion);
+		num_dispatched++;
+	}
+
+	return num_dispatched;
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _INTEL_FENCE_H_
+#define _INTEL_FENCE_H_
+
+#include <pthread.h>
+#include <stdint.h>
+
+/*
+ * Completion tracking with pollable fence fds, sync_files from the
+ * I915_EXEC_FENCE_OUT submissions in the driver. Anything that becomes
+ * readable once signaled works, the tests use eventfds.
+ */
+
+/* A fence per engine: the submissions to one engine complete in order */
+#define INTEL_FENCE_SET_SIZE    8
+
+struct intel_fence_set {
+	int fds[INTEL_FENCE_SET_SIZE];      /* -1 when empty */
+};
+
+void
+intel_fence_set_init(struct intel_fence_set *set);
+
+/* Closes the fences */
+void
+intel_fence_set_reset(struct intel_fence_set *set);
+
+/* Takes fd over, replacing the previous fence of slot */
+void
+intel_fence_set_add(struct intel_fence_set *set, int slot, int fd);
+
+int
+intel_fence_set_is_empty(const struct intel_fence_set *set);
+
+/* Duplicates the fences of src into the empty dst, 0 or -errno */
+int
+intel_fence_set_dup(struct intel_fence_set *dst, const struct intel_fence_set *src);
+
+/*
+ * Drops the signaled fences without blocking, so the set only holds those
+ * still pending. Returns 1 when all have signaled.
+ */
+int
+intel_fence_set_poll(struct intel_fence_set *set);
+
+/* As intel_fence_set_poll(), for up to timeout_ns or forever if negative: 0 or -ETIME */
+int
+intel_fence_set_wait(struct intel_fence_set *set, int64_t timeout_ns);
+
+/*
+ * A single fence signaled with all those of the set, owned by the caller,
+ * or -errno. Several fences are merged, which needs sync_files.
+ */
+int
+intel_fence_set_export(const struct intel_fence_set *set);
+
+typedef void (*intel_completion_func)(void *data);
+
+struct intel_completion;
+
+/*
+ * Calls back once fence sets have signaled. The queue fd is an epoll fd,
+ * readable while a completion is ready to be dispatched, so that a single
+ * thread can poll it together with other fds.
+ */
+struct intel_completion_queue {
+	pthread_mutex_t mutex;
+	int epoll_fd;
+	struct intel_completion *pending;
+	int num_pending;
+};
+
+int
+intel_completion_queue_init(struct intel_completion_queue *queue);
+
+/* Pending completions are dropped without calling back */
+void
+intel_completion_queue_fini(struct intel_completion_queue *queue);
+
+/*
+ * Calls func with data once all the fences of set have signaled, right away
+ * if set is empty. The fences are duplicated. Returns 0 or -errno.
+ */
+int
+intel_completion_queue_add(struct intel_completion_queue *queue,
+						   const struct intel_fence_set *set,
+						   intel_completion_func func, void *data);
+
+static inline int
+intel_completion_queue_fd(const struct intel_completion_queue *queue)
+{
+	return queue->epoll_fd;
+}
+
+/* Calls back the completions whose fences have all signaled, without blocking */
+int
+intel_completion_queue_dispatch(struct intel_completion_queue *queue);
+
+#endif /* _INTEL_FENCE_H_ */
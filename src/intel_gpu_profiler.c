@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "intel_gpu_profiler.h"
+
+/* TIMESTAMP is 36 bits wide */
+#define TIMESTAMP_MASK  ((1ULL << 36) - 1)
+
+static const char *stage_names[INTEL_GPU_STAGE_COUNT] = {
+	[INTEL_GPU_STAGE_SCALING] = "scaling",
+	[INTEL_GPU_STAGE_ME] = "me",
+	[INTEL_GPU_STAGE_BRC_INIT] = "brc_init",
+	[INTEL_GPU_STAGE_BRC_UPDATE] = "brc_update",
+	[INTEL_GPU_STAGE_MBENC] = "mbenc",
+	[INTEL_GPU_STAGE_MPU] = "mpu",
+	[INTEL_GPU_STAGE_TPU] = "tpu",
+	[INTEL_GPU_STAGE_ENC_KERNEL] = "enc_kernel",
+	[INTEL_GPU_STAGE_PAK] = "pak",
+	[INTEL_GPU_STAGE_DECODE] = "decode",
+	[INTEL_GPU_STAGE_VPP] = "vpp",
+};
+
+const char *
+intel_gpu_stage_name(enum intel_gpu_stage stage)
+{
+	if (stage < 0 || stage >= INTEL_GPU_STAGE_COUNT)
+		return "unknown";
+
+	return stage_names[stage];
+}
+
+struct intel_gpu_profiler *
+intel_gpu_profiler_new(dri_bufmgr *bufmgr, uint64_t frequency)
+{
+	struct intel_gpu_profiler *profiler = calloc(1, sizeof(*profiler));
+	int i;
+
+	if (!profiler)
+		return NULL;
+
+	profiler->bufmgr = bufmgr;
+	profiler->frequency = frequency ? frequency : 12500000;
+
+	for (i = 0; i < INTEL_GPU_STAGE_COUNT; i++)
+		profiler->open[i] = -1;
+
+	return profiler;
+}
+
+void
+intel_gpu_profiler_free(struct intel_gpu_profiler *profiler)
+{
+	int i;
+
+	if (!profiler)
+		return;
+
+	for (i = 0; i < INTEL_GPU_PROFILER_DEPTH; i++)
+		dri_bo_unreference(profiler->queries[i].bo);
+
+	free(profiler);
+}
+
+static struct intel_gpu_profiler_queries *
+intel_gpu_profiler_current(struct intel_gpu_profiler *profiler)
+{
+	return &profiler->queries[(profiler->head + profiler->num_submitted) %
+							  INTEL_GPU_PROFILER_DEPTH];
+}
+
+int
+intel_gpu_profiler_begin(struct intel_gpu_profiler *profiler, enum intel_gpu_stage stage,
+						 dri_bo **bo, uint32_t *offset)
+{
+	struct intel_gpu_profiler_queries *queries = intel_gpu_profiler_current(profiler);
+	int index;
+
+	/* nested runs of the same stage count once */
+	if (profiler->open[stage] >= 0)
+		return 0;
+
+	if (queries->num_queries == INTEL_GPU_PROFILER_QUERIES) {
+		profiler->num_dropped++;
+		return 0;
+	}
+
+	if (!queries->bo) {
+		queries->bo = dri_bo_alloc(profiler->bufmgr,
+								   "gpu profiler queries",
+								   INTEL_GPU_PROFILER_QUERIES * INTEL_GPU_PROFILER_QUERY_SIZE,
+								   64);
+		if (!queries->bo)
+			return 0;
+	}
+
+	index = queries->num_queries++;
+	queries->stages[index] = stage;
+	profiler->open[stage] = index;
+
+	*bo = queries->bo;
+	*offset = index * INTEL_GPU_PROFILER_QUERY_SIZE;
+
+	return 1;
+}
+
+int
+intel_gpu_profiler_end(struct intel_gpu_profiler *profiler, enum intel_gpu_stage stage,
+					   dri_bo **bo, uint32_t *offset)
+{
+	int index = profiler->open[stage];
+
+	if (index < 0)
+		return 0;
+
+	profiler->open[stage] = -1;
+
+	*bo = intel_gpu_profiler_current(profiler)->bo;
+	*offset = index * INTEL_GPU_PROFILER_QUERY_SIZE + 8;
+
+	return 1;
+}
+
+static void
+intel_gpu_profiler_retire(struct intel_gpu_profiler *profiler)
+{
+	struct intel_gpu_profiler_queries *queries = &profiler->queries[profiler->head];
+	uint64_t timestamps[2 * INTEL_GPU_PROFILER_QUERIES];
+	const uint32_t *data;
+	int i;
+
+	dri_bo_map(queries->bo, 0);
+	data = queries->bo->virtual;
+
+	if (data) {
+		for (i = 0; i < 2 * queries->num_queries; i++)
+			timestamps[i] = data[2 * i] | (uint64_t)data[2 * i + 1] << 32;
+
+		intel_gpu_profiler_account(profiler, queries->stages, timestamps, queries->num_queries);
+	} else
+		profiler->num_dropped += queries->num_queries;
+
+	dri_bo_unmap(queries->bo);
+
+	queries->num_queries = 0;
+	profiler->head = (profiler->head + 1) % INTEL_GPU_PROFILER_DEPTH;
+	profiler->num_submitted--;
+}
+
+void
+intel_gpu_profiler_submit(struct intel_gpu_profiler *profiler)
+{
+	struct intel_gpu_profiler_queries *queries = intel_gpu_profiler_current(profiler);
+	int i;
+
+	if (queries->num_queries) {
+		/* a stage can't span two submissions */
+		for (i = 0; i < INTEL_GPU_STAGE_COUNT; i++) {
+			if (profiler->open[i] >= 0) {
+				queries->stages[profiler->open[i]] = INTEL_GPU_STAGE_COUNT;
+				profiler->open[i] = -1;
+				profiler->num_dropped++;
+			}
+		}
+
+		profiler->num_submitted++;
+	}
+
+	while (profiler->num_submitted > 0 &&
+		   !drm_intel_bo_busy(profiler->queries[profiler->head].bo))
+		intel_gpu_profiler_retire(profiler);
+
+	/* all the buffers are in flight, wait for the oldest one */
+	if (profiler->num_submitted == INTEL_GPU_PROFILER_DEPTH)
+		intel_gpu_profiler_retire(profiler);
+}
+
+void
+intel_gpu_profiler_wait(struct intel_gpu_profiler *profiler)
+{
+	while (profiler->num_submitted > 0)
+		intel_gpu_profiler_retire(profiler);
+}
+
+static uint64_t
+intel_gpu_profiler_ticks_to_ns(struct intel_gpu_profiler *profiler, uint64_t ticks)
+{
+	const uint64_t frequency = profiler->frequency;
+
+	/* split so that ticks * 10^9 doesn't overflow */
+	return ticks / frequency * 1000000000ULL +
+		   ticks % frequency * 1000000000ULL / frequency;
+}
+
+static void
+intel_gpu_stage_stats_add(struct intel_gpu_stage_stats *stats, uint64_t ns)
+{
+	uint64_t us = ns / 1000;
+	int bucket = us ? 64 - __builtin_clzll(us) : 0;
+
+	if (!stats->count || ns < stats->min_ns)
+		stats->min_ns = ns;
+
+	if (ns > stats->max_ns)
+		stats->max_ns = ns;
+
+	stats->count++;
+	stats->total_ns += ns;
+	stats->histogram[bucket < INTEL_GPU_PROFILER_BUCKETS ? bucket : INTEL_GPU_PROFILER_BUCKETS - 1]++;
+}
+
+void
+intel_gpu_profiler_account(struct intel_gpu_profiler *profiler, const uint8_t *stages,
+						   const uint64_t *timestamps, int num_queries)
+{
+	uint64_t ticks;
+	int i;
+
+	for (i = 0; i < num_queries; i++) {
+		/* unfinished, already counted as dropped */
+		if (stages[i] >= INTEL_GPU_STAGE_COUNT)
+			continue;
+
+		ticks = (timestamps[2 * i + 1] - timestamps[2 * i]) & TIMESTAMP_MASK;
+		intel_gpu_stage_stats_add(&profiler->stats[stages[i]],
+								  intel_gpu_profiler_ticks_to_ns(profiler, ticks));
+	}
+}
+
+void
+intel_gpu_profiler_dump(struct intel_gpu_profiler *profiler, FILE *fp, const char *name)
+{
+	const struct intel_gpu_stage_stats *stats;
+	uint64_t count = 0;
+	int i, j;
+
+	for (i = 0; i < INTEL_GPU_STAGE_COUNT; i++)
+		count += profiler->stats[i].count;
+
+	if (!count && !profiler->num_dropped)
+		return;
+
+	fprintf(fp, "i965: GPU profile of the %s batch, %llu stages dropped\n",
+			name, (unsigned long long)profiler->num_dropped);
+
+	for (i = 0; i < INTEL_GPU_STAGE_COUNT; i++) {
+		stats = &profiler->stats[i];
+
+		if (!stats->count)
+			continue;
+
+		fprintf(fp, "  %-10s %8llu runs, avg %9.1f us, min %9.1f us, max %9.1f us\n",
+				intel_gpu_stage_name(i),
+				(unsigned long long)stats->count,
+				stats->total_ns / 1000.0 / stats->count,
+				stats->min_ns / 1000.0,
+				stats->max_ns / 1000.0);
+
+		fprintf(fp, "  %-10s", "");
+		for (j = 0; j < INTEL_GPU_PROFILER_BUCKETS; j++) {
+			if (!stats->histogram[j])
+				continue;
+
+			if (j == 0)
+				fprintf(fp, " <1us:%llu", (unsigned long long)stats->histogram[j]);
+			else if (j == INTEL_GPU_PROFILER_BUCKETS - 1)
+				fprintf(fp, " >=%lluus:%llu", 1ULL << (j - 1),
+						(unsigned long long)stats->histogram[j]);
+			else
+				fprintf(fp, " %lluus:%llu", 1ULL << (j - 1),
+						(unsigned long long)stats->histogram[j]);
+		}
+		fprintf(fp, "\n");
+	}
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _INTEL_GPU_PROFILER_H_
+#define _INTEL_GPU_PROFILER_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <intel_bufmgr.h>
+
+/*
+ * GPU time of the pipeline stages, enabled with VA_INTEL_DEBUG=32.
+ *
+ * Each stage is bracketed in the batch with stores of the ring TIMESTAMP
+ * register into a query buffer. Submitted query buffers are read back once
+ * the GPU has retired them, without waiting, and the durations accumulate
+ * into per stage histograms that are dumped when the batch is freed.
+ */
+
+enum intel_gpu_stage {
+	INTEL_GPU_STAGE_SCALING = 0,
+	INTEL_GPU_STAGE_ME,
+	INTEL_GPU_STAGE_BRC_INIT,
+	INTEL_GPU_STAGE_BRC_UPDATE,
+	INTEL_GPU_STAGE_MBENC,
+	INTEL_GPU_STAGE_MPU,
+	INTEL_GPU_STAGE_TPU,
+	INTEL_GPU_STAGE_ENC_KERNEL,         /* any other encoder kernel */
+	INTEL_GPU_STAGE_PAK,
+	INTEL_GPU_STAGE_DECODE,
+	INTEL_GPU_STAGE_VPP,
+	INTEL_GPU_STAGE_COUNT
+};
+
+#define INTEL_GPU_PROFILER_QUERIES      64      /* stages per query buffer */
+#define INTEL_GPU_PROFILER_DEPTH        4       /* query buffers in flight */
+#define INTEL_GPU_PROFILER_BUCKETS      16      /* [2^(i-1), 2^i) us, the last is open */
+
+/* Begin and end timestamps, each stored as two dwords */
+#define INTEL_GPU_PROFILER_QUERY_SIZE   16
+
+struct intel_gpu_stage_stats {
+	uint64_t count;
+	uint64_t total_ns;
+	uint64_t min_ns;
+	uint64_t max_ns;
+	uint64_t histogram[INTEL_GPU_PROFILER_BUCKETS];
+};
+
+struct intel_gpu_profiler_queries {
+	dri_bo *bo;
+	int num_queries;
+	uint8_t stages[INTEL_GPU_PROFILER_QUERIES];
+};
+
+struct intel_gpu_profiler {
+	dri_bufmgr *bufmgr;
+	uint64_t frequency;                 /* timestamp ticks per second */
+
+	/* submitted buffers from head, followed by the one being filled */
+	struct intel_gpu_profiler_queries queries[INTEL_GPU_PROFILER_DEPTH];
+	int head;
+	int num_submitted;
+
+	/* query of each stage begun in the current buffer, or -1 */
+	int open[INTEL_GPU_STAGE_COUNT];
+
+	struct intel_gpu_stage_stats stats[INTEL_GPU_STAGE_COUNT];
+	uint64_t num_dropped;
+};
+
+const char *
+intel_gpu_stage_name(enum intel_gpu_stage stage);
+
+struct intel_gpu_profiler *
+intel_gpu_profiler_new(dri_bufmgr *bufmgr, uint64_t frequency);
+
+void
+intel_gpu_profiler_free(struct intel_gpu_profiler *profiler);
+
+/*
+ * Reserve the location the begin and the end timestamp of stage are to be
+ * stored at. Return 0 when the stage can't be profiled, e.g. the query
+ * buffer is full or end comes without begin, nothing should be emitted then.
+ */
+int
+intel_gpu_profiler_begin(struct intel_gpu_profiler *profiler, enum intel_gpu_stage stage,
+						 dri_bo **bo, uint32_t *offset);
+
+int
+intel_gpu_profiler_end(struct intel_gpu_profiler *profiler, enum intel_gpu_stage stage,
+					   dri_bo **bo, uint32_t *offset);
+
+/*
+ * Called after each submission: queues the current query buffer and reads
+ * back those the GPU has retired.
+ */
+void
+intel_gpu_profiler_submit(struct intel_gpu_profiler *profiler);
+
+/* Reads back all the submitted query buffers, waiting for the GPU */
+void
+intel_gpu_profiler_wait(struct intel_gpu_profiler *profiler);
+
+/* Accounts num_queries begin/end timestamp pairs read back from the GPU */
+void
+intel_gpu_profiler_account(struct intel_gpu_profiler *profiler, const uint8_t *stages,
+						   const uint64_t *timestamps, int num_queries);
+
+void
+intel_gpu_profiler_dump(struct intel_gpu_profiler *profiler, FILE *fp, const char *name);
+
+#endif /* _INTEL_GPU_PROFILER_H_ */
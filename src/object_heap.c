@@ -34,6 +34,59 @@
 #define LAST_FREE   -1
 #define ALLOCATED   -2
 
+static int object_heap_shard_counter = 0;
+static __thread int object_heap_shard_index = -1;
+
+static INLINE object_base_p
+object_heap_get_object(void **bucket, object_heap_p heap, int index)
+{
+	int bucket_index = index / heap->heap_increment;
+	int obj_index = index % heap->heap_increment;
+
+	return (object_base_p)(bucket[bucket_index] + obj_index * heap->object_size);
+}
+
+/*
+ * Returns the free list shard of the calling thread
+ */
+static struct object_heap_shard *
+object_heap_get_shard(object_heap_p heap)
+{
+	if (object_heap_shard_index < 0)
+		object_heap_shard_index = __atomic_fetch_add(&object_heap_shard_counter, 1,
+								  __ATOMIC_RELAXED) % OBJECT_HEAP_NUM_SHARDS;
+
+	return &heap->shards[object_heap_shard_index];
+}
+
+/*
+ * Moves the objects cached on all shards back onto the shared free list,
+ * the heap mutex must be held
+ */
+static void object_heap_reclaim_shards(object_heap_p heap)
+{
+	int i;
+
+	for (i = 0; i < OBJECT_HEAP_NUM_SHARDS; i++) {
+		struct object_heap_shard *shard = &heap->shards[i];
+		int next_free;
+
+		_i965LockMutex(&shard->mutex);
+		next_free = shard->next_free;
+		while (next_free != LAST_FREE) {
+			object_base_p obj = object_heap_get_object(heap->bucket, heap, next_free);
+			int index = next_free;
+
+			next_free = obj->next_free;
+			__atomic_store_n(&obj->next_free, heap->next_free, __ATOMIC_RELAXED);
+			heap->next_free = index;
+		}
+		shard->next_free = LAST_FREE;
+		shard->num_free = 0;
+		_i965UnlockMutex(&shard->mutex);
+	}
+}
+
 /*
  * Expands the heap
  * Return 0 on success, -1 on error
@@ -46,17 +99,36 @@ static int object_heap_expand(object_heap_p heap)
 	int new_heap_size = heap->heap_size + heap->heap_increment;
 	int bucket_index = new_heap_size / heap->heap_increment - 1;
 
+	if (new_heap_size - 1 > OBJECT_HEAP_INDEX_MASK)
+		return -1;
+
 	if (bucket_index >= heap->num_buckets) {
-		int new_num_buckets = heap->num_buckets + 8;
+		int new_num_buckets = heap->num_buckets ? heap->num_buckets * 2 : 8;
+		void ***new_retired;
 		void **new_bucket;
 
-		new_bucket = realloc(heap->bucket, new_num_buckets * sizeof(void *));
+		/* The old table can't be realloc()ed since lookups don't take the
+		 * heap mutex, build a new one and retire the old one instead */
+		new_bucket = malloc(new_num_buckets * sizeof(void *));
 		if (NULL == new_bucket) {
 			return -1;
 		}
 
+		if (heap->bucket) {
+			new_retired = realloc(heap->retired_buckets,
+								  (heap->num_retired_buckets + 1) * sizeof(void **));
+			if (NULL == new_retired) {
+				free(new_bucket);
+				return -1;
+			}
+
+			heap->retired_buckets = new_retired;
+			heap->retired_buckets[heap->num_retired_buckets++] = heap->bucket;
+			memcpy(new_bucket, heap->bucket, heap->num_buckets * sizeof(void *));
+		}
+
 		heap->num_buckets = new_num_buckets;
-		heap->bucket = new_bucket;
+		__atomic_store_n(&heap->bucket, new_bucket, __ATOMIC_RELEASE);
 	}
 
 	new_heap_index = (void *) malloc(heap->heap_increment * heap->object_size);
@@ -73,7 +145,9 @@ static int object_heap_expand(object_heap_p heap)
 		next_free = i;
 	}
 	heap->next_free = next_free;
-	heap->heap_size = new_heap_size;
+
+	/* Publish the new objects only after the bucket is in place */
+	__atomic_store_n(&heap->heap_size, new_heap_size, __ATOMIC_RELEASE);
 	return 0; /* Success */
 }
 
@@ -82,6 +156,8 @@ static int object_heap_expand(object_heap_p heap)
  */
 int object_heap_init(object_heap_p heap, int object_size, int id_offset)
 {
+	int i;
+
 	heap->object_size = object_size;
 	heap->id_offset = id_offset & OBJECT_HEAP_OFFSET_MASK;
 	heap->heap_size = 0;
@@ -89,10 +165,21 @@ int object_heap_init(object_heap_p heap, int object_size, int id_offset)
 	heap->next_free = LAST_FREE;
 	heap->num_buckets = 0;
 	heap->bucket = NULL;
+	heap->retired_buckets = NULL;
+	heap->num_retired_buckets = 0;
+
+	for (i = 0; i < OBJECT_HEAP_NUM_SHARDS; i++) {
+		heap->shards[i].next_free = LAST_FREE;
+		heap->shards[i].num_free = 0;
+	}
 
 	if (object_heap_expand(heap) == 0) {
 		ASSERT(heap->heap_size);
 		_i965InitMutex(&heap->mutex);
+
+		for (i = 0; i < OBJECT_HEAP_NUM_SHARDS; i++)
+			_i965InitMutex(&heap->shards[i].mutex);
+
 		return 0;
 	} else {
 		ASSERT(!heap->heap_size);
@@ -110,26 +197,38 @@ int object_heap_init(object_heap_p heap, int object_size, int id_offset)
  */
 int object_heap_allocate(object_heap_p heap)
 {
-	object_base_p obj;
-	int bucket_index, obj_index;
-
-	_i965LockMutex(&heap->mutex);
-	if (LAST_FREE == heap->next_free) {
-		if (-1 == object_heap_expand(heap)) {
-			_i965UnlockMutex(&heap->mutex);
-			return -1; /* Out of memory */
-		}
+	struct object_heap_shard *shard = object_heap_get_shard(heap);
+	object_base_p obj = NULL;
+
+	/* Fast path, recycle an object freed on this shard */
+	_i965LockMutex(&shard->mutex);
+	if (LAST_FREE != shard->next_free) {
+		obj = object_heap_get_object(__atomic_load_n(&heap->bucket, __ATOMIC_ACQUIRE),
+									 heap, shard->next_free);
+		shard->next_free = obj->next_free;
+		shard->num_free--;
 	}
-	ASSERT(heap->next_free >= 0);
+	_i965UnlockMutex(&shard->mutex);
 
-	bucket_index = heap->next_free / heap->heap_increment;
-	obj_index = heap->next_free % heap->heap_increment;
+	if (NULL == obj) {
+		_i965LockMutex(&heap->mutex);
+		if (LAST_FREE == heap->next_free)
+			object_heap_reclaim_shards(heap);
+
+		if (LAST_FREE == heap->next_free) {
+			if (-1 == object_heap_expand(heap)) {
+				_i965UnlockMutex(&heap->mutex);
+				return -1; /* Out of memory */
+			}
+		}
+		ASSERT(heap->next_free >= 0);
 
-	obj = (object_base_p)(heap->bucket[bucket_index] + obj_index * heap->object_size);
-	heap->next_free = obj->next_free;
-	_i965UnlockMutex(&heap->mutex);
+		obj = object_heap_get_object(heap->bucket, heap, heap->next_free);
+		heap->next_free = obj->next_free;
+		_i965UnlockMutex(&heap->mutex);
+	}
 
-	obj->next_free = ALLOCATED;
+	__atomic_store_n(&obj->next_free, ALLOCATED, __ATOMIC_RELEASE);
 	return obj->id;
 }
 
@@ -140,21 +239,26 @@ int object_heap_allocate(object_heap_p heap)
 object_base_p object_heap_lookup(object_heap_p heap, int id)
 {
 	object_base_p obj;
-	int bucket_index, obj_index;
+	void **bucket;
+	int index;
 
-	_i965LockMutex(&heap->mutex);
-	if ((id < heap->id_offset) || (id > (heap->heap_size + heap->id_offset))) {
-		_i965UnlockMutex(&heap->mutex);
+	if ((id & ~OBJECT_HEAP_ID_MASK) != heap->id_offset)
 		return NULL;
-	}
-	id &= OBJECT_HEAP_ID_MASK;
-	bucket_index = id / heap->heap_increment;
-	obj_index = id % heap->heap_increment;
-	obj = (object_base_p)(heap->bucket[bucket_index] + obj_index * heap->object_size);
-	_i965UnlockMutex(&heap->mutex);
+
+	index = id & OBJECT_HEAP_INDEX_MASK;
+	if (index >= __atomic_load_n(&heap->heap_size, __ATOMIC_ACQUIRE))
+		return NULL;
+
+	bucket = __atomic_load_n(&heap->bucket, __ATOMIC_ACQUIRE);
+	obj = object_heap_get_object(bucket, heap, index);
 
 	/* Check if the object has in fact been allocated */
-	if (obj->next_free != ALLOCATED) {
+	if (__atomic_load_n(&obj->next_free, __ATOMIC_ACQUIRE) != ALLOCATED) {
+		return NULL;
+	}
+
+	/* and that the slot hasn't been recycled since the ID was handed out */
+	if (__atomic_load_n(&obj->id, __ATOMIC_RELAXED) != id) {
 		return NULL;
 	}
 	return obj;
@@ -178,14 +282,10 @@ object_base_p object_heap_next(object_heap_p heap, object_heap_iterator *iter)
 {
 	object_base_p obj;
 	int i = *iter + 1;
-	int bucket_index, obj_index;
 
 	_i965LockMutex(&heap->mutex);
 	while (i < heap->heap_size) {
-		bucket_index = i / heap->heap_increment;
-		obj_index = i % heap->heap_increment;
-
-		obj = (object_base_p)(heap->bucket[bucket_index] + obj_index * heap->object_size);
+		obj = object_heap_get_object(heap->bucket, heap, i);
 		if (obj->next_free == ALLOCATED) {
 			_i965UnlockMutex(&heap->mutex);
 			*iter = i;
@@ -207,13 +307,26 @@ void object_heap_free(object_heap_p heap, object_base_p obj)
 {
 	/* Don't complain about NULL pointers */
 	if (NULL != obj) {
+		struct object_heap_shard *shard = object_heap_get_shard(heap);
+		int index = obj->id & OBJECT_HEAP_INDEX_MASK;
+		int gen = ((obj->id & OBJECT_HEAP_GEN_MASK) >> OBJECT_HEAP_GEN_SHIFT) + 1;
+
 		/* Check if the object has in fact been allocated */
 		ASSERT(obj->next_free == ALLOCATED);
 
-		_i965LockMutex(&heap->mutex);
-		obj->next_free = heap->next_free;
-		heap->next_free = obj->id & OBJECT_HEAP_ID_MASK;
-		_i965UnlockMutex(&heap->mutex);
+		/* Bump the generation first so that a concurrent lookup with the
+		 * old ID fails once the slot gets recycled */
+		__atomic_store_n(&obj->id,
+						 heap->id_offset |
+						 ((gen << OBJECT_HEAP_GEN_SHIFT) & OBJECT_HEAP_GEN_MASK) |
+						 index,
+						 __ATOMIC_RELAXED);
+
+		_i965LockMutex(&shard->mutex);
+		__atomic_store_n(&obj->next_free, shard->next_free, __ATOMIC_RELEASE);
+		shard->next_free = index;
+		shard->num_free++;
+		_i965UnlockMutex(&shard->mutex);
 	}
 }
 
@@ -224,17 +337,17 @@ void object_heap_destroy(object_heap_p heap)
 {
 	object_base_p obj;
 	int i;
-	int bucket_index, obj_index;
 
 	if (heap->heap_size) {
 		_i965DestroyMutex(&heap->mutex);
 
+		for (i = 0; i < OBJECT_HEAP_NUM_SHARDS; i++)
+			_i965DestroyMutex(&heap->shards[i].mutex);
+
 		/* Check if heap is empty */
 		for (i = 0; i < heap->heap_size; i++) {
 			/* Check if object is not still allocated */
-			bucket_index = i / heap->heap_increment;
-			obj_index = i % heap->heap_increment;
-			obj = (object_base_p)(heap->bucket[bucket_index] + obj_index * heap->object_size);
+			obj = object_heap_get_object(heap->bucket, heap, i);
 			ASSERT(obj->next_free != ALLOCATED);
 		}
 
@@ -243,9 +356,21 @@ void object_heap_destroy(object_heap_p heap)
 		}
 
 		free(heap->bucket);
+
+		for (i = 0; i < heap->num_retired_buckets; i++)
+			free(heap->retired_buckets[i]);
+
+		free(heap->retired_buckets);
 	}
 
 	heap->bucket = NULL;
+	heap->retired_buckets = NULL;
+	heap->num_retired_buckets = 0;
 	heap->heap_size = 0;
 	heap->next_free = LAST_FREE;
+
+	for (i = 0; i < OBJECT_HEAP_NUM_SHARDS; i++) {
+		heap->shards[i].next_free = LAST_FREE;
+		heap->shards[i].num_free = 0;
+	}
 }
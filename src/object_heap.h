@@ -30,6 +30,17 @@
 #define OBJECT_HEAP_OFFSET_MASK     0x7F000000
 #define OBJECT_HEAP_ID_MASK         0x00FFFFFF
 
+/*
+ * The low bits of an object ID index the object slot, the upper bits of
+ * OBJECT_HEAP_ID_MASK carry a generation count that is bumped whenever the
+ * slot is freed, so a stale ID doesn't resolve to a recycled object.
+ */
+#define OBJECT_HEAP_INDEX_MASK      0x000FFFFF
+#define OBJECT_HEAP_GEN_MASK        0x00F00000
+#define OBJECT_HEAP_GEN_SHIFT       20
+
+#define OBJECT_HEAP_NUM_SHARDS      8
+
 typedef struct object_base *object_base_p;
 typedef struct object_heap *object_heap_p;
 
@@ -38,6 +49,16 @@ struct object_base {
 	int next_free;
 };
 
+/*
+ * Per-thread free list, objects freed by a thread are recycled by the
+ * threads mapped onto the same shard before the shared free list is used.
+ */
+struct object_heap_shard {
+	_I965Mutex mutex;
+	int next_free;
+	int num_free;
+};
+
 struct object_heap {
 	int object_size;
 	int id_offset;
@@ -47,6 +68,13 @@ struct object_heap {
 	_I965Mutex mutex;
 	void **bucket;
 	int num_buckets;
+
+	/* Bucket tables replaced on expansion, a lookup running without the
+	 * lock may still walk them so they are only released on destroy */
+	void ***retired_buckets;
+	int num_retired_buckets;
+
+	struct object_heap_shard shards[OBJECT_HEAP_NUM_SHARDS];
 };
 
 typedef int object_heap_iterator;
@@ -63,7 +91,7 @@ int object_heap_init(object_heap_p heap, int object_size, int id_offset);
 int object_heap_allocate(object_heap_p heap);
 
 /*
- * Lookup an allocated object by object ID
+ * Lookup an allocated object by object ID, this never blocks
  * Returns a pointer to the object on success, returns NULL on error
  */
 object_base_p object_heap_lookup(object_heap_p heap, int id);
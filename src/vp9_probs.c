@@ -42,6 +42,7 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
+#include <pthread.h>
 #include "vp9_probs.h"
 #include "i965_drv_video.h"
 #include <stdlib.h>
@@ -588,6 +589,50 @@ void intel_init_default_vp9_probs(FRAME_CONTEXT *frame_context)
 	return;
 }
 
+static FRAME_CONTEXT vp9_key_frame_context;
+static FRAME_CONTEXT vp9_inter_frame_context;
+static pthread_once_t vp9_default_frame_contexts_once = PTHREAD_ONCE_INIT;
+
+static void intel_init_default_vp9_frame_contexts(void)
+{
+	FRAME_CONTEXT *key = &vp9_key_frame_context;
+
+	intel_init_default_vp9_probs(&vp9_inter_frame_context);
+
+	/* the key frame context leaves out all of the inter probabilities */
+	key->tx_probs = default_tx_probs;
+	memcpy(key->coeff_probs4x4, default_coef_probs_4x4,
+		   sizeof(default_coef_probs_4x4));
+	memcpy(key->coeff_probs8x8, default_coef_probs_8x8,
+		   sizeof(default_coef_probs_8x8));
+	memcpy(key->coeff_probs16x16, default_coef_probs_16x16,
+		   sizeof(default_coef_probs_16x16));
+	memcpy(key->coeff_probs32x32, default_coef_probs_32x32,
+		   sizeof(default_coef_probs_32x32));
+	memcpy(key->skip_probs, default_skip_probs,
+		   sizeof(default_skip_probs));
+	memcpy(key->partition_prob, vp9_kf_partition_probs,
+		   sizeof(vp9_kf_partition_probs));
+	memcpy(key->uv_mode_prob, vp9_kf_uv_mode_prob,
+		   sizeof(vp9_kf_uv_mode_prob));
+	memcpy(key->seg_tree_probs, default_seg_tree_probs,
+		   sizeof(default_seg_tree_probs));
+	memcpy(key->seg_pred_probs, default_seg_pred_probs,
+		   sizeof(default_seg_pred_probs));
+}
+
+/*
+ * The default contexts are built once per process in the layout of the
+ * HCP probability buffer, decoder contexts share them read-only.
+ */
+const FRAME_CONTEXT *intel_vp9_default_frame_context(bool key_frame)
+{
+	pthread_once(&vp9_default_frame_contexts_once,
+				 intel_init_default_vp9_frame_contexts);
+
+	return key_frame ? &vp9_key_frame_context : &vp9_inter_frame_context;
+}
+
 
 void intel_vp9_copy_frame_context(FRAME_CONTEXT *dst,
 								  FRAME_CONTEXT *src,
@@ -203,6 +203,8 @@ extern vp9_prob default_coef_probs_32x32[COEFF_PROB_SIZE][COEFF_PROB_NUM];
 
 extern void intel_init_default_vp9_probs(FRAME_CONTEXT *frame_context);
 
+extern const FRAME_CONTEXT *intel_vp9_default_frame_context(bool key_frame);
+
 extern void intel_vp9_copy_frame_context(FRAME_CONTEXT *dst,
 										 FRAME_CONTEXT *src,
 										 bool inter_flag);
@@ -0,0 +1,694 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+#include "i965_internal_decl.h"
+
+extern "C" {
+    #include "gen6_mfc.h"
+    #include "i965_bit_writer.h"
+    #include "i965_encoder_utils.h"
+
+    void binarize_vp8_frame_header(VAEncSequenceParameterBufferVP8 *,
+        VAEncPictureParameterBufferVP8 *, VAQMatrixBufferVP8 *,
+        struct gen6_mfc_context *, struct intel_encoder_context *,
+        unsigned char *, int);
+}
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace {
+
+// The growable dword writer the header builders used before, kept as the
+// reference the new writer has to match bit for bit.
+class LegacyWriter
+{
+public:
+    LegacyWriter() : buffer(1024, 0), bitOffset(0) { }
+
+    void putUi(unsigned int val, int sizeInBits)
+    {
+        int pos = bitOffset >> 5;
+        int bitLeft = 32 - (bitOffset & 0x1f);
+
+        if (!sizeInBits)
+            return;
+
+        if (sizeInBits < 32)
+            val &= (1U << sizeInBits) - 1;
+
+        bitOffset += sizeInBits;
+
+        if (bitLeft > sizeInBits) {
+            buffer[pos] = buffer[pos] << sizeInBits | val;
+        } else {
+            sizeInBits -= bitLeft;
+            if (bitLeft == 32)
+                buffer[pos] = val;
+            else
+                buffer[pos] = (buffer[pos] << bitLeft) | (val >> sizeInBits);
+            buffer[pos] = swap32(buffer[pos]);
+
+            if (pos + 2 > (int)buffer.size())
+                buffer.resize(buffer.size() * 2, 0);
+
+            buffer[pos + 1] = val;
+        }
+    }
+
+    void putUe(unsigned int val)
+    {
+        int sizeInBits = 0;
+        unsigned int tmp = ++val;
+
+        while (tmp) {
+            tmp >>= 1;
+            sizeInBits++;
+        }
+
+        putUi(0, sizeInBits - 1);
+        putUi(val, sizeInBits);
+    }
+
+    void putSe(int val)
+    {
+        putUe(val <= 0 ? -2 * val : 2 * val - 1);
+    }
+
+    void byteAligning(int bit)
+    {
+        int bitLeft = 8 - (bitOffset & 0x7);
+
+        if (bitLeft == 8)
+            return;
+
+        putUi(bit ? (1U << bitLeft) - 1 : 0, bitLeft);
+    }
+
+    unsigned int end()
+    {
+        int pos = bitOffset >> 5;
+        int bitLeft = 32 - (bitOffset & 0x1f);
+
+        if (bitLeft != 32)
+            buffer[pos] = swap32(buffer[pos] << bitLeft);
+
+        return bitOffset;
+    }
+
+    const uint8_t *data() const
+    {
+        return reinterpret_cast<const uint8_t *>(buffer.data());
+    }
+
+private:
+    static unsigned int swap32(unsigned int val)
+    {
+        return __builtin_bswap32(val);
+    }
+
+    std::vector<unsigned int> buffer;
+    int bitOffset;
+};
+
+enum OpType { OP_UI, OP_UE, OP_SE, OP_ALIGN };
+
+struct Op
+{
+    OpType type;
+    unsigned int val;
+    int size;
+};
+
+// Roughly the mix of a slice header, mostly short fixed and Exp-Golomb
+// fields with the odd long one.
+std::vector<Op> randomOps(unsigned int seed, size_t count)
+{
+    std::vector<Op> ops;
+
+    srand(seed);
+    for (size_t i = 0; i < count; i++) {
+        Op op;
+
+        op.type = OpType(rand() % 4);
+        op.size = 1 + rand() % 32;
+        op.val = (unsigned int)rand() << 16 ^ rand();
+
+        switch (op.type) {
+        case OP_UI:
+            if (rand() % 4)
+                op.size = 1 + rand() % 8;
+            break;
+        case OP_UE:
+            /* the legacy writer cannot code 0xffffffff */
+            op.val >>= rand() % 32;
+            if (op.val == 0xffffffff)
+                op.val--;
+            break;
+        case OP_SE:
+            op.val = (int)(op.val >> (1 + rand() % 31)) - (1 << 15);
+            break;
+        case OP_ALIGN:
+            op.val &= 1;
+            break;
+        }
+        ops.push_back(op);
+    }
+
+    return ops;
+}
+
+void replay(LegacyWriter &lw, const std::vector<Op> &ops)
+{
+    for (const Op &op : ops) {
+        switch (op.type) {
+        case OP_UI: lw.putUi(op.val, op.size); break;
+        case OP_UE: lw.putUe(op.val); break;
+        case OP_SE: lw.putSe((int)op.val); break;
+        case OP_ALIGN: lw.byteAligning(op.val); break;
+        }
+    }
+}
+
+void replay(struct i965_bit_writer *bw, const std::vector<Op> &ops)
+{
+    for (const Op &op : ops) {
+        switch (op.type) {
+        case OP_UI: i965_bit_writer_put_ui(bw, op.val, op.size); break;
+        case OP_UE: i965_bit_writer_put_ue(bw, op.val); break;
+        case OP_SE: i965_bit_writer_put_se(bw, (int)op.val); break;
+        case OP_ALIGN: i965_bit_writer_byte_aligning(bw, op.val); break;
+        }
+    }
+}
+
+std::vector<uint8_t> writeUe(unsigned int val, unsigned int *bits)
+{
+    std::vector<uint8_t> out(16, 0xa5);
+    struct i965_bit_writer bw;
+
+    i965_bit_writer_init(&bw, out.data(), out.size());
+    i965_bit_writer_put_ue(&bw, val);
+    *bits = i965_bit_writer_flush(&bw);
+
+    return out;
+}
+
+// Fixed builder inputs. The expected headers below are the output of the
+// dword writer based builders the driver had before i965_bit_writer.
+void avcSlice(int n, VAEncSequenceParameterBufferH264 &sps,
+    VAEncPictureParameterBufferH264 &pic, VAEncSliceParameterBufferH264 &slice)
+{
+    sps = VAEncSequenceParameterBufferH264();
+    pic = VAEncPictureParameterBufferH264();
+    slice = VAEncSliceParameterBufferH264();
+
+    sps.seq_fields.bits.frame_mbs_only_flag = 1;
+    sps.seq_fields.bits.log2_max_pic_order_cnt_lsb_minus4 = 2;
+
+    switch (n) {
+    case 0:                                   // IDR I slice, CABAC
+        pic.pic_fields.bits.idr_pic_flag = 1;
+        pic.pic_fields.bits.reference_pic_flag = 1;
+        pic.pic_fields.bits.entropy_coding_mode_flag = 1;
+        pic.pic_fields.bits.deblocking_filter_control_present_flag = 1;
+        slice.slice_type = 2;
+        slice.idr_pic_id = 1;
+        slice.slice_qp_delta = -3;
+        slice.slice_alpha_c0_offset_div2 = 1;
+        slice.slice_beta_offset_div2 = -2;
+        break;
+    case 1:                                   // reference P slice, CAVLC
+        pic.frame_num = 5;
+        pic.CurrPic.TopFieldOrderCnt = 10;
+        pic.pic_fields.bits.reference_pic_flag = 1;
+        slice.macroblock_address = 120;
+        slice.slice_type = 0;
+        slice.num_ref_idx_active_override_flag = 1;
+        slice.num_ref_idx_l0_active_minus1 = 2;
+        slice.slice_qp_delta = 4;
+        break;
+    default:                                  // non reference B slice
+        pic.frame_num = 6;
+        pic.CurrPic.TopFieldOrderCnt = 8;
+        pic.pic_fields.bits.entropy_coding_mode_flag = 1;
+        pic.pic_fields.bits.deblocking_filter_control_present_flag = 1;
+        slice.slice_type = 1;
+        slice.direct_spatial_mv_pred_flag = 1;
+        slice.num_ref_idx_active_override_flag = 1;
+        slice.num_ref_idx_l0_active_minus1 = 1;
+        slice.cabac_init_idc = 2;
+        slice.disable_deblocking_filter_idc = 1;
+        break;
+    }
+}
+
+int hevcSlice(int n, VAEncSequenceParameterBufferHEVC &seq,
+    VAEncPictureParameterBufferHEVC &pic, VAEncSliceParameterBufferHEVC &slice)
+{
+    seq = VAEncSequenceParameterBufferHEVC();
+    pic = VAEncPictureParameterBufferHEVC();
+    slice = VAEncSliceParameterBufferHEVC();
+
+    seq.log2_diff_max_min_luma_coding_block_size = 2;
+    seq.pic_width_in_luma_samples = 1920;
+    seq.pic_height_in_luma_samples = 1080;
+    seq.seq_fields.bits.sample_adaptive_offset_enabled_flag = 1;
+    seq.seq_fields.bits.sps_temporal_mvp_enabled_flag = 1;
+
+    switch (n) {
+    case 0:                                   // IDR I slice with SAO
+        pic.pic_fields.bits.idr_pic_flag = 1;
+        pic.pic_fields.bits.reference_pic_flag = 1;
+        slice.slice_type = HEVC_SLICE_I;
+        slice.slice_qp_delta = 2;
+        slice.max_num_merge_cand = 5;
+        slice.slice_fields.bits.slice_sao_luma_flag = 1;
+        slice.slice_fields.bits.slice_sao_chroma_flag = 1;
+        return 0;
+    case 1:                                   // P slice, chroma QP offsets
+        pic.pic_fields.bits.reference_pic_flag = 1;
+        pic.decoded_curr_pic.pic_order_cnt = 3;
+        slice.slice_type = HEVC_SLICE_P;
+        slice.ref_pic_list0[0].pic_order_cnt = 2;
+        slice.max_num_merge_cand = 5;
+        slice.slice_qp_delta = 1;
+        slice.slice_cb_qp_offset = 1;
+        slice.slice_cr_qp_offset = 2;
+        slice.slice_fields.bits.slice_temporal_mvp_enabled_flag = 1;
+        return 0;
+    default:                                  // second B slice segment
+        pic.pic_fields.bits.dependent_slice_segments_enabled_flag = 1;
+        pic.decoded_curr_pic.pic_order_cnt = 6;
+        slice.slice_type = HEVC_SLICE_B;
+        slice.slice_segment_address = 30;
+        slice.ref_pic_list0[0].pic_order_cnt = 4;
+        slice.ref_pic_list1[0].pic_order_cnt = 8;
+        slice.max_num_merge_cand = 3;
+        slice.slice_fields.bits.slice_temporal_mvp_enabled_flag = 1;
+        slice.slice_fields.bits.mvd_l1_zero_flag = 1;
+        slice.slice_fields.bits.collocated_from_l0_flag = 1;
+        return 1;
+    }
+}
+
+void vp8Frame(int n, VAEncPictureParameterBufferVP8 &pic,
+    VAQMatrixBufferVP8 &q, struct gen6_mfc_context &mfc)
+{
+    pic = VAEncPictureParameterBufferVP8();
+    q = VAQMatrixBufferVP8();
+    memset(&mfc, 0, sizeof(mfc));
+
+    pic.pic_flags.bits.frame_type = n;        // 0 is a key frame
+    pic.pic_flags.bits.num_token_partitions = 2;
+    pic.loop_filter_level[0] = 20;
+    pic.sharpness_level = 3;
+    for (int i = 0; i < 4; i++) {
+        pic.ref_lf_delta[i] = i - 2;
+        pic.mode_lf_delta[i] = 3 - 2 * i;
+    }
+    if (n) {
+        pic.pic_flags.bits.refresh_last = 1;
+        pic.pic_flags.bits.copy_buffer_to_golden = 1;
+        pic.pic_flags.bits.sign_bias_alternate = 1;
+    }
+
+    q.quantization_index[0] = 40;
+    q.quantization_index_delta[1] = -3;
+    q.quantization_index_delta[4] = 5;
+
+    mfc.vp8_state.prob_skip_false = 200;
+    mfc.vp8_state.prob_intra = 63;
+    mfc.vp8_state.prob_last = 128;
+    mfc.vp8_state.prob_gf = 90;
+    for (int i = 0; i < 4; i++)
+        mfc.vp8_state.y_mode_probs[i] = 100 + i;
+    for (int i = 0; i < 3; i++)
+        mfc.vp8_state.uv_mode_probs[i] = 150 + i;
+}
+
+// The builders pad the header to a dword with zeros.
+void expectHeader(const std::vector<uint8_t> &expected, int expectedBits,
+    const uint8_t *out, int bits)
+{
+    ASSERT_EQ(expectedBits, bits);
+    ASSERT_EQ(expected.size(), size_t(((bits + 31) & ~31) / 8));
+    EXPECT_EQ(0, memcmp(expected.data(), out, expected.size()));
+}
+
+} // namespace
+
+TEST(BitWriterTest, MatchesLegacyWriter)
+{
+    for (unsigned int seed = 1; seed <= 200; seed++) {
+        const std::vector<Op> ops = randomOps(seed, 1 + seed * 3);
+        std::vector<uint8_t> out(8192, 0);
+        struct i965_bit_writer bw;
+        LegacyWriter lw;
+
+        replay(lw, ops);
+        i965_bit_writer_init(&bw, out.data(), out.size());
+        replay(&bw, ops);
+
+        const unsigned int bits = lw.end();
+        ASSERT_EQ(bits, i965_bit_writer_bit_offset(&bw)) << "seed " << seed;
+        ASSERT_EQ(bits, i965_bit_writer_flush(&bw)) << "seed " << seed;
+        EXPECT_FALSE(bw.overflow);
+
+        // both pad the last dword with zeros
+        const size_t bytes = ((bits + 31) & ~31) / 8;
+        ASSERT_EQ(0, memcmp(lw.data(), out.data(), bytes)) << "seed " << seed;
+    }
+}
+
+TEST(BitWriterTest, ExpGolomb)
+{
+    unsigned int bits;
+    std::vector<uint8_t> out;
+
+    out = writeUe(0, &bits);
+    EXPECT_EQ(1u, bits);
+    EXPECT_EQ(0x80, out[0]);
+
+    out = writeUe(6, &bits);                  // 00111
+    EXPECT_EQ(5u, bits);
+    EXPECT_EQ(0x38, out[0]);
+
+    out = writeUe(0xfffe, &bits);             // 15 zeros, 16 bit code
+    EXPECT_EQ(31u, bits);
+    EXPECT_EQ(0x00, out[0]);
+    EXPECT_EQ(0x01, out[1]);
+    EXPECT_EQ(0xff, out[2]);
+    EXPECT_EQ(0xfe, out[3]);
+
+    out = writeUe(0xffff, &bits);             // first code split in two writes
+    EXPECT_EQ(33u, bits);
+    EXPECT_EQ(0x00, out[0]);
+    EXPECT_EQ(0x00, out[1]);
+    EXPECT_EQ(0x80, out[2]);
+    EXPECT_EQ(0x00, out[3]);
+    EXPECT_EQ(0x00, out[4]);
+
+    out = writeUe(0xffffffff, &bits);         // 33 bit code
+    EXPECT_EQ(65u, bits);
+    for (int i = 0; i < 4; i++)
+        EXPECT_EQ(0x00, out[i]);
+    EXPECT_EQ(0x80, out[4]);
+    for (int i = 5; i < 12; i++)
+        EXPECT_EQ(0x00, out[i]);
+
+    struct i965_bit_writer bw;
+    uint8_t se[8] = { 0 };
+
+    i965_bit_writer_init(&bw, se, sizeof(se));
+    i965_bit_writer_put_se(&bw, 1);           // 010
+    i965_bit_writer_put_se(&bw, -1);          // 011
+    i965_bit_writer_put_se(&bw, 0);           // 1
+    i965_bit_writer_put_se(&bw, -2);          // 00101
+    EXPECT_EQ(12u, i965_bit_writer_flush(&bw));
+    EXPECT_EQ(0x4e, se[0]);
+    EXPECT_EQ(0x50, se[1]);
+}
+
+TEST(BitWriterTest, Alignment)
+{
+    struct i965_bit_writer bw;
+    uint8_t out[8];
+
+    memset(out, 0xa5, sizeof(out));
+    i965_bit_writer_init(&bw, out, sizeof(out));
+
+    i965_bit_writer_byte_aligning(&bw, 1);
+    EXPECT_EQ(0u, i965_bit_writer_bit_offset(&bw));
+
+    i965_bit_writer_put_ui(&bw, 0, 3);
+    i965_bit_writer_byte_aligning(&bw, 1);
+    EXPECT_EQ(8u, i965_bit_writer_bit_offset(&bw));
+
+    i965_bit_writer_put_ui(&bw, 1, 2);
+    i965_bit_writer_rbsp_trailing_bits(&bw);
+    EXPECT_EQ(16u, i965_bit_writer_flush(&bw));
+
+    EXPECT_EQ(0x1f, out[0]);
+    EXPECT_EQ(0x60, out[1]);
+    EXPECT_EQ(0x00, out[2]);
+    EXPECT_EQ(0x00, out[3]);
+    EXPECT_EQ(0xa5, out[4]);
+}
+
+TEST(BitWriterTest, Overflow)
+{
+    struct i965_bit_writer bw;
+    uint8_t out[24];
+
+    memset(out, 0xa5, sizeof(out));
+    i965_bit_writer_init(&bw, out, 16);
+
+    for (int i = 0; i < 4; i++)
+        i965_bit_writer_put_ui(&bw, 0xffffffff, 32);
+    EXPECT_FALSE(bw.overflow);
+
+    i965_bit_writer_put_ui(&bw, 0, 31);
+    EXPECT_FALSE(bw.overflow);
+    i965_bit_writer_put_ui(&bw, 0, 2);
+    EXPECT_FALSE(bw.overflow);
+
+    EXPECT_EQ(161u, i965_bit_writer_flush(&bw));
+    EXPECT_TRUE(bw.overflow);
+
+    // nothing lands past the storage given to the writer
+    for (int i = 16; i < 24; i++)
+        EXPECT_EQ(0xa5, out[i]);
+}
+
+TEST(BitWriterTest, AvcSliceHeader)
+{
+    static const std::vector<uint8_t> expected[] = {
+        { 0x00, 0x00, 0x00, 0x01, 0x65, 0xb8, 0x20, 0x03,
+          0xd1, 0x7f, 0x00, 0x00, },
+        { 0x00, 0x00, 0x00, 0x01, 0x41, 0x03, 0xce, 0xa5,
+          0x58, 0x20, 0x00, 0x00, },
+        { 0x00, 0x00, 0x00, 0x01, 0x01, 0xab, 0x11, 0xa8,
+          0xeb, 0x00, 0x00, 0x00, },
+    };
+    static const int expectedBits[] = { 80, 78, 72 };
+    VAEncSequenceParameterBufferH264 sps;
+    VAEncPictureParameterBufferH264 pic;
+    VAEncSliceParameterBufferH264 slice;
+    uint8_t out[I965_HEADER_BUFFER_SIZE];
+
+    for (int n = 0; n < 3; n++) {
+        SCOPED_TRACE(::testing::Message() << "slice " << n);
+
+        avcSlice(n, sps, pic, slice);
+        expectHeader(expected[n], expectedBits[n], out,
+            build_avc_slice_header(&sps, &pic, &slice, out, sizeof(out)));
+    }
+}
+
+TEST(BitWriterTest, HevcSliceHeader)
+{
+    static const std::vector<uint8_t> expected[] = {
+        { 0x00, 0x00, 0x00, 0x01, 0x26, 0x01, 0xef, 0x7c, },
+        { 0x00, 0x00, 0x00, 0x01, 0x02, 0x01, 0xd0, 0x18,
+          0xbc, 0x52, 0x70, 0x00, },
+        { 0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0x40, 0x7a,
+          0x0c, 0x24, 0xab, 0x1b, 0xf0, 0x00, 0x00, 0x00, },
+    };
+    static const int expectedBits[] = { 64, 88, 104 };
+    VAEncSequenceParameterBufferHEVC seq;
+    VAEncPictureParameterBufferHEVC pic;
+    VAEncSliceParameterBufferHEVC slice;
+    uint8_t out[I965_HEADER_BUFFER_SIZE];
+
+    for (int n = 0; n < 3; n++) {
+        SCOPED_TRACE(::testing::Message() << "slice " << n);
+
+        const int index = hevcSlice(n, seq, pic, slice);
+        expectHeader(expected[n], expectedBits[n], out,
+            build_hevc_slice_header(&seq, &pic, &slice, out, sizeof(out),
+                index));
+    }
+}
+
+TEST(BitWriterTest, Mpeg2SliceHeader)
+{
+    VAEncSequenceParameterBufferMPEG2 sps = VAEncSequenceParameterBufferMPEG2();
+    VAEncPictureParameterBufferMPEG2 pic = VAEncPictureParameterBufferMPEG2();
+    VAEncSliceParameterBufferMPEG2 slice = VAEncSliceParameterBufferMPEG2();
+    uint8_t out[I965_HEADER_BUFFER_SIZE];
+
+    // the PAK inserts the MPEG-2 slice header itself
+    EXPECT_EQ(0, build_mpeg2_slice_header(&sps, &pic, &slice, out,
+        sizeof(out)));
+}
+
+// Removal delays of 90000 and 0 in 24 bits, CPB removal and DPB output
+// delays of 2 and 4 in 24 bits.
+TEST(BitWriterTest, AvcSei)
+{
+    uint8_t out[I965_HEADER_BUFFER_SIZE];
+
+    expectHeader({
+        0x00, 0x00, 0x00, 0x01, 0x06, 0x00, 0x07, 0x80,
+        0xaf, 0xc8, 0x00, 0x00, 0x00, 0x40, 0x80, 0x00,
+    }, 120, out, build_avc_sei_buffering_period(24, 90000, 0, out,
+        sizeof(out)));
+
+    expectHeader({
+        0x00, 0x00, 0x00, 0x01, 0x06, 0x01, 0x06, 0x00,
+        0x00, 0x02, 0x00, 0x00, 0x04, 0x80, 0x00, 0x00,
+    }, 112, out, build_avc_sei_pic_timing(24, 2, 24, 4, out, sizeof(out)));
+
+    expectHeader({
+        0x00, 0x00, 0x00, 0x01, 0x06, 0x00, 0x07, 0x80,
+        0xaf, 0xc8, 0x00, 0x00, 0x00, 0x40, 0x01, 0x06,
+        0x00, 0x00, 0x02, 0x00, 0x00, 0x04, 0x80, 0x00,
+    }, 184, out, build_avc_sei_buffer_timing(24, 90000, 0, 24, 2, 24, 4,
+        out, sizeof(out)));
+}
+
+TEST(BitWriterTest, HevcSei)
+{
+    uint8_t out[I965_HEADER_BUFFER_SIZE];
+
+    expectHeader({
+        0x00, 0x00, 0x00, 0x01, 0x4e, 0x01, 0x00, 0x07,
+        0x80, 0xaf, 0xc8, 0x00, 0x00, 0x00, 0x40, 0x80,
+    }, 128, out, build_hevc_sei_buffering_period(24, 90000, 0, out,
+        sizeof(out)));
+
+    expectHeader({
+        0x00, 0x00, 0x00, 0x01, 0x4e, 0x01, 0x01, 0x06,
+        0x00, 0x00, 0x02, 0x00, 0x00, 0x04, 0x80, 0x00,
+    }, 120, out, build_hevc_sei_pic_timing(24, 2, 24, 4, out, sizeof(out)));
+
+    expectHeader({
+        0x00, 0x00, 0x00, 0x01, 0x4e, 0x01, 0x00, 0x07,
+        0x80, 0xaf, 0xc8, 0x00, 0x00, 0x00, 0x40, 0x01,
+        0x06, 0x00, 0x00, 0x02, 0x00, 0x00, 0x04, 0x80,
+    }, 192, out, build_hevc_idr_sei_buffer_timing(24, 90000, 0, 24, 2, 24, 4,
+        out, sizeof(out)));
+}
+
+TEST(BitWriterTest, Vp8FrameHeader)
+{
+    // Everything between the head and the tail is the all zero "no coeff
+    // prob update" flags.
+    static const std::vector<uint8_t> head[] = {
+        { 0x05, 0x1f, 0x0b, 0x07, 0x03, 0x05, 0x0d, 0x05,
+          0x07, 0x0f, 0x28, 0x4e, 0x55, },
+        { 0x14, 0x7c, 0x2c, 0x1c, 0x0c, 0x14, 0x34, 0x14,
+          0x1c, 0x3c, 0xa1, 0x39, 0x50, 0x8e, },
+    };
+    static const std::vector<uint8_t> tail[] = {
+        { 0x00, 0xe4, 0x00, 0x00, },
+        { 0x00, 0x01, 0xc8, 0x3f, 0x80, 0x5a, 0xb2, 0x32,
+          0xb3, 0x33, 0xe5, 0xa5, 0xe6, 0x00, 0x00, 0x00,
+          0x00, 0x00, 0x00, 0x00, },
+    };
+    static const unsigned int pos[][5] = {
+        /* lf, qindex, token, mv, bits */
+        { 13, 81, 104, 0, 1169 },
+        { 11, 79, 111, 1258, 1296 },
+    };
+    std::unique_ptr<struct gen6_mfc_context> mfc(new struct gen6_mfc_context);
+    VAEncPictureParameterBufferVP8 pic;
+    VAQMatrixBufferVP8 q;
+    uint8_t out[512];
+
+    for (int n = 0; n < 2; n++) {
+        SCOPED_TRACE(::testing::Message() << "frame type " << n);
+
+        std::vector<uint8_t> expected(head[n]);
+        expected.resize(144, 0);
+        expected.insert(expected.end(), tail[n].begin(), tail[n].end());
+
+        vp8Frame(n, pic, q, *mfc);
+        binarize_vp8_frame_header(NULL, &pic, &q, mfc.get(), NULL, out,
+            sizeof(out));
+
+        EXPECT_EQ(pos[n][0], mfc->vp8_state.frame_header_lf_update_pos);
+        EXPECT_EQ(pos[n][1], mfc->vp8_state.frame_header_qindex_update_pos);
+        EXPECT_EQ(pos[n][2], mfc->vp8_state.frame_header_token_update_pos);
+        EXPECT_EQ(pos[n][3], mfc->vp8_state.frame_header_bin_mv_upate_pos);
+        expectHeader(expected, pos[n][4], out,
+            mfc->vp8_state.frame_header_bit_count);
+    }
+}
+
+TEST(BitWriterTest, Throughput)
+{
+    const int iterations = 200000;
+    VAEncSequenceParameterBufferH264 sps;
+    VAEncPictureParameterBufferH264 pic;
+    VAEncSliceParameterBufferH264 slice;
+    VAEncSequenceParameterBufferHEVC hevcSeq;
+    VAEncPictureParameterBufferHEVC hevcPic;
+    VAEncSliceParameterBufferHEVC hevcSliceParam;
+    std::unique_ptr<struct gen6_mfc_context> mfc(new struct gen6_mfc_context);
+    VAEncPictureParameterBufferVP8 vp8Pic;
+    VAQMatrixBufferVP8 q;
+    uint8_t out[512];
+    unsigned int sink = 0;
+
+    avcSlice(1, sps, pic, slice);
+    const int index = hevcSlice(1, hevcSeq, hevcPic, hevcSliceParam);
+    vp8Frame(1, vp8Pic, q, *mfc);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        sink += build_avc_slice_header(&sps, &pic, &slice, out, sizeof(out));
+    auto avc = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        sink += build_hevc_slice_header(&hevcSeq, &hevcPic, &hevcSliceParam,
+            out, sizeof(out), index);
+    auto hevc = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        sink += build_avc_sei_buffer_timing(24, 90000, 0, 24, i, 24, 4, out,
+            sizeof(out));
+    auto sei = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        binarize_vp8_frame_header(NULL, &vp8Pic, &q, mfc.get(), NULL, out,
+            sizeof(out));
+        sink += mfc->vp8_state.frame_header_bit_count;
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    EXPECT_NE(0u, sink);
+
+    auto rate = [iterations](std::chrono::steady_clock::time_point a,
+                             std::chrono::steady_clock::time_point b) {
+        return iterations / std::chrono::duration<double>(b - a).count();
+    };
+
+    std::cout << "[ INFO     ] headers/s AVC slice " << rate(start, avc)
+              << ", HEVC slice " << rate(avc, hevc)
+              << ", AVC SEI " << rate(hevc, sei)
+              << ", VP8 frame " << rate(sei, stop) << std::endl;
+}
@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "i965_brc_lookahead.h"
+}
+
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+
+enum { P = 0, I = 2 };
+
+// Per frame VME distortion and coded size at QP 26 of a 90 frame 1080p
+// sequence, intra period 30, with a cut to a much busier scene at frame 45.
+struct TraceFrame
+{
+    int type;
+    int distortion;
+    int bits;
+};
+
+const TraceFrame sceneCut[] = {
+    { 2, 289429, 140976 }, { 0,  61811,  36562 }, { 0,  60430,  37546 },
+    { 0,  54695,  34770 }, { 0,  54449,  34205 }, { 0,  54838,  32539 },
+    { 0,  59094,  39484 }, { 0,  55485,  33670 }, { 0,  61529,  41867 },
+    { 0,  60925,  38045 }, { 0,  65715,  38699 }, { 0,  64301,  39454 },
+    { 0,  55731,  33222 }, { 0,  57701,  38491 }, { 0,  56168,  36130 },
+    { 0,  61666,  38356 }, { 0,  60572,  35770 }, { 0,  54715,  33107 },
+    { 0,  62164,  39014 }, { 0,  57769,  37183 }, { 0,  59438,  36531 },
+    { 0,  63532,  41624 }, { 0,  56929,  36578 }, { 0,  60302,  40587 },
+    { 0,  62753,  38493 }, { 0,  65762,  39204 }, { 0,  59017,  39015 },
+    { 0,  55823,  35382 }, { 0,  54470,  35517 }, { 0,  63174,  40581 },
+    { 2, 322528, 161435 }, { 0,  62343,  40183 }, { 0,  60958,  38434 },
+    { 0,  64079,  43582 }, { 0,  59689,  38895 }, { 0,  54728,  35870 },
+    { 0,  61765,  42312 }, { 0,  63863,  39152 }, { 0,  58629,  38231 },
+    { 0,  54270,  34248 }, { 0,  56016,  33388 }, { 0,  54707,  36227 },
+    { 0,  55552,  33848 }, { 0,  58691,  39481 }, { 0,  54966,  34617 },
+    { 0, 292867, 197365 }, { 0, 159578, 107226 }, { 0, 143352,  89789 },
+    { 0, 145763,  98243 }, { 0, 163731,  98156 }, { 0, 140286,  85255 },
+    { 0, 142000,  89947 }, { 0, 152673,  93261 }, { 0, 135122,  84684 },
+    { 0, 146077,  93737 }, { 0, 163592, 107040 }, { 0, 150464,  97336 },
+    { 0, 155286,  91564 }, { 0, 161985, 107461 }, { 0, 161235, 107257 },
+    { 2, 410959, 208589 }, { 0, 138106,  89576 }, { 0, 136867,  80889 },
+    { 0, 141262,  84849 }, { 0, 145201,  85596 }, { 0, 135006,  80940 },
+    { 0, 138043,  85739 }, { 0, 135765,  91368 }, { 0, 153422,  91938 },
+    { 0, 142567,  88314 }, { 0, 145924,  87064 }, { 0, 160468, 109929 },
+    { 0, 148979,  94351 }, { 0, 137576,  81795 }, { 0, 145279,  88774 },
+    { 0, 159865,  96009 }, { 0, 135692,  92376 }, { 0, 150847,  90366 },
+    { 0, 151295,  88796 }, { 0, 150843, 103112 }, { 0, 160899, 105371 },
+    { 0, 142833,  88758 }, { 0, 140011,  92769 }, { 0, 150977, 100144 },
+    { 0, 144889,  87922 }, { 0, 159345, 109027 }, { 0, 160578, 106953 },
+    { 0, 159549, 105195 }, { 0, 141802,  90292 }, { 0, 145666,  85521 },
+};
+
+const int numFrames = sizeof(sceneCut) / sizeof(sceneCut[0]);
+
+const double bitsPerFrame = 60000.;
+const double bufferSize = 30 * bitsPerFrame / 2; // half a second
+const int window = 16;
+
+double qstep(int qp)
+{
+    return 0.625 * std::pow(2., qp / 6.);
+}
+
+// Replays a trace, scaling the recorded sizes to the chosen QP and
+// re-encoding at a higher QP on HRD underflow like the MFC encoders do.
+struct Replay
+{
+    double fullness;
+    int underflows;
+    int qpSwing;
+    int prevQp[3];
+    double minFullness;
+
+    Replay()
+        : fullness(bufferSize / 2), underflows(0), qpSwing(0)
+        , minFullness(bufferSize)
+    {
+        prevQp[P] = prevQp[1] = prevQp[I] = -1;
+    }
+
+    int encode(const TraceFrame& frame, int& qp)
+    {
+        int bits;
+
+        for (;;) {
+            bits = (int)(frame.bits * qstep(26) / qstep(qp));
+            if (fullness - bits > 0. || qp == 51)
+                break;
+            underflows++;
+            qp = std::min(qp + 2, 51);
+        }
+
+        fullness = std::min(fullness - bits + bitsPerFrame, bufferSize);
+        minFullness = std::min(minFullness, fullness);
+        if (prevQp[frame.type] >= 0)
+            qpSwing += std::abs(qp - prevQp[frame.type]);
+        prevQp[frame.type] = qp;
+
+        return bits;
+    }
+};
+
+// Reacts to the size of the previous frame of the same type only
+Replay replayReactive()
+{
+    const double targetI = bitsPerFrame * 30 / (1 + 0.6 * 29);
+    const double target[3] = { 0.6 * targetI, 0.25 * targetI, targetI };
+    int qp[3] = { 26, 26, 26 };
+    Replay replay;
+
+    for (int i(0); i < numFrames; ++i) {
+        const TraceFrame& frame = sceneCut[i];
+        int bits = replay.encode(frame, qp[frame.type]);
+        int delta = (int)std::floor(6. * std::log2(bits / target[frame.type]) + 0.5);
+
+        qp[frame.type] += std::max(-5, std::min(5, delta));
+        qp[frame.type] = std::max(1, std::min(51, qp[frame.type]));
+    }
+
+    return replay;
+}
+
+Replay replayLookahead(struct i965_brc_lookahead& la)
+{
+    Replay replay;
+
+    i965_brc_lookahead_init(&la, window, bitsPerFrame, bufferSize,
+        bufferSize / 2, 1);
+
+    for (int i(0); i < numFrames; ++i) {
+        const TraceFrame& frame = sceneCut[i];
+        int qp = i965_brc_lookahead_get_qp(&la, frame.type, frame.distortion,
+            replay.fullness, 26);
+        int bits = replay.encode(frame, qp);
+
+        i965_brc_lookahead_update(&la, frame.type, frame.distortion, qp, bits);
+    }
+
+    return replay;
+}
+
+} // namespace
+
+TEST(BrcLookaheadTest, Disabled)
+{
+    struct i965_brc_lookahead la;
+
+    i965_brc_lookahead_init(&la, 0, bitsPerFrame, bufferSize, bufferSize / 2, 1);
+    i965_brc_lookahead_update(&la, P, 60000., 30, 40000);
+
+    EXPECT_EQ(26, i965_brc_lookahead_get_qp(&la, P, 60000., bufferSize / 2, 26));
+    EXPECT_EQ(0u, la.num_frames);
+}
+
+TEST(BrcLookaheadTest, FallbackWithoutModel)
+{
+    struct i965_brc_lookahead la;
+
+    i965_brc_lookahead_init(&la, window, bitsPerFrame, bufferSize, bufferSize / 2, 1);
+
+    EXPECT_EQ(26, i965_brc_lookahead_get_qp(&la, I, 300000., bufferSize / 2, 26));
+    i965_brc_lookahead_update(&la, I, 300000., 26, 150000);
+
+    // The intra model doesn't say anything about P frames
+    EXPECT_EQ(30, i965_brc_lookahead_get_qp(&la, P, 60000., bufferSize / 2, 30));
+    EXPECT_EQ(2u, la.num_fallbacks);
+}
+
+TEST(BrcLookaheadTest, SteadyComplexity)
+{
+    struct i965_brc_lookahead la;
+
+    i965_brc_lookahead_init(&la, window, bitsPerFrame, bufferSize, bufferSize / 2, 1);
+
+    // Same complexity and the bits of an average frame: the QP stays put
+    i965_brc_lookahead_update(&la, P, 60000., 30, (int)bitsPerFrame);
+    EXPECT_EQ(30, i965_brc_lookahead_get_qp(&la, P, 60000., bufferSize / 2, 26));
+}
+
+TEST(BrcLookaheadTest, ComplexityRaisesQp)
+{
+    struct i965_brc_lookahead la;
+    int qp, qpBusy;
+
+    i965_brc_lookahead_init(&la, window, bitsPerFrame, bufferSize, bufferSize / 2, 1);
+    for (int i(0); i < window; ++i)
+        i965_brc_lookahead_update(&la, P, 60000., 30, (int)bitsPerFrame);
+
+    qp = i965_brc_lookahead_get_qp(&la, P, 60000., bufferSize / 2, 26);
+    qpBusy = i965_brc_lookahead_get_qp(&la, P, 120000., bufferSize / 2, 26);
+
+    // Twice the complexity gets more bits, but not twice as many
+    EXPECT_GT(qpBusy, qp);
+    EXPECT_LE(qpBusy, qp + 6);
+}
+
+TEST(BrcLookaheadTest, HrdMargin)
+{
+    struct i965_brc_lookahead la;
+    int qp;
+
+    i965_brc_lookahead_init(&la, window, bitsPerFrame, bufferSize, bufferSize / 2, 1);
+    i965_brc_lookahead_update(&la, P, 60000., 30, (int)bitsPerFrame);
+
+    // Nearly empty buffer: the QP change limit is overridden to avoid underflow
+    qp = i965_brc_lookahead_get_qp(&la, P, 60000., 0.12 * bufferSize, 26);
+    EXPECT_GT(qp, 30 + 4);
+    EXPECT_LE(bitsPerFrame * qstep(30) / qstep(qp), 0.02 * bufferSize);
+}
+
+TEST(BrcLookaheadTest, SceneCut)
+{
+    struct i965_brc_lookahead la;
+    Replay reactive(replayReactive());
+    Replay lookahead(replayLookahead(la));
+
+    std::cout << "[ INFO     ] reactive: " << reactive.underflows
+              << " underflows, QP swing " << reactive.qpSwing
+              << ", lowest fullness " << (int)reactive.minFullness << std::endl;
+    std::cout << "[ INFO     ] lookahead: " << lookahead.underflows
+              << " underflows, QP swing " << lookahead.qpSwing
+              << ", lowest fullness " << (int)lookahead.minFullness << std::endl;
+
+    EXPECT_EQ(0, lookahead.underflows);
+    EXPECT_LT(lookahead.qpSwing, reactive.qpSwing);
+    EXPECT_EQ((unsigned)numFrames, la.num_frames);
+}
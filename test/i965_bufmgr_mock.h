@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef I965_BUFMGR_MOCK_H
+#define I965_BUFMGR_MOCK_H
+
+#include "test.h"
+
+#include <i915_drm.h>
+
+extern "C" {
+    #include "i965_bufmgr_ops.h"
+}
+
+#include <map>
+#include <set>
+#include <vector>
+
+// A minimal stand-in for the GEM buffer manager behind i965_bufmgr_ops:
+// buffer objects are plain allocations with their own reference count, the
+// kernel purges and keeps busy whatever the test tells it to, every fd
+// refers to a dma-buf the test names, and uploads and relocations are
+// logged instead of written. The state is kept in function statics so that
+// any test can include this, reset() clears it.
+struct MockBufmgr
+{
+    struct Buffer
+    {
+        dri_bo bo;
+        std::vector<char> storage;
+        int refs;
+        int maps;
+    };
+
+    struct Reloc
+    {
+        dri_bo *batch;
+        uint32_t offset;
+        dri_bo *target;
+        uint32_t delta;
+        uint32_t read_domains;
+        uint32_t write_domain;
+
+        bool operator==(const Reloc& other) const
+        {
+            return batch == other.batch && offset == other.offset
+                && target == other.target && delta == other.delta
+                && read_domains == other.read_domains
+                && write_domain == other.write_domain;
+        }
+    };
+
+    static std::map<dri_bo *, Buffer *>& buffers()
+    {
+        static std::map<dri_bo *, Buffer *> buffers;
+        return buffers;
+    }
+
+    static std::set<dri_bo *>& purged()
+    {
+        static std::set<dri_bo *> purged;
+        return purged;
+    }
+
+    static std::set<dri_bo *>& busy_bos()
+    {
+        static std::set<dri_bo *> busy_bos;
+        return busy_bos;
+    }
+
+    static std::map<int, uint64_t>& fd_inode()
+    {
+        static std::map<int, uint64_t> fd_inode;
+        return fd_inode;
+    }
+
+    static std::map<uint64_t, unsigned long>& inode_size()
+    {
+        static std::map<uint64_t, unsigned long> inode_size;
+        return inode_size;
+    }
+
+    static std::vector<std::pair<unsigned long, unsigned long> >& uploads()
+    {
+        static std::vector<std::pair<unsigned long, unsigned long> > uploads;
+        return uploads;
+    }
+
+    static std::vector<Reloc>& relocs()
+    {
+        static std::vector<Reloc> relocs;
+        return relocs;
+    }
+
+    static bool& fail_alloc()
+    {
+        static bool fail_alloc;
+        return fail_alloc;
+    }
+
+    // import calls, each one is a PRIME ioctl
+    static int& imports()
+    {
+        static int imports;
+        return imports;
+    }
+
+    // unreference calls, including the ones that did not free the bo
+    static int& unreferenced()
+    {
+        static int unreferenced;
+        return unreferenced;
+    }
+
+    static int refs(dri_bo *bo)
+    {
+        return buffers().count(bo) ? buffers()[bo]->refs : 0;
+    }
+
+    static void add_fd(int fd, uint64_t ino, unsigned long size)
+    {
+        fd_inode()[fd] = ino;
+        inode_size()[ino] = size;
+    }
+
+    static dri_bo *alloc(unsigned long size)
+    {
+        Buffer *buffer = new Buffer();
+        buffer->bo.size = size;
+        buffer->refs = 1;
+        buffer->maps = 0;
+        buffers()[&buffer->bo] = buffer;
+        return &buffer->bo;
+    }
+
+    static dri_bo *alloc(dri_bufmgr *, const char *, unsigned long size,
+        unsigned int alignment)
+    {
+        EXPECT_EQ(4096u, alignment);
+
+        return fail_alloc() ? NULL : alloc(size);
+    }
+
+    static void reference(dri_bo *bo)
+    {
+        ASSERT_EQ(1u, buffers().count(bo));
+        buffers()[bo]->refs++;
+    }
+
+    static void unreference(dri_bo *bo)
+    {
+        ASSERT_EQ(1u, buffers().count(bo));
+        unreferenced()++;
+
+        Buffer *buffer = buffers()[bo];
+        if (!--buffer->refs) {
+            EXPECT_EQ(0, buffer->maps);
+            buffers().erase(bo);
+            purged().erase(bo);
+            busy_bos().erase(bo);
+            delete buffer;
+        }
+    }
+
+    static int madvise(dri_bo *bo, int madv)
+    {
+        // retained unless the test purged it
+        return madv == I915_MADV_WILLNEED ? !purged().count(bo) : 1;
+    }
+
+    static int subdata(dri_bo *bo, unsigned long offset, unsigned long size,
+        const void *)
+    {
+        EXPECT_EQ(1u, buffers().count(bo));
+        EXPECT_LE(offset + size, bo->size);
+        uploads().push_back(std::make_pair(offset, size));
+        return 0;
+    }
+
+    static int map(dri_bo *bo, int write_enable)
+    {
+        EXPECT_EQ(1u, buffers().count(bo));
+        EXPECT_TRUE(write_enable);
+        EXPECT_EQ(0u, busy_bos().count(bo));
+
+        Buffer *buffer = buffers()[bo];
+        buffer->storage.resize(bo->size);
+        buffer->maps++;
+        bo->virt = buffer->storage.data();
+        return 0;
+    }
+
+    static int unmap(dri_bo *bo)
+    {
+        EXPECT_EQ(1u, buffers().count(bo));
+        if (!--buffers()[bo]->maps)
+            bo->virt = NULL;
+        return 0;
+    }
+
+    static int busy(dri_bo *bo)
+    {
+        return busy_bos().count(bo);
+    }
+
+    static dri_bo *import(dri_bufmgr *, int fd, int size)
+    {
+        imports()++;
+
+        if (size <= 0)
+            return NULL;
+
+        return alloc(fd_inode().count(fd) ? inode_size()[fd_inode()[fd]] : size);
+    }
+
+    static int prime_inode(int fd, uint64_t *dev, uint64_t *ino)
+    {
+        if (!fd_inode().count(fd))
+            return -1;
+
+        *dev = 1;
+        *ino = fd_inode()[fd];
+        return 0;
+    }
+
+    static int emit_reloc(dri_bo *bo, uint32_t offset,
+        dri_bo *target_bo, uint32_t target_offset,
+        uint32_t read_domains, uint32_t write_domain)
+    {
+        relocs().push_back(Reloc{ bo, offset, target_bo, target_offset,
+            read_domains, write_domain });
+        return 0;
+    }
+
+    static void reset()
+    {
+        buffers().clear();
+        purged().clear();
+        busy_bos().clear();
+        fd_inode().clear();
+        inode_size().clear();
+        uploads().clear();
+        relocs().clear();
+        fail_alloc() = false;
+        imports() = 0;
+        unreferenced() = 0;
+    }
+
+    static const struct i965_bufmgr_ops *ops()
+    {
+        static struct i965_bufmgr_ops ops;
+
+        ops.alloc = alloc;
+        ops.reference = reference;
+        ops.unreference = unreference;
+        ops.madvise = madvise;
+        ops.subdata = subdata;
+        ops.map = map;
+        ops.unmap = unmap;
+        ops.busy = busy;
+        ops.import = import;
+        ops.prime_inode = prime_inode;
+        ops.emit_reloc = emit_reloc;
+        return &ops;
+    }
+};
+
+#endif
@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "i965_byte_scan.h"
+}
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <vector>
+
+namespace {
+
+const uint8_t h264Delimiter[] = { 0x00, 0x00, 0x00, 0x00, 0x00 };
+const uint8_t mpeg2Delimiter[] = { 0x00, 0x00, 0x00, 0x00, 0xb0 };
+const uint8_t jpegEoi[] = { 0xff, 0xd9 };
+
+// Looks like a coded slice: random payload without emulated start codes,
+// and start codes, but never the 5 zero bytes of the delimiter.
+std::vector<uint8_t> bitstream(size_t size)
+{
+    std::vector<uint8_t> bytes(size);
+    for (size_t i(0); i < size; ++i) {
+        if (i % 61 == 0 && i + 4 <= size) {
+            if (i > 0 && bytes[i - 1] == 0)
+                bytes[i - 1] = 0x80;
+            bytes[i] = bytes[i + 1] = bytes[i + 2] = 0;
+            bytes[i + 3] = 1;
+            i += 3;
+            continue;
+        }
+        bytes[i] = std::rand();
+        if (i >= 2 && bytes[i - 1] == 0 && bytes[i - 2] == 0 && bytes[i] < 3)
+            bytes[i] = 3;
+    }
+    return bytes;
+}
+
+const uint8_t *reference(const std::vector<uint8_t>& buf,
+    const uint8_t *pattern, size_t pattern_size)
+{
+    auto it = std::search(buf.begin(), buf.end(), pattern, pattern + pattern_size);
+    return it == buf.end() ? NULL : buf.data() + (it - buf.begin());
+}
+
+// The slice header walk avc_get_first_mb_bit_offset_with_epb() used before
+unsigned int reference_count_epb(const uint8_t *buf, size_t buf_size,
+    size_t header_size)
+{
+    unsigned int n(0);
+    for (size_t i = 2, j = 2; i < buf_size && j < header_size; i++, j++) {
+        if (buf[i] == 0x03 && buf[i - 1] == 0x00 && buf[i - 2] == 0x00)
+            i += 2, j++, n++;
+    }
+    return n;
+}
+
+// Mostly zeros and 3s so that escaped sequences, back to back ones and
+// sequences straddling the limits are all common.
+std::vector<uint8_t> epb_heavy(size_t size)
+{
+    static const uint8_t alphabet[] = { 0x00, 0x00, 0x00, 0x03, 0x03, 0x01, 0x80 };
+    std::vector<uint8_t> bytes(size);
+    for (auto& b : bytes)
+        b = alphabet[std::rand() % sizeof(alphabet)];
+    return bytes;
+}
+
+class ByteScanTest
+    : public ::testing::TestWithParam<int>
+{
+protected:
+    virtual void SetUp()
+    {
+        const int path = i965_byte_scan_set_path(GetParam());
+        if (path != GetParam())
+            std::cout << "[ INFO     ] path " << GetParam()
+                << " not supported, using " << path << std::endl;
+    }
+
+    virtual void TearDown()
+    {
+        i965_byte_scan_set_path(I965_BYTE_SCAN_PATH_AVX2);
+    }
+};
+
+TEST_P(ByteScanTest, Delimiters)
+{
+    for (size_t size : { 5, 6, 16, 31, 32, 33, 36, 63, 64, 100, 4099 }) {
+        for (size_t pos(0); pos + 5 <= size; pos += (size > 100 ? 97 : 1)) {
+            for (const uint8_t *delimiter : { h264Delimiter, mpeg2Delimiter }) {
+                std::vector<uint8_t> buf = bitstream(size);
+                std::copy(delimiter, delimiter + 5, buf.begin() + pos);
+
+                ASSERT_EQ(reference(buf, delimiter, 5),
+                    i965_byte_scan_find(buf.data(), buf.size(), delimiter, 5))
+                    << "size " << size << ", delimiter at " << pos;
+            }
+        }
+    }
+}
+
+TEST_P(ByteScanTest, RandomPatterns)
+{
+    for (int round(0); round < 2000; ++round) {
+        std::vector<uint8_t> buf(1 + std::rand() % 300);
+        // a small alphabet makes partial matches likely
+        for (auto& b : buf)
+            b = std::rand() % 3;
+
+        const size_t pattern_size = 1 + std::rand() % 20;
+        std::vector<uint8_t> pattern(pattern_size);
+        for (auto& b : pattern)
+            b = std::rand() % 3;
+
+        ASSERT_EQ(reference(buf, pattern.data(), pattern_size),
+            i965_byte_scan_find(buf.data(), buf.size(), pattern.data(), pattern_size))
+            << "round " << round;
+    }
+}
+
+TEST_P(ByteScanTest, NotFound)
+{
+    std::vector<uint8_t> buf = bitstream(8192);
+    std::replace(buf.begin(), buf.end(), 0xff, 0xfe);
+
+    EXPECT_TRUE(NULL == i965_byte_scan_find(buf.data(), buf.size(), h264Delimiter, 5));
+    EXPECT_TRUE(NULL == i965_byte_scan_find(buf.data(), 4, h264Delimiter, 5));
+
+    // the match must lie entirely within the buffer
+    std::copy(jpegEoi, jpegEoi + 2, buf.end() - 2);
+    EXPECT_TRUE(NULL == i965_byte_scan_find(buf.data(), buf.size() - 1, jpegEoi, 2));
+    EXPECT_EQ(buf.data() + buf.size() - 2,
+        i965_byte_scan_find(buf.data(), buf.size(), jpegEoi, 2));
+
+    EXPECT_EQ(buf.data(), i965_byte_scan_find(buf.data(), buf.size(), jpegEoi, 0));
+}
+
+TEST_P(ByteScanTest, StartCodes)
+{
+    const uint8_t start_code[] = { 0x00, 0x00, 0x01 };
+    const uint8_t epb[] = { 0x00, 0x00, 0x03 };
+
+    for (int round(0); round < 5000; ++round) {
+        std::vector<uint8_t> buf = epb_heavy(std::rand() % 200);
+
+        ASSERT_EQ(reference(buf, start_code, 3),
+            i965_byte_scan_find_start_code(buf.data(), buf.size()))
+            << "round " << round;
+        ASSERT_EQ(reference(buf, epb, 3),
+            i965_byte_scan_find_epb(buf.data(), buf.size()))
+            << "round " << round;
+    }
+}
+
+TEST_P(ByteScanTest, EmulationPreventionFuzz)
+{
+    for (int round(0); round < 20000; ++round) {
+        const size_t header_size = std::rand() % 300;
+        const size_t size = std::min((size_t)std::rand() % 500, (header_size * 3 + 1) / 2);
+        std::vector<uint8_t> buf = epb_heavy(size);
+
+        ASSERT_EQ(reference_count_epb(buf.data(), size, header_size),
+            i965_byte_scan_count_epb(buf.data(), size, header_size))
+            << "round " << round << ", size " << size << ", header " << header_size;
+    }
+
+    // real slice headers: random payload with a handful of escapes
+    for (int round(0); round < 2000; ++round) {
+        std::vector<uint8_t> buf = bitstream(64 + std::rand() % 256);
+        for (size_t i(0); i + 3 <= buf.size(); i += 8 + std::rand() % 24) {
+            buf[i] = buf[i + 1] = 0;
+            buf[i + 2] = 3;
+        }
+        const size_t header_size = buf.size() * 2 / 3;
+
+        ASSERT_EQ(reference_count_epb(buf.data(), buf.size(), header_size),
+            i965_byte_scan_count_epb(buf.data(), buf.size(), header_size))
+            << "round " << round;
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(
+    Paths, ByteScanTest, ::testing::Values(
+        I965_BYTE_SCAN_PATH_C,
+        I965_BYTE_SCAN_PATH_SSE2,
+        I965_BYTE_SCAN_PATH_AVX2));
+
+// The fallback when the encoder doesn't report the coded size: a 1080p
+// sized coded buffer filled up to the delimiter near its end.
+TEST(ByteScanThroughputTest, CodedBuffer)
+{
+    const size_t size = 1920 * 1088 * 3 / 2;
+    const int rounds = 50;
+
+    std::vector<uint8_t> buf = bitstream(size);
+    std::copy(h264Delimiter, h264Delimiter + 5, buf.end() - 4096);
+
+    const uint8_t *expected = buf.data() + size - 4096;
+
+    // the loop i965_MapBuffer2() used before
+    auto start = std::chrono::steady_clock::now();
+    const uint8_t *found = NULL;
+    for (int r(0); r < rounds; ++r) {
+        size_t i;
+        for (i = 0; i < size - 4; ++i) {
+            if (buf[i] == 0 && buf[i + 1] == 0 && buf[i + 2] == 0 &&
+                buf[i + 3] == 0 && buf[i + 4] == 0)
+                break;
+        }
+        found = buf.data() + i;
+    }
+    auto elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(expected, found);
+
+    std::cout << "[ INFO     ] byte loop: " << std::fixed << std::setprecision(2)
+        << (rounds * (double)size / elapsed / 1e9) << " GB/s" << std::endl;
+
+    for (int path : { I965_BYTE_SCAN_PATH_C, I965_BYTE_SCAN_PATH_SSE2,
+        I965_BYTE_SCAN_PATH_AVX2 }) {
+        i965_byte_scan_set_path(path);
+
+        start = std::chrono::steady_clock::now();
+        for (int r(0); r < rounds; ++r)
+            found = i965_byte_scan_find(buf.data(), size, h264Delimiter, 5);
+        elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        EXPECT_EQ(expected, found);
+
+        std::cout << "[ INFO     ] path " << i965_byte_scan_get_path() << ": "
+            << std::fixed << std::setprecision(2)
+            << (rounds * (double)size / elapsed / 1e9) << " GB/s" << std::endl;
+    }
+
+    i965_byte_scan_set_path(I965_BYTE_SCAN_PATH_AVX2);
+}
+
+// A frame cut into many slices, each with an escaped header, as parsed by
+// the gen4/gen5 AVC decoder once per slice.
+TEST(ByteScanThroughputTest, SliceHeaders)
+{
+    const size_t num_slices = 512;
+    const size_t slice_size = 1024;
+    const size_t header_size = 48;
+    const size_t buf_size = (header_size * 3 + 1) / 2;
+    const int rounds = 200;
+
+    std::vector<uint8_t> frame = bitstream(num_slices * slice_size);
+    for (size_t s(0); s < num_slices; ++s) {
+        uint8_t *header = frame.data() + s * slice_size;
+        header[8] = header[9] = header[20] = header[21] = 0;
+        header[10] = header[22] = 3;
+    }
+
+    // per slice read back into a temporary and walk it byte by byte
+    unsigned int expected(0), total(0);
+    auto start = std::chrono::steady_clock::now();
+    for (int r(0); r < rounds; ++r) {
+        for (size_t s(0); s < num_slices; ++s) {
+            uint8_t *buf = (uint8_t *)malloc(buf_size);
+            ASSERT_PTR(buf);
+            memcpy(buf, frame.data() + s * slice_size, buf_size);
+            expected += reference_count_epb(buf, buf_size, header_size);
+            free(buf);
+        }
+    }
+    auto elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "[ INFO     ] byte loop: " << std::fixed << std::setprecision(2)
+        << (rounds * num_slices / elapsed / 1e6) << " M slices/s" << std::endl;
+
+    for (int path : { I965_BYTE_SCAN_PATH_C, I965_BYTE_SCAN_PATH_SSE2,
+        I965_BYTE_SCAN_PATH_AVX2 }) {
+        i965_byte_scan_set_path(path);
+
+        total = 0;
+        start = std::chrono::steady_clock::now();
+        for (int r(0); r < rounds; ++r) {
+            for (size_t s(0); s < num_slices; ++s)
+                total += i965_byte_scan_count_epb(frame.data() + s * slice_size,
+                    buf_size, header_size);
+        }
+        elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        EXPECT_EQ(expected, total);
+
+        std::cout << "[ INFO     ] path " << i965_byte_scan_get_path() << ": "
+            << std::fixed << std::setprecision(2)
+            << (rounds * num_slices / elapsed / 1e6) << " M slices/s" << std::endl;
+    }
+
+    i965_byte_scan_set_path(I965_BYTE_SCAN_PATH_AVX2);
+}
+
+} // namespace
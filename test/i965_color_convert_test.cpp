@@ -0,0 +1,346 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "i965_color_convert.h"
+}
+
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+std::vector<uint8_t> randomBytes(size_t size)
+{
+    std::vector<uint8_t> bytes(size);
+    for (auto& b : bytes)
+        b = std::rand();
+    return bytes;
+}
+
+// A frame in its own buffer, each row padded so that overruns are caught
+class Frame
+{
+public:
+    static const unsigned padding = 37;
+    static const uint8_t canary = 0xcd;
+
+    Frame(unsigned fourcc, unsigned width, unsigned height)
+        : width(width), height(height)
+    {
+        const unsigned cw = (width + 1) / 2, ch = (height + 1) / 2;
+
+        frame.fourcc = fourcc;
+
+        switch (fourcc) {
+        case VA_FOURCC_NV12:
+            addPlane(0, width, height);
+            addPlane(1, 2 * cw, ch);
+            break;
+        case VA_FOURCC_P010:
+            addPlane(0, 2 * width, height);
+            addPlane(1, 4 * cw, ch);
+            break;
+        case VA_FOURCC_I420:
+        case VA_FOURCC_YV12:
+            addPlane(0, width, height);
+            addPlane(1, cw, ch);
+            addPlane(2, cw, ch);
+            break;
+        case VA_FOURCC_YUY2:
+        case VA_FOURCC_UYVY:
+            addPlane(0, 4 * cw, height);
+            break;
+        default:
+            addPlane(0, 4 * width, height);
+            break;
+        }
+
+        data.assign(size, canary);
+        for (unsigned p(0); p < 3; ++p)
+            frame.planes[p] = frame.pitches[p] ? data.data() + offsets[p] : NULL;
+    }
+
+    void randomize()
+    {
+        std::vector<uint8_t> bytes = randomBytes(size);
+        for (unsigned p(0); p < 3; ++p)
+            for (unsigned y(0); y < rows[p]; ++y)
+                std::copy_n(bytes.begin() + offsets[p] + y * frame.pitches[p],
+                    lengths[p], data.begin() + offsets[p] + y * frame.pitches[p]);
+
+        // 10 bits samples in the high bits, the low bits are zero
+        if (frame.fourcc == VA_FOURCC_P010)
+            for (unsigned i(0); i < size; i += 2)
+                data[i] &= 0xc0;
+    }
+
+    // Everything past the samples of each row is left alone
+    bool paddingIntact() const
+    {
+        for (unsigned p(0); p < 3; ++p)
+            for (unsigned y(0); y < rows[p]; ++y)
+                for (unsigned x(lengths[p]); x < frame.pitches[p]; ++x)
+                    if (data[offsets[p] + y * frame.pitches[p] + x] != canary)
+                        return false;
+        return true;
+    }
+
+    uint8_t *row(unsigned plane, unsigned y)
+    {
+        return frame.planes[plane] + y * frame.pitches[plane];
+    }
+
+    unsigned width, height;
+    i965_color_frame frame = {};
+    std::vector<uint8_t> data;
+
+private:
+    void addPlane(unsigned p, unsigned length, unsigned count)
+    {
+        offsets[p] = size;
+        lengths[p] = length;
+        rows[p] = count;
+        frame.pitches[p] = length + padding;
+        size += frame.pitches[p] * count;
+    }
+
+    unsigned offsets[3] = {}, lengths[3] = {}, rows[3] = {};
+    unsigned size = 0;
+};
+
+// data.assign() binds canary to a reference, the constants need a definition
+const unsigned Frame::padding;
+const uint8_t Frame::canary;
+
+const unsigned others[] = {
+    VA_FOURCC_I420, VA_FOURCC_YV12, VA_FOURCC_YUY2, VA_FOURCC_UYVY,
+    VA_FOURCC_RGBX, VA_FOURCC_BGRX, VA_FOURCC_P010,
+};
+
+// Odd sizes leave tails for the C code after every SIMD loop
+const unsigned sizes[][2] = {
+    { 1, 1 }, { 2, 2 }, { 7, 3 }, { 33, 17 }, { 67, 35 }, { 258, 130 },
+};
+
+class ColorConvertTest
+    : public ::testing::TestWithParam<unsigned>
+{
+protected:
+    virtual void TearDown()
+    {
+        i965_color_convert_set_path(I965_COLOR_CONVERT_PATH_AVX2);
+        i965_color_convert_set_threads(I965_COLOR_CONVERT_MAX_THREADS);
+    }
+
+    // The output of the C path is the reference of the SIMD ones
+    void checkAgainstC(unsigned dstFourcc, unsigned srcFourcc,
+        unsigned width, unsigned height)
+    {
+        Frame src(srcFourcc, width, height);
+        Frame expected(dstFourcc, width, height);
+        Frame actual(dstFourcc, width, height);
+
+        src.randomize();
+
+        i965_color_convert_set_path(I965_COLOR_CONVERT_PATH_C);
+        ASSERT_EQ(0, i965_color_convert(&expected.frame, &src.frame,
+            width, height, VAProcColorStandardBT601));
+
+        i965_color_convert_set_path(GetParam());
+        ASSERT_EQ(0, i965_color_convert(&actual.frame, &src.frame,
+            width, height, VAProcColorStandardBT601));
+
+        EXPECT_TRUE(expected.data == actual.data)
+            << std::hex << srcFourcc << " to " << dstFourcc << std::dec
+            << " " << width << "x" << height;
+        EXPECT_TRUE(actual.paddingIntact());
+    }
+};
+
+TEST_P(ColorConvertTest, FromNV12)
+{
+    const int path = i965_color_convert_set_path(GetParam());
+    if (path != (int)GetParam())
+        std::cout << "[ INFO     ] path " << GetParam()
+            << " not supported, using " << path << std::endl;
+
+    for (unsigned fourcc : others)
+        for (const auto& size : sizes)
+            checkAgainstC(fourcc, VA_FOURCC_NV12, size[0], size[1]);
+}
+
+TEST_P(ColorConvertTest, ToNV12)
+{
+    for (unsigned fourcc : others)
+        for (const auto& size : sizes)
+            checkAgainstC(VA_FOURCC_NV12, fourcc, size[0], size[1]);
+}
+
+INSTANTIATE_TEST_CASE_P(
+    Paths, ColorConvertTest, ::testing::Values(
+        I965_COLOR_CONVERT_PATH_C,
+        I965_COLOR_CONVERT_PATH_SSE41,
+        I965_COLOR_CONVERT_PATH_AVX2));
+
+TEST(ColorConvertFormatsTest, Supported)
+{
+    for (unsigned fourcc : others) {
+        EXPECT_TRUE(i965_color_convert_supported(VA_FOURCC_NV12, fourcc));
+        EXPECT_TRUE(i965_color_convert_supported(fourcc, VA_FOURCC_NV12));
+    }
+
+    EXPECT_FALSE(i965_color_convert_supported(VA_FOURCC_NV12, VA_FOURCC_NV12));
+    EXPECT_FALSE(i965_color_convert_supported(VA_FOURCC_I420, VA_FOURCC_YUY2));
+    EXPECT_FALSE(i965_color_convert_supported(VA_FOURCC_NV12, VA_FOURCC_RGBA));
+
+    Frame dst(VA_FOURCC_I420, 16, 16), src(VA_FOURCC_YUY2, 16, 16);
+    EXPECT_EQ(-1, i965_color_convert(&dst.frame, &src.frame, 16, 16,
+        VAProcColorStandardBT601));
+}
+
+// NV12 to the lossless formats and back gives the frame again
+TEST(ColorConvertFormatsTest, RoundTrip)
+{
+    for (unsigned fourcc : { VA_FOURCC_I420, VA_FOURCC_YV12, VA_FOURCC_YUY2,
+                             VA_FOURCC_UYVY, VA_FOURCC_P010 }) {
+        for (const auto& size : sizes) {
+            Frame nv12(VA_FOURCC_NV12, size[0], size[1]);
+            Frame other(fourcc, size[0], size[1]);
+            Frame back(VA_FOURCC_NV12, size[0], size[1]);
+
+            nv12.randomize();
+            ASSERT_EQ(0, i965_color_convert(&other.frame, &nv12.frame,
+                size[0], size[1], VAProcColorStandardBT601));
+            ASSERT_EQ(0, i965_color_convert(&back.frame, &other.frame,
+                size[0], size[1], VAProcColorStandardBT601));
+
+            EXPECT_TRUE(nv12.data == back.data) << std::hex << fourcc;
+        }
+    }
+}
+
+TEST(ColorConvertFormatsTest, Layouts)
+{
+    Frame nv12(VA_FOURCC_NV12, 2, 2);
+    nv12.row(0, 0)[0] = 1;
+    nv12.row(0, 0)[1] = 2;
+    nv12.row(0, 1)[0] = 3;
+    nv12.row(0, 1)[1] = 4;
+    nv12.row(1, 0)[0] = 10;
+    nv12.row(1, 0)[1] = 20;
+
+    Frame yv12(VA_FOURCC_YV12, 2, 2);
+    ASSERT_EQ(0, i965_color_convert(&yv12.frame, &nv12.frame, 2, 2,
+        VAProcColorStandardBT601));
+    EXPECT_EQ(20, yv12.row(1, 0)[0]);
+    EXPECT_EQ(10, yv12.row(2, 0)[0]);
+
+    Frame uyvy(VA_FOURCC_UYVY, 2, 2);
+    ASSERT_EQ(0, i965_color_convert(&uyvy.frame, &nv12.frame, 2, 2,
+        VAProcColorStandardBT601));
+    const uint8_t row1[] = { 10, 3, 20, 4 };
+    EXPECT_TRUE(std::equal(row1, row1 + 4, uyvy.row(0, 1)));
+
+    Frame p010(VA_FOURCC_P010, 2, 2);
+    ASSERT_EQ(0, i965_color_convert(&p010.frame, &nv12.frame, 2, 2,
+        VAProcColorStandardBT601));
+    EXPECT_EQ(4 << 8, reinterpret_cast<uint16_t *>(p010.row(0, 1))[1]);
+
+    // 10 bits to 8 rounds to nearest and saturates
+    reinterpret_cast<uint16_t *>(p010.row(0, 0))[0] = 0x3ff << 6;
+    reinterpret_cast<uint16_t *>(p010.row(0, 0))[1] = 6 << 6;
+    ASSERT_EQ(0, i965_color_convert(&nv12.frame, &p010.frame, 2, 2,
+        VAProcColorStandardBT601));
+    EXPECT_EQ(255, nv12.row(0, 0)[0]);
+    EXPECT_EQ(2, nv12.row(0, 0)[1]);
+}
+
+// The BT.601 limited range end points and a few colours
+TEST(ColorConvertFormatsTest, Rgb)
+{
+    struct { uint8_t y, u, v, r, g, b; } colors[] = {
+        {  16, 128, 128,   0,   0,   0 },
+        { 235, 128, 128, 255, 255, 255 },
+        {  81,  90, 240, 255,   0,   0 },
+        { 145,  54,  34,   0, 255,   0 },
+        {  41, 240, 110,   0,   0, 255 },
+    };
+
+    for (const auto& c : colors) {
+        Frame nv12(VA_FOURCC_NV12, 2, 2), rgbx(VA_FOURCC_RGBX, 2, 2);
+
+        std::fill(nv12.row(0, 0), nv12.row(0, 0) + 2, c.y);
+        std::fill(nv12.row(0, 1), nv12.row(0, 1) + 2, c.y);
+        nv12.row(1, 0)[0] = c.u;
+        nv12.row(1, 0)[1] = c.v;
+
+        ASSERT_EQ(0, i965_color_convert(&rgbx.frame, &nv12.frame, 2, 2,
+            VAProcColorStandardBT601));
+        EXPECT_NEAR(c.r, rgbx.row(0, 1)[4], 2);
+        EXPECT_NEAR(c.g, rgbx.row(0, 1)[5], 2);
+        EXPECT_NEAR(c.b, rgbx.row(0, 1)[6], 2);
+        EXPECT_EQ(0xff, rgbx.row(0, 1)[7]);
+
+        Frame bgrx(VA_FOURCC_BGRX, 2, 2), back(VA_FOURCC_NV12, 2, 2);
+        ASSERT_EQ(0, i965_color_convert(&bgrx.frame, &nv12.frame, 2, 2,
+            VAProcColorStandardBT601));
+        EXPECT_EQ(rgbx.row(0, 0)[0], bgrx.row(0, 0)[2]);
+
+        ASSERT_EQ(0, i965_color_convert(&back.frame, &bgrx.frame, 2, 2,
+            VAProcColorStandardBT601));
+        EXPECT_NEAR(c.y, back.row(0, 1)[1], 1);
+        EXPECT_NEAR(c.u, back.row(1, 0)[0], 1);
+        EXPECT_NEAR(c.v, back.row(1, 0)[1], 1);
+    }
+}
+
+// A 4K frame is converted by stripes, the result must not depend on the
+// number of threads
+TEST(ColorConvertStripesTest, MatchesSingleThreaded)
+{
+    const unsigned width = 3840, height = 2161;
+
+    for (unsigned fourcc : { VA_FOURCC_RGBX, VA_FOURCC_YUY2 }) {
+        Frame src(fourcc, width, height);
+        Frame reference(VA_FOURCC_NV12, width, height);
+        Frame actual(VA_FOURCC_NV12, width, height);
+
+        src.randomize();
+
+        i965_color_convert_set_threads(1);
+        ASSERT_EQ(0, i965_color_convert(&reference.frame, &src.frame,
+            width, height, VAProcColorStandardBT709));
+
+        i965_color_convert_set_threads(I965_COLOR_CONVERT_MAX_THREADS);
+        ASSERT_EQ(0, i965_color_convert(&actual.frame, &src.frame,
+            width, height, VAProcColorStandardBT709));
+
+        EXPECT_TRUE(reference.data == actual.data) << std::hex << fourcc;
+    }
+}
+
+} // namespace
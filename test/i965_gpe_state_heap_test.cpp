@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "i965_gpe_state_heap.h"
+}
+
+#include "i965_bufmgr_mock.h"
+
+#include <vector>
+
+namespace {
+
+const unsigned int chunk_size = I965_GPE_STATE_HEAP_CHUNK_SIZE;
+
+class GpeStateHeapTest : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        MockBufmgr::reset();
+        i965_gpe_state_heap_init(&heap, NULL, MockBufmgr::ops());
+    }
+
+    virtual void TearDown()
+    {
+        for (auto& slice : slices)
+            i965_gpe_state_heap_free(&heap, &slice);
+
+        i965_gpe_state_heap_terminate(&heap);
+        EXPECT_TRUE(MockBufmgr::buffers().empty());
+    }
+
+    struct i965_gpe_state_slice *alloc(unsigned int size,
+        unsigned int alignment = 4096)
+    {
+        struct i965_gpe_state_slice slice;
+
+        if (i965_gpe_state_heap_alloc(&heap, size, alignment, &slice))
+            return NULL;
+
+        slices.push_back(slice);
+        return &slices.back();
+    }
+
+    struct i965_gpe_state_heap_stats stats()
+    {
+        struct i965_gpe_state_heap_stats s;
+        i965_gpe_state_heap_get_stats(&heap, &s);
+        return s;
+    }
+
+    struct i965_gpe_state_heap heap;
+    std::vector<struct i965_gpe_state_slice> slices;
+};
+
+} // namespace
+
+TEST_F(GpeStateHeapTest, SuballocatesOneBufferObject)
+{
+    slices.reserve(64);
+
+    // the surface and dynamic state of an encoder's kernels
+    for (unsigned int i(0); i < 32; ++i) {
+        ASSERT_TRUE(alloc(17000) != NULL);
+        ASSERT_TRUE(alloc(1000, 64) != NULL);
+    }
+
+    EXPECT_EQ(1u, MockBufmgr::buffers().size());
+
+    for (unsigned int i(1); i < slices.size(); ++i) {
+        const struct i965_gpe_state_slice& prev = slices[i - 1];
+        const struct i965_gpe_state_slice& slice = slices[i];
+
+        EXPECT_TRUE(prev.bo == slice.bo);
+        EXPECT_GE(slice.offset, prev.offset + prev.size);
+        EXPECT_EQ(0u, slice.offset % (i % 2 ? 64 : 4096));
+        EXPECT_EQ((char *)slice.bo->virt + slice.offset,
+            (char *)slice.map);
+    }
+
+    EXPECT_EQ(64u, stats().allocations);
+    EXPECT_EQ(64u, stats().live_slices);
+    EXPECT_EQ(32u * 18000u, stats().bytes_allocated);
+    EXPECT_EQ(1u, stats().chunk_allocations);
+}
+
+TEST_F(GpeStateHeapTest, FullChunkIsRetired)
+{
+    slices.reserve(8);
+
+    ASSERT_TRUE(alloc(chunk_size / 2) != NULL);
+    ASSERT_TRUE(alloc(chunk_size / 2) != NULL);
+    ASSERT_TRUE(alloc(4096) != NULL);
+
+    EXPECT_TRUE(slices[0].bo == slices[1].bo);
+    EXPECT_TRUE(slices[1].bo != slices[2].bo);
+    EXPECT_EQ(0u, slices[2].offset);
+
+    // the retired chunk still holds slices, it can't be reused
+    ASSERT_TRUE(alloc(chunk_size) != NULL);
+    EXPECT_TRUE(slices[3].bo != slices[0].bo);
+    EXPECT_TRUE(slices[3].bo != slices[2].bo);
+
+    EXPECT_EQ(3u, stats().num_chunks);
+    EXPECT_EQ(3u, stats().chunk_allocations);
+    EXPECT_EQ(0u, stats().chunk_reuses);
+}
+
+TEST_F(GpeStateHeapTest, RetiredChunkReusedOnceIdle)
+{
+    slices.reserve(8);
+
+    ASSERT_TRUE(alloc(chunk_size) != NULL);
+    dri_bo *first = slices[0].bo;
+
+    // the GPU is still reading the state of the first frame
+    MockBufmgr::busy_bos().insert(first);
+    i965_gpe_state_heap_free(&heap, &slices[0]);
+
+    ASSERT_TRUE(alloc(chunk_size) != NULL);
+    EXPECT_TRUE(slices[1].bo != first);
+
+    ASSERT_TRUE(alloc(chunk_size) != NULL);
+    EXPECT_TRUE(slices[2].bo != first);
+    EXPECT_EQ(0u, stats().chunk_reuses);
+
+    MockBufmgr::busy_bos().clear();
+
+    ASSERT_TRUE(alloc(chunk_size) != NULL);
+    EXPECT_TRUE(slices[3].bo == first);
+    EXPECT_EQ(0u, slices[3].offset);
+    EXPECT_EQ(1u, stats().chunk_reuses);
+    EXPECT_EQ(3u, stats().num_chunks);
+}
+
+TEST_F(GpeStateHeapTest, CurrentChunkRewindsWhenEmpty)
+{
+    slices.reserve(8);
+
+    ASSERT_TRUE(alloc(8192) != NULL);
+    ASSERT_TRUE(alloc(8192) != NULL);
+
+    MockBufmgr::busy_bos().insert(slices[0].bo);
+    i965_gpe_state_heap_free(&heap, &slices[0]);
+    i965_gpe_state_heap_free(&heap, &slices[1]);
+
+    // busy, the next slice must not overlap the freed ones
+    ASSERT_TRUE(alloc(8192) != NULL);
+    EXPECT_EQ(16384u, slices[2].offset);
+
+    MockBufmgr::busy_bos().clear();
+    i965_gpe_state_heap_free(&heap, &slices[2]);
+
+    ASSERT_TRUE(alloc(8192) != NULL);
+    EXPECT_EQ(0u, slices[3].offset);
+    EXPECT_EQ(1u, stats().chunk_allocations);
+}
+
+TEST_F(GpeStateHeapTest, OversizedSlice)
+{
+    slices.reserve(8);
+
+    ASSERT_TRUE(alloc(4096) != NULL);
+    ASSERT_TRUE(alloc(chunk_size + 100) != NULL);
+
+    EXPECT_TRUE(slices[0].bo != slices[1].bo);
+    EXPECT_EQ(0u, slices[1].offset);
+    EXPECT_EQ(chunk_size + 4096, slices[1].bo->size);
+}
+
+TEST_F(GpeStateHeapTest, IdleChunksTrimmed)
+{
+    const unsigned int num_frames = I965_GPE_STATE_HEAP_MAX_IDLE + 4;
+
+    slices.reserve(num_frames + 1);
+
+    // every frame is still in flight when the next one is set up
+    for (unsigned int i(0); i < num_frames; ++i) {
+        ASSERT_TRUE(alloc(chunk_size) != NULL);
+        MockBufmgr::busy_bos().insert(slices[i].bo);
+        i965_gpe_state_heap_free(&heap, &slices[i]);
+    }
+
+    EXPECT_EQ(num_frames, stats().num_chunks);
+
+    MockBufmgr::busy_bos().clear();
+
+    ASSERT_TRUE(alloc(chunk_size) != NULL);
+
+    // one reused, the idle ones past the limit released
+    EXPECT_EQ(1u, stats().chunk_reuses);
+    EXPECT_EQ(I965_GPE_STATE_HEAP_MAX_IDLE + 1u, stats().num_chunks);
+    EXPECT_EQ(num_frames, stats().max_chunks);
+    EXPECT_EQ(stats().num_chunks, MockBufmgr::buffers().size());
+}
+
+TEST_F(GpeStateHeapTest, AllocationFailure)
+{
+    MockBufmgr::fail_alloc() = true;
+
+    EXPECT_TRUE(alloc(4096) == NULL);
+    EXPECT_EQ(1u, stats().failures);
+    EXPECT_EQ(0u, stats().allocations);
+
+    // a failed slice can be freed
+    struct i965_gpe_state_slice slice;
+    EXPECT_NE(0, i965_gpe_state_heap_alloc(&heap, 4096, 4096, &slice));
+    EXPECT_TRUE(slice.bo == NULL);
+    i965_gpe_state_heap_free(&heap, &slice);
+
+    MockBufmgr::fail_alloc() = false;
+
+    EXPECT_TRUE(alloc(4096) != NULL);
+    EXPECT_EQ(1u, stats().num_chunks);
+}
@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "i965_image_copy.h"
+}
+
+#include <i915_drm.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <vector>
+
+namespace {
+
+// Byte at (x, y) of a plane with the given tiling, straight from the
+// hardware documentation, one byte at a time.
+size_t referenceOffset(unsigned tiling, unsigned pitch, unsigned x, unsigned y)
+{
+    switch (tiling) {
+    case I915_TILING_X:
+        return (y / 8) * pitch * 8 + (x / 512) * 4096 + (y % 8) * 512 + x % 512;
+    case I915_TILING_Y:
+        return (y / 32) * pitch * 32 + (x / 128) * 4096
+            + ((x % 128) / 16) * 512 + (y % 32) * 16 + x % 16;
+    default:
+        return y * pitch + x;
+    }
+}
+
+std::vector<uint8_t> randomBytes(size_t size)
+{
+    std::vector<uint8_t> bytes(size);
+    for (auto& b : bytes)
+        b = std::rand();
+    return bytes;
+}
+
+struct Rect
+{
+    unsigned x, y, width, height;
+};
+
+class ImageCopyTest
+    : public ::testing::TestWithParam<unsigned>
+{
+protected:
+    // 4 Y tiles / 1 X tile wide, 4 Y / 16 X tile rows high
+    static const unsigned pitch = 512;
+    static const unsigned height = 128;
+
+    virtual void TearDown()
+    {
+        i965_image_copy_set_path(I965_IMAGE_COPY_PATH_AVX2);
+        i965_image_copy_set_threads(I965_IMAGE_COPY_MAX_THREADS);
+    }
+
+    void checkFromSurface(unsigned tiling, const Rect& r)
+    {
+        // the surface mapping is page aligned, like a real one
+        uint8_t *surface = static_cast<uint8_t *>(
+            aligned_alloc(4096, pitch * height));
+        std::vector<uint8_t> data = randomBytes(pitch * height);
+        std::copy(data.begin(), data.end(), surface);
+
+        const unsigned stride = r.width + 7;
+        std::vector<uint8_t> image(stride * r.height, 0xcd);
+
+        i965_image_copy_from_surface(image.data(), stride,
+            surface, pitch, tiling, r.x, r.y, r.width, r.height);
+
+        for (unsigned y(0); y < r.height; ++y) {
+            for (unsigned x(0); x < r.width; ++x) {
+                ASSERT_EQ(surface[referenceOffset(tiling, pitch, r.x + x, r.y + y)],
+                    image[y * stride + x])
+                    << "tiling " << tiling << " at " << x << "," << y;
+            }
+            for (unsigned x(r.width); x < stride; ++x)
+                ASSERT_EQ(0xcd, image[y * stride + x]);
+        }
+
+        free(surface);
+    }
+
+    void checkToSurface(unsigned tiling, const Rect& r)
+    {
+        std::vector<uint8_t> surface = randomBytes(pitch * height);
+        std::vector<uint8_t> expected(surface);
+
+        const unsigned stride = r.width + 3;
+        std::vector<uint8_t> image = randomBytes(stride * r.height);
+
+        for (unsigned y(0); y < r.height; ++y)
+            for (unsigned x(0); x < r.width; ++x)
+                expected[referenceOffset(tiling, pitch, r.x + x, r.y + y)] =
+                    image[y * stride + x];
+
+        i965_image_copy_to_surface(surface.data(), pitch, tiling,
+            r.x, r.y, image.data(), stride, r.width, r.height);
+
+        ASSERT_TRUE(expected == surface) << "tiling " << tiling;
+    }
+};
+
+const Rect rects[] = {
+    { 0, 0, 512, 128 },     // whole plane
+    { 0, 0, 16, 1 },
+    { 3, 1, 1, 1 },
+    { 5, 7, 200, 45 },      // unaligned on every side
+    { 16, 32, 96, 32 },     // exactly one band of Y columns
+    { 100, 30, 412, 98 },   // crosses tile rows
+    { 510, 127, 2, 1 },
+};
+
+TEST_P(ImageCopyTest, FromSurface)
+{
+    const int path = i965_image_copy_set_path(GetParam());
+    if (path != (int)GetParam())
+        std::cout << "[ INFO     ] path " << GetParam()
+            << " not supported, using " << path << std::endl;
+
+    for (unsigned tiling : { I915_TILING_NONE, I915_TILING_X, I915_TILING_Y })
+        for (const Rect& r : rects)
+            checkFromSurface(tiling, r);
+}
+
+TEST_P(ImageCopyTest, ToSurface)
+{
+    i965_image_copy_set_path(GetParam());
+
+    for (unsigned tiling : { I915_TILING_NONE, I915_TILING_X, I915_TILING_Y })
+        for (const Rect& r : rects)
+            checkToSurface(tiling, r);
+}
+
+INSTANTIATE_TEST_CASE_P(
+    Paths, ImageCopyTest, ::testing::Values(
+        I965_IMAGE_COPY_PATH_C,
+        I965_IMAGE_COPY_PATH_SSE41,
+        I965_IMAGE_COPY_PATH_AVX2));
+
+// A 4K NV12 frame goes over the threshold and is copied by stripes, the
+// result must not depend on the number of threads nor on the path.
+TEST(ImageCopyStripesTest, MatchesSingleThreaded)
+{
+    const unsigned pitch = 3840, height = 2176 * 3 / 2;
+    const unsigned x = 6, y = 13, width = 3800, rows = 3000;
+
+    uint8_t *surface = static_cast<uint8_t *>(aligned_alloc(4096, pitch * height));
+    std::vector<uint8_t> data = randomBytes(pitch * height);
+    std::copy(data.begin(), data.end(), surface);
+
+    for (unsigned tiling : { I915_TILING_NONE, I915_TILING_X, I915_TILING_Y }) {
+        std::vector<uint8_t> reference(width * rows), image(width * rows);
+
+        i965_image_copy_set_path(I965_IMAGE_COPY_PATH_C);
+        i965_image_copy_set_threads(1);
+        i965_image_copy_from_surface(reference.data(), width,
+            surface, pitch, tiling, x, y, width, rows);
+
+        i965_image_copy_set_path(I965_IMAGE_COPY_PATH_AVX2);
+        i965_image_copy_set_threads(I965_IMAGE_COPY_MAX_THREADS);
+        i965_image_copy_from_surface(image.data(), width,
+            surface, pitch, tiling, x, y, width, rows);
+        EXPECT_TRUE(reference == image) << "tiling " << tiling;
+
+        std::vector<uint8_t> copy(pitch * height);
+        i965_image_copy_to_surface(copy.data(), pitch, tiling, x, y,
+            image.data(), width, width, rows);
+        for (unsigned r(0); r < rows; r += 97)
+            for (unsigned c(0); c < width; c += 13)
+                ASSERT_EQ(surface[referenceOffset(tiling, pitch, x + c, y + r)],
+                    copy[referenceOffset(tiling, pitch, x + c, y + r)]);
+    }
+
+    free(surface);
+}
+
+TEST(ImageCopyStripesTest, Throughput)
+{
+    const unsigned pitch = 3840, height = 2176 * 3 / 2;
+    const int rounds = 20;
+
+    uint8_t *surface = static_cast<uint8_t *>(aligned_alloc(4096, pitch * height));
+    std::vector<uint8_t> image(pitch * height);
+    std::fill(surface, surface + pitch * height, 0x80);
+
+    for (int path : { I965_IMAGE_COPY_PATH_C, I965_IMAGE_COPY_PATH_AVX2 }) {
+        for (unsigned tiling : { I915_TILING_NONE, I915_TILING_Y }) {
+            i965_image_copy_set_path(path);
+
+            auto start = std::chrono::steady_clock::now();
+            for (int i(0); i < rounds; ++i)
+                i965_image_copy_from_surface(image.data(), pitch,
+                    surface, pitch, tiling, 0, 0, pitch, height);
+            auto elapsed = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+
+            std::cout << "[ INFO     ] path " << i965_image_copy_get_path()
+                << ", tiling " << tiling << ": "
+                << std::fixed << std::setprecision(1)
+                << (rounds * (double)pitch * height / elapsed / 1e9) << " GB/s"
+                << std::endl;
+        }
+    }
+
+    EXPECT_EQ(0x80, image[pitch * height - 1]);
+
+    free(surface);
+}
+
+} // namespace
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "i965_kernel_cache.h"
+}
+
+#include "i965_bufmgr_mock.h"
+
+#include <vector>
+
+namespace {
+
+// stand-ins for the static kernel binaries
+const uint32_t kernel_a[64][4] = { { 1 } };
+const uint32_t kernel_b[32][4] = { { 2 } };
+const uint32_t kernel_c[16][4] = { { 3 } };
+
+// packed the way gen8_gpe_load_kernels() lays them out
+std::vector<struct i965_kernel_cache_blob> packed(
+    const std::vector<std::pair<const void *, unsigned int> >& kernels,
+    unsigned long *size)
+{
+    std::vector<struct i965_kernel_cache_blob> blobs;
+    unsigned int end(0);
+
+    *size = 0;
+    for (auto& k : kernels) {
+        struct i965_kernel_cache_blob blob;
+        blob.bin = k.first;
+        blob.size = k.second;
+        blob.offset = (end + 63) & ~63;
+        if (k.second)
+            end = blob.offset + k.second;
+        blobs.push_back(blob);
+        *size += (k.second + 63) & ~63;
+    }
+    return blobs;
+}
+
+class KernelCacheTest : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        MockBufmgr::reset();
+        i965_kernel_cache_init(&cache, NULL, MockBufmgr::ops());
+    }
+
+    virtual void TearDown()
+    {
+        i965_kernel_cache_terminate(&cache);
+        EXPECT_TRUE(MockBufmgr::buffers().empty());
+    }
+
+    struct i965_kernel_cache_stats stats()
+    {
+        struct i965_kernel_cache_stats s;
+        i965_kernel_cache_get_stats(&cache, &s);
+        return s;
+    }
+
+    struct i965_kernel_cache cache;
+};
+
+} // namespace
+
+TEST_F(KernelCacheTest, SharedAcrossContexts)
+{
+    unsigned long size;
+    std::vector<struct i965_kernel_cache_blob> blobs = packed({
+        { kernel_a, sizeof(kernel_a) },
+        { kernel_b, sizeof(kernel_b) },
+        { kernel_c, sizeof(kernel_c) } }, &size);
+
+    // 50 encode sessions loading the same kernels
+    std::vector<dri_bo *> contexts;
+    for (unsigned int i(0); i < 50; ++i)
+        contexts.push_back(i965_kernel_cache_get(&cache, "kernel shader",
+            blobs.data(), blobs.size(), size));
+
+    for (dri_bo *bo : contexts)
+        EXPECT_TRUE(contexts[0] == bo);
+
+    EXPECT_EQ(1u, MockBufmgr::buffers().size());
+    EXPECT_EQ(3u, MockBufmgr::uploads().size());
+    EXPECT_EQ(1u, stats().misses);
+    EXPECT_EQ(49u, stats().hits);
+    EXPECT_EQ(size, stats().bytes_uploaded);
+
+    // every context plus the cache
+    EXPECT_EQ(51, MockBufmgr::refs(contexts[0]));
+
+    for (dri_bo *bo : contexts)
+        MockBufmgr::unreference(bo);
+    EXPECT_EQ(1, MockBufmgr::refs(contexts[0]));
+}
+
+TEST_F(KernelCacheTest, Layout)
+{
+    unsigned long size;
+    std::vector<struct i965_kernel_cache_blob> blobs = packed({
+        { kernel_a, sizeof(kernel_a) },
+        { kernel_b, sizeof(kernel_b) } }, &size);
+
+    dri_bo *bo = i965_kernel_cache_get(&cache, "kernel shader",
+        blobs.data(), blobs.size(), size);
+    ASSERT_PTR(bo);
+
+    ASSERT_EQ(2u, MockBufmgr::uploads().size());
+    EXPECT_EQ(0u, MockBufmgr::uploads()[0].first);
+    EXPECT_EQ(sizeof(kernel_a), MockBufmgr::uploads()[0].second);
+    EXPECT_EQ(sizeof(kernel_a), MockBufmgr::uploads()[1].first);
+    EXPECT_EQ(sizeof(kernel_b), MockBufmgr::uploads()[1].second);
+
+    std::vector<dri_bo *> others;
+
+    // the same binaries in another order
+    std::vector<struct i965_kernel_cache_blob> swapped = packed({
+        { kernel_b, sizeof(kernel_b) },
+        { kernel_a, sizeof(kernel_a) } }, &size);
+    others.push_back(i965_kernel_cache_get(&cache, "kernel shader",
+        swapped.data(), swapped.size(), size));
+
+    // a subset
+    others.push_back(i965_kernel_cache_get(&cache, "kernel shader",
+        blobs.data(), 1, size));
+
+    // extra room at the end, as the VPP kernels get
+    others.push_back(i965_kernel_cache_get(&cache, "kernel shader",
+        blobs.data(), blobs.size(), size + 4096));
+
+    for (dri_bo *other : others) {
+        ASSERT_PTR(other);
+        EXPECT_FALSE(bo == other);
+        MockBufmgr::unreference(other);
+    }
+
+    EXPECT_EQ(4u, stats().misses);
+    EXPECT_EQ(0u, stats().hits);
+    EXPECT_EQ(4u, stats().num_entries);
+
+    MockBufmgr::unreference(bo);
+}
+
+TEST_F(KernelCacheTest, EmptySlots)
+{
+    unsigned long size;
+    std::vector<struct i965_kernel_cache_blob> blobs = packed({
+        { kernel_a, sizeof(kernel_a) },
+        { NULL, 0 },
+        { kernel_c, sizeof(kernel_c) } }, &size);
+
+    dri_bo *bo = i965_kernel_cache_get(&cache, "kernel shader",
+        blobs.data(), blobs.size(), size);
+    ASSERT_PTR(bo);
+
+    // modules without a kernel take no room and upload nothing
+    ASSERT_EQ(2u, MockBufmgr::uploads().size());
+    EXPECT_EQ(sizeof(kernel_a), MockBufmgr::uploads()[1].first);
+
+    MockBufmgr::unreference(bo);
+}
+
+TEST_F(KernelCacheTest, SingleKernels)
+{
+    struct i965_kernel_cache_blob blob_a = { kernel_a, sizeof(kernel_a), 0 };
+    struct i965_kernel_cache_blob blob_b = { kernel_b, sizeof(kernel_b), 0 };
+
+    dri_bo *a1 = i965_kernel_cache_get(&cache, "a", &blob_a, 1, sizeof(kernel_a));
+    dri_bo *b1 = i965_kernel_cache_get(&cache, "b", &blob_b, 1, sizeof(kernel_b));
+    dri_bo *a2 = i965_kernel_cache_get(&cache, "a", &blob_a, 1, sizeof(kernel_a));
+
+    EXPECT_TRUE(a1 == a2);
+    EXPECT_FALSE(a1 == b1);
+    EXPECT_EQ(2u, MockBufmgr::uploads().size());
+
+    MockBufmgr::unreference(a1);
+    MockBufmgr::unreference(b1);
+    MockBufmgr::unreference(a2);
+}
+
+TEST_F(KernelCacheTest, AllocFailure)
+{
+    struct i965_kernel_cache_blob blob = { kernel_a, sizeof(kernel_a), 0 };
+
+    MockBufmgr::fail_alloc() = true;
+    EXPECT_PTR_NULL(i965_kernel_cache_get(&cache, "a", &blob, 1, sizeof(kernel_a)));
+    EXPECT_EQ(0u, stats().num_entries);
+
+    // nothing was cached, the next attempt allocates again
+    MockBufmgr::fail_alloc() = false;
+    dri_bo *bo = i965_kernel_cache_get(&cache, "a", &blob, 1, sizeof(kernel_a));
+    ASSERT_PTR(bo);
+    EXPECT_EQ(2u, stats().misses);
+
+    MockBufmgr::unreference(bo);
+}
@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "i965_prime_cache.h"
+}
+
+#include "i965_bufmgr_mock.h"
+
+#include <vector>
+
+namespace {
+
+const int frame_size = 1920 * 1088 * 3 / 2;
+
+class PrimeCacheTest : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        MockBufmgr::reset();
+        i965_prime_cache_init(&cache, NULL, 2, MockBufmgr::ops());
+    }
+
+    virtual void TearDown()
+    {
+        i965_prime_cache_terminate(&cache);
+        EXPECT_TRUE(MockBufmgr::buffers().empty());
+    }
+
+    struct i965_prime_cache_stats stats()
+    {
+        struct i965_prime_cache_stats s;
+        i965_prime_cache_get_stats(&cache, &s);
+        return s;
+    }
+
+    struct i965_prime_cache cache;
+};
+
+} // namespace
+
+TEST_F(PrimeCacheTest, RepeatedImport)
+{
+    struct i965_prime_cache_key key1, key2;
+
+    MockBufmgr::add_fd(10, 100, frame_size);
+
+    dri_bo *bo1 = i965_prime_cache_import(&cache, 10, frame_size, &key1);
+    dri_bo *bo2 = i965_prime_cache_import(&cache, 10, frame_size, &key2);
+
+    ASSERT_PTR(bo1);
+    EXPECT_TRUE(bo1 == bo2);
+    EXPECT_EQ(1, MockBufmgr::imports());
+    EXPECT_EQ(1u, stats().misses);
+    EXPECT_EQ(1u, stats().hits);
+
+    // two surfaces plus the cache
+    EXPECT_EQ(3, MockBufmgr::refs(bo1));
+
+    i965_prime_cache_release(&cache, &key1, bo1);
+    i965_prime_cache_release(&cache, &key2, bo2);
+    EXPECT_EQ(1, MockBufmgr::refs(bo1));
+    EXPECT_EQ(1u, stats().num_idle);
+}
+
+TEST_F(PrimeCacheTest, DistinctFdsSameBuffer)
+{
+    struct i965_prime_cache_key key1, key2;
+
+    // a dup()ed or re-exported fd of the same dma-buf
+    MockBufmgr::add_fd(10, 100, frame_size);
+    MockBufmgr::add_fd(11, 100, frame_size);
+
+    dri_bo *bo1 = i965_prime_cache_import(&cache, 10, frame_size, &key1);
+    dri_bo *bo2 = i965_prime_cache_import(&cache, 11, frame_size, &key2);
+
+    EXPECT_TRUE(bo1 == bo2);
+    EXPECT_EQ(1, MockBufmgr::imports());
+
+    i965_prime_cache_release(&cache, &key1, bo1);
+    i965_prime_cache_release(&cache, &key2, bo2);
+}
+
+TEST_F(PrimeCacheTest, ReimportAfterRelease)
+{
+    struct i965_prime_cache_key key;
+
+    MockBufmgr::add_fd(10, 100, frame_size);
+
+    // create and destroy a surface around the same buffer every frame
+    dri_bo *first = i965_prime_cache_import(&cache, 10, frame_size, &key);
+    i965_prime_cache_release(&cache, &key, first);
+
+    for (unsigned int i(0); i < 100; ++i) {
+        dri_bo *bo = i965_prime_cache_import(&cache, 10, frame_size, &key);
+        EXPECT_TRUE(first == bo);
+        i965_prime_cache_release(&cache, &key, bo);
+    }
+
+    EXPECT_EQ(1, MockBufmgr::imports());
+    EXPECT_EQ(100u, stats().hits);
+    EXPECT_EQ(0u, stats().evictions);
+}
+
+TEST_F(PrimeCacheTest, IdleCap)
+{
+    std::vector<dri_bo *> bos;
+    std::vector<struct i965_prime_cache_key> keys(4);
+
+    for (unsigned int i(0); i < 4; ++i) {
+        MockBufmgr::add_fd(10 + i, 100 + i, frame_size);
+        bos.push_back(i965_prime_cache_import(&cache, 10 + i, frame_size, &keys[i]));
+    }
+
+    // buffers still backing surfaces are never evicted
+    EXPECT_EQ(4u, stats().num_entries);
+    EXPECT_EQ(0u, stats().num_idle);
+
+    for (unsigned int i(0); i < 4; ++i)
+        i965_prime_cache_release(&cache, &keys[i], bos[i]);
+
+    // only the two most recently released stay alive
+    EXPECT_EQ(2u, stats().evictions);
+    EXPECT_EQ(2u, stats().num_idle);
+    EXPECT_EQ(2u, MockBufmgr::buffers().size());
+    EXPECT_EQ(0u, MockBufmgr::buffers().count(bos[0]));
+    EXPECT_EQ(0u, MockBufmgr::buffers().count(bos[1]));
+
+    struct i965_prime_cache_key key;
+    dri_bo *bo = i965_prime_cache_import(&cache, 10, frame_size, &key);
+    EXPECT_EQ(5, MockBufmgr::imports());
+    i965_prime_cache_release(&cache, &key, bo);
+
+    bo = i965_prime_cache_import(&cache, 13, frame_size, &key);
+    EXPECT_TRUE(bos[3] == bo);
+    EXPECT_EQ(5, MockBufmgr::imports());
+    i965_prime_cache_release(&cache, &key, bo);
+}
+
+TEST_F(PrimeCacheTest, Disabled)
+{
+    struct i965_prime_cache_key key1, key2;
+
+    i965_prime_cache_terminate(&cache);
+    i965_prime_cache_init(&cache, NULL, 0, MockBufmgr::ops());
+
+    MockBufmgr::add_fd(10, 100, frame_size);
+
+    // live surfaces still share the buffer object
+    dri_bo *bo1 = i965_prime_cache_import(&cache, 10, frame_size, &key1);
+    dri_bo *bo2 = i965_prime_cache_import(&cache, 10, frame_size, &key2);
+    EXPECT_TRUE(bo1 == bo2);
+
+    i965_prime_cache_release(&cache, &key1, bo1);
+    i965_prime_cache_release(&cache, &key2, bo2);
+    EXPECT_TRUE(MockBufmgr::buffers().empty());
+    EXPECT_EQ(0u, stats().num_entries);
+}
+
+TEST_F(PrimeCacheTest, Unkeyable)
+{
+    struct i965_prime_cache_key key1, key2;
+
+    // no distinct inode, e.g. an older kernel
+    dri_bo *bo1 = i965_prime_cache_import(&cache, 20, frame_size, &key1);
+    dri_bo *bo2 = i965_prime_cache_import(&cache, 20, frame_size, &key2);
+
+    ASSERT_PTR(bo1);
+    ASSERT_PTR(bo2);
+    EXPECT_FALSE(bo1 == bo2);
+    EXPECT_EQ(2, MockBufmgr::imports());
+    EXPECT_EQ(2u, stats().uncached);
+    EXPECT_EQ(0u, stats().num_entries);
+
+    i965_prime_cache_release(&cache, &key1, bo1);
+    i965_prime_cache_release(&cache, &key2, bo2);
+    EXPECT_TRUE(MockBufmgr::buffers().empty());
+}
+
+TEST_F(PrimeCacheTest, SizeMismatch)
+{
+    struct i965_prime_cache_key key1, key2;
+
+    MockBufmgr::add_fd(10, 100, frame_size);
+
+    dri_bo *bo1 = i965_prime_cache_import(&cache, 10, frame_size, &key1);
+
+    // claiming more than the buffer holds never returns the cached object
+    dri_bo *bo2 = i965_prime_cache_import(&cache, 10, frame_size * 2, &key2);
+    EXPECT_FALSE(bo1 == bo2);
+    EXPECT_EQ(2, MockBufmgr::imports());
+    EXPECT_EQ(1u, stats().uncached);
+
+    i965_prime_cache_release(&cache, &key2, bo2);
+    i965_prime_cache_release(&cache, &key1, bo1);
+
+    // an idle entry gets replaced instead
+    bo2 = i965_prime_cache_import(&cache, 10, frame_size * 2, &key2);
+    EXPECT_EQ(3, MockBufmgr::imports());
+    EXPECT_EQ(1u, stats().evictions);
+    i965_prime_cache_release(&cache, &key2, bo2);
+}
+
+TEST_F(PrimeCacheTest, ImportFailure)
+{
+    struct i965_prime_cache_key key;
+
+    MockBufmgr::add_fd(10, 100, frame_size);
+
+    EXPECT_PTR_NULL(i965_prime_cache_import(&cache, 10, 0, &key));
+    EXPECT_EQ(0u, stats().num_entries);
+    EXPECT_EQ(0u, key.ino);
+}
+
+TEST_F(PrimeCacheTest, TerminateWithIdle)
+{
+    struct i965_prime_cache_key key;
+
+    MockBufmgr::add_fd(10, 100, frame_size);
+
+    dri_bo *bo = i965_prime_cache_import(&cache, 10, frame_size, &key);
+    i965_prime_cache_release(&cache, &key, bo);
+    EXPECT_EQ(1u, MockBufmgr::buffers().size());
+
+    // TearDown checks that terminate drops the last reference
+}
+
+TEST_F(PrimeCacheTest, ExportCounters)
+{
+    i965_prime_cache_count_export(&cache, 0);
+    i965_prime_cache_count_export(&cache, 1);
+    i965_prime_cache_count_export(&cache, 1);
+
+    EXPECT_EQ(3u, stats().exports);
+    EXPECT_EQ(2u, stats().export_hits);
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "i965_state_dedup.h"
+}
+
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+namespace {
+
+typedef std::vector<uint32_t> Packet;
+
+const uint32_t REF_IDX = 0x73a20000;
+const uint32_t WEIGHTOFFSET = 0x73a30000;
+const uint32_t SLICE_OBJECT = 0x73a80000;
+
+struct Slice
+{
+    // Indexed as the slots: ref idx l0/l1 then weightoffset l0/l1
+    Packet state[4];
+};
+
+Packet make_packet(uint32_t opcode, unsigned len, int list, unsigned seed)
+{
+    Packet packet(len, 0);
+    packet[0] = opcode | (len - 2);
+    packet[1] = list;
+    // Few distinct payloads so that neighbouring slices often match
+    for (unsigned i = 2; i < len; i++)
+        packet[i] = (seed * 2654435761u + i) & 0xffff;
+    return packet;
+}
+
+std::vector<Slice> random_picture(unsigned num_slices)
+{
+    std::vector<Slice> slices(num_slices);
+    for (auto& slice : slices) {
+        const int type = std::rand() % 3; // I, P or B
+        for (int list = 0; list < 2; list++) {
+            if (type == 0 || (type == 1 && list == 1))
+                continue;
+            slice.state[list] = make_packet(REF_IDX, 18, list,
+                std::rand() % 3);
+            if (std::rand() % 2)
+                slice.state[2 + list] = make_packet(WEIGHTOFFSET, 34, list,
+                    std::rand() % 2);
+        }
+    }
+    return slices;
+}
+
+// Writes the picture the way gen9_hcpd_hevc_decode_picture() does, with or
+// without skipping the duplicated state
+std::vector<uint32_t> emit(const std::vector<Slice>& slices,
+    struct i965_state_dedup *dedup)
+{
+    std::vector<uint32_t> stream;
+
+    if (dedup)
+        i965_state_dedup_reset(dedup);
+
+    for (unsigned i = 0; i < slices.size(); i++) {
+        for (unsigned slot = 0; slot < 4; slot++) {
+            const Packet& packet = slices[i].state[slot];
+            if (packet.empty())
+                continue;
+            if (dedup && i965_state_dedup_check(dedup, slot, packet.data(),
+                    packet.size()))
+                continue;
+            stream.insert(stream.end(), packet.begin(), packet.end());
+        }
+        stream.push_back(SLICE_OBJECT);
+        stream.push_back(i);
+    }
+
+    return stream;
+}
+
+// Plays the stream on a model of the hardware which keeps the last packet
+// of each kind, returns the state every slice object got decoded with
+std::vector<std::map<uint32_t, Packet> > play(const std::vector<uint32_t>& stream)
+{
+    std::vector<std::map<uint32_t, Packet> > decoded;
+    std::map<uint32_t, Packet> state;
+
+    for (size_t i = 0; i < stream.size();) {
+        if (stream[i] == SLICE_OBJECT) {
+            decoded.push_back(state);
+            i += 2;
+            continue;
+        }
+
+        const size_t len = (stream[i] & 0xff) + 2;
+        EXPECT_LE(i + len, stream.size());
+        if (i + len > stream.size())
+            break;
+
+        const uint32_t key = (stream[i] & 0xffff0000) | (stream[i + 1] & 1);
+        state[key] = Packet(stream.begin() + i, stream.begin() + i + len);
+        i += len;
+    }
+
+    return decoded;
+}
+
+} // namespace
+
+TEST(StateDedupTest, Check)
+{
+    struct i965_state_dedup dedup = {};
+    const uint32_t a[4] = { 1, 2, 3, 4 };
+    const uint32_t b[4] = { 1, 2, 3, 5 };
+
+    i965_state_dedup_reset(&dedup);
+
+    EXPECT_FALSE(i965_state_dedup_check(&dedup, 0, a, 4));
+    EXPECT_TRUE(i965_state_dedup_check(&dedup, 0, a, 4));
+
+    // Every slot keeps its own packet
+    EXPECT_FALSE(i965_state_dedup_check(&dedup, 1, a, 4));
+    EXPECT_FALSE(i965_state_dedup_check(&dedup, 0, b, 4));
+    EXPECT_FALSE(i965_state_dedup_check(&dedup, 0, a, 4));
+    EXPECT_TRUE(i965_state_dedup_check(&dedup, 1, a, 4));
+
+    // A prefix isn't the same packet
+    EXPECT_FALSE(i965_state_dedup_check(&dedup, 0, a, 3));
+    EXPECT_FALSE(i965_state_dedup_check(&dedup, 0, a, 4));
+
+    EXPECT_EQ(6u, dedup.emitted);
+    EXPECT_EQ(2u, dedup.skipped);
+}
+
+TEST(StateDedupTest, Reset)
+{
+    struct i965_state_dedup dedup = {};
+    const uint32_t a[2] = { 1, 2 };
+
+    i965_state_dedup_reset(&dedup);
+
+    EXPECT_FALSE(i965_state_dedup_check(&dedup, 0, a, 2));
+    EXPECT_TRUE(i965_state_dedup_check(&dedup, 0, a, 2));
+
+    // A new picture programs its state again
+    i965_state_dedup_reset(&dedup);
+    EXPECT_FALSE(i965_state_dedup_check(&dedup, 0, a, 2));
+
+    // Zeroes are no valid packet of an empty slot
+    const uint32_t zero[I965_STATE_DEDUP_MAX_DWORDS] = {};
+    EXPECT_FALSE(i965_state_dedup_check(&dedup, 1, zero,
+        I965_STATE_DEDUP_MAX_DWORDS));
+}
+
+TEST(StateDedupTest, Equivalent)
+{
+    struct i965_state_dedup dedup = {};
+    size_t full_size = 0, dedup_size = 0;
+
+    for (int n = 0; n < 200; n++) {
+        const std::vector<Slice> slices = random_picture(1 + std::rand() % 40);
+        const std::vector<uint32_t> full = emit(slices, NULL);
+        const std::vector<uint32_t> deduped = emit(slices, &dedup);
+
+        ASSERT_LE(deduped.size(), full.size());
+        ASSERT_TRUE(play(full) == play(deduped)) << "picture " << n;
+
+        full_size += full.size();
+        dedup_size += deduped.size();
+    }
+
+    EXPECT_LT(dedup_size, full_size);
+    std::cout << "[ INFO     ] " << dedup_size << " of " << full_size
+        << " dwords emitted" << std::endl;
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "i965_surface_pool.h"
+}
+
+#include "i965_bufmgr_mock.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct i965_surface_pool_key
+make_key(unsigned int fourcc, unsigned int pitch, unsigned int height,
+    unsigned int tiling = I915_TILING_Y)
+{
+    struct i965_surface_pool_key key;
+    key.fourcc = fourcc;
+    key.tiling = tiling;
+    key.pitch = pitch;
+    key.height = height;
+    return key;
+}
+
+class SurfacePoolTest : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        MockBufmgr::reset();
+        i965_surface_pool_init(&pool, 64 << 20, MockBufmgr::ops());
+    }
+
+    virtual void TearDown()
+    {
+        i965_surface_pool_terminate(&pool);
+        EXPECT_TRUE(MockBufmgr::buffers().empty());
+    }
+
+    struct i965_surface_pool_stats stats()
+    {
+        struct i965_surface_pool_stats s;
+        i965_surface_pool_get_stats(&pool, &s);
+        return s;
+    }
+
+    struct i965_surface_pool pool;
+};
+
+} // namespace
+
+TEST_F(SurfacePoolTest, MissThenHit)
+{
+    const struct i965_surface_pool_key key = make_key(VA_FOURCC_NV12, 1920, 1632);
+
+    EXPECT_PTR_NULL(i965_surface_pool_acquire(&pool, &key));
+    EXPECT_EQ(1u, stats().misses);
+
+    dri_bo *bo = MockBufmgr::alloc(1920 * 1632);
+    i965_surface_pool_release(&pool, &key, bo);
+    EXPECT_EQ(1u, stats().num_held);
+    EXPECT_EQ(bo->size, stats().bytes_held);
+
+    EXPECT_TRUE(bo == i965_surface_pool_acquire(&pool, &key));
+    EXPECT_EQ(1u, stats().hits);
+    EXPECT_EQ(0u, stats().bytes_held);
+
+    MockBufmgr::unreference(bo);
+}
+
+TEST_F(SurfacePoolTest, KeyMismatch)
+{
+    const struct i965_surface_pool_key key = make_key(VA_FOURCC_NV12, 1920, 1632);
+    dri_bo *bo = MockBufmgr::alloc(1920 * 1632);
+
+    i965_surface_pool_release(&pool, &key, bo);
+
+    struct i965_surface_pool_key other = key;
+    other.fourcc = VA_FOURCC_P010;
+    EXPECT_PTR_NULL(i965_surface_pool_acquire(&pool, &other));
+    other = key;
+    other.tiling = I915_TILING_NONE;
+    EXPECT_PTR_NULL(i965_surface_pool_acquire(&pool, &other));
+    other = key;
+    other.pitch = 2048;
+    EXPECT_PTR_NULL(i965_surface_pool_acquire(&pool, &other));
+    other = key;
+    other.height = 1088;
+    EXPECT_PTR_NULL(i965_surface_pool_acquire(&pool, &other));
+
+    EXPECT_EQ(4u, stats().misses);
+    EXPECT_EQ(1u, stats().num_held);
+}
+
+TEST_F(SurfacePoolTest, LRUCap)
+{
+    const unsigned long size = 16 << 20;
+    std::vector<dri_bo *> bos;
+
+    // 6 x 16MB into a 64MB pool, the two oldest get evicted
+    for (unsigned int i(0); i < 6; ++i) {
+        const struct i965_surface_pool_key key = make_key(VA_FOURCC_NV12, 4096, 4096 + i);
+        bos.push_back(MockBufmgr::alloc(size));
+        i965_surface_pool_release(&pool, &key, bos.back());
+    }
+
+    EXPECT_EQ(2, MockBufmgr::unreferenced());
+    EXPECT_EQ(2u, stats().evictions);
+    EXPECT_EQ(4u, stats().num_held);
+    EXPECT_EQ(4 * size, stats().bytes_held);
+
+    for (unsigned int i(0); i < 6; ++i) {
+        const struct i965_surface_pool_key key = make_key(VA_FOURCC_NV12, 4096, 4096 + i);
+        dri_bo *bo = i965_surface_pool_acquire(&pool, &key);
+        if (i < 2) {
+            EXPECT_PTR_NULL(bo);
+        } else {
+            EXPECT_TRUE(bos[i] == bo);
+            MockBufmgr::unreference(bo);
+        }
+    }
+}
+
+TEST_F(SurfacePoolTest, Trim)
+{
+    for (unsigned int i(0); i < 8; ++i) {
+        const struct i965_surface_pool_key key = make_key(VA_FOURCC_YUY2, 1024 * (i + 1), 64);
+        i965_surface_pool_release(&pool, &key, MockBufmgr::alloc(1 << 20));
+    }
+    EXPECT_EQ(8u, stats().num_held);
+
+    i965_surface_pool_trim(&pool, 3 << 20);
+    EXPECT_EQ(3u, stats().num_held);
+    EXPECT_EQ(5, MockBufmgr::unreferenced());
+
+    // the most recently released survive
+    const struct i965_surface_pool_key key = make_key(VA_FOURCC_YUY2, 1024 * 8, 64);
+    dri_bo *bo = i965_surface_pool_acquire(&pool, &key);
+    EXPECT_PTR(bo);
+    MockBufmgr::unreference(bo);
+
+    i965_surface_pool_trim(&pool, 0);
+    EXPECT_EQ(0u, stats().num_held);
+    EXPECT_EQ(0u, stats().bytes_held);
+}
+
+TEST_F(SurfacePoolTest, Purged)
+{
+    const struct i965_surface_pool_key key = make_key(VA_FOURCC_NV12, 1280, 1088);
+    dri_bo *a = MockBufmgr::alloc(1280 * 1088);
+    dri_bo *b = MockBufmgr::alloc(1280 * 1088);
+
+    i965_surface_pool_release(&pool, &key, a);
+    i965_surface_pool_release(&pool, &key, b);
+
+    // the kernel reclaimed the most recent one under memory pressure
+    MockBufmgr::purged().insert(b);
+
+    EXPECT_TRUE(a == i965_surface_pool_acquire(&pool, &key));
+    EXPECT_EQ(1u, stats().purged);
+    EXPECT_EQ(0u, stats().num_held);
+    EXPECT_EQ(0u, MockBufmgr::buffers().count(b));
+
+    MockBufmgr::unreference(a);
+}
+
+TEST_F(SurfacePoolTest, Disabled)
+{
+    i965_surface_pool_terminate(&pool);
+    i965_surface_pool_init(&pool, 0, MockBufmgr::ops());
+
+    const struct i965_surface_pool_key key = make_key(VA_FOURCC_NV12, 1920, 1088);
+    i965_surface_pool_release(&pool, &key, MockBufmgr::alloc(1920 * 1088));
+
+    EXPECT_EQ(1, MockBufmgr::unreferenced());
+    EXPECT_PTR_NULL(i965_surface_pool_acquire(&pool, &key));
+    EXPECT_EQ(0u, stats().num_held);
+}
@@ -25,6 +25,7 @@
 #include "i965_test_fixture.h"
 
 #include <algorithm>
+#include <cstring>
 #include <set>
 
 static const std::set<unsigned> pixelFormats = {
@@ -118,3 +119,74 @@ TEST_F(CreateSurfacesTest, UnsupportedPixelFormats)
             destroySurfaces(surfaces), "VA_STATUS_ERROR_INVALID_SURFACE");
     }
 }
+
+class SurfaceStatusTest
+    : public I965TestFixture
+{ };
+
+TEST_F(SurfaceStatusTest, HardwarePutImage)
+{
+    struct i965_driver_data *i965(*this);
+    ASSERT_PTR(i965);
+
+    if (!HAS_ACCELERATED_PUTIMAGE(i965) || !HAS_VPP(i965))
+        return;
+
+    Surfaces surfaces = createSurfaces(1920, 1080, VA_RT_FORMAT_YUV420);
+    ASSERT_EQ(1u, surfaces.size());
+
+    struct object_surface *obj_surface = SURFACE(surfaces.front());
+    ASSERT_PTR(obj_surface);
+
+    VAImageFormat format = {};
+    format.fourcc = VA_FOURCC_NV12;
+    format.byte_order = VA_LSB_FIRST;
+    format.bits_per_pixel = 12;
+
+    /* Back to back copies would otherwise move to the CPU. */
+    const int cpu_convert = i965->cpu_convert;
+    i965->cpu_convert = I965_CPU_CONVERT_NEVER;
+
+    VAImage image;
+    ASSERT_STATUS(vaCreateImage(*this, &format, 1920, 1080, &image));
+
+    void *data = NULL;
+    ASSERT_STATUS(vaMapBuffer(*this, image.buf, &data));
+    memset(data, 0x80, image.data_size);
+    ASSERT_STATUS(vaUnmapBuffer(*this, image.buf));
+
+    /*
+     * The first copy leaves the surface with fences that have signaled
+     * once it is synced, so a status check that still looked at those
+     * would report the later copies ready while they run.
+     */
+    ASSERT_STATUS(vaPutImage(*this, surfaces.front(), image.image_id,
+        0, 0, 1920, 1080, 0, 0, 1920, 1080));
+    ASSERT_STATUS(vaSyncSurface(*this, surfaces.front()));
+
+    for (unsigned i = 0; i < 16; ++i) {
+        SCOPED_TRACE(::testing::Message() << "copy " << i);
+
+        ASSERT_STATUS(vaPutImage(*this, surfaces.front(), image.image_id,
+            0, 0, 1920, 1080, 0, 0, 1920, 1080));
+        if (i965->intel.has_exec_fence)
+            EXPECT_TRUE(obj_surface->fences_valid);
+
+        VASurfaceStatus status;
+        ASSERT_STATUS(
+            vaQuerySurfaceStatus(*this, surfaces.front(), &status));
+        if (status == VASurfaceReady)
+            EXPECT_FALSE(drm_intel_bo_busy(obj_surface->bo));
+    }
+
+    VASurfaceStatus status;
+    ASSERT_STATUS(vaSyncSurface(*this, surfaces.front()));
+    ASSERT_STATUS(vaQuerySurfaceStatus(*this, surfaces.front(), &status));
+    EXPECT_EQ(VASurfaceReady, status);
+    EXPECT_FALSE(drm_intel_bo_busy(obj_surface->bo));
+
+    i965->cpu_convert = cpu_convert;
+
+    EXPECT_STATUS(vaDestroyImage(*this, image.image_id));
+    destroySurfaces(surfaces);
+}
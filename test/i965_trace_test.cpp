@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "i965_trace.h"
+}
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+int traced_call(int x)
+{
+    I965_TRACE_SCOPE("traced_call", "test");
+
+    return x + 1;
+}
+
+struct i965_trace_point *find_point(const char *name)
+{
+    for (struct i965_trace_point *point = i965_trace_points(); point; point = point->next) {
+        if (std::string(point->name) == name)
+            return point;
+    }
+
+    return NULL;
+}
+
+uint64_t num_events()
+{
+    uint64_t count = 0;
+
+    for (struct i965_trace_ring *ring = i965_trace_rings(); ring; ring = ring->next)
+        count += std::min<uint64_t>(i965_trace_ring_head(ring), I965_TRACE_RING_SIZE);
+
+    return count;
+}
+
+class TraceTest : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        i965_trace_init(NULL);
+    }
+
+    virtual void TearDown()
+    {
+        i965_trace_fini();
+    }
+
+    std::string output(void (*write)(FILE *))
+    {
+        FILE *fp = tmpfile();
+        std::string out;
+        char line[512];
+
+        write(fp);
+        rewind(fp);
+        while (fgets(line, sizeof(line), fp))
+            out += line;
+        fclose(fp);
+
+        return out;
+    }
+
+    static size_t occurrences(const std::string& haystack, const std::string& needle)
+    {
+        size_t count = 0;
+
+        for (size_t pos = haystack.find(needle); pos != std::string::npos;
+             pos = haystack.find(needle, pos + 1))
+            count++;
+
+        return count;
+    }
+};
+
+} // namespace
+
+TEST(TraceDisabledTest, RecordsNothing)
+{
+    EXPECT_FALSE(i965_trace_enabled);
+
+    EXPECT_EQ(2, traced_call(1));
+    I965_TRACE_EVENT(&i965_trace_bo_alloc, 4096);
+
+    EXPECT_TRUE(i965_trace_points() == NULL);
+    EXPECT_EQ(0u, num_events());
+}
+
+TEST_F(TraceTest, Scope)
+{
+    EXPECT_TRUE(i965_trace_enabled);
+
+    EXPECT_EQ(2, traced_call(1));
+    EXPECT_EQ(3, traced_call(2));
+
+    struct i965_trace_point *point = find_point("traced_call");
+    ASSERT_PTR(point);
+    EXPECT_STREQ("test", point->category);
+    EXPECT_EQ(2u, point->count);
+    EXPECT_EQ(0u, point->num_instants);
+    EXPECT_GE(point->total_ns, point->max_ns);
+    EXPECT_EQ(2u, num_events());
+}
+
+TEST_F(TraceTest, Instant)
+{
+    I965_TRACE_EVENT(&i965_trace_bo_alloc, 4096);
+    I965_TRACE_EVENT(&i965_trace_bo_alloc, 8192);
+
+    struct i965_trace_point *point = find_point("bo_alloc");
+    ASSERT_PTR(point);
+    EXPECT_EQ(0u, point->count);
+    EXPECT_EQ(2u, point->num_instants);
+    EXPECT_EQ(12288u, point->total_arg);
+
+    const std::string json = output(i965_trace_write_json);
+    EXPECT_EQ(2u, occurrences(json, "\"ph\":\"i\""));
+    EXPECT_NE(std::string::npos, json.find("\"args\":{\"value\":8192}"));
+}
+
+TEST_F(TraceTest, Histogram)
+{
+    static struct i965_trace_point point = { "manual", "test" };
+
+    i965_trace_complete(&point, 1000, 1000 + 500);          // <1us
+    i965_trace_complete(&point, 1000, 1000 + 3500);         // [2, 4) us
+    i965_trace_complete(&point, 1000, 1000 + 3900);         // [2, 4) us
+    i965_trace_complete(&point, 1000, 1000 + 20000000);     // 20 ms
+
+    EXPECT_EQ(4u, point.count);
+    EXPECT_EQ(1u, point.histogram[0]);
+    EXPECT_EQ(2u, point.histogram[2]);
+    EXPECT_EQ(1u, point.histogram[15]);
+    EXPECT_EQ(20000000u, point.max_ns);
+
+    const std::string summary = output(i965_trace_dump_summary);
+    EXPECT_NE(std::string::npos, summary.find("4 calls"));
+    EXPECT_NE(std::string::npos, summary.find("p50 <4 us"));
+    EXPECT_NE(std::string::npos, summary.find("p99 <32768 us"));
+    EXPECT_NE(std::string::npos, summary.find(" <1us:1 2us:2 16384us:1"));
+}
+
+TEST_F(TraceTest, RingWraps)
+{
+    static struct i965_trace_point point = { "wrap", "test" };
+
+    for (int i = 0; i < I965_TRACE_RING_SIZE + 10; i++)
+        i965_trace_instant(&point, i);
+
+    EXPECT_EQ((uint64_t)I965_TRACE_RING_SIZE + 10, point.num_instants);
+    EXPECT_EQ((uint64_t)I965_TRACE_RING_SIZE, num_events());
+
+    // the oldest events were overwritten
+    const std::string json = output(i965_trace_write_json);
+    EXPECT_EQ((size_t)I965_TRACE_RING_SIZE, occurrences(json, "\"name\":\"wrap\""));
+    EXPECT_EQ(std::string::npos, json.find("\"args\":{\"value\":9}}"));
+    EXPECT_NE(std::string::npos, json.find("\"args\":{\"value\":10}}"));
+}
+
+TEST_F(TraceTest, Json)
+{
+    traced_call(0);
+    I965_TRACE_EVENT(&i965_trace_bo_alloc, 64);
+
+    const std::string json = output(i965_trace_write_json);
+    EXPECT_EQ(0u, json.find("{\"traceEvents\":["));
+    EXPECT_NE(std::string::npos, json.find("\"name\":\"traced_call\",\"cat\":\"test\""));
+    EXPECT_EQ(1u, occurrences(json, "\"ph\":\"X\",\"dur\":"));
+    EXPECT_EQ(1u, occurrences(json, "\"ph\":\"i\""));
+    EXPECT_NE(std::string::npos, json.find("\n],\"displayTimeUnit\":\"ns\"}"));
+}
+
+TEST_F(TraceTest, Threads)
+{
+    const int num_threads = 4;
+    const int num_calls = 1000;
+    std::vector<std::thread> threads;
+    std::set<uint32_t> tids;
+
+    for (int i = 0; i < num_threads; i++) {
+        threads.push_back(std::thread([] {
+            for (int j = 0; j < num_calls; j++)
+                traced_call(j);
+        }));
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    struct i965_trace_point *point = find_point("traced_call");
+    ASSERT_PTR(point);
+    EXPECT_EQ((uint64_t)num_threads * num_calls, point->count);
+
+    for (struct i965_trace_ring *ring = i965_trace_rings(); ring; ring = ring->next) {
+        if (i965_trace_ring_head(ring)) {
+            EXPECT_EQ((uint64_t)num_calls, i965_trace_ring_head(ring));
+            tids.insert(ring->tid);
+        }
+    }
+    EXPECT_EQ((size_t)num_threads, tids.size());
+}
+
+TEST_F(TraceTest, WriteWhileRecording)
+{
+    static struct i965_trace_point point = { "racing", "test" };
+    bool done = false;
+
+    std::thread thread([&done] {
+        for (uint64_t i = 0; !__atomic_load_n(&done, __ATOMIC_RELAXED); i++)
+            i965_trace_instant(&point, i);
+    });
+
+    // the thread wraps its ring while it is written, no event may be torn
+    // or come from a later lap
+    for (int n = 0; n < 10; n++) {
+        const std::string json = output(i965_trace_write_json);
+        const std::string value = "\"args\":{\"value\":";
+        uint64_t last = 0;
+        size_t count = 0;
+
+        for (size_t pos = json.find(value); pos != std::string::npos;
+             pos = json.find(value, pos + 1)) {
+            const uint64_t arg = strtoull(json.c_str() + pos + value.size(), NULL, 10);
+
+            if (count++) {
+                EXPECT_LT(last, arg);
+            }
+            last = arg;
+        }
+        EXPECT_GE((size_t)I965_TRACE_RING_SIZE, count);
+    }
+
+    __atomic_store_n(&done, true, __ATOMIC_RELAXED);
+    thread.join();
+}
+
+TEST(TraceRingTest, FreedOnThreadExit)
+{
+    uint32_t tid = 0;
+
+    auto find_ring = [&tid]() {
+        for (struct i965_trace_ring *ring = i965_trace_rings(); ring; ring = ring->next) {
+            if (ring->tid == tid)
+                return true;
+        }
+        return false;
+    };
+
+    auto record = [&tid] {
+        tid = syscall(SYS_gettid);
+        traced_call(0);
+    };
+
+    // a thread exiting during a session leaves its events to i965_trace_fini()
+    i965_trace_init(NULL);
+    std::thread(record).join();
+    EXPECT_TRUE(find_ring());
+    i965_trace_fini();
+    EXPECT_FALSE(find_ring());
+
+    // and frees its ring right away outside of one
+    int step = 0;
+
+    i965_trace_init(NULL);
+    std::thread thread([&step, &record] {
+        record();
+        __atomic_store_n(&step, 1, __ATOMIC_RELEASE);
+        while (__atomic_load_n(&step, __ATOMIC_ACQUIRE) != 2)
+            std::this_thread::yield();
+    });
+    while (__atomic_load_n(&step, __ATOMIC_ACQUIRE) != 1)
+        std::this_thread::yield();
+    i965_trace_fini();
+    EXPECT_TRUE(find_ring());
+
+    __atomic_store_n(&step, 2, __ATOMIC_RELEASE);
+    thread.join();
+    EXPECT_FALSE(find_ring());
+}
+
+TEST(TraceDisabledTest, Overhead)
+{
+    const int num_calls = 10000000;
+    int x = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_calls; i++)
+        x = traced_call(x);
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(num_calls, x);
+
+    std::cout << "[   INFO   ] disabled tracing: "
+              << elapsed.count() / num_calls << " ns per call" << std::endl;
+}
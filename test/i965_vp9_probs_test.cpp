@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "i965_test_fixture.h"
+
+extern "C" {
+    #include "vp9_probs.h"
+}
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+namespace VP9 {
+namespace Decode {
+
+// What vp9_gen_default_probabilities() built for every decoder context
+// before the defaults were shared
+void reference_contexts(FRAME_CONTEXT *key, FRAME_CONTEXT *inter,
+    FRAME_CONTEXT frame_ctx[FRAME_CONTEXTS])
+{
+    memset(key, 0, sizeof(*key));
+    memset(inter, 0, sizeof(*inter));
+    memset(frame_ctx, 0, sizeof(*frame_ctx) * FRAME_CONTEXTS);
+
+    key->tx_probs = default_tx_probs;
+    vp9_copy(key->coeff_probs4x4, default_coef_probs_4x4);
+    vp9_copy(key->coeff_probs8x8, default_coef_probs_8x8);
+    vp9_copy(key->coeff_probs16x16, default_coef_probs_16x16);
+    vp9_copy(key->coeff_probs32x32, default_coef_probs_32x32);
+    vp9_copy(key->skip_probs, default_skip_probs);
+    vp9_copy(key->partition_prob, vp9_kf_partition_probs);
+    vp9_copy(key->uv_mode_prob, vp9_kf_uv_mode_prob);
+    vp9_copy(key->seg_tree_probs, default_seg_tree_probs);
+    vp9_copy(key->seg_pred_probs, default_seg_pred_probs);
+
+    inter->tx_probs = default_tx_probs;
+    vp9_copy(inter->coeff_probs4x4, default_coef_probs_4x4);
+    vp9_copy(inter->coeff_probs8x8, default_coef_probs_8x8);
+    vp9_copy(inter->coeff_probs16x16, default_coef_probs_16x16);
+    vp9_copy(inter->coeff_probs32x32, default_coef_probs_32x32);
+    vp9_copy(inter->skip_probs, default_skip_probs);
+    vp9_copy(inter->inter_mode_probs, default_inter_mode_probs);
+    vp9_copy(inter->switchable_interp_prob, default_switchable_interp_prob);
+    vp9_copy(inter->intra_inter_prob, default_intra_inter_p);
+    vp9_copy(inter->comp_inter_prob, default_comp_inter_p);
+    vp9_copy(inter->single_ref_prob, default_single_ref_p);
+    vp9_copy(inter->comp_ref_prob, default_comp_ref_p);
+    vp9_copy(inter->y_mode_prob, default_if_y_probs);
+    vp9_copy(inter->partition_prob, default_partition_probs);
+    inter->nmvc = default_nmv_context;
+    vp9_copy(inter->uv_mode_prob, default_if_uv_probs);
+    vp9_copy(inter->seg_tree_probs, default_seg_tree_probs);
+    vp9_copy(inter->seg_pred_probs, default_seg_pred_probs);
+
+    for (int i(0); i < FRAME_CONTEXTS; ++i)
+        frame_ctx[i] = *inter;
+}
+
+TEST(VP9ProbsTest, DefaultContexts)
+{
+    FRAME_CONTEXT key, inter, frame_ctx[FRAME_CONTEXTS];
+    reference_contexts(&key, &inter, frame_ctx);
+
+    const FRAME_CONTEXT *shared_key = intel_vp9_default_frame_context(true);
+    const FRAME_CONTEXT *shared_inter = intel_vp9_default_frame_context(false);
+
+    ASSERT_PTR(shared_key);
+    ASSERT_PTR(shared_inter);
+    EXPECT_EQ(0, memcmp(&key, shared_key, sizeof(key)));
+    EXPECT_EQ(0, memcmp(&inter, shared_inter, sizeof(inter)));
+
+    // built once, every caller gets the same copy
+    EXPECT_EQ(shared_key, intel_vp9_default_frame_context(true));
+    EXPECT_EQ(shared_inter, intel_vp9_default_frame_context(false));
+}
+
+// The per context CPU work, the old rebuild against the shared defaults
+TEST(VP9ProbsTest, SetupCost)
+{
+    const int rounds = 20000;
+    FRAME_CONTEXT key, inter, frame_ctx[FRAME_CONTEXTS];
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r(0); r < rounds; ++r)
+        reference_contexts(&key, &inter, frame_ctx);
+    auto elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "[ INFO     ] rebuilt: " << std::fixed << std::setprecision(3)
+        << (elapsed / rounds * 1e6) << " us per context" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    for (int r(0); r < rounds; ++r) {
+        const FRAME_CONTEXT *shared = intel_vp9_default_frame_context(false);
+        for (int i(0); i < FRAME_CONTEXTS; ++i)
+            frame_ctx[i] = *shared;
+    }
+    elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "[ INFO     ] shared: " << std::fixed << std::setprecision(3)
+        << (elapsed / rounds * 1e6) << " us per context" << std::endl;
+
+    EXPECT_EQ(0, memcmp(&inter, &frame_ctx[FRAME_CONTEXTS - 1], sizeof(inter)));
+}
+
+class VP9DecodeContextTest : public I965TestFixture { };
+
+// A conference gateway creates and destroys short lived decoders all the
+// time, measure the whole vaCreateContext() / vaDestroyContext() cycle
+TEST_F(VP9DecodeContextTest, CreateDestroy)
+{
+    struct i965_driver_data *i965(*this);
+    ASSERT_PTR(i965);
+    if (not HAS_VP9_DECODING_PROFILE(i965, VAProfileVP9Profile0)) {
+        RecordProperty("skipped", true);
+        std::cout << "[  SKIPPED ] " << getFullTestName()
+            << " is unsupported on this hardware" << std::endl;
+        return;
+    }
+
+    const int rounds = 200;
+
+    ASSERT_NO_FAILURE(
+        VAConfigID config = createConfig(VAProfileVP9Profile0, VAEntrypointVLD));
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r(0); r < rounds; ++r) {
+        ASSERT_NO_FAILURE(
+            VAContextID context = createContext(config, 1280, 720));
+        ASSERT_NO_FAILURE(destroyContext(context));
+    }
+    auto elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "[ INFO     ] " << std::fixed << std::setprecision(1)
+        << (elapsed / rounds * 1e6) << " us per context" << std::endl;
+
+    destroyConfig(config);
+}
+
+} // namespace Decode
+} // namespace VP9
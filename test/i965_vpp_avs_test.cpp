@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "i965_vpp_avs.h"
+}
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+
+namespace {
+
+// Same as gen8_avs_config
+const AVSConfig config = {
+    6, 1.0f / (1U << 6),
+    {
+        {
+            { -2, -2, -2, -2, -2, -2, -2, -2 },
+            { -2, -2, -2, -2, -2, -2, -2, -2 },
+            { -1, -2, -2, -1 },
+            { -1, -2, -2, -1 },
+        },
+        {
+            { 2, 2, 2, 2, 2, 2, 2, 2 },
+            { 2, 2, 2, 2, 2, 2, 2, 2 },
+            { 1, 2, 2, 1 },
+            { 1, 2, 2, 1 },
+        },
+    },
+    16, 8, 4,
+};
+
+// A ladder of downscales from 4K and upscales from 360p
+const float factors[] = {
+    1920.0f / 3840, 1280.0f / 3840, 960.0f / 3840, 640.0f / 3840,
+    1280.0f / 1920, 854.0f / 1920, 1920.0f / 640, 1280.0f / 640,
+};
+
+// The Lanczos kernel evaluated with libm, before normalization
+float referenceKernel(int i, int num_coeffs, int phase, int num_phases, float f)
+{
+    const int c = num_coeffs / 2 - 1;
+    const int l = num_coeffs > 4 ? 3 : 2;
+    const float p = (float)phase / (num_phases * 2);
+    const double x = (i - (c + p)) * std::min(f, 1.0f);
+
+    if (std::fabs(x) >= l)
+        return 0.0f;
+    if (x == 0.0)
+        return 1.0f;
+    return (std::sin(x * M_PI) / (x * M_PI)) * (std::sin(x / l * M_PI) / (x / l * M_PI));
+}
+
+class AVSTest
+    : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        avs_flush_coefficients_cache();
+    }
+
+    virtual void TearDown()
+    {
+        avs_set_gen_path(AVS_GEN_PATH_SSE2);
+        avs_flush_coefficients_cache();
+    }
+
+    void update(AVSState& avs, float sx, float sy)
+    {
+        avs_init_state(&avs, &config);
+        ASSERT_TRUE(avs_update_coefficients(&avs, sx, sy, VA_FILTER_SCALING_HQ));
+    }
+
+    static bool sameCoeffs(const AVSState& a, const AVSState& b)
+    {
+        return std::memcmp(a.coeffs, b.coeffs,
+            (config.num_phases + 1) * sizeof(AVSCoeffs)) == 0;
+    }
+};
+
+TEST_F(AVSTest, PathsMatch)
+{
+    if (avs_set_gen_path(AVS_GEN_PATH_SSE2) != AVS_GEN_PATH_SSE2) {
+        std::cout << "[ INFO     ] SSE2 not supported" << std::endl;
+        return;
+    }
+
+    for (float sx : factors) {
+        for (float sy : factors) {
+            AVSState c, sse2;
+
+            avs_set_gen_path(AVS_GEN_PATH_C);
+            avs_flush_coefficients_cache();
+            update(c, sx, sy);
+
+            avs_set_gen_path(AVS_GEN_PATH_SSE2);
+            avs_flush_coefficients_cache();
+            update(sse2, sx, sy);
+
+            EXPECT_TRUE(sameCoeffs(c, sse2)) << sx << "x" << sy;
+        }
+    }
+}
+
+TEST_F(AVSTest, MatchesLibm)
+{
+    for (float f : factors) {
+        AVSState avs;
+        update(avs, f, f);
+
+        for (int phase(0); phase <= config.num_phases; ++phase) {
+            const AVSCoeffs& coeffs = avs.coeffs[phase];
+            float sum(0.0f);
+
+            for (int i(0); i < config.num_luma_coeffs; ++i)
+                sum += referenceKernel(i, config.num_luma_coeffs, phase, config.num_phases, f);
+
+            // normalization moves the rounding error of the taps to the
+            // center ones, the others must round the same way as with libm
+            for (int i(0); i < config.num_luma_coeffs; ++i) {
+                const float expected = rintf(referenceKernel(i, config.num_luma_coeffs,
+                    phase, config.num_phases, f) / sum / config.coeff_epsilon) * config.coeff_epsilon;
+                const float tolerance = (i >= 2 && i <= 5) ? 4 * config.coeff_epsilon : 0.0f;
+
+                EXPECT_NEAR(expected, coeffs.y_k_h[i], tolerance)
+                    << "factor " << f << ", phase " << phase << ", tap " << i;
+                EXPECT_EQ(coeffs.y_k_h[i], coeffs.y_k_v[i]);
+            }
+        }
+    }
+}
+
+TEST_F(AVSTest, Cache)
+{
+    AVSState first, second, again;
+    unsigned hits, misses;
+
+    update(first, factors[0], factors[1]);
+    update(second, factors[1], factors[0]);
+    avs_get_coefficients_cache_stats(&hits, &misses);
+    EXPECT_EQ(0u, hits);
+    EXPECT_EQ(2u, misses);
+    EXPECT_FALSE(sameCoeffs(first, second));
+
+    // a fresh state picks up the table of the first one
+    update(again, factors[0], factors[1]);
+    avs_get_coefficients_cache_stats(&hits, &misses);
+    EXPECT_EQ(1u, hits);
+    EXPECT_TRUE(sameCoeffs(first, again));
+
+    // unchanged parameters don't even get to the cache
+    ASSERT_TRUE(avs_update_coefficients(&again, factors[0], factors[1], VA_FILTER_SCALING_HQ));
+    avs_get_coefficients_cache_stats(&hits, &misses);
+    EXPECT_EQ(1u, hits);
+    EXPECT_EQ(2u, misses);
+
+    // the bilinear table is shared by all factors
+    AVSState linear;
+    avs_init_state(&linear, &config);
+    ASSERT_TRUE(avs_update_coefficients(&linear, factors[0], factors[0], VA_FILTER_SCALING_DEFAULT));
+    avs_init_state(&linear, &config);
+    ASSERT_TRUE(avs_update_coefficients(&linear, factors[1], factors[2], VA_FILTER_SCALING_DEFAULT));
+    avs_get_coefficients_cache_stats(&hits, &misses);
+    EXPECT_EQ(2u, hits);
+}
+
+TEST_F(AVSTest, LeastRecentlyUsedIsEvicted)
+{
+    AVSState avs;
+    unsigned hits, misses;
+
+    // fill the cache, the first entry is touched again so the second one
+    // is the oldest when one more table comes in
+    for (int i(0); i < AVS_COEFFS_CACHE_SIZE; ++i)
+        update(avs, 1.0f / (i + 2), 1.0f);
+    update(avs, 1.0f / 2, 1.0f);
+    update(avs, 0.01f, 1.0f);
+
+    update(avs, 1.0f / 2, 1.0f);
+    for (int i(2); i < AVS_COEFFS_CACHE_SIZE; ++i)
+        update(avs, 1.0f / (i + 2), 1.0f);
+    avs_get_coefficients_cache_stats(&hits, &misses);
+    EXPECT_EQ(AVS_COEFFS_CACHE_SIZE + 1u, misses);
+
+    update(avs, 1.0f / 3, 1.0f);
+    avs_get_coefficients_cache_stats(&hits, &misses);
+    EXPECT_EQ(AVS_COEFFS_CACHE_SIZE + 2u, misses);
+}
+
+// Generation time per unique scale factor, against switching between
+// rungs of the ladder once their tables are cached.
+TEST_F(AVSTest, Throughput)
+{
+    const int rounds = 200;
+
+    for (int path : { AVS_GEN_PATH_C, AVS_GEN_PATH_SSE2 }) {
+        avs_set_gen_path(path);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i(0); i < rounds; ++i) {
+            AVSState avs;
+            avs_flush_coefficients_cache();
+            update(avs, 0.25f + i * 0.001f, 0.3f + i * 0.001f);
+        }
+        auto elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "[ INFO     ] path " << path << ": "
+            << std::fixed << std::setprecision(2)
+            << elapsed / rounds * 1e6 << " us per generated table" << std::endl;
+    }
+
+    avs_flush_coefficients_cache();
+    auto start = std::chrono::steady_clock::now();
+    for (int i(0); i < rounds; ++i) {
+        AVSState avs;
+        const float f = factors[i % 4];
+        update(avs, f, f);
+    }
+    auto elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    unsigned hits, misses;
+    avs_get_coefficients_cache_stats(&hits, &misses);
+    EXPECT_EQ(4u, misses);
+
+    std::cout << "[ INFO     ] ladder switch: "
+        << std::fixed << std::setprecision(2)
+        << elapsed / rounds * 1e6 << " us per update" << std::endl;
+}
+
+} // namespace
@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "intel_batch_record.h"
+}
+
+#include "i965_bufmgr_mock.h"
+
+#include <i915_drm.h>
+
+#include <vector>
+
+namespace {
+
+typedef MockBufmgr::Reloc Reloc;
+
+// Emits commands the way intel_batchbuffer does, feeding the record with
+// the relocations while one is being recorded.
+struct Batch
+{
+    dri_bo bo;
+    std::vector<uint32_t> dwords;
+    struct intel_batch_record *record;
+    size_t record_start;
+
+    Batch() : bo(), record(NULL), record_start(0) { }
+
+    void emit(uint32_t dw)
+    {
+        dwords.push_back(dw);
+    }
+
+    void emitReloc(dri_bo *target, uint32_t rd, uint32_t wd, uint32_t delta,
+        bool is_64bit)
+    {
+        const uint32_t offset = dwords.size() * 4;
+        const uint64_t address = target->offset64 + delta;
+
+        MockBufmgr::emit_reloc(&bo, offset, target, delta, rd, wd);
+        if (record)
+            intel_batch_record_add_reloc(record, offset - record_start,
+                target, rd, wd, delta, is_64bit);
+
+        emit(address);
+        if (is_64bit)
+            emit(address >> 32);
+    }
+
+    void beginRecord(struct intel_batch_record *r, const void *key,
+        size_t key_size)
+    {
+        ASSERT_TRUE(intel_batch_record_begin(r, key, key_size));
+        record = r;
+        record_start = dwords.size() * 4;
+    }
+
+    void endRecord()
+    {
+        ASSERT_TRUE(intel_batch_record_end(record,
+            &dwords[record_start / 4], dwords.size() * 4 - record_start));
+        record = NULL;
+    }
+
+    void replay(const struct intel_batch_record *r)
+    {
+        const size_t offset = dwords.size();
+        dwords.resize(offset + intel_batch_record_size(r) / 4);
+        intel_batch_record_replay(r, &dwords[offset], &bo, offset * 4);
+    }
+};
+
+// Something shaped like STATE_BASE_ADDRESS followed by a few constant
+// packets, with 32 and 64 bit relocations.
+void emitState(Batch& batch, dri_bo *surface, dri_bo *dynamic,
+    dri_bo *instruction, uint32_t mocs)
+{
+    batch.emit(0x61010000 | (19 - 2));
+    batch.emit(1);
+    batch.emit(0);
+    batch.emit(0);
+    batch.emitReloc(surface, I915_GEM_DOMAIN_INSTRUCTION, 0, 1 | mocs << 4, true);
+    batch.emitReloc(dynamic, I915_GEM_DOMAIN_RENDER | I915_GEM_DOMAIN_SAMPLER,
+        I915_GEM_DOMAIN_RENDER, 1 | mocs << 4, true);
+    batch.emit(1);
+    batch.emit(0);
+    batch.emitReloc(instruction, I915_GEM_DOMAIN_INSTRUCTION, 0, 1 | mocs << 4, true);
+    for (int i(0); i < 4; ++i)
+        batch.emit(0xfffff001);
+    batch.emit(0x70000000 | (4 - 2));
+    batch.emit(0);
+    batch.emit(0x400);
+    batch.emitReloc(surface, I915_GEM_DOMAIN_SAMPLER, 0, 0x40, false);
+}
+
+class BatchRecordTest : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        MockBufmgr::reset();
+        intel_batch_record_init(&record, MockBufmgr::ops());
+
+        surface = dri_bo();
+        dynamic = dri_bo();
+        instruction = dri_bo();
+        surface.offset64 = 0x100000;
+        dynamic.offset64 = 0x1ffff0000ull;
+        instruction.offset64 = 0x300000;
+    }
+
+    virtual void TearDown()
+    {
+        intel_batch_record_fini(&record);
+    }
+
+    struct intel_batch_record record;
+    dri_bo surface, dynamic, instruction;
+};
+
+} // namespace
+
+TEST_F(BatchRecordTest, ReplayMatchesDirectEmission)
+{
+    const uint32_t key = 42;
+    Batch recorded;
+
+    recorded.emit(0x02000000);  // a flush that isn't part of the record
+    recorded.beginRecord(&record, &key, sizeof(key));
+    emitState(recorded, &surface, &dynamic, &instruction, 2);
+    recorded.endRecord();
+
+    ASSERT_TRUE(intel_batch_record_match(&record, &key, sizeof(key)));
+    EXPECT_EQ(recorded.dwords.size() * 4 - 4, intel_batch_record_size(&record));
+
+    // the buffers moved since, the presumed addresses must follow
+    surface.offset64 = 0x7000;
+    dynamic.offset64 = 0x2fffe0000ull;
+
+    Batch direct, replayed;
+    direct.emit(0);
+    direct.emit(0);
+    replayed.emit(0);
+    replayed.emit(0);
+
+    MockBufmgr::relocs().clear();
+    emitState(direct, &surface, &dynamic, &instruction, 2);
+    std::vector<Reloc> direct_relocs(MockBufmgr::relocs());
+
+    MockBufmgr::relocs().clear();
+    replayed.replay(&record);
+
+    EXPECT_TRUE(direct.dwords == replayed.dwords);
+
+    ASSERT_EQ(direct_relocs.size(), MockBufmgr::relocs().size());
+    for (size_t i(0); i < direct_relocs.size(); ++i) {
+        Reloc expected = direct_relocs[i];
+        expected.batch = &replayed.bo;
+        EXPECT_TRUE(expected == MockBufmgr::relocs()[i]) << "reloc " << i;
+    }
+}
+
+TEST_F(BatchRecordTest, KeyMismatch)
+{
+    const uint32_t key[2] = { 1, 2 };
+    const uint32_t other[2] = { 1, 3 };
+    Batch batch;
+
+    EXPECT_FALSE(intel_batch_record_match(&record, key, sizeof(key)));
+
+    batch.beginRecord(&record, key, sizeof(key));
+    EXPECT_FALSE(intel_batch_record_match(&record, key, sizeof(key)));
+    emitState(batch, &surface, &dynamic, &instruction, 0);
+    batch.endRecord();
+
+    EXPECT_TRUE(intel_batch_record_match(&record, key, sizeof(key)));
+    EXPECT_FALSE(intel_batch_record_match(&record, other, sizeof(other)));
+    EXPECT_FALSE(intel_batch_record_match(&record, key, sizeof(key[0])));
+    EXPECT_FALSE(intel_batch_record_match(&record, NULL, 0));
+}
+
+TEST_F(BatchRecordTest, EmptyKey)
+{
+    Batch batch;
+
+    batch.beginRecord(&record, NULL, 0);
+    for (uint32_t i(0); i < 208; ++i)
+        batch.emit(i * 0x01010101);
+    batch.endRecord();
+
+    EXPECT_TRUE(intel_batch_record_match(&record, NULL, 0));
+
+    Batch replayed;
+    replayed.replay(&record);
+    EXPECT_TRUE(batch.dwords == replayed.dwords);
+}
+
+TEST_F(BatchRecordTest, RerecordDropsOldContent)
+{
+    const uint32_t key = 1, new_key = 2;
+    Batch first, second;
+
+    first.beginRecord(&record, &key, sizeof(key));
+    emitState(first, &surface, &dynamic, &instruction, 0);
+    first.endRecord();
+
+    second.beginRecord(&record, &new_key, sizeof(new_key));
+    second.emit(0x05000000);
+    second.emitReloc(&instruction, I915_GEM_DOMAIN_INSTRUCTION, 0, 8, false);
+    second.endRecord();
+
+    EXPECT_FALSE(intel_batch_record_match(&record, &key, sizeof(key)));
+    ASSERT_TRUE(intel_batch_record_match(&record, &new_key, sizeof(new_key)));
+    EXPECT_EQ(8u, intel_batch_record_size(&record));
+
+    MockBufmgr::relocs().clear();
+    Batch replayed;
+    replayed.replay(&record);
+    EXPECT_TRUE(second.dwords == replayed.dwords);
+    ASSERT_EQ(1u, MockBufmgr::relocs().size());
+    EXPECT_EQ(&instruction, MockBufmgr::relocs()[0].target);
+    EXPECT_EQ(4u, MockBufmgr::relocs()[0].offset);
+}
+
+TEST_F(BatchRecordTest, Abort)
+{
+    const uint32_t key = 1;
+    Batch batch;
+
+    batch.beginRecord(&record, &key, sizeof(key));
+    emitState(batch, &surface, &dynamic, &instruction, 0);
+    batch.endRecord();
+
+    intel_batch_record_abort(&record);
+    EXPECT_FALSE(intel_batch_record_match(&record, &key, sizeof(key)));
+    EXPECT_EQ(0u, intel_batch_record_size(&record));
+}
@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "intel_bsd_scheduler.h"
+}
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+const uint64_t ms = 1000 * 1000;
+
+// Macroblocks per frame
+const unsigned mb4k = 240 * 135;
+const unsigned mb1080p = 120 * 68;
+const unsigned mb720p = 80 * 45;
+
+struct Stream
+{
+    unsigned cost;      // per frame
+    unsigned fps;
+    uint64_t start;     // ns
+};
+
+// Decodes the streams frame by frame for duration, pinning each one when
+// it starts, and returns the macroblocks per second left on each ring at
+// the end.
+std::vector<double> simulate(int mode, const std::vector<Stream>& streams,
+    uint64_t duration)
+{
+    struct intel_bsd_scheduler sched;
+    std::vector<int> rings(streams.size(), -2);
+    std::vector<uint64_t> next_frame(streams.size());
+    std::vector<double> rates(2, 0.0);
+
+    intel_bsd_scheduler_init(&sched, 2, mode);
+
+    for (size_t i(0); i < streams.size(); ++i)
+        next_frame[i] = streams[i].start;
+
+    // 1ms steps are fine enough for 60fps
+    for (uint64_t now(0); now < duration; now += ms) {
+        for (size_t i(0); i < streams.size(); ++i) {
+            if (now < streams[i].start)
+                continue;
+            if (rings[i] == -2) {
+                rings[i] = intel_bsd_scheduler_pin(&sched, now);
+                rates[rings[i] < 0 ? 0 : rings[i]] += streams[i].cost * streams[i].fps;
+            }
+            while (next_frame[i] <= now) {
+                intel_bsd_scheduler_account(&sched, rings[i], streams[i].cost, now);
+                next_frame[i] += 1000 * ms / streams[i].fps;
+            }
+        }
+    }
+
+    for (size_t i(0); i < streams.size(); ++i)
+        intel_bsd_scheduler_unpin(&sched, rings[i]);
+    intel_bsd_scheduler_fini(&sched);
+
+    return rates;
+}
+
+double imbalance(const std::vector<double>& rates)
+{
+    return std::fabs(rates[0] - rates[1]) / (rates[0] + rates[1]);
+}
+
+TEST(BSDSchedulerTest, ParseMode)
+{
+    EXPECT_EQ(INTEL_BSD_SCHEDULER_BALANCE, intel_bsd_scheduler_parse_mode(NULL));
+    EXPECT_EQ(INTEL_BSD_SCHEDULER_BALANCE, intel_bsd_scheduler_parse_mode("balance"));
+    EXPECT_EQ(INTEL_BSD_SCHEDULER_KERNEL, intel_bsd_scheduler_parse_mode("Kernel"));
+    EXPECT_EQ(INTEL_BSD_SCHEDULER_RING0, intel_bsd_scheduler_parse_mode("0"));
+    EXPECT_EQ(INTEL_BSD_SCHEDULER_RING1, intel_bsd_scheduler_parse_mode("1"));
+    EXPECT_EQ(INTEL_BSD_SCHEDULER_BALANCE, intel_bsd_scheduler_parse_mode("2"));
+}
+
+TEST(BSDSchedulerTest, Modes)
+{
+    struct intel_bsd_scheduler sched;
+
+    intel_bsd_scheduler_init(&sched, 2, INTEL_BSD_SCHEDULER_RING1);
+    EXPECT_EQ(1, intel_bsd_scheduler_pin(&sched, 0));
+    EXPECT_EQ(1, intel_bsd_scheduler_pin(&sched, 0));
+    intel_bsd_scheduler_fini(&sched);
+
+    intel_bsd_scheduler_init(&sched, 2, INTEL_BSD_SCHEDULER_KERNEL);
+    EXPECT_EQ(-1, intel_bsd_scheduler_pin(&sched, 0));
+    intel_bsd_scheduler_fini(&sched);
+
+    // a single ring is always left to the kernel
+    intel_bsd_scheduler_init(&sched, 1, INTEL_BSD_SCHEDULER_RING1);
+    EXPECT_EQ(-1, intel_bsd_scheduler_pin(&sched, 0));
+    intel_bsd_scheduler_init(&sched, 1, INTEL_BSD_SCHEDULER_BALANCE);
+    EXPECT_EQ(-1, intel_bsd_scheduler_pin(&sched, 0));
+    intel_bsd_scheduler_fini(&sched);
+}
+
+TEST(BSDSchedulerTest, IdleRingsAlternate)
+{
+    struct intel_bsd_scheduler sched;
+
+    intel_bsd_scheduler_init(&sched, 2, INTEL_BSD_SCHEDULER_BALANCE);
+
+    EXPECT_EQ(0, intel_bsd_scheduler_pin(&sched, 0));
+    EXPECT_EQ(1, intel_bsd_scheduler_pin(&sched, 0));
+    EXPECT_EQ(0, intel_bsd_scheduler_pin(&sched, 0));
+    EXPECT_EQ(1, intel_bsd_scheduler_pin(&sched, 0));
+
+    intel_bsd_scheduler_unpin(&sched, 0);
+    EXPECT_EQ(0, intel_bsd_scheduler_pin(&sched, 0));
+
+    intel_bsd_scheduler_fini(&sched);
+}
+
+TEST(BSDSchedulerTest, LoadDecays)
+{
+    struct intel_bsd_scheduler sched;
+
+    intel_bsd_scheduler_init(&sched, 2, INTEL_BSD_SCHEDULER_BALANCE);
+
+    intel_bsd_scheduler_account(&sched, 0, 1000, 0);
+    EXPECT_DOUBLE_EQ(1000.0, intel_bsd_scheduler_get_load(&sched, 0, 0));
+    EXPECT_NEAR(500.0, intel_bsd_scheduler_get_load(&sched, 0,
+        INTEL_BSD_SCHEDULER_HALF_LIFE), 1e-6);
+
+    // ring 0 is busy, then goes idle long enough to be the better choice
+    intel_bsd_scheduler_account(&sched, 1, 100, 10 * INTEL_BSD_SCHEDULER_HALF_LIFE);
+    EXPECT_EQ(0, intel_bsd_scheduler_pin(&sched, 10 * INTEL_BSD_SCHEDULER_HALF_LIFE));
+
+    intel_bsd_scheduler_fini(&sched);
+}
+
+// A 4K stream followed by a mix of smaller ones: pinning on arrival to the
+// least loaded ring must end up much closer to an even split than handing
+// out the rings in turn, which is what the kernel does per batch at best.
+TEST(BSDSchedulerTest, Simulation)
+{
+    std::vector<Stream> streams;
+
+    streams.push_back({ mb4k, 60, 0 });
+    for (int i(0); i < 4; ++i)
+        streams.push_back({ mb1080p, 30, (uint64_t)(i + 1) * 200 * ms });
+    for (int i(0); i < 4; ++i)
+        streams.push_back({ mb720p, 30, (uint64_t)(i + 5) * 200 * ms });
+    streams.push_back({ mb4k, 30, 1800 * ms });
+    streams.push_back({ mb1080p, 60, 2000 * ms });
+
+    const std::vector<double> balanced = simulate(INTEL_BSD_SCHEDULER_BALANCE, streams, 3000 * ms);
+
+    // what alternating contexts between the rings gives
+    std::vector<double> alternating(2, 0.0);
+    for (size_t i(0); i < streams.size(); ++i)
+        alternating[i % 2] += streams[i].cost * streams[i].fps;
+
+    std::cout << "[ INFO     ] MB/s per ring: balanced "
+        << balanced[0] << " / " << balanced[1]
+        << ", alternating " << alternating[0] << " / " << alternating[1]
+        << std::endl;
+
+    EXPECT_LT(imbalance(balanced), 0.15);
+    EXPECT_LT(imbalance(balanced), imbalance(alternating));
+
+    const std::vector<double> forced = simulate(INTEL_BSD_SCHEDULER_RING0, streams, 3000 * ms);
+    EXPECT_DOUBLE_EQ(0.0, forced[1]);
+}
+
+TEST(BSDSchedulerTest, PickModes)
+{
+    struct intel_bsd_scheduler sched;
+
+    intel_bsd_scheduler_init(&sched, 2, INTEL_BSD_SCHEDULER_RING1);
+    EXPECT_EQ(1, intel_bsd_scheduler_pick(&sched, 0));
+    intel_bsd_scheduler_fini(&sched);
+
+    intel_bsd_scheduler_init(&sched, 2, INTEL_BSD_SCHEDULER_KERNEL);
+    EXPECT_EQ(-1, intel_bsd_scheduler_pick(&sched, 0));
+    intel_bsd_scheduler_fini(&sched);
+
+    intel_bsd_scheduler_init(&sched, 1, INTEL_BSD_SCHEDULER_BALANCE);
+    EXPECT_EQ(-1, intel_bsd_scheduler_pick(&sched, 0));
+    intel_bsd_scheduler_fini(&sched);
+
+    // picking doesn't count as a context on the ring
+    intel_bsd_scheduler_init(&sched, 2, INTEL_BSD_SCHEDULER_BALANCE);
+    EXPECT_EQ(0, intel_bsd_scheduler_pick(&sched, 0));
+    EXPECT_EQ(0, intel_bsd_scheduler_pick(&sched, 0));
+    EXPECT_EQ(0u, sched.rings[0].num_contexts);
+    EXPECT_EQ(0, intel_bsd_scheduler_pin(&sched, 0));
+    EXPECT_EQ(1, intel_bsd_scheduler_pick(&sched, 0));
+    intel_bsd_scheduler_fini(&sched);
+}
+
+// An all-intra 4K stream picks a ring per picture, next to a 1080p stream
+// pinned to the first ring: the intra pictures must fill the other ring
+// first and then spread over both.
+TEST(BSDSchedulerTest, IntraPicturesSpread)
+{
+    struct intel_bsd_scheduler sched;
+    std::vector<double> costs(2, 0.0);
+
+    intel_bsd_scheduler_init(&sched, 2, INTEL_BSD_SCHEDULER_BALANCE);
+
+    const int pinned = intel_bsd_scheduler_pin(&sched, 0);
+    EXPECT_EQ(0, pinned);
+
+    for (uint64_t now(0); now < 2000 * ms; now += 1000 * ms / 60) {
+        intel_bsd_scheduler_account(&sched, pinned, mb1080p, now);
+        costs[pinned] += mb1080p;
+
+        const int ring = intel_bsd_scheduler_pick(&sched, now);
+        ASSERT_TRUE(ring == 0 || ring == 1);
+        intel_bsd_scheduler_account(&sched, ring, mb4k, now);
+        costs[ring] += mb4k;
+    }
+
+    std::cout << "[ INFO     ] MB per ring: "
+        << costs[0] << " / " << costs[1] << std::endl;
+
+    EXPECT_GT(costs[0], 0.0);
+    EXPECT_LT(imbalance(costs), 0.15);
+
+    intel_bsd_scheduler_unpin(&sched, pinned);
+    intel_bsd_scheduler_fini(&sched);
+}
+
+} // namespace
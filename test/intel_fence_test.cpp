@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "intel_fence.h"
+}
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// eventfds stand in for sync_files: readable once written to
+class FenceTest : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        intel_fence_set_init(&set);
+    }
+
+    virtual void TearDown()
+    {
+        intel_fence_set_reset(&set);
+
+        for (size_t i = 0; i < fences.size(); i++)
+            close(fences[i]);
+    }
+
+    // returns the fence, set owns a duplicate of it
+    int add(int slot)
+    {
+        const int fd = eventfd(0, EFD_CLOEXEC);
+
+        EXPECT_GE(fd, 0);
+        fences.push_back(fd);
+        intel_fence_set_add(&set, slot, dup(fd));
+
+        return fd;
+    }
+
+    void signal(int fd)
+    {
+        const uint64_t one = 1;
+
+        EXPECT_EQ((ssize_t)sizeof(one), write(fd, &one, sizeof(one)));
+    }
+
+    static bool readable(int fd)
+    {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+
+        return poll(&pfd, 1, 0) == 1;
+    }
+
+    struct intel_fence_set set;
+    std::vector<int> fences;
+};
+
+void count(void *data)
+{
+    (*static_cast<int *>(data))++;
+}
+
+} // namespace
+
+TEST_F(FenceTest, Empty)
+{
+    EXPECT_TRUE(intel_fence_set_is_empty(&set));
+    EXPECT_TRUE(intel_fence_set_poll(&set));
+    EXPECT_EQ(0, intel_fence_set_wait(&set, 0));
+    EXPECT_EQ(-ENOENT, intel_fence_set_export(&set));
+}
+
+TEST_F(FenceTest, Poll)
+{
+    const int render = add(1);
+    const int bsd = add(2);
+
+    EXPECT_FALSE(intel_fence_set_is_empty(&set));
+    EXPECT_FALSE(intel_fence_set_poll(&set));
+
+    // the signaled fence is dropped, the other is kept
+    signal(bsd);
+    EXPECT_FALSE(intel_fence_set_poll(&set));
+    EXPECT_GE(set.fds[1], 0);
+    EXPECT_EQ(-1, set.fds[2]);
+
+    signal(render);
+    EXPECT_TRUE(intel_fence_set_poll(&set));
+    EXPECT_TRUE(intel_fence_set_is_empty(&set));
+}
+
+TEST_F(FenceTest, ReplaceSlot)
+{
+    const int first = add(1);
+    add(1);
+
+    // only the last fence of an engine matters
+    signal(first);
+    EXPECT_FALSE(intel_fence_set_poll(&set));
+}
+
+TEST_F(FenceTest, WaitTimeout)
+{
+    const int fd = add(4);
+
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(-ETIME, intel_fence_set_wait(&set, 20000000));
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_GE(elapsed, std::chrono::milliseconds(20));
+    EXPECT_FALSE(intel_fence_set_is_empty(&set));
+    EXPECT_EQ(-ETIME, intel_fence_set_wait(&set, 0));
+
+    signal(fd);
+    EXPECT_EQ(0, intel_fence_set_wait(&set, 0));
+    EXPECT_TRUE(intel_fence_set_is_empty(&set));
+}
+
+TEST_F(FenceTest, WaitForever)
+{
+    const int render = add(1);
+    const int vebox = add(4);
+
+    signal(render);
+    std::thread signaler([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        signal(vebox);
+    });
+
+    EXPECT_EQ(0, intel_fence_set_wait(&set, -1));
+    EXPECT_TRUE(intel_fence_set_is_empty(&set));
+
+    signaler.join();
+}
+
+TEST_F(FenceTest, Dup)
+{
+    struct intel_fence_set copy;
+    const int fd = add(3);
+
+    intel_fence_set_init(&copy);
+    ASSERT_EQ(0, intel_fence_set_dup(&copy, &set));
+    EXPECT_GE(copy.fds[3], 0);
+    EXPECT_NE(set.fds[3], copy.fds[3]);
+
+    // waiting on the copy leaves the original alone
+    signal(fd);
+    EXPECT_EQ(0, intel_fence_set_wait(&copy, -1));
+    EXPECT_GE(set.fds[3], 0);
+    EXPECT_TRUE(intel_fence_set_poll(&set));
+}
+
+TEST_F(FenceTest, ExportSingle)
+{
+    const int fd = add(1);
+
+    const int exported = intel_fence_set_export(&set);
+    ASSERT_GE(exported, 0);
+    EXPECT_FALSE(readable(exported));
+
+    signal(fd);
+    EXPECT_TRUE(readable(exported));
+    close(exported);
+}
+
+TEST_F(FenceTest, CompletionQueue)
+{
+    struct intel_completion_queue queue;
+    int done = 0, idle = 0;
+
+    ASSERT_EQ(0, intel_completion_queue_init(&queue));
+
+    const int render = add(1);
+    const int bsd = add(2);
+    ASSERT_EQ(0, intel_completion_queue_add(&queue, &set, count, &done));
+    EXPECT_EQ(1, queue.num_pending);
+
+    // an empty set completes right away
+    struct intel_fence_set empty;
+    intel_fence_set_init(&empty);
+    ASSERT_EQ(0, intel_completion_queue_add(&queue, &empty, count, &idle));
+    EXPECT_EQ(1, idle);
+
+    EXPECT_FALSE(readable(intel_completion_queue_fd(&queue)));
+    EXPECT_EQ(0, intel_completion_queue_dispatch(&queue));
+
+    // the completion needs all the fences
+    signal(render);
+    EXPECT_TRUE(readable(intel_completion_queue_fd(&queue)));
+    EXPECT_EQ(0, intel_completion_queue_dispatch(&queue));
+    EXPECT_EQ(0, done);
+    EXPECT_FALSE(readable(intel_completion_queue_fd(&queue)));
+
+    signal(bsd);
+    EXPECT_TRUE(readable(intel_completion_queue_fd(&queue)));
+    EXPECT_EQ(1, intel_completion_queue_dispatch(&queue));
+    EXPECT_EQ(1, done);
+    EXPECT_EQ(0, queue.num_pending);
+    EXPECT_FALSE(readable(intel_completion_queue_fd(&queue)));
+
+    intel_completion_queue_fini(&queue);
+}
+
+TEST_F(FenceTest, CompletionQueueMany)
+{
+    struct intel_completion_queue queue;
+    const int num_surfaces = 200;
+    std::vector<int> fds;
+    int done = 0;
+
+    ASSERT_EQ(0, intel_completion_queue_init(&queue));
+
+    for (int i = 0; i < num_surfaces; i++) {
+        intel_fence_set_reset(&set);
+        fds.push_back(add(i % INTEL_FENCE_SET_SIZE));
+        ASSERT_EQ(0, intel_completion_queue_add(&queue, &set, count, &done));
+    }
+    EXPECT_EQ(num_surfaces, queue.num_pending);
+
+    for (int i = 0; i < num_surfaces; i += 2)
+        signal(fds[i]);
+
+    EXPECT_EQ(num_surfaces / 2, intel_completion_queue_dispatch(&queue));
+    EXPECT_EQ(num_surfaces / 2, done);
+    EXPECT_EQ(num_surfaces / 2, queue.num_pending);
+
+    // the pending ones are dropped without calling back
+    intel_completion_queue_fini(&queue);
+    EXPECT_EQ(num_surfaces / 2, done);
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "intel_gpu_profiler.h"
+}
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 12.5 MHz, 80 ns per tick
+const uint64_t frequency = 12500000;
+
+class GpuProfilerTest : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        profiler = intel_gpu_profiler_new(NULL, frequency);
+        ASSERT_PTR(profiler);
+    }
+
+    virtual void TearDown()
+    {
+        intel_gpu_profiler_free(profiler);
+    }
+
+    void account(uint8_t stage, uint64_t begin, uint64_t end)
+    {
+        const uint64_t timestamps[2] = { begin, end };
+
+        intel_gpu_profiler_account(profiler, &stage, timestamps, 1);
+    }
+
+    std::string dump()
+    {
+        FILE *fp = tmpfile();
+        std::string out;
+        char line[256];
+
+        intel_gpu_profiler_dump(profiler, fp, "render");
+        rewind(fp);
+        while (fgets(line, sizeof(line), fp))
+            out += line;
+        fclose(fp);
+
+        return out;
+    }
+
+    struct intel_gpu_profiler *profiler;
+};
+
+} // namespace
+
+TEST_F(GpuProfilerTest, StageNames)
+{
+    EXPECT_STREQ("me", intel_gpu_stage_name(INTEL_GPU_STAGE_ME));
+    EXPECT_STREQ("brc_update", intel_gpu_stage_name(INTEL_GPU_STAGE_BRC_UPDATE));
+    EXPECT_STREQ("pak", intel_gpu_stage_name(INTEL_GPU_STAGE_PAK));
+    EXPECT_STREQ("vpp", intel_gpu_stage_name(INTEL_GPU_STAGE_VPP));
+    EXPECT_STREQ("unknown", intel_gpu_stage_name(INTEL_GPU_STAGE_COUNT));
+
+    for (int i = 0; i < INTEL_GPU_STAGE_COUNT; i++)
+        EXPECT_STRNE("unknown", intel_gpu_stage_name(intel_gpu_stage(i)));
+}
+
+TEST_F(GpuProfilerTest, Durations)
+{
+    const struct intel_gpu_stage_stats *stats = &profiler->stats[INTEL_GPU_STAGE_MBENC];
+
+    account(INTEL_GPU_STAGE_MBENC, 1000, 1000 + 12500);     // 1 ms
+    account(INTEL_GPU_STAGE_MBENC, 5000, 5000 + 25000);     // 2 ms
+    account(INTEL_GPU_STAGE_MBENC, 9000, 9000 + 6);         // 480 ns
+
+    EXPECT_EQ(3u, stats->count);
+    EXPECT_EQ(3000480u, stats->total_ns);
+    EXPECT_EQ(480u, stats->min_ns);
+    EXPECT_EQ(2000000u, stats->max_ns);
+
+    // [512, 1024) and [1024, 2048) us, sub-microsecond
+    EXPECT_EQ(1u, stats->histogram[10]);
+    EXPECT_EQ(1u, stats->histogram[11]);
+    EXPECT_EQ(1u, stats->histogram[0]);
+
+    EXPECT_EQ(0u, profiler->stats[INTEL_GPU_STAGE_ME].count);
+}
+
+TEST_F(GpuProfilerTest, TimestampWraps)
+{
+    const uint64_t top = (1ULL << 36) - 100;
+
+    // the counter is 36 bits wide
+    account(INTEL_GPU_STAGE_PAK, top, 150);
+    EXPECT_EQ(250u * 80, profiler->stats[INTEL_GPU_STAGE_PAK].total_ns);
+}
+
+TEST_F(GpuProfilerTest, LongStages)
+{
+    const struct intel_gpu_stage_stats *stats = &profiler->stats[INTEL_GPU_STAGE_DECODE];
+
+    // about 92 minutes, 2^36 ticks * 10^9 would overflow
+    account(INTEL_GPU_STAGE_DECODE, 0, (1ULL << 36) - 1);
+    EXPECT_EQ(((1ULL << 36) - 1) * 80, stats->total_ns);
+    EXPECT_EQ(1u, stats->histogram[INTEL_GPU_PROFILER_BUCKETS - 1]);
+}
+
+TEST_F(GpuProfilerTest, UnfinishedStagesSkipped)
+{
+    const uint8_t stages[3] = { INTEL_GPU_STAGE_ME, INTEL_GPU_STAGE_COUNT, INTEL_GPU_STAGE_ME };
+    const uint64_t timestamps[6] = { 0, 100, 200, 0, 300, 400 };
+
+    intel_gpu_profiler_account(profiler, stages, timestamps, 3);
+
+    EXPECT_EQ(2u, profiler->stats[INTEL_GPU_STAGE_ME].count);
+    EXPECT_EQ(200u * 80, profiler->stats[INTEL_GPU_STAGE_ME].total_ns);
+}
+
+TEST_F(GpuProfilerTest, EndWithoutBegin)
+{
+    dri_bo *bo = NULL;
+    uint32_t offset = 0;
+
+    EXPECT_EQ(0, intel_gpu_profiler_end(profiler, INTEL_GPU_STAGE_PAK, &bo, &offset));
+    EXPECT_EQ(NULL, bo);
+
+    // nothing was queued
+    intel_gpu_profiler_submit(profiler);
+    EXPECT_EQ(0, profiler->num_submitted);
+}
+
+TEST_F(GpuProfilerTest, Dump)
+{
+    EXPECT_EQ("", dump());
+
+    account(INTEL_GPU_STAGE_ME, 0, 1250);                   // 100 us
+    account(INTEL_GPU_STAGE_ME, 0, 3750);                   // 300 us
+    account(INTEL_GPU_STAGE_BRC_UPDATE, 0, 125);            // 10 us
+
+    const std::string out = dump();
+
+    EXPECT_NE(std::string::npos, out.find("GPU profile of the render batch, 0 stages dropped"));
+    EXPECT_NE(std::string::npos, out.find("me                2 runs, avg     200.0 us, min     100.0 us, max     300.0 us"));
+    EXPECT_NE(std::string::npos, out.find(" 64us:1 256us:1\n"));
+    EXPECT_NE(std::string::npos, out.find("brc_update        1 runs"));
+    EXPECT_EQ(std::string::npos, out.find("mbenc"));
+}
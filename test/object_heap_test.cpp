@@ -29,9 +29,12 @@ extern "C" {
 }
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
 #include <ctime>
 #include <iomanip>
+#include <thread>
 #include <vector>
 
 TEST(ObjectHeapTest, Init)
@@ -246,3 +249,177 @@ TEST(ObjectHeapTest, OffsetID)
         object_heap_destroy(&heap);
     }
 }
+
+TEST(ObjectHeapTest, GenerationID)
+{
+    struct object_heap heap = {};
+
+    ASSERT_EQ(0, object_heap_init(&heap, sizeof(object_base), 0));
+
+    int id = object_heap_allocate(&heap);
+    object_base_p obj = object_heap_lookup(&heap, id);
+    ASSERT_PTR(obj);
+
+    object_heap_free(&heap, obj);
+    EXPECT_PTR_NULL(object_heap_lookup(&heap, id));
+
+    // the slot is recycled under a new ID, the stale one stays invalid
+    int new_id = object_heap_allocate(&heap);
+    EXPECT_NE(id, new_id);
+    EXPECT_EQ(id & OBJECT_HEAP_INDEX_MASK, new_id & OBJECT_HEAP_INDEX_MASK);
+    EXPECT_TRUE(obj == object_heap_lookup(&heap, new_id));
+    EXPECT_PTR_NULL(object_heap_lookup(&heap, id));
+
+    object_heap_free(&heap, obj);
+    object_heap_destroy(&heap);
+}
+
+TEST(ObjectHeapTest, MultiThreadedStress)
+{
+    struct test_object {
+        struct object_base base;
+        int owner;
+        int value;
+    };
+
+    typedef test_object *test_object_p;
+    struct object_heap heap = {};
+
+    ASSERT_EQ(0, object_heap_init(&heap, sizeof(test_object), 0x04000000));
+
+    const int nthreads = std::max(4u, std::thread::hardware_concurrency());
+    const int iterations = 20000;
+    std::atomic<int> errors(0);
+    std::vector<std::thread> threads;
+
+    for (int t(0); t < nthreads; ++t) {
+        threads.push_back(std::thread([&, t] {
+            std::vector<int> ids;
+            for (int i(0); i < iterations; ++i) {
+                int id = object_heap_allocate(&heap);
+                test_object_p object = (test_object_p)object_heap_lookup(&heap, id);
+                if (!object) {
+                    errors++;
+                    continue;
+                }
+                object->owner = t;
+                object->value = i;
+                ids.push_back(id);
+
+                // keep a window of live objects and recycle the oldest
+                if (ids.size() > 32 || (i & 7) == 0) {
+                    int victim = ids.front();
+                    ids.erase(ids.begin());
+                    object = (test_object_p)object_heap_lookup(&heap, victim);
+                    if (!object || object->owner != t)
+                        errors++;
+                    object_heap_free(&heap, &object->base);
+                    if (object_heap_lookup(&heap, victim))
+                        errors++;
+                }
+            }
+            for (int id : ids) {
+                object_base_p obj = object_heap_lookup(&heap, id);
+                if (!obj || ((test_object_p)obj)->owner != t)
+                    errors++;
+                object_heap_free(&heap, obj);
+            }
+        }));
+    }
+
+    std::for_each(threads.begin(), threads.end(),
+        [](std::thread& th){ th.join(); });
+
+    EXPECT_EQ(0, errors.load());
+
+    object_heap_iterator iter;
+    EXPECT_PTR_NULL(object_heap_first(&heap, &iter));
+
+    object_heap_destroy(&heap);
+}
+
+TEST(ObjectHeapTest, LookupDuringExpand)
+{
+    struct object_heap heap = {};
+
+    ASSERT_EQ(0, object_heap_init(&heap, sizeof(object_base), 0));
+
+    std::vector<int> ids(64);
+    std::generate(ids.begin(), ids.end(),
+        [&]{ return object_heap_allocate(&heap); });
+
+    std::atomic<bool> done(false);
+    std::atomic<int> errors(0);
+    std::vector<std::thread> readers;
+
+    for (int t(0); t < 4; ++t) {
+        readers.push_back(std::thread([&] {
+            while (!done.load()) {
+                for (int id : ids) {
+                    object_base_p obj = object_heap_lookup(&heap, id);
+                    if (!obj || obj->id != id)
+                        errors++;
+                }
+            }
+        }));
+    }
+
+    // grow the heap (and its bucket table) underneath the readers
+    std::vector<object_base_p> objects(16384, NULL);
+    std::generate(objects.begin(), objects.end(),
+        [&]{ return object_heap_lookup(&heap, object_heap_allocate(&heap)); });
+
+    done = true;
+    std::for_each(readers.begin(), readers.end(),
+        [](std::thread& th){ th.join(); });
+
+    EXPECT_EQ(0, errors.load());
+
+    std::for_each(objects.begin(), objects.end(),
+        [&](object_base_p o){ object_heap_free(&heap, o); });
+    std::for_each(ids.begin(), ids.end(),
+        [&](int id){ object_heap_free(&heap, object_heap_lookup(&heap, id)); });
+    object_heap_destroy(&heap);
+}
+
+TEST(ObjectHeapTest, LookupThroughput)
+{
+    struct object_heap heap = {};
+
+    ASSERT_EQ(0, object_heap_init(&heap, sizeof(object_base), 0));
+
+    std::vector<int> ids(1024);
+    std::generate(ids.begin(), ids.end(),
+        [&]{ return object_heap_allocate(&heap); });
+
+    const int nthreads = std::max(4u, std::thread::hardware_concurrency());
+    const int rounds = 1000;
+    std::atomic<long> found(0);
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int t(0); t < nthreads; ++t) {
+        threads.push_back(std::thread([&] {
+            long n(0);
+            for (int r(0); r < rounds; ++r)
+                for (int id : ids)
+                    n += object_heap_lookup(&heap, id) != NULL;
+            found += n;
+        }));
+    }
+    std::for_each(threads.begin(), threads.end(),
+        [](std::thread& th){ th.join(); });
+    auto elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    const long total = (long)nthreads * rounds * ids.size();
+    EXPECT_EQ(total, found.load());
+
+    std::cout << "[ INFO     ] " << nthreads << " threads, "
+        << std::fixed << std::setprecision(1)
+        << (total / elapsed / 1e6) << "M lookups/s" << std::endl;
+
+    std::for_each(ids.begin(), ids.end(),
+        [&](int id){ object_heap_free(&heap, object_heap_lookup(&heap, id)); });
+    object_heap_destroy(&heap);
+}